@@ -0,0 +1,718 @@
+/////////////////////////////////////////////////////////////////////////////
+// Benchmarks.cpp
+//
+// Throughput benchmarks for the Diagnostics and Utils libraries.
+//
+// Usage: Benchmarks [ResultsFile [MillisecondsPerCase]]
+//        Benchmarks -latency [ResultsFile [Threads [CallsPerSecond [Seconds]]]]
+//
+// Results are written to ResultsFile (Benchmarks.json by default) as
+// JSON, one object per case, so runs from different releases can be
+// compared.  The console sink cases write to standard output.  With
+// -latency, runs the tail latency harness instead (LatencyHarness.cpp).
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "LatencyHarness.h"
+#include "../DiagnosticsLibrary/Diagnostics.h"
+#include "../DiagnosticsLibrary/Metrics.h"
+#include "../DiagnosticsLibrary/RecordFields.h"
+#include "../Utils/FileWrapper.h"
+#include "../Utils/Parallel.h"
+#include "../Utils/Utils.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+#define DEFAULT_CASE_MILLISECONDS	200
+#define DEFAULT_RESULTS_FILE		_T("Benchmarks.json")
+#define BENCHMARK_LOG_FILE			_T("\\DiagnosticsBenchmark.log")
+#define BENCHMARK_APPEND_FILE		_T("DiagnosticsBenchmark.dat")
+// operations between clock checks in the single threaded cases
+#define OPERATION_BATCH				16
+
+static const DWORD	g_ThreadCounts[]	= { 1, 2, 4, 8, 16, 32, 64 };
+static const size_t	g_MessageSizes[]	= { 16, 256, 4096, 16384 };
+static const ULONG	g_CodePages[]		= { CP_UTF8, 1252 };
+
+// text representable in every code page above
+static const wchar_t	g_SampleText[]	=
+	L"The quick brown fox jumps over the lazy dog. Caf\x00E9 na\x00EFve d\x00E9j\x00E0 vu. ";
+
+static const TCHAR*		g_EmailAddresses[]	=
+{
+	_T("james@example.com"),
+	_T("first.last+tag@sub.example.co.uk"),
+	_T("not an address"),
+	_T("missing@tld")
+};
+
+typedef void (*Operation)(
+	void*	Context);
+
+/////////////////////////////////////////////////////////////////////////////
+// Class: NullSink
+//
+// Accepts every record and does nothing, to measure Report itself.
+/////////////////////////////////////////////////////////////////////////////
+class NullSink : public StructuredSink
+{
+	public:
+		// Methods
+			virtual void WriteRecord(
+				LPCTSTR		Message,
+				size_t		MessageLength,
+				const BYTE*	Fields,
+				size_t		FieldsSize)
+			{
+			}
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Class: ResultsWriter
+/////////////////////////////////////////////////////////////////////////////
+class ResultsWriter
+{
+	public:
+		// Methods
+			ResultsWriter(
+				FILE*	File,
+				DWORD	CaseMilliseconds);
+			~ResultsWriter(void);
+
+			void Write(
+				const char*	Name,
+				const char*	Variant,
+				DWORD		Threads,
+				size_t		Size,
+				LONGLONG	Operations,
+				ULONGLONG	Microseconds);
+
+	private:
+		// Properties
+			FILE*	m_File;
+			bool	m_First;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Report benchmark types
+/////////////////////////////////////////////////////////////////////////////
+struct ProducerContext
+{
+	Diagnostics*	Target;
+	const char*		NarrowMessage;
+	const wchar_t*	WideMessage;
+	size_t			Length;
+	HANDLE			StartEvent;
+	volatile LONG*	Stop;
+	LONGLONG		Operations;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Micro benchmark contexts
+/////////////////////////////////////////////////////////////////////////////
+struct ConcatContext
+{
+	TCHAR*	Parts[3];
+};
+
+struct ConvertContext
+{
+	ULONG		CodePage;
+	wchar_t*	Unicode;
+	size_t		UnicodeLength;
+	char*		MultiByte;
+	size_t		MultiByteLength;
+	size_t		MultiByteSize;
+	wchar_t*	UnicodeBuffer;
+};
+
+struct AppendContext
+{
+	FileWrapper*	File;
+	BYTE*			Contents;
+	DWORD			Length;
+};
+
+struct EmailContext
+{
+	size_t	Next;
+	bool	Valid;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// FillText
+//
+// Repeats the sample text to fill Length characters.
+/////////////////////////////////////////////////////////////////////////////
+static void
+FillText(
+	wchar_t*	Text,
+	size_t		Length)
+{
+	size_t	SampleLength	= _countof(g_SampleText) - 1;
+
+	for (size_t Index = 0; Index < Length; Index++)
+	{
+		Text[Index] = g_SampleText[Index % SampleLength];
+	}
+
+	Text[Length] = L'\0';
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RunForDuration
+//
+// Runs the operation over and over for about Milliseconds, checking the
+// clock once every OPERATION_BATCH operations.
+/////////////////////////////////////////////////////////////////////////////
+static void
+RunForDuration(
+	Operation	Run,
+	void*		Context,
+	DWORD		Milliseconds,
+	LONGLONG*	Operations,
+	ULONGLONG*	Microseconds)
+{
+	ULONGLONG	Limit		= (ULONGLONG)Milliseconds * 1000;
+	ULONGLONG	Elapsed		= 0;
+	LONGLONG	Count		= 0;
+
+	// warm up caches and any lazily created state
+	Run(Context);
+
+	LONGLONG	StartCount	= GetPerformanceCount();
+
+	while (Elapsed < Limit)
+	{
+		for (int Index = 0; Index < OPERATION_BATCH; Index++)
+		{
+			Run(Context);
+		}
+
+		Count	+= OPERATION_BATCH;
+		Elapsed	= GetElapsedMicroseconds(StartCount, GetPerformanceCount());
+	}
+
+	*Operations		= Count;
+	*Microseconds	= Elapsed;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ResultsWriter Class Definition
+/////////////////////////////////////////////////////////////////////////////
+ResultsWriter::ResultsWriter(
+	FILE*	File,
+	DWORD	CaseMilliseconds) :
+		m_File(File),
+		m_First(true)
+{
+	fprintf(m_File, "{\n  \"processors\": %lu,\n  \"case_milliseconds\": %lu,\n"
+		"  \"results\": [",
+		GetProcessorCount(),
+		CaseMilliseconds);
+}
+
+ResultsWriter::~ResultsWriter(void)
+{
+	fprintf(m_File, "\n  ]\n}\n");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Write
+//
+// Names and variants are fixed identifiers, so need no escaping.
+/////////////////////////////////////////////////////////////////////////////
+void
+ResultsWriter::Write(
+	const char*	Name,
+	const char*	Variant,
+	DWORD		Threads,
+	size_t		Size,
+	LONGLONG	Operations,
+	ULONGLONG	Microseconds)
+{
+	double	Seconds				= (double)Microseconds / 1000000.0;
+	double	OperationsPerSecond	= 0.0;
+
+	if (0 < Microseconds)
+	{
+		OperationsPerSecond = (double)Operations / Seconds;
+	}
+
+	fprintf(m_File, "%s\n    {\"name\": \"%s\", \"variant\": \"%s\", \"threads\": %lu, "
+		"\"size\": %lu, \"operations\": %I64d, \"seconds\": %.6f, "
+		"\"operations_per_second\": %.1f, \"bytes_per_second\": %.1f}",
+		(true == m_First) ? "" : ",",
+		Name,
+		Variant,
+		Threads,
+		(ULONG)Size,
+		Operations,
+		Seconds,
+		OperationsPerSecond,
+		OperationsPerSecond * (double)Size);
+
+	m_First = false;
+
+	// progress, on the console
+	_tprintf_s(_T("%hs %hs threads=%lu size=%lu: %.0f/s\r\n"),
+		Name, Variant, Threads, (ULONG)Size, OperationsPerSecond);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RunProducer
+//
+// One reporting thread.  All producers start together, and report until
+// told to stop.
+/////////////////////////////////////////////////////////////////////////////
+static DWORD WINAPI
+RunProducer(
+	LPVOID	Parameter)
+{
+	ProducerContext*	Context		= (ProducerContext*)Parameter;
+	LONGLONG			Operations	= 0;
+
+	WaitForSingleObject(Context->StartEvent, INFINITE);
+
+	while (0 == *Context->Stop)
+	{
+		if (NULL != Context->WideMessage)
+		{
+			Context->Target->Report(Context->WideMessage, Context->Length);
+		}
+		else
+		{
+			Context->Target->Report(Context->NarrowMessage, Context->Length);
+		}
+
+		Operations++;
+	}
+
+	Context->Operations = Operations;
+
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RunReportCase
+/////////////////////////////////////////////////////////////////////////////
+static bool
+RunReportCase(
+	Diagnostics*	Target,
+	const char*		NarrowMessage,
+	const wchar_t*	WideMessage,
+	size_t			Length,
+	DWORD			ThreadCount,
+	DWORD			Milliseconds,
+	LONGLONG*		Operations,
+	ULONGLONG*		Microseconds)
+{
+	bool				ReturnCode	= false;
+	ProducerContext		Contexts[MAXIMUM_WAIT_OBJECTS];
+	HANDLE				Threads[MAXIMUM_WAIT_OBJECTS];
+	DWORD				Started		= 0;
+	volatile LONG		Stop		= 0;
+	HANDLE				StartEvent	= CreateEvent(NULL, TRUE, FALSE, NULL);
+
+	if (NULL != StartEvent)
+	{
+		for (Started = 0; Started < ThreadCount; Started++)
+		{
+			Contexts[Started].Target		= Target;
+			Contexts[Started].NarrowMessage	= NarrowMessage;
+			Contexts[Started].WideMessage	= WideMessage;
+			Contexts[Started].Length		= Length;
+			Contexts[Started].StartEvent	= StartEvent;
+			Contexts[Started].Stop			= &Stop;
+			Contexts[Started].Operations	= 0;
+
+			Threads[Started] = CreateThread(NULL, 0, RunProducer, &Contexts[Started], 0, NULL);
+
+			if (NULL == Threads[Started])
+			{
+				break;
+			}
+		}
+
+		LONGLONG	StartCount	= GetPerformanceCount();
+
+		SetEvent(StartEvent);
+		Sleep(Milliseconds);
+		InterlockedExchange(&Stop, 1);
+
+		WaitForMultipleObjects(Started, Threads, TRUE, INFINITE);
+		*Microseconds	= GetElapsedMicroseconds(StartCount, GetPerformanceCount());
+		*Operations		= 0;
+
+		for (DWORD Index = 0; Index < Started; Index++)
+		{
+			*Operations += Contexts[Index].Operations;
+			CloseHandle(Threads[Index]);
+		}
+
+		CloseHandle(StartEvent);
+
+		ReturnCode = (Started == ThreadCount);
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RunReportBenchmarks
+//
+// Every sink, thread count, message size and input width.
+/////////////////////////////////////////////////////////////////////////////
+static void
+RunReportBenchmarks(
+	ResultsWriter*	Results,
+	DWORD			Milliseconds)
+{
+	static const char*	SinkNames[]	= { "file", "console", "null" };
+	const size_t		MaximumSize	= g_MessageSizes[_countof(g_MessageSizes) - 1];
+	wchar_t*			WideMessage		= new wchar_t[MaximumSize + 1];
+	char*				NarrowMessage	= new char[MaximumSize + 1];
+	TCHAR				LogFileName[]	= BENCHMARK_LOG_FILE;
+	TCHAR				Version[]		= _T("Benchmarks");
+	TCHAR*				LogFilePath		= GetUserDataPath(LogFileName);
+	NullSink			DiscardSink;
+
+	if ((NULL != WideMessage) && (NULL != NarrowMessage))
+	{
+
+		FillText(WideMessage, MaximumSize);
+
+		// narrow input is plain ASCII
+		for (size_t Index = 0; Index < MaximumSize; Index++)
+		{
+			NarrowMessage[Index] = (char)('a' + Index % 26);
+		}
+
+		NarrowMessage[MaximumSize] = '\0';
+
+		for (size_t Sink = 0; Sink < _countof(SinkNames); Sink++)
+		{
+			Diagnostics	Target(LogFileName, Version);
+
+			switch (Sink)
+			{
+				case 0:
+				{
+					Target.SetDiagnosticOutput(DIAGNOSTICS_LOGFILE);
+					break;
+				}
+				case 1:
+				{
+					Target.SetDiagnosticOutput(DIAGNOSTICS_CONSOLE);
+					break;
+				}
+				default:
+				{
+					Target.SetDiagnosticOutput(DIAGNOSTICS_NONE);
+					Target.SetStructuredSink(&DiscardSink);
+					break;
+				}
+			}
+
+			for (size_t Threads = 0; Threads < _countof(g_ThreadCounts); Threads++)
+			{
+				for (size_t Size = 0; Size < _countof(g_MessageSizes); Size++)
+				{
+					for (int Wide = 0; Wide < 2; Wide++)
+					{
+						LONGLONG	Operations		= 0;
+						ULONGLONG	Microseconds	= 0;
+						char		Variant[32];
+
+						sprintf_s(Variant, "%s_%s", SinkNames[Sink],
+							(1 == Wide) ? "wide" : "narrow");
+
+						if (true == RunReportCase(&Target,
+								NarrowMessage,
+								(1 == Wide) ? WideMessage : NULL,
+								g_MessageSizes[Size],
+								g_ThreadCounts[Threads],
+								Milliseconds,
+								&Operations,
+								&Microseconds))
+						{
+							Results->Write("report", Variant, g_ThreadCounts[Threads],
+								g_MessageSizes[Size], Operations, Microseconds);
+						}
+
+						// keep the log from growing across cases
+						if (NULL != LogFilePath)
+						{
+							DeleteFile(LogFilePath);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	delete[] WideMessage;
+	delete[] NarrowMessage;
+
+	if (NULL != LogFilePath)
+	{
+		delete[] LogFilePath;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Micro benchmark operations
+/////////////////////////////////////////////////////////////////////////////
+static void
+RunConcatStrings(
+	void*	Parameter)
+{
+	ConcatContext*	Context	= (ConcatContext*)Parameter;
+	TCHAR*			Result	= ConcatStringsV(Context->Parts[0],
+								Context->Parts[1],
+								Context->Parts[2],
+								NULL);
+
+	delete[] Result;
+}
+
+static void
+RunConvertToMultiByte(
+	void*	Parameter)
+{
+	ConvertContext*	Context	= (ConvertContext*)Parameter;
+
+	ConvertUnicodeToMultiByte(Context->CodePage,
+		Context->Unicode,
+		Context->UnicodeLength,
+		Context->MultiByte,
+		Context->MultiByteSize,
+		NULL);
+}
+
+static void
+RunConvertToUnicode(
+	void*	Parameter)
+{
+	ConvertContext*	Context	= (ConvertContext*)Parameter;
+
+	ConvertMultiByteToUnicode(Context->CodePage,
+		Context->MultiByte,
+		Context->MultiByteLength,
+		Context->UnicodeBuffer,
+		Context->UnicodeLength + 1,
+		NULL);
+}
+
+static void
+RunAppend(
+	void*	Parameter)
+{
+	AppendContext*	Context	= (AppendContext*)Parameter;
+
+	Context->File->Append(Context->Contents, Context->Length);
+}
+
+static void
+RunIsEmailValid(
+	void*	Parameter)
+{
+	EmailContext*	Context	= (EmailContext*)Parameter;
+
+	Context->Valid	= IsEmailValid(g_EmailAddresses[Context->Next]);
+	Context->Next	= (Context->Next + 1) % _countof(g_EmailAddresses);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RunMicroBenchmarks
+/////////////////////////////////////////////////////////////////////////////
+static void
+RunMicroBenchmarks(
+	ResultsWriter*	Results,
+	DWORD			Milliseconds)
+{
+	LONGLONG	Operations		= 0;
+	ULONGLONG	Microseconds	= 0;
+
+	for (size_t Size = 0; Size < _countof(g_MessageSizes); Size++)
+	{
+		size_t	Length	= g_MessageSizes[Size];
+
+		// ConcatStringsV, three parts making up Length characters
+		ConcatContext	Concat;
+		size_t			PartLength	= Length / 3;
+
+		for (int Part = 0; Part < 3; Part++)
+		{
+			Concat.Parts[Part] = new TCHAR[PartLength + 1];
+
+			if (NULL != Concat.Parts[Part])
+			{
+				FillText(Concat.Parts[Part], PartLength);
+			}
+		}
+
+		if ((NULL != Concat.Parts[0]) && (NULL != Concat.Parts[1]) &&
+			(NULL != Concat.Parts[2]))
+		{
+			RunForDuration(RunConcatStrings, &Concat, Milliseconds, &Operations, &Microseconds);
+			Results->Write("concat_strings_v", "three_parts", 1, Length * sizeof(TCHAR),
+				Operations, Microseconds);
+		}
+
+		for (int Part = 0; Part < 3; Part++)
+		{
+			delete[] Concat.Parts[Part];
+		}
+
+		// code page conversions, both ways
+		for (size_t CodePage = 0; CodePage < _countof(g_CodePages); CodePage++)
+		{
+			ConvertContext	Convert;
+			char			Variant[32];
+
+			sprintf_s(Variant, "cp%lu", g_CodePages[CodePage]);
+
+			Convert.CodePage		= g_CodePages[CodePage];
+			Convert.UnicodeLength	= Length;
+			Convert.Unicode			= new wchar_t[Length + 1];
+			Convert.UnicodeBuffer	= new wchar_t[Length + 1];
+			Convert.MultiByteSize	= GetMultiByteBound(Convert.CodePage, Length);
+			Convert.MultiByte		= new char[Convert.MultiByteSize];
+
+			if ((NULL != Convert.Unicode) && (NULL != Convert.UnicodeBuffer) &&
+				(NULL != Convert.MultiByte))
+			{
+				FillText(Convert.Unicode, Length);
+
+				Convert.MultiByteLength = ConvertUnicodeToMultiByte(Convert.CodePage,
+					Convert.Unicode,
+					Length,
+					Convert.MultiByte,
+					Convert.MultiByteSize,
+					NULL);
+
+				RunForDuration(RunConvertToMultiByte, &Convert, Milliseconds,
+					&Operations, &Microseconds);
+				Results->Write("convert_unicode_to_multibyte", Variant, 1,
+					Length * sizeof(wchar_t), Operations, Microseconds);
+
+				RunForDuration(RunConvertToUnicode, &Convert, Milliseconds,
+					&Operations, &Microseconds);
+				Results->Write("convert_multibyte_to_unicode", Variant, 1,
+					Convert.MultiByteLength, Operations, Microseconds);
+			}
+
+			delete[] Convert.Unicode;
+			delete[] Convert.UnicodeBuffer;
+			delete[] Convert.MultiByte;
+		}
+
+		// FileWrapper::Append, to a file in the temp directory
+		LPCTSTR	AppendPath	= GetFileNameTempPath(BENCHMARK_APPEND_FILE);
+
+		if (NULL != AppendPath)
+		{
+			FileWrapper		File(AppendPath);
+			AppendContext	Append;
+
+			Append.File		= &File;
+			Append.Length	= (DWORD)Length;
+			Append.Contents	= new BYTE[Length];
+
+			if (NULL != Append.Contents)
+			{
+				memset(Append.Contents, 'x', Length);
+
+				RunForDuration(RunAppend, &Append, Milliseconds, &Operations, &Microseconds);
+				Results->Write("file_wrapper_append", "temp_file", 1, Length,
+					Operations, Microseconds);
+
+				delete[] Append.Contents;
+			}
+
+			DeleteFile(AppendPath);
+			delete[] (TCHAR*)AppendPath;
+		}
+	}
+
+	EmailContext	Email;
+
+	Email.Next	= 0;
+	Email.Valid	= false;
+
+	RunForDuration(RunIsEmailValid, &Email, Milliseconds, &Operations, &Microseconds);
+	Results->Write("is_email_valid", "mixed", 1, 0, Operations, Microseconds);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RunThroughputBenchmarks
+/////////////////////////////////////////////////////////////////////////////
+static int
+RunThroughputBenchmarks(
+	LPCTSTR	ResultsPath,
+	DWORD	CaseMilliseconds)
+{
+	int		ReturnCode	= 1;
+	FILE*	ResultsFile	= NULL;
+
+	if ((0 == _tfopen_s(&ResultsFile, ResultsPath, _T("w"))) && (NULL != ResultsFile))
+	{
+		{
+			ResultsWriter	Results(ResultsFile, CaseMilliseconds);
+
+			RunMicroBenchmarks(&Results, CaseMilliseconds);
+			RunReportBenchmarks(&Results, CaseMilliseconds);
+		}
+
+		fclose(ResultsFile);
+		ReturnCode = 0;
+	}
+	else
+	{
+		_tprintf_s(_T("Could not open %s\r\n"), ResultsPath);
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// _tmain
+/////////////////////////////////////////////////////////////////////////////
+int
+_tmain(
+	int		ArgumentCount,
+	TCHAR*	Arguments[])
+{
+	int		ReturnCode			= 1;
+	LPCTSTR	ResultsPath			= DEFAULT_RESULTS_FILE;
+	DWORD	CaseMilliseconds	= DEFAULT_CASE_MILLISECONDS;
+
+	if ((1 < ArgumentCount) && (0 == _tcsicmp(Arguments[1], _T("-latency"))))
+	{
+		ReturnCode = RunLatencyHarness(ArgumentCount - 1, Arguments + 1);
+	}
+	else
+	{
+		if (1 < ArgumentCount)
+		{
+			ResultsPath = Arguments[1];
+		}
+
+		if ((2 < ArgumentCount) && (0 < _ttoi(Arguments[2])))
+		{
+			CaseMilliseconds = (DWORD)_ttoi(Arguments[2]);
+		}
+
+		ReturnCode = RunThroughputBenchmarks(ResultsPath, CaseMilliseconds);
+	}
+
+	return ReturnCode;
+}
@@ -0,0 +1,490 @@
+/////////////////////////////////////////////////////////////////////////////
+// LatencyHarness.cpp
+//
+// Tail latency of Diagnostics::Report under contention.
+//
+// Each producer thread calls Report on a fixed schedule.  Latency is
+// measured from when a call was due, not from when it actually started,
+// so a stall also counts against the calls it held back (coordinated
+// omission correction).  The uncorrected figures are written alongside
+// for comparison.
+//
+// Every scenario runs the same load while something gets in the way of
+// the log writes:
+//	steady		nothing
+//	flush		another thread keeps flushing the log file to disk
+//	rotate		another thread keeps renaming the log file away
+//	slow_disk	records go to a sink throttled to a slow disk's speed
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "LatencyHarness.h"
+#include "../DiagnosticsLibrary/Diagnostics.h"
+#include "../DiagnosticsLibrary/Metrics.h"
+#include "../DiagnosticsLibrary/RecordFields.h"
+#include "../Utils/Utils.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+#define DEFAULT_RESULTS_FILE		_T("Latency.json")
+#define DEFAULT_THREADS				16
+#define DEFAULT_CALLS_PER_SECOND	1000
+#define DEFAULT_SECONDS				5
+#define LATENCY_LOG_FILE			_T("\\DiagnosticsLatency.log")
+#define SLOW_DISK_FILE				_T("DiagnosticsSlowDisk.log")
+#define LATENCY_MESSAGE_SIZE		200
+// a small, slow device
+#define SLOW_DISK_BYTES_PER_SECOND	(512 * 1024)
+#define FLUSH_INTERVAL				20
+#define ROTATE_INTERVAL				100
+
+enum Scenario
+{
+	ScenarioSteady,
+	ScenarioFlush,
+	ScenarioRotate,
+	ScenarioSlowDisk
+};
+
+static const char*	g_ScenarioNames[]	= { "steady", "flush", "rotate", "slow_disk" };
+
+/////////////////////////////////////////////////////////////////////////////
+// Class: SlowDiskSink
+//
+// Stands in for a slow disk.  Records are written to a local file one at
+// a time, and each write holds the device for as long as its bytes would
+// take at SLOW_DISK_BYTES_PER_SECOND.
+/////////////////////////////////////////////////////////////////////////////
+class SlowDiskSink : public StructuredSink
+{
+	public:
+		// Methods
+			SlowDiskSink(
+				LPCTSTR	FilePath);
+			virtual ~SlowDiskSink(void);
+
+			virtual void WriteRecord(
+				LPCTSTR		Message,
+				size_t		MessageLength,
+				const BYTE*	Fields,
+				size_t		FieldsSize);
+
+	private:
+		// Properties
+			CRITICAL_SECTION	m_Lock;
+			HANDLE				m_File;
+			// device time owed, not yet slept off
+			ULONGLONG			m_Debt;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Harness types
+/////////////////////////////////////////////////////////////////////////////
+struct LatencyContext
+{
+	Diagnostics*		Target;
+	LPCTSTR				Message;
+	size_t				MessageLength;
+	LONGLONG			IntervalCounts;
+	LONGLONG			StartCount;
+	LONGLONG			EndCount;
+	MetricHistogram*	Corrected;
+	MetricHistogram*	Uncorrected;
+};
+
+struct DisturberContext
+{
+	Scenario	Type;
+	LPCTSTR		LogFilePath;
+	LPCTSTR		RotatedPath;
+	HANDLE		StopEvent;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// SlowDiskSink Class Definition
+/////////////////////////////////////////////////////////////////////////////
+SlowDiskSink::SlowDiskSink(
+	LPCTSTR	FilePath) :
+		m_File(INVALID_HANDLE_VALUE),
+		m_Debt(0)
+{
+	InitializeCriticalSection(&m_Lock);
+
+	m_File = CreateFile(FilePath,
+				GENERIC_WRITE,
+				FILE_SHARE_READ,
+				NULL,
+				CREATE_ALWAYS,
+				FILE_FLAG_DELETE_ON_CLOSE,
+				NULL);
+}
+
+SlowDiskSink::~SlowDiskSink(void)
+{
+	if (INVALID_HANDLE_VALUE != m_File)
+	{
+		CloseHandle(m_File);
+		m_File = INVALID_HANDLE_VALUE;
+	}
+
+	DeleteCriticalSection(&m_Lock);
+}
+
+void
+SlowDiskSink::WriteRecord(
+	LPCTSTR		Message,
+	size_t		MessageLength,
+	const BYTE*	Fields,
+	size_t		FieldsSize)
+{
+	DWORD	BytesWritten	= 0;
+	DWORD	Size			= (DWORD)(MessageLength * sizeof(TCHAR));
+
+	EnterCriticalSection(&m_Lock);
+
+	if (INVALID_HANDLE_VALUE != m_File)
+	{
+		WriteFile(m_File, Message, Size, &BytesWritten, NULL);
+	}
+
+	m_Debt += (ULONGLONG)Size * 1000000 / SLOW_DISK_BYTES_PER_SECOND;
+
+	// Sleep only has millisecond resolution, so the debt is paid in whole
+	// milliseconds, still holding the device
+	if (1000 <= m_Debt)
+	{
+		DWORD	Milliseconds	= (DWORD)(m_Debt / 1000);
+
+		Sleep(Milliseconds);
+		m_Debt -= (ULONGLONG)Milliseconds * 1000;
+	}
+
+	LeaveCriticalSection(&m_Lock);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RunLatencyProducer
+//
+// Calls Report on schedule until the end time.  A thread that falls
+// behind calls back to back until it catches up, as a real caller
+// with queued work would.
+/////////////////////////////////////////////////////////////////////////////
+static DWORD WINAPI
+RunLatencyProducer(
+	LPVOID	Parameter)
+{
+	LatencyContext*	Context		= (LatencyContext*)Parameter;
+	LONGLONG		DueCount	= Context->StartCount;
+
+	while (DueCount < Context->EndCount)
+	{
+		LONGLONG	Now	= GetPerformanceCount();
+
+		// wait for the due time, sleeping only when far from it
+		while (Now < DueCount)
+		{
+			if (2000 < GetElapsedMicroseconds(Now, DueCount))
+			{
+				Sleep(1);
+			}
+			else
+			{
+				SwitchToThread();
+			}
+
+			Now = GetPerformanceCount();
+		}
+
+		Context->Target->Report(Context->Message, Context->MessageLength);
+
+		LONGLONG	EndCount	= GetPerformanceCount();
+
+		Context->Corrected->Record((LONGLONG)GetElapsedMicroseconds(DueCount, EndCount));
+		Context->Uncorrected->Record((LONGLONG)GetElapsedMicroseconds(Now, EndCount));
+
+		DueCount += Context->IntervalCounts;
+	}
+
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RunDisturber
+//
+// Gets in the way of the log writes, until stopped.
+/////////////////////////////////////////////////////////////////////////////
+static DWORD WINAPI
+RunDisturber(
+	LPVOID	Parameter)
+{
+	DisturberContext*	Context		= (DisturberContext*)Parameter;
+	DWORD				Interval	= FLUSH_INTERVAL;
+
+	if (ScenarioRotate == Context->Type)
+	{
+		Interval = ROTATE_INTERVAL;
+	}
+
+	while (WAIT_TIMEOUT == WaitForSingleObject(Context->StopEvent, Interval))
+	{
+		if (ScenarioFlush == Context->Type)
+		{
+			HANDLE	File	= CreateFile(Context->LogFilePath,
+								GENERIC_WRITE,
+								FILE_SHARE_READ | FILE_SHARE_WRITE,
+								NULL,
+								OPEN_EXISTING,
+								0,
+								NULL);
+
+			if (INVALID_HANDLE_VALUE != File)
+			{
+				FlushFileBuffers(File);
+				CloseHandle(File);
+			}
+		}
+		else if (ScenarioRotate == Context->Type)
+		{
+			// fails, and is retried, while a write has the file open
+			MoveFileEx(Context->LogFilePath, Context->RotatedPath,
+				MOVEFILE_REPLACE_EXISTING);
+		}
+	}
+
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// WriteHistogram
+/////////////////////////////////////////////////////////////////////////////
+static void
+WriteHistogram(
+	FILE*				File,
+	const char*			Name,
+	MetricHistogram*	Histogram)
+{
+	fprintf(File, "\"%s\": {\"count\": %I64d, \"p50_us\": %I64d, \"p99_us\": %I64d, "
+		"\"p999_us\": %I64d, \"max_us\": %I64d}",
+		Name,
+		Histogram->GetCount(),
+		Histogram->GetPercentile(50.0),
+		Histogram->GetPercentile(99.0),
+		Histogram->GetPercentile(99.9),
+		Histogram->GetMaximum());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RunScenario
+/////////////////////////////////////////////////////////////////////////////
+static bool
+RunScenario(
+	Scenario	Type,
+	DWORD		ThreadCount,
+	DWORD		CallsPerSecond,
+	DWORD		Seconds,
+	FILE*		ResultsFile,
+	bool		First)
+{
+	bool				ReturnCode		= false;
+	TCHAR				LogFileName[]	= LATENCY_LOG_FILE;
+	TCHAR				Version[]		= _T("Latency");
+	TCHAR*				LogFilePath		= GetUserDataPath(LogFileName);
+	TCHAR*				RotatedPath		= NULL;
+	LPCTSTR				SlowDiskPath	= GetFileNameTempPath(SLOW_DISK_FILE);
+	TCHAR				Message[LATENCY_MESSAGE_SIZE + 1];
+	LatencyContext		Contexts[MAXIMUM_WAIT_OBJECTS];
+	HANDLE				Threads[MAXIMUM_WAIT_OBJECTS];
+	DWORD				Started			= 0;
+	LARGE_INTEGER		Frequency;
+	InternedString		Name(_T("latency"));
+	MetricHistogram		Corrected(Name);
+	MetricHistogram		Uncorrected(Name);
+
+	for (size_t Index = 0; Index < LATENCY_MESSAGE_SIZE; Index++)
+	{
+		Message[Index] = (TCHAR)(_T('a') + Index % 26);
+	}
+
+	Message[LATENCY_MESSAGE_SIZE] = _T('\0');
+
+	if ((NULL != LogFilePath) && (NULL != SlowDiskPath) &&
+		(FALSE != QueryPerformanceFrequency(&Frequency)))
+	{
+		// the sink outlives the Diagnostics object that uses it
+		SlowDiskSink	SlowDisk(SlowDiskPath);
+		Diagnostics		Target(LogFileName, Version);
+
+		RotatedPath = ConcatStrings(LogFilePath, _T(".1"));
+
+		if (ScenarioSlowDisk == Type)
+		{
+			Target.SetDiagnosticOutput(DIAGNOSTICS_NONE);
+			Target.SetStructuredSink(&SlowDisk);
+		}
+		else
+		{
+			Target.SetDiagnosticOutput(DIAGNOSTICS_LOGFILE);
+		}
+
+		DisturberContext	Disturber;
+		HANDLE				DisturberThread	= NULL;
+
+		Disturber.Type			= Type;
+		Disturber.LogFilePath	= LogFilePath;
+		Disturber.RotatedPath	= RotatedPath;
+		Disturber.StopEvent		= CreateEvent(NULL, TRUE, FALSE, NULL);
+
+		if ((NULL != Disturber.StopEvent) && (NULL != RotatedPath) &&
+			((ScenarioFlush == Type) || (ScenarioRotate == Type)))
+		{
+			DisturberThread = CreateThread(NULL, 0, RunDisturber, &Disturber, 0, NULL);
+		}
+
+		// every thread starts on the same schedule, a little from now
+		LONGLONG	StartCount	= GetPerformanceCount() + Frequency.QuadPart / 10;
+
+		for (Started = 0; Started < ThreadCount; Started++)
+		{
+			Contexts[Started].Target			= &Target;
+			Contexts[Started].Message			= Message;
+			Contexts[Started].MessageLength		= LATENCY_MESSAGE_SIZE;
+			Contexts[Started].IntervalCounts	= Frequency.QuadPart / CallsPerSecond;
+			Contexts[Started].StartCount		= StartCount;
+			Contexts[Started].EndCount			= StartCount + Frequency.QuadPart * Seconds;
+			Contexts[Started].Corrected			= &Corrected;
+			Contexts[Started].Uncorrected		= &Uncorrected;
+
+			Threads[Started] = CreateThread(NULL, 0, RunLatencyProducer,
+				&Contexts[Started], 0, NULL);
+
+			if (NULL == Threads[Started])
+			{
+				break;
+			}
+		}
+
+		WaitForMultipleObjects(Started, Threads, TRUE, INFINITE);
+
+		for (DWORD Index = 0; Index < Started; Index++)
+		{
+			CloseHandle(Threads[Index]);
+		}
+
+		if (NULL != DisturberThread)
+		{
+			SetEvent(Disturber.StopEvent);
+			WaitForSingleObject(DisturberThread, INFINITE);
+			CloseHandle(DisturberThread);
+		}
+
+		if (NULL != Disturber.StopEvent)
+		{
+			CloseHandle(Disturber.StopEvent);
+		}
+
+		fprintf(ResultsFile, "%s\n    {\"scenario\": \"%s\", \"threads\": %lu, "
+			"\"calls_per_second\": %lu, \"seconds\": %lu, ",
+			(true == First) ? "" : ",",
+			g_ScenarioNames[Type],
+			Started,
+			CallsPerSecond,
+			Seconds);
+		WriteHistogram(ResultsFile, "corrected", &Corrected);
+		fprintf(ResultsFile, ", ");
+		WriteHistogram(ResultsFile, "uncorrected", &Uncorrected);
+		fprintf(ResultsFile, "}");
+
+		_tprintf_s(_T("%hs: p50=%I64dus p99=%I64dus p99.9=%I64dus max=%I64dus\r\n"),
+			g_ScenarioNames[Type],
+			Corrected.GetPercentile(50.0),
+			Corrected.GetPercentile(99.0),
+			Corrected.GetPercentile(99.9),
+			Corrected.GetMaximum());
+
+		ReturnCode = (Started == ThreadCount);
+	}
+
+	if (NULL != LogFilePath)
+	{
+		DeleteFile(LogFilePath);
+		delete[] LogFilePath;
+	}
+
+	if (NULL != RotatedPath)
+	{
+		DeleteFile(RotatedPath);
+		delete[] RotatedPath;
+	}
+
+	if (NULL != SlowDiskPath)
+	{
+		delete[] (TCHAR*)SlowDiskPath;
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RunLatencyHarness
+/////////////////////////////////////////////////////////////////////////////
+int
+RunLatencyHarness(
+	int		ArgumentCount,
+	TCHAR*	Arguments[])
+{
+	int		ReturnCode		= 1;
+	LPCTSTR	ResultsPath		= DEFAULT_RESULTS_FILE;
+	DWORD	ThreadCount		= DEFAULT_THREADS;
+	DWORD	CallsPerSecond	= DEFAULT_CALLS_PER_SECOND;
+	DWORD	Seconds			= DEFAULT_SECONDS;
+	FILE*	ResultsFile		= NULL;
+
+	if (1 < ArgumentCount)
+	{
+		ResultsPath = Arguments[1];
+	}
+
+	if ((2 < ArgumentCount) && (0 < _ttoi(Arguments[2])))
+	{
+		ThreadCount = min((DWORD)_ttoi(Arguments[2]), (DWORD)MAXIMUM_WAIT_OBJECTS);
+	}
+
+	if ((3 < ArgumentCount) && (0 < _ttoi(Arguments[3])))
+	{
+		CallsPerSecond = (DWORD)_ttoi(Arguments[3]);
+	}
+
+	if ((4 < ArgumentCount) && (0 < _ttoi(Arguments[4])))
+	{
+		Seconds = (DWORD)_ttoi(Arguments[4]);
+	}
+
+	if ((0 == _tfopen_s(&ResultsFile, ResultsPath, _T("w"))) && (NULL != ResultsFile))
+	{
+		fprintf(ResultsFile, "{\n  \"results\": [");
+
+		for (int Type = ScenarioSteady; Type <= ScenarioSlowDisk; Type++)
+		{
+			RunScenario((Scenario)Type, ThreadCount, CallsPerSecond, Seconds,
+				ResultsFile, (ScenarioSteady == Type));
+		}
+
+		fprintf(ResultsFile, "\n  ]\n}\n");
+		fclose(ResultsFile);
+
+		ReturnCode = 0;
+	}
+	else
+	{
+		_tprintf_s(_T("Could not open %s\r\n"), ResultsPath);
+	}
+
+	return ReturnCode;
+}
@@ -0,0 +1,20 @@
+/////////////////////////////////////////////////////////////////////////////
+// LatencyHarness.h
+//
+// Tail latency of Diagnostics::Report under contention.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// RunLatencyHarness
+//
+// Arguments: -latency [ResultsFile [Threads [CallsPerSecond [Seconds]]]]
+// Returns the process exit code.
+/////////////////////////////////////////////////////////////////////////////
+int
+RunLatencyHarness(
+	int		ArgumentCount,
+	TCHAR*	Arguments[]);
@@ -0,0 +1,11 @@
+/////////////////////////////////////////////////////////////////////////////
+// stdafx.cpp
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+// stdafx.cpp : source file that includes just the standard includes
+// Benchmarks.pch will be the pre-compiled header
+// stdafx.obj will contain the pre-compiled type information
+
+#include "stdafx.h"
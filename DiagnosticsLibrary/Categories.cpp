@@ -0,0 +1,205 @@
+///////////////////////////////////////////////////////////////////////
+// Categories.cpp - Class Implementation
+//
+// Process wide table of report categories, each a small integer id.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "Categories.h"
+
+///////////////////////////////////////////////////////////////////////
+// Class: CategoryNames
+//
+// The storage behind CategoryTable.  Names are compared as interned
+// strings, so a lookup compares pointers, not characters.  Names are
+// only ever appended, each written before the count that covers it is
+// raised, so lookups read the table without the lock; only Register
+// takes it.
+///////////////////////////////////////////////////////////////////////
+class CategoryNames
+{
+	public:
+		// Methods
+			CategoryNames(void);
+			~CategoryNames(void);
+
+			int Find(
+				const InternedString&	Name);
+			int Find(
+				LPCTSTR	Name,
+				size_t	Length);
+			InternedString GetName(
+				int	CategoryId);
+			int Register(
+				const InternedString&	Name);
+
+	private:
+		// Properties
+			CRITICAL_SECTION	m_Lock;
+			InternedString		m_Names[DIAGNOSTICS_CATEGORIES];
+			volatile LONG		m_Count;
+};
+
+static CategoryNames g_CategoryNames;
+
+///////////////////////////////////////////////////////////////////////
+// CategoryNames Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Ctors / Dtors
+///////////////////////////////////////////////////////////////////////
+CategoryNames::CategoryNames(void) :
+	// id 0 is DIAGNOSTICS_CATEGORY_NONE
+	m_Count(1)
+{
+	InitializeCriticalSection(&m_Lock);
+}
+
+CategoryNames::~CategoryNames(void)
+{
+	DeleteCriticalSection(&m_Lock);
+}
+
+int
+CategoryNames::Find(
+	const InternedString&	Name)
+{
+	int	CategoryId	= DIAGNOSTICS_CATEGORY_NONE;
+	int	Count		= m_Count;
+
+	for (int Index = DIAGNOSTICS_CATEGORY_NONE + 1; Index < Count; Index++)
+	{
+		if (Name == m_Names[Index])
+		{
+			CategoryId = Index;
+			break;
+		}
+	}
+
+	return CategoryId;
+}
+
+int
+CategoryNames::Find(
+	LPCTSTR	Name,
+	size_t	Length)
+{
+	int	CategoryId	= DIAGNOSTICS_CATEGORY_NONE;
+	int	Count		= m_Count;
+
+	for (int Index = DIAGNOSTICS_CATEGORY_NONE + 1; Index < Count; Index++)
+	{
+		if ((Length == m_Names[Index].GetLength()) &&
+			(0 == memcmp(Name, m_Names[Index].GetString(),
+				Length * sizeof(TCHAR))))
+		{
+			CategoryId = Index;
+			break;
+		}
+	}
+
+	return CategoryId;
+}
+
+InternedString
+CategoryNames::GetName(
+	int	CategoryId)
+{
+	InternedString	Name;
+
+	if ((DIAGNOSTICS_CATEGORY_NONE < CategoryId) && (CategoryId < m_Count))
+	{
+		Name = m_Names[CategoryId];
+	}
+
+	return Name;
+}
+
+int
+CategoryNames::Register(
+	const InternedString&	Name)
+{
+	int	CategoryId	= DIAGNOSTICS_CATEGORY_NONE;
+
+	if (false == Name.IsEmpty())
+	{
+		EnterCriticalSection(&m_Lock);
+
+		CategoryId = Find(Name);
+
+		if ((DIAGNOSTICS_CATEGORY_NONE == CategoryId) &&
+			(m_Count < DIAGNOSTICS_CATEGORIES))
+		{
+			CategoryId			= m_Count;
+			m_Names[m_Count]	= Name;
+
+			// publishes the name, which is written first
+			InterlockedIncrement(&m_Count);
+		}
+
+		LeaveCriticalSection(&m_Lock);
+	}
+
+	return CategoryId;
+}
+
+///////////////////////////////////////////////////////////////////////
+// CategoryTable Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Find
+//
+// Returns DIAGNOSTICS_CATEGORY_NONE if the name was never registered.
+///////////////////////////////////////////////////////////////////////
+int
+CategoryTable::Find(
+	const InternedString&	Name)
+{
+	return g_CategoryNames.Find(Name);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Find
+//
+// As above, but compares the characters, so the name need not be
+// interned first.
+///////////////////////////////////////////////////////////////////////
+int
+CategoryTable::Find(
+	LPCTSTR	Name,
+	size_t	Length)
+{
+	return g_CategoryNames.Find(Name, Length);
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetName
+//
+// Empty for DIAGNOSTICS_CATEGORY_NONE and unknown ids.
+///////////////////////////////////////////////////////////////////////
+InternedString
+CategoryTable::GetName(
+	int	CategoryId)
+{
+	return g_CategoryNames.GetName(CategoryId);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Register
+//
+// Returns the name's id, adding it if it is new.  Returns
+// DIAGNOSTICS_CATEGORY_NONE for an empty name, or once all
+// DIAGNOSTICS_CATEGORIES ids are taken.
+///////////////////////////////////////////////////////////////////////
+int
+CategoryTable::Register(
+	const InternedString&	Name)
+{
+	return g_CategoryNames.Register(Name);
+}
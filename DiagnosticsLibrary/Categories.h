@@ -0,0 +1,48 @@
+///////////////////////////////////////////////////////////////////////
+// Categories.h
+//
+// Process wide table of report categories, each a small integer id.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "../Include/common.h"
+#include "../Utils/InternedString.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+const int DIAGNOSTICS_CATEGORIES		= 256;
+
+// reports in no category, or in one the table had no room for
+const int DIAGNOSTICS_CATEGORY_NONE		= 0;
+
+// the category level that defers to the output level
+const int DIAGNOSTICS_CATEGORY_DEFAULT	= -1;
+
+///////////////////////////////////////////////////////////////////////
+// Class: CategoryTable
+//
+// Names are registered once and never removed, so an id stays valid
+// for the life of the process, and means the same category to every
+// Diagnostics object.  Lookups take no lock.
+///////////////////////////////////////////////////////////////////////
+class DllExport CategoryTable
+{
+	public:
+		// Methods
+			static int Find(
+				const InternedString&	Name);
+			static int Find(
+				LPCTSTR	Name,
+				size_t	Length);
+			static InternedString GetName(
+				int	CategoryId);
+			static int Register(
+				const InternedString&	Name);
+};
@@ -0,0 +1,1107 @@
+///////////////////////////////////////////////////////////////////////
+// ConfigSource.cpp - Class Implementation
+//
+// Where the output levels and log file come from when they are not set
+// in code, and the watching that keeps them current.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include <malloc.h>
+#include <tchar.h>
+#include "ConfigSource.h"
+#include "Diagnostics.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+// larger files are not read
+#define CONFIG_FILE_MAXIMUM		(64 * 1024)
+
+struct ConfigLine
+{
+	const char*	Name;
+	size_t		NameLength;
+	const char*	Value;
+	size_t		ValueLength;
+};
+
+struct LevelName
+{
+	const char*	Name;
+	DWORD		Level;
+};
+
+static const LevelName	g_LevelNames[]	=
+{
+	{ "none",		DIAGNOSTICS_NONE },
+	{ "logfile",	DIAGNOSTICS_LOGFILE },
+	{ "popups",		DIAGNOSTICS_POPUPS },
+	{ "console",	DIAGNOSTICS_CONSOLE },
+	{ "eventlog",	DIAGNOSTICS_EVENTLOG }
+};
+
+// the default source, shared by every Diagnostics object that takes
+// its level from the registry
+static CRITICAL_SECTION			g_DefaultLock;
+static bool						g_DefaultLockReady	= false;
+static RegistryConfigSource*	g_DefaultSource		= NULL;
+static LONG						g_DefaultUsers		= 0;
+
+///////////////////////////////////////////////////////////////////////
+// IsConfigSpace
+///////////////////////////////////////////////////////////////////////
+static bool
+IsConfigSpace(
+	char	Character)
+{
+	return (' ' == Character) || ('\t' == Character) ||
+		('\r' == Character) || ('\n' == Character);
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetNextConfigLine
+//
+// Finds the next name=value line from Position on, skipping comments
+// and lines without '='.  Name and value are trimmed, and not
+// terminated.
+///////////////////////////////////////////////////////////////////////
+static bool
+GetNextConfigLine(
+	const char*	Contents,
+	size_t		Size,
+	size_t*		Position,
+	ConfigLine*	Line)
+{
+	bool	ReturnCode	= false;
+
+	while ((false == ReturnCode) && (*Position < Size))
+	{
+		size_t	Start	= *Position;
+		size_t	LineEnd	= Start;
+		size_t	Equals	= Size;
+
+		while ((LineEnd < Size) && ('\n' != Contents[LineEnd]))
+		{
+			if ((Size == Equals) && ('=' == Contents[LineEnd]))
+			{
+				Equals = LineEnd;
+			}
+
+			LineEnd++;
+		}
+
+		*Position = LineEnd + 1;
+
+		while ((Start < LineEnd) && (true == IsConfigSpace(Contents[Start])))
+		{
+			Start++;
+		}
+
+		if ((Start < Equals) && (Equals < LineEnd) &&
+			('#' != Contents[Start]) && (';' != Contents[Start]))
+		{
+			size_t	NameEnd		= Equals;
+			size_t	ValueStart	= Equals + 1;
+			size_t	ValueEnd	= LineEnd;
+
+			while ((Start < NameEnd) && (true == IsConfigSpace(Contents[NameEnd - 1])))
+			{
+				NameEnd--;
+			}
+
+			while ((ValueStart < ValueEnd) && (true == IsConfigSpace(Contents[ValueStart])))
+			{
+				ValueStart++;
+			}
+
+			while ((ValueStart < ValueEnd) && (true == IsConfigSpace(Contents[ValueEnd - 1])))
+			{
+				ValueEnd--;
+			}
+
+			Line->Name			= Contents + Start;
+			Line->NameLength	= NameEnd - Start;
+			Line->Value			= Contents + ValueStart;
+			Line->ValueLength	= ValueEnd - ValueStart;
+			ReturnCode			= true;
+		}
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetConfigString
+//
+// Converts UTF-8 text from the file.
+///////////////////////////////////////////////////////////////////////
+static InternedString
+GetConfigString(
+	const char*	Text,
+	size_t		Length)
+{
+	InternedString	String;
+
+	if (0 < Length)
+	{
+		TCHAR*	Buffer		= new TCHAR[Length];
+
+		if (NULL != Buffer)
+		{
+			int	BufferLength	= MultiByteToWideChar(CP_UTF8,
+										0,
+										Text,
+										(int)Length,
+										Buffer,
+										(int)Length);
+
+			if (0 < BufferLength)
+			{
+				String = InternedString(Buffer, BufferLength);
+			}
+
+			delete[] Buffer;
+		}
+	}
+
+	return String;
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetDirectory
+//
+// delete after use.
+///////////////////////////////////////////////////////////////////////
+static TCHAR*
+GetDirectory(
+	LPCTSTR	FilePath)
+{
+	size_t	Length		= _tcslen(FilePath);
+	size_t	Separator	= Length;
+	TCHAR*	Directory	= NULL;
+
+	while ((0 < Separator) && (_T('\\') != FilePath[Separator - 1]) &&
+		(_T('/') != FilePath[Separator - 1]))
+	{
+		Separator--;
+	}
+
+	if (0 == Separator)
+	{
+		Directory = new TCHAR[2];
+
+		if (NULL != Directory)
+		{
+			_tcscpy_s(Directory, 2, _T("."));
+		}
+	}
+	else
+	{
+		// a root keeps its separator
+		if ((1 < Separator) && (_T(':') != FilePath[Separator - 2]))
+		{
+			Separator--;
+		}
+
+		Directory = new TCHAR[Separator + 1];
+
+		if (NULL != Directory)
+		{
+			memcpy(Directory, FilePath, Separator * sizeof(TCHAR));
+			Directory[Separator] = _T('\0');
+		}
+	}
+
+	return Directory;
+}
+
+///////////////////////////////////////////////////////////////////////
+// ConfigSource Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Ctors / Dtors
+///////////////////////////////////////////////////////////////////////
+ConfigSource::ConfigSource(void) :
+	m_Level(CONFIG_LEVEL_UNSET),
+	m_CategoryCount(0),
+	m_Settings(NULL),
+	m_StopEvent(NULL),
+	m_Thread(NULL),
+	m_Module(NULL),
+	m_References(1)
+{
+	InitializeCriticalSection(&m_Lock);
+
+	for (int Index = 0; Index < DIAGNOSTICS_CATEGORIES; Index++)
+	{
+		m_CategoryLevels[Index] = CONFIG_LEVEL_UNSET;
+	}
+}
+
+ConfigSource::~ConfigSource(void)
+{
+	StopWatching();
+
+	if (NULL != m_Settings)
+	{
+		delete m_Settings;
+		m_Settings = NULL;
+	}
+
+	// left open by Release
+	if (NULL != m_StopEvent)
+	{
+		CloseHandle(m_StopEvent);
+		m_StopEvent = NULL;
+	}
+
+	DeleteCriticalSection(&m_Lock);
+}
+
+///////////////////////////////////////////////////////////////////////
+// BeginRead
+//
+// Returns the current settings, NULL if there are none, which stay
+// valid until EndRead with the same token.  Takes no lock.
+///////////////////////////////////////////////////////////////////////
+const ConfigSettings*
+ConfigSource::BeginRead(
+	int*	Token)
+{
+	*Token = m_Readers.BeginRead();
+
+	return m_Settings;
+}
+
+void
+ConfigSource::EndRead(
+	int	Token)
+{
+	m_Readers.EndRead(Token);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Refresh
+//
+// Reads the backend now.  Returns false if it could not be read.
+///////////////////////////////////////////////////////////////////////
+bool
+ConfigSource::Refresh(void)
+{
+	return Update(false);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Release
+//
+// Frees the source in place of delete, without waiting for the watch
+// thread: the thread is told to stop, and frees the source itself as
+// it exits, then lets go of the module.  So it is safe under the loader
+// lock, as in the destructor of a global in a DLL being unloaded.
+///////////////////////////////////////////////////////////////////////
+void
+ConfigSource::Release(void)
+{
+	HANDLE	Thread	= m_Thread;
+
+	if (NULL != Thread)
+	{
+		m_Thread = NULL;
+
+		SetEvent(m_StopEvent);
+		CloseHandle(Thread);
+	}
+
+	if (0 == InterlockedDecrement(&m_References))
+	{
+		delete this;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// StartWatching
+//
+// Reads the backend, then again on every change, on a thread of its
+// own, until StopWatching.
+///////////////////////////////////////////////////////////////////////
+bool
+ConfigSource::StartWatching(void)
+{
+	bool	ReturnCode	= false;
+
+	if (NULL == m_Thread)
+	{
+		m_StopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+		if (NULL != m_StopEvent)
+		{
+			// the thread keeps the module loaded until it has exited, so
+			// it can outlive its owner; without a reference it still runs,
+			// but must be stopped before the module is unloaded
+			if (FALSE == GetModuleHandleEx(
+				GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (LPCTSTR)Run,
+				&m_Module))
+			{
+				m_Module = NULL;
+			}
+
+			InterlockedIncrement(&m_References);
+
+			m_Thread = CreateThread(NULL, 0, Run, this, 0, NULL);
+
+			if (NULL != m_Thread)
+			{
+				ReturnCode = true;
+			}
+			else
+			{
+				InterlockedDecrement(&m_References);
+
+				if (NULL != m_Module)
+				{
+					FreeLibrary(m_Module);
+					m_Module = NULL;
+				}
+
+				CloseHandle(m_StopEvent);
+				m_StopEvent = NULL;
+			}
+		}
+	}
+
+	return ReturnCode;
+}
+
+void
+ConfigSource::StopWatching(void)
+{
+	if (NULL != m_Thread)
+	{
+		SetEvent(m_StopEvent);
+		WaitForSingleObject(m_Thread, INFINITE);
+
+		CloseHandle(m_Thread);
+		m_Thread = NULL;
+
+		CloseHandle(m_StopEvent);
+		m_StopEvent = NULL;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// operator new
+//
+// Cache line aligned, for m_Readers; derived sources inherit it.
+///////////////////////////////////////////////////////////////////////
+void*
+ConfigSource::operator new(
+	size_t	Size) throw()
+{
+	return _aligned_malloc(Size, RCU_CACHE_LINE);
+}
+
+void
+ConfigSource::operator delete(
+	void*	Memory)
+{
+	_aligned_free(Memory);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Publish
+//
+// Called with the lock held.  Stores only what changed; readers see
+// each level change on its own, at once.
+///////////////////////////////////////////////////////////////////////
+void
+ConfigSource::Publish(
+	const ConfigValues&	Values)
+{
+	LONG	Level	= Values.Level;
+
+	// the registry option only makes sense in code
+	if (CONFIG_LEVEL_UNSET != Level)
+	{
+		Level &= ~DIAGNOSTICS_FROMREGISTRY;
+	}
+
+	if (Level != m_Level)
+	{
+		InterlockedExchange(&m_Level, Level);
+	}
+
+	for (int Index = DIAGNOSTICS_CATEGORY_NONE + 1; Index < DIAGNOSTICS_CATEGORIES; Index++)
+	{
+		LONG	CategoryLevel	= Values.CategoryLevels[Index];
+
+		if (CONFIG_LEVEL_UNSET != CategoryLevel)
+		{
+			CategoryLevel &= ~DIAGNOSTICS_FROMREGISTRY;
+		}
+
+		if (CategoryLevel != m_CategoryLevels[Index])
+		{
+			if (CONFIG_LEVEL_UNSET == m_CategoryLevels[Index])
+			{
+				InterlockedIncrement(&m_CategoryCount);
+			}
+			else if (CONFIG_LEVEL_UNSET == CategoryLevel)
+			{
+				InterlockedDecrement(&m_CategoryCount);
+			}
+
+			InterlockedExchange(&m_CategoryLevels[Index], CategoryLevel);
+		}
+	}
+
+	InternedString	OldPath;
+
+	if (NULL != m_Settings)
+	{
+		OldPath = m_Settings->LogFilePath;
+	}
+
+	if (Values.LogFilePath != OldPath)
+	{
+		ConfigSettings*	Settings	= NULL;
+
+		if (false == Values.LogFilePath.IsEmpty())
+		{
+			Settings = new ConfigSettings;
+
+			if (NULL != Settings)
+			{
+				Settings->LogFilePath = Values.LogFilePath;
+			}
+		}
+
+		if ((NULL != Settings) || (true == Values.LogFilePath.IsEmpty()))
+		{
+			ConfigSettings*	OldSettings	= m_Settings;
+
+			InterlockedExchangePointer((PVOID volatile*)&m_Settings, Settings);
+
+			// wait out the readers that may still have the old settings
+			m_Readers.Synchronize();
+
+			if (NULL != OldSettings)
+			{
+				delete OldSettings;
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Update
+///////////////////////////////////////////////////////////////////////
+bool
+ConfigSource::Update(
+	bool	Arm)
+{
+	bool			ReturnCode	= false;
+	ConfigValues	Values;
+
+	Values.Level = CONFIG_LEVEL_UNSET;
+
+	for (int Index = 0; Index < DIAGNOSTICS_CATEGORIES; Index++)
+	{
+		Values.CategoryLevels[Index] = CONFIG_LEVEL_UNSET;
+	}
+
+	EnterCriticalSection(&m_Lock);
+
+	if (true == Arm)
+	{
+		ArmNotification();
+	}
+
+	// a backend that cannot be read holds nothing, so the levels set
+	// in code apply again
+	ReturnCode = ReadConfig(&Values);
+
+	Publish(Values);
+
+	LeaveCriticalSection(&m_Lock);
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Run
+///////////////////////////////////////////////////////////////////////
+DWORD WINAPI
+ConfigSource::Run(
+	LPVOID	Parameter)
+{
+	ConfigSource*	Source	= (ConfigSource*)Parameter;
+	HMODULE			Module	= Source->m_Module;
+
+	do
+	{
+		Source->Update(true);
+	}
+	while (true == Source->WaitForChange(Source->m_StopEvent));
+
+	// after Release, the source is this thread's to free
+	if (0 == InterlockedDecrement(&Source->m_References))
+	{
+		delete Source;
+	}
+
+	if (NULL != Module)
+	{
+		FreeLibraryAndExitThread(Module, 0);
+	}
+
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// RegistryConfigSource Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Ctors / Dtors
+///////////////////////////////////////////////////////////////////////
+RegistryConfigSource::RegistryConfigSource(
+	HKEY	Root,
+	LPCTSTR	SubKey,
+	LPCTSTR	ValueName) :
+		m_Root(Root),
+		m_SubKey(SubKey),
+		m_ValueName(ValueName),
+		m_Key(NULL),
+		m_ChangeEvent(NULL),
+		m_Armed(false)
+{
+	m_ChangeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+RegistryConfigSource::~RegistryConfigSource(void)
+{
+	StopWatching();
+	CloseKey();
+
+	if (NULL != m_ChangeEvent)
+	{
+		CloseHandle(m_ChangeEvent);
+		m_ChangeEvent = NULL;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// AcquireDefault
+//
+// The source for DIAGNOSTICS_FROMREGISTRY, the Diagnostics value under
+// HKEY_LOCAL_MACHINE\SOFTWARE\Zenware.  One is shared by all users, and
+// watched while there are any; each call is matched by ReleaseDefault.
+// Returns NULL only if memory runs out.
+///////////////////////////////////////////////////////////////////////
+RegistryConfigSource*
+RegistryConfigSource::AcquireDefault(void)
+{
+	RegistryConfigSource*	Source	= NULL;
+
+	if (true == g_DefaultLockReady)
+	{
+		EnterCriticalSection(&g_DefaultLock);
+
+		if (NULL == g_DefaultSource)
+		{
+			g_DefaultSource = new RegistryConfigSource(HKEY_LOCAL_MACHINE,
+				_T("SOFTWARE\\Zenware"),
+				_T("Diagnostics"));
+
+			if (NULL != g_DefaultSource)
+			{
+				// read now, so the first caller sees the level at once
+				g_DefaultSource->Refresh();
+				g_DefaultSource->StartWatching();
+			}
+		}
+
+		if (NULL != g_DefaultSource)
+		{
+			g_DefaultUsers++;
+			Source = g_DefaultSource;
+		}
+
+		LeaveCriticalSection(&g_DefaultLock);
+	}
+
+	return Source;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Initialize
+//
+// Called from DllMain on DLL_PROCESS_ATTACH.
+///////////////////////////////////////////////////////////////////////
+bool
+RegistryConfigSource::Initialize(void)
+{
+	if (false == g_DefaultLockReady)
+	{
+		InitializeCriticalSection(&g_DefaultLock);
+		g_DefaultLockReady = true;
+	}
+
+	return true;
+}
+
+void
+RegistryConfigSource::ReleaseDefault(void)
+{
+	if (true == g_DefaultLockReady)
+	{
+		EnterCriticalSection(&g_DefaultLock);
+
+		if ((NULL != g_DefaultSource) && (0 == --g_DefaultUsers))
+		{
+			// may be called from a destructor under the loader lock,
+			// so the watch thread is not waited for
+			g_DefaultSource->Release();
+			g_DefaultSource = NULL;
+		}
+
+		LeaveCriticalSection(&g_DefaultLock);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Uninitialize
+//
+// Called from DllMain on DLL_PROCESS_DETACH.  A default source still in
+// use by then is not deleted: waiting for its thread here, under the
+// loader lock, could hang.  One already released frees itself, on its
+// own thread.
+///////////////////////////////////////////////////////////////////////
+void
+RegistryConfigSource::Uninitialize(void)
+{
+	if ((true == g_DefaultLockReady) && (NULL == g_DefaultSource))
+	{
+		DeleteCriticalSection(&g_DefaultLock);
+		g_DefaultLockReady = false;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// ArmNotification
+///////////////////////////////////////////////////////////////////////
+bool
+RegistryConfigSource::ArmNotification(void)
+{
+	m_Armed = false;
+
+	if ((NULL != m_ChangeEvent) && ((NULL != m_Key) || (true == OpenKey())))
+	{
+		LONG	Result	= RegNotifyChangeKeyValue(m_Key,
+							FALSE,
+							REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET,
+							m_ChangeEvent,
+							TRUE);
+
+		if (ERROR_SUCCESS == Result)
+		{
+			m_Armed = true;
+		}
+		else
+		{
+			// deleted since it was opened
+			CloseKey();
+		}
+	}
+
+	return m_Armed;
+}
+
+///////////////////////////////////////////////////////////////////////
+// ReadConfig
+//
+// The registry only holds the level.
+///////////////////////////////////////////////////////////////////////
+bool
+RegistryConfigSource::ReadConfig(
+	ConfigValues*	Values)
+{
+	bool	ReturnCode	= false;
+
+	if ((NULL != m_Key) || (true == OpenKey()))
+	{
+		DWORD	Type		= REG_NONE;
+		DWORD	Value		= 0;
+		DWORD	BufferSize	= sizeof(DWORD);
+		LONG	Result		= RegQueryValueEx(m_Key,
+								m_ValueName.GetString(),
+								NULL,
+								&Type,
+								(LPBYTE)&Value,
+								&BufferSize);
+
+		if ((ERROR_SUCCESS == Result) && (REG_DWORD == Type))
+		{
+			Values->Level	= (LONG)Value;
+			ReturnCode		= true;
+		}
+		else if (ERROR_KEY_DELETED == Result)
+		{
+			CloseKey();
+		}
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// WaitForChange
+///////////////////////////////////////////////////////////////////////
+bool
+RegistryConfigSource::WaitForChange(
+	HANDLE	StopEvent)
+{
+	bool	ReturnCode	= false;
+
+	if (true == m_Armed)
+	{
+		HANDLE	Handles[2]	= { StopEvent, m_ChangeEvent };
+
+		if ((WAIT_OBJECT_0 + 1) ==
+			WaitForMultipleObjects(2, Handles, FALSE, INFINITE))
+		{
+			ReturnCode = true;
+		}
+	}
+	else if (WAIT_TIMEOUT == WaitForSingleObject(StopEvent, CONFIG_RETRY_INTERVAL))
+	{
+		ReturnCode = true;
+	}
+
+	return ReturnCode;
+}
+
+void
+RegistryConfigSource::CloseKey(void)
+{
+	if (NULL != m_Key)
+	{
+		RegCloseKey(m_Key);
+		m_Key = NULL;
+	}
+}
+
+bool
+RegistryConfigSource::OpenKey(void)
+{
+	bool	ReturnCode	= false;
+
+	if (ERROR_SUCCESS == RegOpenKeyEx(m_Root,
+			m_SubKey.GetString(),
+			0,
+			KEY_READ,
+			&m_Key))
+	{
+		ReturnCode = true;
+	}
+	else
+	{
+		m_Key = NULL;
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// FileConfigSource Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Ctors / Dtors
+///////////////////////////////////////////////////////////////////////
+FileConfigSource::FileConfigSource(
+	LPCTSTR	FilePath) :
+		m_FilePath(FilePath),
+		m_Notification(INVALID_HANDLE_VALUE),
+		m_Armed(false)
+{
+}
+
+FileConfigSource::~FileConfigSource(void)
+{
+	StopWatching();
+
+	if (INVALID_HANDLE_VALUE != m_Notification)
+	{
+		FindCloseChangeNotification(m_Notification);
+		m_Notification = INVALID_HANDLE_VALUE;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// ParseLevel
+//
+// A number, or output names, such as "logfile|console".  Unknown names
+// make the whole value invalid.
+///////////////////////////////////////////////////////////////////////
+bool
+FileConfigSource::ParseLevel(
+	const char*	Value,
+	size_t		Length,
+	DWORD*		Level)
+{
+	bool	ReturnCode	= false;
+
+	if ((0 < Length) && (Value[0] >= '0') && (Value[0] <= '9'))
+	{
+		char	Number[16];
+
+		if (Length < sizeof(Number))
+		{
+			memcpy(Number, Value, Length);
+			Number[Length] = '\0';
+
+			*Level		= strtoul(Number, NULL, 0);
+			ReturnCode	= true;
+		}
+	}
+	else if (0 < Length)
+	{
+		size_t	Position	= 0;
+
+		*Level		= DIAGNOSTICS_NONE;
+		ReturnCode	= true;
+
+		while ((true == ReturnCode) && (Position < Length))
+		{
+			size_t	End		= Position;
+			bool	Found	= false;
+
+			while ((End < Length) && ('|' != Value[End]))
+			{
+				End++;
+			}
+
+			size_t	Start	= Position;
+
+			while ((Start < End) && (true == IsConfigSpace(Value[Start])))
+			{
+				Start++;
+			}
+
+			size_t	Stop	= End;
+
+			while ((Start < Stop) && (true == IsConfigSpace(Value[Stop - 1])))
+			{
+				Stop--;
+			}
+
+			for (size_t Index = 0; Index < _countof(g_LevelNames); Index++)
+			{
+				if ((strlen(g_LevelNames[Index].Name) == Stop - Start) &&
+					(0 == _strnicmp(Value + Start, g_LevelNames[Index].Name, Stop - Start)))
+				{
+					*Level	|= g_LevelNames[Index].Level;
+					Found	= true;
+				}
+			}
+
+			ReturnCode	= Found;
+			Position	= End + 1;
+		}
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// ArmNotification
+///////////////////////////////////////////////////////////////////////
+bool
+FileConfigSource::ArmNotification(void)
+{
+	bool	ReturnCode	= false;
+
+	if (INVALID_HANDLE_VALUE != m_Notification)
+	{
+		if (FALSE != FindNextChangeNotification(m_Notification))
+		{
+			ReturnCode = true;
+		}
+		else
+		{
+			FindCloseChangeNotification(m_Notification);
+			m_Notification = INVALID_HANDLE_VALUE;
+		}
+	}
+
+	if (INVALID_HANDLE_VALUE == m_Notification)
+	{
+		TCHAR*	Directory	= GetDirectory(m_FilePath.GetString());
+
+		if (NULL != Directory)
+		{
+			m_Notification = FindFirstChangeNotification(Directory,
+				FALSE,
+				FILE_NOTIFY_CHANGE_FILE_NAME |
+					FILE_NOTIFY_CHANGE_SIZE |
+					FILE_NOTIFY_CHANGE_LAST_WRITE);
+
+			ReturnCode = (INVALID_HANDLE_VALUE != m_Notification);
+
+			delete[] Directory;
+		}
+	}
+
+	m_Armed = ReturnCode;
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// ReadConfig
+//
+// Runs on the watch thread, so a reload costs the reporting threads
+// nothing.  Values that do not parse are left unset.
+///////////////////////////////////////////////////////////////////////
+bool
+FileConfigSource::ReadConfig(
+	ConfigValues*	Values)
+{
+	const char	CategoryPrefix[]	= "level.";
+	bool		ReturnCode			= false;
+	size_t		Size				= 0;
+	char*		Contents			= ReadContents(&Size);
+
+	if (NULL != Contents)
+	{
+		size_t		Position	= 0;
+		ConfigLine	Line;
+
+		// skip a byte order mark
+		if ((3 <= Size) && ('\xEF' == Contents[0]) &&
+			('\xBB' == Contents[1]) && ('\xBF' == Contents[2]))
+		{
+			Position = 3;
+		}
+
+		while (true == GetNextConfigLine(Contents, Size, &Position, &Line))
+		{
+			DWORD	Level	= 0;
+
+			if ((5 == Line.NameLength) &&
+				(0 == _strnicmp(Line.Name, "level", 5)))
+			{
+				if (true == ParseLevel(Line.Value, Line.ValueLength, &Level))
+				{
+					Values->Level = (LONG)Level;
+				}
+			}
+			else if ((_countof(CategoryPrefix) - 1 < Line.NameLength) &&
+				(0 == _strnicmp(Line.Name, CategoryPrefix, _countof(CategoryPrefix) - 1)))
+			{
+				InternedString	Category	= GetConfigString(
+					Line.Name + _countof(CategoryPrefix) - 1,
+					Line.NameLength - (_countof(CategoryPrefix) - 1));
+				int				CategoryId	= CategoryTable::Register(Category);
+
+				if ((DIAGNOSTICS_CATEGORY_NONE != CategoryId) &&
+					(true == ParseLevel(Line.Value, Line.ValueLength, &Level)))
+				{
+					Values->CategoryLevels[CategoryId] = (LONG)Level;
+				}
+			}
+			else if ((8 == Line.NameLength) &&
+				(0 == _strnicmp(Line.Name, "log_file", 8)))
+			{
+				Values->LogFilePath = GetConfigString(Line.Value, Line.ValueLength);
+			}
+		}
+
+		delete[] Contents;
+		ReturnCode = true;
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// WaitForChange
+///////////////////////////////////////////////////////////////////////
+bool
+FileConfigSource::WaitForChange(
+	HANDLE	StopEvent)
+{
+	bool	ReturnCode	= false;
+
+	if (true == m_Armed)
+	{
+		HANDLE	Handles[2]	= { StopEvent, m_Notification };
+
+		if ((WAIT_OBJECT_0 + 1) ==
+			WaitForMultipleObjects(2, Handles, FALSE, INFINITE))
+		{
+			ReturnCode = true;
+		}
+	}
+	else if (WAIT_TIMEOUT == WaitForSingleObject(StopEvent, CONFIG_RETRY_INTERVAL))
+	{
+		ReturnCode = true;
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// ReadContents
+//
+// The file is shared for writing, so an editor saving it meanwhile may
+// leave a partial read; the change notification that follows reads it
+// again.  delete[] after use.
+///////////////////////////////////////////////////////////////////////
+char*
+FileConfigSource::ReadContents(
+	size_t*	Size)
+{
+	char*	Contents	= NULL;
+	HANDLE	File		= CreateFile(m_FilePath.GetString(),
+							GENERIC_READ,
+							FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+							NULL,
+							OPEN_EXISTING,
+							FILE_ATTRIBUTE_NORMAL,
+							NULL);
+
+	if (INVALID_HANDLE_VALUE != File)
+	{
+		DWORD	FileSize	= GetFileSize(File, NULL);
+		DWORD	BytesRead	= 0;
+
+		if ((INVALID_FILE_SIZE != FileSize) && (FileSize <= CONFIG_FILE_MAXIMUM))
+		{
+			Contents = new char[FileSize + 1];
+
+			if (NULL != Contents)
+			{
+				if (FALSE != ::ReadFile(File, Contents, FileSize, &BytesRead, NULL))
+				{
+					Contents[BytesRead]	= '\0';
+					*Size				= BytesRead;
+				}
+				else
+				{
+					delete[] Contents;
+					Contents = NULL;
+				}
+			}
+		}
+
+		CloseHandle(File);
+	}
+
+	return Contents;
+}
@@ -0,0 +1,254 @@
+///////////////////////////////////////////////////////////////////////
+// ConfigSource.h
+//
+// Where the output levels and log file come from when they are not set
+// in code, and the watching that keeps them current.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "../Include/common.h"
+#include "../Utils/InternedString.h"
+#include "Categories.h"
+#include "ReadCopyUpdate.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+// the source holds no level, or could not be read
+const LONG CONFIG_LEVEL_UNSET		= -1;
+
+// how often a registry key that does not exist yet is looked for again
+const DWORD CONFIG_RETRY_INTERVAL	= 5000;
+
+///////////////////////////////////////////////////////////////////////
+// ConfigValues
+//
+// Everything one read of a backend found.  Levels it did not find are
+// CONFIG_LEVEL_UNSET, a path it did not find is empty.
+///////////////////////////////////////////////////////////////////////
+struct ConfigValues
+{
+	LONG			Level;
+	LONG			CategoryLevels[DIAGNOSTICS_CATEGORIES];
+	InternedString	LogFilePath;
+};
+
+///////////////////////////////////////////////////////////////////////
+// ConfigSettings
+//
+// The settings that do not fit in a word.  Replaced whole on a change,
+// never modified.
+///////////////////////////////////////////////////////////////////////
+struct ConfigSettings
+{
+	InternedString	LogFilePath;
+};
+
+///////////////////////////////////////////////////////////////////////
+// Class: ConfigSource
+//
+// Holds the last levels read from its backend, each in one word that
+// every Diagnostics object using the source reads directly; a change is
+// published to all of them by a single store.  While watching, a
+// thread of its own waits on the backend's change notification and
+// reads the backend again, so there is no polling, and nothing is read
+// on the reporting path.
+//
+// On a reload, only the words that changed are stored.  The settings
+// that do not fit in a word are built on the watch thread and swapped
+// in by pointer; readers pin them with BeginRead and EndRead, which
+// take no lock, and the old settings are freed once no reader can
+// still be using them.
+//
+// Derived classes call StopWatching in their destructors, before
+// anything the watch thread uses is released.  StopWatching, and so
+// delete, wait for the watch thread, which must not be done under the
+// loader lock; Release does not wait, and is the way to free a source
+// that may be freed from a destructor or DllMain.
+//
+// Sources are allocated cache line aligned, for the reader shards of
+// m_Readers.
+///////////////////////////////////////////////////////////////////////
+class DllExport ConfigSource
+{
+	public:
+		// Methods
+			ConfigSource(void);
+			virtual ~ConfigSource(void);
+
+			const ConfigSettings* BeginRead(
+				int*	Token);
+			void EndRead(
+				int	Token);
+			LONG GetCategoryLevel(
+				int	CategoryId) const
+			{
+				LONG	Level	= CONFIG_LEVEL_UNSET;
+
+				if ((DIAGNOSTICS_CATEGORY_NONE < CategoryId) &&
+					(CategoryId < DIAGNOSTICS_CATEGORIES))
+				{
+					Level = m_CategoryLevels[CategoryId];
+				}
+
+				return Level;
+			}
+			LONG GetLevel(void) const
+			{
+				return m_Level;
+			}
+			bool HasCategoryLevels(void) const
+			{
+				return (0 < m_CategoryCount);
+			}
+
+			bool Refresh(void);
+			void Release(void);
+			bool StartWatching(void);
+			void StopWatching(void);
+
+			static void* operator new(
+				size_t	Size) throw();
+			static void operator delete(
+				void*	Memory);
+
+	protected:
+		// Methods
+			// Sets up the notification for the next change.  Called
+			// before each read, so a change made during the read is
+			// not missed.
+			virtual bool ArmNotification(void) = 0;
+			// Values comes with every level unset and no path.
+			virtual bool ReadConfig(
+				ConfigValues*	Values) = 0;
+			// Waits for the notification armed last.  Returns false
+			// once StopEvent is signaled.
+			virtual bool WaitForChange(
+				HANDLE	StopEvent) = 0;
+
+	private:
+		// Properties
+			volatile LONG			m_Level;
+			volatile LONG			m_CategoryLevels[DIAGNOSTICS_CATEGORIES];
+			// categories with a level
+			volatile LONG			m_CategoryCount;
+			ConfigSettings* volatile	m_Settings;
+			ReadCopyUpdate			m_Readers;
+			// serializes the backend calls of Refresh and the watch thread
+			CRITICAL_SECTION		m_Lock;
+			HANDLE					m_StopEvent;
+			HANDLE					m_Thread;
+			// the module, held by the watch thread while it runs
+			HMODULE					m_Module;
+			// the owner, and the watch thread while it runs; the last
+			// to let go of the source deletes it
+			volatile LONG			m_References;
+
+		// Methods
+			ConfigSource(
+				const ConfigSource&);
+			ConfigSource& operator=(
+				const ConfigSource&);
+
+			void Publish(
+				const ConfigValues&	Values);
+			bool Update(
+				bool	Arm);
+
+			static DWORD WINAPI Run(
+				LPVOID	Parameter);
+};
+
+///////////////////////////////////////////////////////////////////////
+// Class: RegistryConfigSource
+//
+// A REG_DWORD value holding the DIAGNOSTICS_* flags.  The key is kept
+// open while it exists; a key that is deleted, or not created yet, is
+// looked for again every CONFIG_RETRY_INTERVAL.
+///////////////////////////////////////////////////////////////////////
+class DllExport RegistryConfigSource : public ConfigSource
+{
+	public:
+		// Methods
+			RegistryConfigSource(
+				HKEY	Root,
+				LPCTSTR	SubKey,
+				LPCTSTR	ValueName);
+			virtual ~RegistryConfigSource(void);
+
+			static RegistryConfigSource* AcquireDefault(void);
+			static bool Initialize(void);
+			static void ReleaseDefault(void);
+			static void Uninitialize(void);
+
+	protected:
+		// Methods
+			virtual bool ArmNotification(void);
+			virtual bool ReadConfig(
+				ConfigValues*	Values);
+			virtual bool WaitForChange(
+				HANDLE	StopEvent);
+
+	private:
+		// Properties
+			HKEY			m_Root;
+			InternedString	m_SubKey;
+			InternedString	m_ValueName;
+			HKEY			m_Key;
+			HANDLE			m_ChangeEvent;
+			bool			m_Armed;
+
+		// Methods
+			void CloseKey(void);
+			bool OpenKey(void);
+};
+
+///////////////////////////////////////////////////////////////////////
+// Class: FileConfigSource
+//
+// A text file of name=value lines, in UTF-8:
+//	level=logfile|console			outputs for all reports
+//	level.Network=logfile			outputs for one category
+//	log_file=D:\Logs\Service.log	the log file, instead of the one
+//									set in code
+// Levels are numbers, or output names joined by '|'.  Lines starting
+// with '#' or ';' are comments, and unknown names are ignored.  The
+// file's directory is watched, with FindFirstChangeNotification, so the
+// file can be replaced as well as edited.  Windows only.
+///////////////////////////////////////////////////////////////////////
+class DllExport FileConfigSource : public ConfigSource
+{
+	public:
+		// Methods
+			FileConfigSource(
+				LPCTSTR	FilePath);
+			virtual ~FileConfigSource(void);
+
+			static bool ParseLevel(
+				const char*	Value,
+				size_t		Length,
+				DWORD*		Level);
+
+	protected:
+		// Methods
+			virtual bool ArmNotification(void);
+			virtual bool ReadConfig(
+				ConfigValues*	Values);
+			virtual bool WaitForChange(
+				HANDLE	StopEvent);
+
+			char* ReadContents(
+				size_t*	Size);
+
+	private:
+		// Properties
+			InternedString	m_FilePath;
+			HANDLE			m_Notification;
+			bool			m_Armed;
+};
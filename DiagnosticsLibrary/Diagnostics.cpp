@@ -15,8 +15,21 @@
 #include <shlobj.h>
 #include <assert.h>
 #include "Diagnostics.h"
+#include "ConfigSource.h"
+#include "MessageArena.h"
+#include "Metrics.h"
+#include "StackTrace.h"
 #include "version.h"
 #include "../Utils/Utils.h"
+#include "../Utils/EncodingDetector.h"
+#include "../Utils/ErrorCatalog.h"
+#include "../Utils/ErrorMessageCache.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+// one report in this many, per counter shard, is timed
+#define REPORT_TIME_SAMPLING	16
 
 ///////////////////////////////////////////////////////////////////////
 // DllMain
@@ -27,7 +40,38 @@ APIENTRY DllMain(
 	DWORD	ul_reason_for_call,
 	LPVOID	lpReserved)
 {
-	return TRUE;
+	BOOL	ReturnCode	= TRUE;
+
+	switch (ul_reason_for_call)
+	{
+		case DLL_PROCESS_ATTACH:
+		{
+			if ((false == MessageArena::Initialize()) ||
+				(false == RegistryConfigSource::Initialize()))
+			{
+				ReturnCode = FALSE;
+			}
+			break;
+		}
+		case DLL_THREAD_DETACH:
+		{
+			MessageArena::ReleaseThreadArena();
+			break;
+		}
+		case DLL_PROCESS_DETACH:
+		{
+			MessageArena::ReleaseThreadArena();
+			MessageArena::Uninitialize();
+			RegistryConfigSource::Uninitialize();
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+
+	return ReturnCode;
 }
 
 VOID DbgPrintf(
@@ -47,6 +91,85 @@ VOID DbgPrintf(
 	_tprintf_s(_T("%s\r\n"), szBuf);
 }
 
+///////////////////////////////////////////////////////////////////////
+// AppendString
+//
+// Copies Length characters and returns the position after them.
+///////////////////////////////////////////////////////////////////////
+static TCHAR*
+AppendString(
+	TCHAR*	Position,
+	LPCTSTR	String,
+	size_t	Length)
+{
+	if (0 < Length)
+	{
+		memcpy(Position, String, Length * sizeof(TCHAR));
+	}
+
+	return Position + Length;
+}
+
+///////////////////////////////////////////////////////////////////////
+// WriteStackTrace
+//
+// Called on the symbolizer thread with each newly seen stack.
+///////////////////////////////////////////////////////////////////////
+static void
+WriteStackTrace(
+	void*	Context,
+	LPCTSTR	Text,
+	size_t	Length)
+{
+	((Diagnostics*)Context)->Report(Text, Length);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Telemetry helpers
+//
+// The metrics are missing only if they could not be allocated.
+///////////////////////////////////////////////////////////////////////
+static LONGLONG
+AddMetric(
+	MetricCounter*	Counter,
+	LONGLONG		Value)
+{
+	LONGLONG	ShardValue	= 0;
+
+	if (NULL != Counter)
+	{
+		ShardValue = Counter->Add(Value);
+	}
+
+	return ShardValue;
+}
+
+static LONGLONG
+GetMetricValue(
+	MetricCounter*	Counter)
+{
+	LONGLONG	Value	= 0;
+
+	if (NULL != Counter)
+	{
+		Value = Counter->GetValue();
+	}
+
+	return Value;
+}
+
+static void
+RecordReportTime(
+	MetricHistogram*	Histogram,
+	LONGLONG			StartCount)
+{
+	if (NULL != Histogram)
+	{
+		Histogram->Record((LONGLONG)GetElapsedMicroseconds(StartCount,
+			GetPerformanceCount()));
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////
 // Diagnostics Class Definition
 ///////////////////////////////////////////////////////////////////////
@@ -55,39 +178,146 @@ VOID DbgPrintf(
 ///////////////////////////////////////////////////////////////////////
 Diagnostics::Diagnostics(void) :
 	m_OutputLevel(0),
-	m_LogFilePath(NULL)
+	m_ConfigSource(NULL),
+	m_RegistrySource(NULL),
+	m_RegistryOverride(false),
+	m_OwnedConfigSource(NULL),
+	m_CategoryOverrides(0),
+	m_Version(_T(VERSION_STRING)),
+	m_StructuredSink(NULL),
+	m_StackTracer(NULL),
+	m_Telemetry(NULL),
+	m_RecordsAccepted(NULL),
+	m_RecordsSuppressed(NULL),
+	m_RecordsDropped(NULL),
+	m_BytesWritten(NULL),
+	m_WriteCalls(NULL),
+	m_ReportTime(NULL),
+	m_StartCount(0)
 {
-	m_Version		= GetUnicodeString(VERSION_STRING);
-	m_LogFilePath	= GetUserDataPath(_T("\\Zenware.log"));
+	InitializeCategories();
+	InitializeTelemetry();
+	SetLogFilePath(_T("\\Zenware.log"));
 }
 
+///////////////////////////////////////////////////////////////////////
+// Version is copied (interned), the caller keeps ownership.
+///////////////////////////////////////////////////////////////////////
 Diagnostics::Diagnostics(
 	TCHAR*	BaseFileName,
 	TCHAR*	Version) :
 		m_OutputLevel(0),
-		m_LogFilePath(NULL)
+		m_ConfigSource(NULL),
+		m_RegistrySource(NULL),
+		m_RegistryOverride(false),
+		m_OwnedConfigSource(NULL),
+		m_CategoryOverrides(0),
+		m_Version(Version),
+		m_StructuredSink(NULL),
+		m_StackTracer(NULL),
+		m_Telemetry(NULL),
+		m_RecordsAccepted(NULL),
+		m_RecordsSuppressed(NULL),
+		m_RecordsDropped(NULL),
+		m_BytesWritten(NULL),
+		m_WriteCalls(NULL),
+		m_ReportTime(NULL),
+		m_StartCount(0)
 {
-	m_Version	= Version;
+	InitializeCategories();
+	InitializeTelemetry();
 
 	if (NULL == BaseFileName)
 	{
 		BaseFileName	= _T("\\Zenware.log");
 	}
-	m_LogFilePath	= GetUserDataPath(BaseFileName);
+	SetLogFilePath(BaseFileName);
 }
 
+///////////////////////////////////////////////////////////////////////
+// The symbolizer and statistics threads report through this object, so
+// they are stopped first.
+///////////////////////////////////////////////////////////////////////
 Diagnostics::~Diagnostics(void)
 {
-	if (NULL != m_LogFilePath)
+	SetStackCapture(false);
+	SetConfigSource(NULL);
+
+	if (NULL != m_Telemetry)
 	{
-		delete m_LogFilePath;
-		m_LogFilePath = NULL;
+		delete m_Telemetry;
+		m_Telemetry = NULL;
 	}
-	if (NULL != m_Version)
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetCategoryId
+//
+// Registers the category on first use.  Look the id up once and keep
+// it; reports by id check the category's level with a single read.
+///////////////////////////////////////////////////////////////////////
+int
+Diagnostics::GetCategoryId(
+	LPCTSTR	Name)
+{
+	int	CategoryId	= DIAGNOSTICS_CATEGORY_NONE;
+
+	if (NULL != Name)
+	{
+		CategoryId = CategoryTable::Register(InternedString(Name));
+	}
+
+	return CategoryId;
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetStatistics
+///////////////////////////////////////////////////////////////////////
+bool
+Diagnostics::GetStatistics(
+	DiagnosticsStatistics*	Statistics)
+{
+	bool	ReturnCode	= false;
+
+	if ((NULL != Statistics) && (NULL != m_Telemetry))
 	{
-		delete m_Version;
-		m_Version = NULL;
+		memset(Statistics, 0, sizeof(DiagnosticsStatistics));
+
+		Statistics->RecordsAccepted		= GetMetricValue(m_RecordsAccepted);
+		Statistics->RecordsSuppressed	= GetMetricValue(m_RecordsSuppressed);
+		Statistics->RecordsDropped		= GetMetricValue(m_RecordsDropped);
+		Statistics->BytesWritten		= GetMetricValue(m_BytesWritten);
+		Statistics->WriteCalls			= GetMetricValue(m_WriteCalls);
+
+		MetricGauge*	HighWater	=
+			m_Telemetry->GetGauge(_T("diagnostics.stack_queue_high_water"));
+		MetricCounter*	BusyTime	=
+			m_Telemetry->GetCounter(_T("diagnostics.symbolizer_busy_us"));
+		ULONGLONG		Elapsed		=
+			GetElapsedMicroseconds(m_StartCount, GetPerformanceCount());
+
+		if (NULL != HighWater)
+		{
+			Statistics->StackQueueHighWater = HighWater->GetValue();
+		}
+
+		if (0 < Elapsed)
+		{
+			Statistics->SymbolizerUtilization =
+				(double)GetMetricValue(BusyTime) / (double)Elapsed;
+		}
+
+		if (NULL != m_ReportTime)
+		{
+			Statistics->ReportTimeMedian	= m_ReportTime->GetPercentile(50.0);
+			Statistics->ReportTime99		= m_ReportTime->GetPercentile(99.0);
+			Statistics->ReportTimeMaximum	= m_ReportTime->GetMaximum();
+		}
+
+		ReturnCode = true;
 	}
+
+	return ReturnCode;
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -97,8 +327,8 @@ Diagnostics::~Diagnostics(void)
 //	DIAGNOSTICS_LOGFILE			write to logfile
 //	DIAGNOSTICS_POPUPS			display popup (messagebox) information
 //	DIAGNOSTICS_FROMREGISTRY	get debug level from registry
-//								reg key is:
-//								HKEY_LOCAL_MACHINE\SOFTWARE\\ZENWARE\Debug
+//								reg value is:
+//								HKEY_LOCAL_MACHINE\SOFTWARE\Zenware\Diagnostics
 //
 //								possible values are hashed flags, so
 //								0	= DIAGNOSTICS_NONE
@@ -106,6 +336,10 @@ Diagnostics::~Diagnostics(void)
 //								2	= DIAGNOSTICS_POPUPS
 //								no value is equivalent of 0
 //								other hashed values ignored
+//
+//								the value is watched, and a change
+//								applies at once to every Diagnostics
+//								object reading it
 ///////////////////////////////////////////////////////////////////////
 bool
 Diagnostics::SetDiagnosticOutput(
@@ -115,24 +349,30 @@ Diagnostics::SetDiagnosticOutput(
 
 	if (DIAGNOSTICS_FROMREGISTRY == OptionCode)
 	{
-		LONG	lRet			= -1;
-		UINT	nDiagnostics	= GetOutputRegistryKey();
+		m_OutputLevel = DIAGNOSTICS_NONE;
 
-		if (0 != nDiagnostics)
+		if (NULL == m_RegistrySource)
 		{
-			m_OutputLevel	= nDiagnostics;
-			ReturnCode		= true;
+			m_RegistrySource = RegistryConfigSource::AcquireDefault();
 		}
-		else
+
+		m_ConfigSource = m_RegistrySource;
+
+		if (DIAGNOSTICS_NONE != GetOutputLevel())
 		{
-			m_OutputLevel	= DIAGNOSTICS_NONE;
-			ReturnCode		= false;
+			ReturnCode = true;
 		}
 	}
 	else
 	{
-		m_OutputLevel	= OptionCode;
-		ReturnCode		= true;
+		m_OutputLevel = OptionCode;
+
+		if (false == m_RegistryOverride)
+		{
+			ReleaseRegistrySource();
+		}
+
+		ReturnCode = true;
 	}
 
 	return ReturnCode;
@@ -142,33 +382,130 @@ void
 Diagnostics::Report(
 	LPCTSTR Message)
 {
-	UINT	ActualOutputLevel	= m_OutputLevel;
-	if (DIAGNOSTICS_LOGFILE & m_OutputLevel)
+	if (NULL != Message)
 	{
-		Write(Message);
+		Report(Message, _tcslen(Message));
 	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Report
+//
+// Message does not need to be NUL terminated.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::Report(
+	LPCTSTR Message,
+	size_t	MessageLength)
+{
+	ReportRecord(GetOutputLevel(), Message, MessageLength, NULL);
+}
 
-	if (DIAGNOSTICS_CONSOLE & m_OutputLevel)
+void
+Diagnostics::Report(
+	LPCTSTR				Message,
+	const RecordFields&	Fields)
+{
+	size_t	MessageLength	= 0;
+
+	if (NULL != Message)
 	{
-		_tprintf_s(_T("%s\r\n"), Message);
+		MessageLength = _tcslen(Message);
 	}
 
-	if (DIAGNOSTICS_POPUPS & m_OutputLevel)
+	Report(Message, MessageLength, Fields);
+}
+
+void
+Diagnostics::Report(
+	LPCTSTR				Message,
+	size_t				MessageLength,
+	const RecordFields&	Fields)
+{
+	ReportRecord(GetOutputLevel(), Message, MessageLength, &Fields);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Report, by category
+//
+// The category's level applies instead of the output level, if it has
+// one.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::Report(
+	int		CategoryId,
+	LPCTSTR	Message)
+{
+	if (NULL != Message)
 	{
-		MessageBox( GetActiveWindow(), Message, _T("Zenware"), MB_OK);
+		Report(CategoryId, Message, _tcslen(Message));
 	}
 }
 
+void
+Diagnostics::Report(
+	int		CategoryId,
+	LPCTSTR	Message,
+	size_t	MessageLength)
+{
+	ReportRecord(GetOutputLevel(CategoryId), Message, MessageLength, NULL);
+}
+
+void
+Diagnostics::Report(
+	int					CategoryId,
+	LPCTSTR				Message,
+	size_t				MessageLength,
+	const RecordFields&	Fields)
+{
+	ReportRecord(GetOutputLevel(CategoryId), Message, MessageLength, &Fields);
+}
+
 void
 Diagnostics::Report(
 	const char* Message)
 {
-	LPCTSTR UnicodeMessage = GetUnicodeString(Message);
+	if (NULL != Message)
+	{
+		Report(Message, strlen(Message));
+	}
+}
 
-	if (NULL != UnicodeMessage)
+void
+Diagnostics::Report(
+	const char* Message,
+	size_t		MessageLength)
+{
+	if ((NULL != Message) && (0 < MessageLength))
 	{
-		Report(UnicodeMessage);
-		delete UnicodeMessage;
+		ArenaScope			Scope;
+		EncodingDetector	Detector;
+		ULONG				CodePage		= Detector.Detect(
+												(const BYTE*)Message,
+												MessageLength,
+												(ULONG)-1,
+												false);
+		size_t				BomLength		= Detector.GetBomLength();
+		size_t				BufferSize		= GetUnicodeBound(CodePage,
+												MessageLength - BomLength);
+		wchar_t*			UnicodeMessage	= Scope.AllocateString(BufferSize);
+		size_t				UnicodeLength	= 0;
+
+		if ((NULL != UnicodeMessage) && (BomLength < MessageLength))
+		{
+			UnicodeLength = ConvertMultiByteToUnicode(CodePage,
+				Message + BomLength, MessageLength - BomLength,
+				UnicodeMessage, BufferSize, NULL);
+		}
+
+		if (0 < UnicodeLength)
+		{
+			Report(UnicodeMessage, UnicodeLength);
+		}
+		else if (BomLength < MessageLength)
+		{
+			AddMetric(m_RecordsDropped, 1);
+		}
 	}
 }
 
@@ -177,81 +514,468 @@ Diagnostics::ReportException(
 	LPCTSTR Module,
 	LPCTSTR Message)
 {
-	TCHAR*	ExceptionConst	= _T("Exception: ");
-	UINT	ActualOutputLevel	= m_OutputLevel;
+	size_t	ModuleLength	= 0;
+	size_t	MessageLength	= 0;
+
+	if (NULL != Module)
+	{
+		ModuleLength = _tcslen(Module);
+	}
+
+	if (NULL != Message)
+	{
+		MessageLength = _tcslen(Message);
+	}
+
+	ReportException(Module, ModuleLength, Message, MessageLength);
+}
+
+void
+Diagnostics::ReportException(
+	const InternedString&	Module,
+	LPCTSTR					Message)
+{
+	size_t	MessageLength	= 0;
+
+	if (NULL != Message)
+	{
+		MessageLength = _tcslen(Message);
+	}
+
+	ReportException(Module.GetString(), Module.GetLength(), Message, MessageLength);
+}
+
+///////////////////////////////////////////////////////////////////////
+// ReportException
+//
+// The module is also the category, if one of that name has a level.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::ReportException(
+	LPCTSTR Module,
+	size_t	ModuleLength,
+	LPCTSTR Message,
+	size_t	MessageLength)
+{
+	ReportModuleException(FindModuleCategory(Module, ModuleLength),
+		Module,
+		ModuleLength,
+		Message,
+		MessageLength);
+}
+
+///////////////////////////////////////////////////////////////////////
+// ReportException, by category
+//
+// The category name stands for the module.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::ReportException(
+	int		CategoryId,
+	LPCTSTR	Message)
+{
+	InternedString	Module			= CategoryTable::GetName(CategoryId);
+	size_t			MessageLength	= 0;
+
+	if (NULL != Message)
+	{
+		MessageLength = _tcslen(Message);
+	}
+
+	ReportModuleException(CategoryId,
+		Module.GetString(),
+		Module.GetLength(),
+		Message,
+		MessageLength);
+}
+
+void
+Diagnostics::ReportModuleException(
+	int		CategoryId,
+	LPCTSTR Module,
+	size_t	ModuleLength,
+	LPCTSTR Message,
+	size_t	MessageLength)
+{
+	const TCHAR	ExceptionConst[]	= _T("Exception: ");
+	DWORD		LastError			= GetLastError();
+
+	if (NULL == Module)
+	{
+		Module			= _T("");
+		ModuleLength	= 0;
+	}
 
 	if (NULL == Message)
 	{
-		Message	= _T("Undefined: ");
+		Message			= _T("Undefined: ");
+		MessageLength	= _tcslen(Message);
 	}
 
-	size_t	ErrorMessageLength	= (_tcslen(Module) +
-									_tcslen(Message) +
-									_tcslen(ExceptionConst) +
-									_tcslen(_T(" ")) + 1)
-									* sizeof(TCHAR);
-	TCHAR*	ErrorMessage		= new TCHAR[ErrorMessageLength];
+	ArenaScope	Scope;
+	size_t	ErrorMessageLength	= _countof(ExceptionConst) - 1 +
+									ModuleLength +
+									1 +
+									MessageLength;
+	TCHAR*	ErrorMessage		= Scope.AllocateString(ErrorMessageLength + 1);
 
 	if (NULL != ErrorMessage)
 	{
-		_stprintf_s(ErrorMessage, ErrorMessageLength, _T("%s%s %s"), ExceptionConst, Module, Message);
+		TCHAR*	Position	= ErrorMessage;
+
+		Position	= AppendString(Position, ExceptionConst, _countof(ExceptionConst) - 1);
+		Position	= AppendString(Position, Module, ModuleLength);
+		Position	= AppendString(Position, _T(" "), 1);
+		Position	= AppendString(Position, Message, MessageLength);
+		*Position	= _T('\0');
+
+		RecordFields	Fields;
+
+		AddStackTrace(&Fields);
 
-		ReportLastError();
-		Report(ErrorMessage);
+		// shares the one stack trace
+		ReportSystemError(CategoryId, NULL, LastError, &Fields);
+		Report(CategoryId, ErrorMessage, ErrorMessageLength, Fields);
 		OutputDebugString(ErrorMessage);
-		delete ErrorMessage;
 	}
 }
 
+///////////////////////////////////////////////////////////////////////
+// LoadConfigFile
+//
+// Takes the output levels and log file from a config file (see
+// FileConfigSource), read now and again whenever it changes, in place
+// of any other config source.  Returns false if the file could not be
+// read now; it is watched regardless, and applies once it can be.
+// Not to be called while other threads are reporting.
+///////////////////////////////////////////////////////////////////////
+bool
+Diagnostics::LoadConfigFile(
+	LPCTSTR	FilePath)
+{
+	bool	ReturnCode	= false;
+
+	if (NULL != FilePath)
+	{
+		FileConfigSource*	Source	= new FileConfigSource(FilePath);
+
+		if (NULL != Source)
+		{
+			ReturnCode = Source->Refresh();
+			Source->StartWatching();
+
+			SetConfigSource(Source);
+			m_OwnedConfigSource = Source;
+		}
+	}
+
+	return ReturnCode;
+}
+
 ///////////////////////////////////////////////////////////////////////
 // ReportLastError
 ///////////////////////////////////////////////////////////////////////
 bool
 Diagnostics::ReportLastError(
 	HMODULE	ModuleHandle /* = NULL */)
+{
+	DWORD	ErrorCode			= GetLastError();
+
+	return ReportSystemError(DIAGNOSTICS_CATEGORY_NONE, ModuleHandle, ErrorCode);
+}
+
+///////////////////////////////////////////////////////////////////////
+// SetCategoryLevel
+//
+// Level takes the DIAGNOSTICS_* output flags, and applies to reports in
+// the category instead of the output level, whether that is set in code
+// or by a config source, and instead of any level the config source
+// has for the category.  DIAGNOSTICS_CATEGORY_DEFAULT makes the
+// category follow those again.  Can be changed while other threads are
+// reporting.
+///////////////////////////////////////////////////////////////////////
+bool
+Diagnostics::SetCategoryLevel(
+	int	CategoryId,
+	int	Level)
 {
 	bool	ReturnCode	= false;
 
-	TCHAR*	ErrorMessageBuffer	= NULL;
-	//LPVOID	ErrorMessageBuffer	= NULL;
-	DWORD	ErrorCode			= GetLastError();
-	DWORD	ResultCode;
-	DWORD	FormatFlags			= FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM;
+	if ((DIAGNOSTICS_CATEGORY_NONE < CategoryId) &&
+		(CategoryId < DIAGNOSTICS_CATEGORIES) &&
+		(DIAGNOSTICS_FROMREGISTRY != Level))
+	{
+		LONG	OldLevel	= InterlockedExchange(&m_CategoryLevels[CategoryId], Level);
+
+		if ((DIAGNOSTICS_CATEGORY_DEFAULT == OldLevel) &&
+			(DIAGNOSTICS_CATEGORY_DEFAULT != Level))
+		{
+			InterlockedIncrement(&m_CategoryOverrides);
+		}
+		else if ((DIAGNOSTICS_CATEGORY_DEFAULT != OldLevel) &&
+			(DIAGNOSTICS_CATEGORY_DEFAULT == Level))
+		{
+			InterlockedDecrement(&m_CategoryOverrides);
+		}
+
+		ReturnCode = true;
+	}
 
-	if (NULL != ModuleHandle)
+	return ReturnCode;
+}
+
+bool
+Diagnostics::SetCategoryLevel(
+	LPCTSTR	Name,
+	int		Level)
+{
+	return SetCategoryLevel(GetCategoryId(Name), Level);
+}
+
+///////////////////////////////////////////////////////////////////////
+// SetConfigSource
+//
+// While a source is set, a level it holds takes precedence over the one
+// set by SetDiagnosticOutput; when it holds none, that one applies.  The
+// same goes for its category levels and log file.  The source is not
+// owned, and must outlive its use here.  NULL removes it.  Not to be
+// changed while other threads are reporting.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::SetConfigSource(
+	ConfigSource*	Source)
+{
+	if (Source != m_RegistrySource)
 	{
-		FormatFlags |= FORMAT_MESSAGE_FROM_HMODULE;
+		m_RegistryOverride = false;
+		ReleaseRegistrySource();
 	}
 
-	ResultCode	= FormatMessage(FormatFlags,
-								ModuleHandle,
-								ErrorCode,
-								MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-								(TCHAR*)&ErrorMessageBuffer,
-								0,
-								NULL);
+	m_ConfigSource = Source;
+
+	if ((NULL != m_OwnedConfigSource) && (Source != m_OwnedConfigSource))
+	{
+		// not delete, which would wait for its watch thread
+		m_OwnedConfigSource->Release();
+		m_OwnedConfigSource = NULL;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// SetRegistryOverride
+//
+// When on, the Diagnostics value in the registry, whenever it is set,
+// takes precedence over the level set in code.  Not to be changed while
+// other threads are reporting.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::SetRegistryOverride(
+	bool	RegistryOverride)
+{
+	m_RegistryOverride = RegistryOverride;
 
-	if (NULL != ErrorMessageBuffer)
+	if (true == RegistryOverride)
 	{
-		size_t	ErrorMessageLength	= (_tcslen(ErrorMessageBuffer) + 13) * sizeof(TCHAR);
-		TCHAR*	ErrorMessage		= new TCHAR[ErrorMessageLength];
+		if (NULL == m_RegistrySource)
+		{
+			m_RegistrySource = RegistryConfigSource::AcquireDefault();
+		}
 
-		_stprintf_s(ErrorMessage, ErrorMessageLength, _T("%x: %s"), ErrorCode, ErrorMessageBuffer);
+		m_ConfigSource = m_RegistrySource;
+	}
+	else
+	{
+		ReleaseRegistrySource();
+	}
+}
 
-		//TRACE(_T("Error: %s\r\n"), ErrorMsg);
-		OutputDebugString(ErrorMessage);
-		Report(ErrorMessage);
-		delete ErrorMessage;
-		LocalFree(ErrorMessageBuffer);
+///////////////////////////////////////////////////////////////////////
+// SetStackCapture
+//
+// When on, exception and error reports carry a "stack" field holding
+// the hash of the caller's stack, and each distinct stack is written
+// once, as its own record, by a background thread.  Turning it off
+// waits for the stacks already captured to be written.  Not to be
+// changed while other threads are reporting.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::SetStackCapture(
+	bool	Enable)
+{
+	if ((true == Enable) && (NULL == m_StackTracer))
+	{
+		m_StackTracer = new StackTracer(WriteStackTrace, this, m_Telemetry);
+	}
+	else if ((false == Enable) && (NULL != m_StackTracer))
+	{
+		delete m_StackTracer;
+		m_StackTracer = NULL;
+	}
+}
 
-		ReturnCode = true;
+///////////////////////////////////////////////////////////////////////
+// SetStructuredSink
+//
+// The sink is not owned, and must outlive its use here.  NULL removes it.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::SetStructuredSink(
+	StructuredSink*	Sink)
+{
+	m_StructuredSink = Sink;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Output
+//
+// Sends the text of a record to each output that is turned on.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::Output(
+	UINT	OutputLevel,
+	LPCTSTR Message,
+	size_t	MessageLength)
+{
+	if (DIAGNOSTICS_LOGFILE & OutputLevel)
+	{
+		Write(Message, MessageLength);
+	}
+
+	if (DIAGNOSTICS_CONSOLE & OutputLevel)
+	{
+		_tprintf_s(_T("%.*s\r\n"), (int)MessageLength, Message);
+	}
+
+	if (DIAGNOSTICS_POPUPS & OutputLevel)
+	{
+		// MessageBox needs a terminated copy
+		ArenaScope	Scope;
+		TCHAR*		PopupMessage	= Scope.AllocateString(MessageLength + 1);
+
+		if (NULL != PopupMessage)
+		{
+			*AppendString(PopupMessage, Message, MessageLength) = _T('\0');
+
+			MessageBox( GetActiveWindow(), PopupMessage, _T("Zenware"), MB_OK);
+		}
+		else
+		{
+			AddMetric(m_RecordsDropped, 1);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// ReportRecord
+//
+// The structured sink gets the fields as encoded; the text outputs get
+// them rendered after the message, as " key=value" pairs.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::ReportRecord(
+	UINT				OutputLevel,
+	LPCTSTR				Message,
+	size_t				MessageLength,
+	const RecordFields*	Fields)
+{
+	if (NULL == Message)
+	{
+		Message			= _T("");
+		MessageLength	= 0;
+	}
+
+	if ((DIAGNOSTICS_NONE == OutputLevel) && (NULL == m_StructuredSink))
+	{
+		AddMetric(m_RecordsSuppressed, 1);
+	}
+	else
+	{
+		// the clock read and the shared histogram cost more than the
+		// sharded counter, so only a sample of reports is timed
+		LONGLONG	Accepted	= AddMetric(m_RecordsAccepted, 1);
+		bool		Timed		= (NULL != m_ReportTime) &&
+			(0 == Accepted % REPORT_TIME_SAMPLING);
+		LONGLONG	StartCount	= 0;
+		const BYTE*	FieldsData	= NULL;
+		size_t		FieldsSize	= 0;
+
+		if (true == Timed)
+		{
+			StartCount = GetPerformanceCount();
+		}
+
+		if ((NULL != Fields) && (0 < Fields->GetSize()))
+		{
+			FieldsData	= Fields->GetData();
+			FieldsSize	= Fields->GetSize();
+		}
+
+		if (NULL != m_StructuredSink)
+		{
+			m_StructuredSink->WriteRecord(Message,
+				MessageLength,
+				FieldsData,
+				FieldsSize);
+		}
+
+		if ((DIAGNOSTICS_NONE != OutputLevel) && (NULL == FieldsData))
+		{
+			Output(OutputLevel, Message, MessageLength);
+		}
+		else if (DIAGNOSTICS_NONE != OutputLevel)
+		{
+			ArenaScope	Scope;
+			size_t		RenderBound	= Fields->GetRenderBound();
+			TCHAR*		Record		= Scope.AllocateString(MessageLength + RenderBound);
+
+			if (NULL != Record)
+			{
+				TCHAR*	Position	= AppendString(Record, Message, MessageLength);
+
+				Position += Fields->Render(Position, RenderBound);
+
+				Output(OutputLevel, Record, Position - Record);
+			}
+			else
+			{
+				AddMetric(m_RecordsDropped, 1);
+			}
+		}
+
+		if (true == Timed)
+		{
+			RecordReportTime(m_ReportTime, StartCount);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// StartStatisticsReports
+//
+// Reports the library's own metrics, the ones GetStatistics reads,
+// every interval until StopStatisticsReports.
+///////////////////////////////////////////////////////////////////////
+bool
+Diagnostics::StartStatisticsReports(
+	DWORD	IntervalMilliseconds)
+{
+	bool	ReturnCode	= false;
+
+	if (NULL != m_Telemetry)
+	{
+		ReturnCode = m_Telemetry->StartSnapshots(IntervalMilliseconds);
 	}
 
 	return ReturnCode;
 }
 
-void Diagnostics::SetRegistryOverride(bool RegistryOverride)
+void
+Diagnostics::StopStatisticsReports(void)
 {
+	if (NULL != m_Telemetry)
+	{
+		m_Telemetry->StopSnapshots();
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -259,15 +983,17 @@ void Diagnostics::SetRegistryOverride(bool RegistryOverride)
 ///////////////////////////////////////////////////////////////////////
 void
 Diagnostics::Write(
-	LPCTSTR EventToReport)
+	LPCTSTR EventToReport,
+	size_t	EventLength)
 {
 	HANDLE		FileHandle				= INVALID_HANDLE_VALUE;
+	bool		Written					= false;
 	SYSTEMTIME	CurrentTime;
 	TCHAR		CurrentTimeString[128];
 
 	GetLocalTime(&CurrentTime);
 
-	_stprintf_s(CurrentTimeString,
+	int	TimeLength	= _stprintf_s(CurrentTimeString,
 				_T(" %04d/%02d/%02d::%02d:%02d:%02d "),
 				CurrentTime.wYear,
 				CurrentTime.wMonth,
@@ -276,9 +1002,30 @@ Diagnostics::Write(
 				CurrentTime.wMinute,
 				CurrentTime.wSecond);
 
-	if (NULL != m_LogFilePath)
+	// a log file named by the config source replaces the one set here;
+	// the source's settings are only pinned while the file is opened
+	ConfigSource*			Source		= m_ConfigSource;
+	const ConfigSettings*	Settings	= NULL;
+	int						ReadToken	= 0;
+	LPCTSTR					LogFilePath	= NULL;
+
+	if (NULL != Source)
+	{
+		Settings = Source->BeginRead(&ReadToken);
+	}
+
+	if (NULL != Settings)
+	{
+		LogFilePath = Settings->LogFilePath.GetString();
+	}
+	else if (false == m_LogFilePath.IsEmpty())
+	{
+		LogFilePath = m_LogFilePath.GetString();
+	}
+
+	if (NULL != LogFilePath)
 	{
-		FileHandle	= CreateFile(m_LogFilePath,
+		FileHandle	= CreateFile(LogFilePath,
 								GENERIC_WRITE,
 								FILE_SHARE_READ | FILE_SHARE_WRITE,
 								0,
@@ -287,68 +1034,89 @@ Diagnostics::Write(
 								0);
 	}
 
+	if (NULL != Source)
+	{
+		Source->EndRead(ReadToken);
+	}
+
 	if (INVALID_HANDLE_VALUE != FileHandle)
 	{
-		DWORD	BytesRead	= 0;
+		DWORD		BytesRead		= 0;
+		ArenaScope	Scope;
+		size_t		VersionLength	= m_Version.GetLength();
+		size_t		MessageLength	= VersionLength + TimeLength + EventLength + 2;
 
-		TCHAR*	TotalMessage = ConcatStringsV(m_Version, CurrentTimeString, EventToReport, _T("\r\n"), NULL);
+		TCHAR*	TotalMessage = Scope.AllocateString(MessageLength + 1);
 
 		if (NULL != TotalMessage)
 		{
-			size_t	BufferSize		= _tcslen(TotalMessage);
+			TCHAR*	Position	= TotalMessage;
+
+			Position	= AppendString(Position, m_Version.GetString(), VersionLength);
+			Position	= AppendString(Position, CurrentTimeString, TimeLength);
+			Position	= AppendString(Position, EventToReport, EventLength);
+			Position	= AppendString(Position, _T("\r\n"), 2);
+			*Position	= _T('\0');
 
-			char*	AnsiTotalMessage	= GetMultiByteString(TotalMessage);
+			int		AnsiBufferSize		= (int)MessageLength * 2 + 2;
+			char*	AnsiTotalMessage	= Scope.AllocateStringA(AnsiBufferSize);
 
 			if (NULL != AnsiTotalMessage)
 			{
-				SetFilePointer(FileHandle, 0, NULL, FILE_END);
+				int	BufferSize	= GetMultiByteStringFromUnicodeString(TotalMessage,
+												AnsiTotalMessage,
+												AnsiBufferSize,
+												-1);
 
-				WriteFile(FileHandle, AnsiTotalMessage, (DWORD)BufferSize, &BytesRead, NULL);
+				SetFilePointer(FileHandle, 0, NULL, FILE_END);
 
-				CloseHandle(FileHandle);
+				if (FALSE != WriteFile(FileHandle, AnsiTotalMessage, (DWORD)BufferSize, &BytesRead, NULL))
+				{
+					Written = true;
+				}
 
-				delete AnsiTotalMessage;
+				AddMetric(m_WriteCalls, 1);
+				AddMetric(m_BytesWritten, BytesRead);
 			}
-
-			delete TotalMessage;
 		}
+
+		CloseHandle(FileHandle);
+	}
+
+	if (false == Written)
+	{
+		AddMetric(m_RecordsDropped, 1);
 	}
 }
 
-bool Diagnostics::ReportError(LPCTSTR Module, HRESULT ErrorCode)
+bool
+Diagnostics::ReportError(
+	const InternedString&	Module,
+	HRESULT					ErrorCode)
 {
-	bool	ReturnCode	= false;
-
-	TCHAR*	ErrorMessageBuffer	= NULL;
-	DWORD	ResultCode;
-	DWORD	FormatFlags			= FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM;
+	return ReportError(Module.GetString(), Module.GetLength(), ErrorCode);
+}
 
-	ResultCode	= FormatMessage(FormatFlags,
-								NULL,
-								ErrorCode,
-								//MAKELANGID(LANG_NEUTRAL, SUBLANG_SYS_DEFAULT),
-								MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-								(TCHAR*)&ErrorMessageBuffer,
-								0,
-								NULL);
+bool Diagnostics::ReportError(LPCTSTR Module, HRESULT ErrorCode)
+{
+	size_t	ModuleLength	= 0;
 
-	if (NULL != ErrorMessageBuffer)
+	if (NULL != Module)
 	{
-		size_t	ErrorMessageLength	= (_tcslen(ErrorMessageBuffer) + 13) * sizeof(TCHAR);
-		TCHAR*	ErrorMessage		= new TCHAR[ErrorMessageLength];
-
-		_stprintf_s(ErrorMessage, ErrorMessageLength, _T("%x: %s"), ErrorCode, ErrorMessageBuffer);
+		ModuleLength = _tcslen(Module);
+	}
 
-		//TRACE(_T("Error: %s\r\n"), ErrorMsg);
-		OutputDebugString(ErrorMessage);
-		Report(ErrorMessage);
-		delete ErrorMessage;
-		LocalFree(ErrorMessageBuffer);
+	return ReportError(Module, ModuleLength, ErrorCode);
+}
 
-		ReturnCode = true;
-	}
+bool Diagnostics::ReportError(LPCTSTR Module, size_t ModuleLength, HRESULT ErrorCode)
+{
+	return ReportSystemError(FindModuleCategory(Module, ModuleLength), NULL, ErrorCode);
+}
 
-	return ReturnCode;
+bool Diagnostics::ReportError(int CategoryId, HRESULT ErrorCode)
+{
+	return ReportSystemError(CategoryId, NULL, ErrorCode);
 }
 
 bool
@@ -360,8 +1128,9 @@ Diagnostics::ReportGenericError(
 
 	if (NULL != ErrorString)
 	{
-		size_t	ErrorMessageLength	= (_tcslen(ErrorString) + 13) * sizeof(TCHAR);
-		TCHAR*	ErrorMessage		= new TCHAR[ErrorMessageLength];
+		ArenaScope	Scope;
+		size_t	ErrorMessageLength	= _tcslen(ErrorString) + 13;
+		TCHAR*	ErrorMessage		= Scope.AllocateString(ErrorMessageLength);
 
 		if (NULL != ErrorMessage)
 		{
@@ -369,7 +1138,6 @@ Diagnostics::ReportGenericError(
 
 			OutputDebugString(ErrorMessage);
 			Report(ErrorMessage);
-			delete ErrorMessage;
 
 			ReturnCode = true;
 		}
@@ -383,11 +1151,59 @@ Diagnostics::ReportString(
 	LPCTSTR	InfoString,
 	LPCTSTR String)
 {
-	LPCTSTR	TotalString	= ConcatStringsV(InfoString, _T(": "), String);
+	size_t	InfoStringLength	= 0;
+	size_t	StringLength		= 0;
 
-	Report(TotalString);
+	if (NULL != InfoString)
+	{
+		InfoStringLength = _tcslen(InfoString);
+	}
+
+	if (NULL != String)
+	{
+		StringLength = _tcslen(String);
+	}
 
-	return true;
+	return ReportString(InfoString, InfoStringLength, String, StringLength);
+}
+
+bool
+Diagnostics::ReportString(
+	LPCTSTR	InfoString,
+	size_t	InfoStringLength,
+	LPCTSTR String,
+	size_t	StringLength)
+{
+	bool	ReturnCode	= false;
+
+	if (NULL == InfoString)
+	{
+		InfoStringLength = 0;
+	}
+
+	if (NULL == String)
+	{
+		StringLength = 0;
+	}
+
+	ArenaScope	Scope;
+	size_t	TotalStringLength	= InfoStringLength + 2 + StringLength;
+	TCHAR*	TotalString			= Scope.AllocateString(TotalStringLength);
+
+	if (NULL != TotalString)
+	{
+		TCHAR*	Position	= TotalString;
+
+		Position	= AppendString(Position, InfoString, InfoStringLength);
+		Position	= AppendString(Position, _T(": "), 2);
+		Position	= AppendString(Position, String, StringLength);
+
+		Report(TotalString, TotalStringLength);
+
+		ReturnCode = true;
+	}
+
+	return ReturnCode;
 }
 
 bool
@@ -399,15 +1215,15 @@ Diagnostics::ReportValue(
 
 	if (NULL != InfoString)
 	{
-		size_t	InfoMessageLength	= (_tcslen(InfoString) + 13) * sizeof(TCHAR);
-		TCHAR*	InfoMessage			= new TCHAR[InfoMessageLength];
+		ArenaScope	Scope;
+		size_t	InfoMessageLength	= _tcslen(InfoString) + 13;
+		TCHAR*	InfoMessage			= Scope.AllocateString(InfoMessageLength);
 
 		if (NULL != InfoMessage)
 		{
 			_stprintf_s(InfoMessage, InfoMessageLength, _T("0x%08X: %s"), Value, InfoString);
 
 			Report(InfoMessage);
-			delete InfoMessage;
 
 			ReturnCode = true;
 		}
@@ -416,35 +1232,186 @@ Diagnostics::ReportValue(
 	return ReturnCode;
 }
 
-DWORD
-Diagnostics::GetOutputRegistryKey()
+///////////////////////////////////////////////////////////////////////
+// ReportSystemError
+//
+// Common system messages come from the built in catalog, the rest from
+// the shared error message cache, so a repeated error is formatted only
+// once.  Fields, if given, already hold the caller's stack trace, which
+// is then not captured again.
+///////////////////////////////////////////////////////////////////////
+bool
+Diagnostics::ReportSystemError(
+	int					CategoryId,
+	HMODULE				ModuleHandle,
+	DWORD				ErrorCode,
+	const RecordFields*	Fields)
+{
+	bool			ReturnCode		= false;
+	LPCTSTR			MessageText		= NULL;
+	size_t			MessageLength	= 0;
+	InternedString	Message;
+
+	if ((NULL != ModuleHandle) || (false == LookupErrorCatalog(ErrorCode,
+		ERROR_MESSAGE_LANGUAGE_DEFAULT, &MessageText, &MessageLength)))
+	{
+		Message			= GetErrorMessage(ModuleHandle, ErrorCode);
+		MessageText		= Message.GetString();
+		MessageLength	= Message.GetLength();
+	}
+
+	if (0 < MessageLength)
+	{
+		ArenaScope	Scope;
+		size_t		ErrorMessageLength	= MessageLength + 13;
+		TCHAR*		ErrorMessage		= Scope.AllocateString(ErrorMessageLength);
+
+		if (NULL != ErrorMessage)
+		{
+			int		PrefixLength	= _stprintf_s(ErrorMessage, ErrorMessageLength, _T("%x: "), ErrorCode);
+
+			*AppendString(ErrorMessage + PrefixLength, MessageText, MessageLength) = _T('\0');
+
+			RecordFields	StackFields;
+
+			if (NULL == Fields)
+			{
+				AddStackTrace(&StackFields);
+				Fields = &StackFields;
+			}
+
+			//TRACE(_T("Error: %s\r\n"), ErrorMsg);
+			OutputDebugString(ErrorMessage);
+			Report(CategoryId, ErrorMessage, PrefixLength + MessageLength, *Fields);
+
+			ReturnCode = true;
+		}
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// FindModuleCategory
+//
+// Only looked up while some category has a level of its own.  The
+// lookup takes no lock and does not intern the module name.
+///////////////////////////////////////////////////////////////////////
+int
+Diagnostics::FindModuleCategory(
+	LPCTSTR	Module,
+	size_t	ModuleLength) const
 {
-	DWORD	ReturnValue	= 0;
-	LONG	lRet		= -1;
-	HKEY	hKey;
-	DWORD	BufferSize	= sizeof(DWORD);
+	int	CategoryId	= DIAGNOSTICS_CATEGORY_NONE;
 
-	lRet = RegOpenKeyEx(	HKEY_LOCAL_MACHINE,
-							_T("SOFTWARE\\Zenware"),
-							0,
-							KEY_READ,
-							&hKey);
+	ConfigSource*	Source		= m_ConfigSource;
+	bool			HasLevels	= (0 < m_CategoryOverrides);
+
+	if ((NULL != Source) && (true == Source->HasCategoryLevels()))
+	{
+		HasLevels = true;
+	}
 
-	if (ERROR_SUCCESS == lRet)
+	if ((true == HasLevels) && (NULL != Module) && (0 < ModuleLength))
 	{
-		lRet	= RegQueryValueEx(	hKey,
-									_T("Diagnostics"),
-									0,
-									NULL,
-									(LPBYTE)&ReturnValue,
-									&BufferSize);
+		CategoryId = CategoryTable::Find(Module, ModuleLength);
+	}
+
+	return CategoryId;
+}
 
-		RegCloseKey( hKey );
+void
+Diagnostics::InitializeCategories(void)
+{
+	for (int Index = 0; Index < DIAGNOSTICS_CATEGORIES; Index++)
+	{
+		m_CategoryLevels[Index] = DIAGNOSTICS_CATEGORY_DEFAULT;
 	}
+}
 
-	return ReturnValue;
+///////////////////////////////////////////////////////////////////////
+// InitializeTelemetry
+//
+// The library's own metrics live in a registry of their own, so they
+// can be reported like any other metrics.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::InitializeTelemetry(void)
+{
+	m_StartCount	= GetPerformanceCount();
+	m_Telemetry		= new MetricsRegistry(*this);
+
+	if (NULL != m_Telemetry)
+	{
+		m_RecordsAccepted	= m_Telemetry->GetCounter(_T("diagnostics.records_accepted"));
+		m_RecordsSuppressed	= m_Telemetry->GetCounter(_T("diagnostics.records_suppressed"));
+		m_RecordsDropped	= m_Telemetry->GetCounter(_T("diagnostics.records_dropped"));
+		m_BytesWritten		= m_Telemetry->GetCounter(_T("diagnostics.bytes_written"));
+		m_WriteCalls		= m_Telemetry->GetCounter(_T("diagnostics.write_calls"));
+		m_ReportTime		= m_Telemetry->GetHistogram(_T("diagnostics.report_time_us"));
+
+		// created now so snapshots always list them
+		m_Telemetry->GetGauge(_T("diagnostics.stack_queue_high_water"));
+		m_Telemetry->GetCounter(_T("diagnostics.symbolizer_busy_us"));
+	}
 }
 
+///////////////////////////////////////////////////////////////////////
+// AddStackTrace
+//
+// Only the return addresses are captured here; the first report of a
+// stack hands it to the symbolizer.
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::AddStackTrace(
+	RecordFields*	Fields)
+{
+	if (NULL != m_StackTracer)
+	{
+		StackTrace	Trace;
+
+		// this frame, and the reporting method that called it
+		if (true == CaptureStackTrace(2, &Trace))
+		{
+			m_StackTracer->Submit(Trace);
+			Fields->AddUnsigned(_T("stack"), Trace.Hash);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// ReleaseRegistrySource
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::ReleaseRegistrySource(void)
+{
+	if (NULL != m_RegistrySource)
+	{
+		if (m_RegistrySource == m_ConfigSource)
+		{
+			m_ConfigSource = NULL;
+		}
+
+		m_RegistrySource = NULL;
+		RegistryConfigSource::ReleaseDefault();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// SetLogFilePath
+///////////////////////////////////////////////////////////////////////
+void
+Diagnostics::SetLogFilePath(
+	TCHAR*	BaseFileName)
+{
+	TCHAR*	LogFilePath	= GetUserDataPath(BaseFileName);
+
+	if (NULL != LogFilePath)
+	{
+		m_LogFilePath = InternedString(LogFilePath);
+		delete LogFilePath;
+	}
+}
 
 ///////////////////////////////////////////////////////////////////////
 // GetUserDataFilePath
@@ -12,6 +12,15 @@
 // Includes
 ///////////////////////////////////////////////////////////////////////
 #include "../Include/common.h"
+#include "../Utils/InternedString.h"
+#include "Categories.h"
+#include "ConfigSource.h"
+#include "RecordFields.h"
+
+#if defined(UNICODE) && defined(_MSVC_LANG) && (_MSVC_LANG >= 201703L)
+#include <string_view>
+#define DIAGNOSTICS_STRING_VIEW
+#endif
 
 ///////////////////////////////////////////////////////////////////////
 // defines
@@ -23,9 +32,40 @@ const int DIAGNOSTICS_CONSOLE		= 4;
 const int DIAGNOSTICS_EVENTLOG		= 8;
 const int DIAGNOSTICS_FROMREGISTRY	= 16;
 
+class MetricCounter;
+class MetricHistogram;
+class MetricsRegistry;
+class StackTracer;
+
 VOID
 DbgPrintf(LPTSTR fmt, ...);
 
+///////////////////////////////////////////////////////////////////////
+// DiagnosticsStatistics
+//
+// What the library itself has done, since the Diagnostics object was
+// created.  Times are in microseconds.
+///////////////////////////////////////////////////////////////////////
+struct DiagnosticsStatistics
+{
+	// reports that went to at least one output
+	LONGLONG	RecordsAccepted;
+	// reports made while every output was off
+	LONGLONG	RecordsSuppressed;
+	// records lost to a failed open, write or allocation, or to a full
+	// stack queue
+	LONGLONG	RecordsDropped;
+	LONGLONG	BytesWritten;
+	LONGLONG	WriteCalls;
+	LONGLONG	StackQueueHighWater;
+	// time the caller spends in Report, from a sample of reports
+	LONGLONG	ReportTimeMedian;
+	LONGLONG	ReportTime99;
+	LONGLONG	ReportTimeMaximum;
+	// share of the time the stack symbolizer thread was busy, 0 to 1
+	double		SymbolizerUtilization;
+};
+
 ///////////////////////////////////////////////////////////////////////
 // Class: Diagnostics
 ///////////////////////////////////////////////////////////////////////
@@ -41,16 +81,81 @@ class DllExport Diagnostics
 				TCHAR*	Version);
 			~Diagnostics(void);
 
+			static int GetCategoryId(
+				LPCTSTR	Name);
+			bool GetStatistics(
+				DiagnosticsStatistics*	Statistics);
+			// true if reports go anywhere
+			bool IsEnabled(void) const
+			{
+				return (DIAGNOSTICS_NONE != GetOutputLevel()) ||
+					(NULL != m_StructuredSink);
+			}
+			bool IsEnabled(
+				int	CategoryId) const
+			{
+				return (DIAGNOSTICS_NONE != GetOutputLevel(CategoryId)) ||
+					(NULL != m_StructuredSink);
+			}
+
+			bool LoadConfigFile(
+				LPCTSTR	FilePath);
 			void Report(
 				LPCTSTR Message);
+			void Report(
+				LPCTSTR Message,
+				size_t	MessageLength);
+			void Report(
+				LPCTSTR				Message,
+				const RecordFields&	Fields);
+			void Report(
+				LPCTSTR				Message,
+				size_t				MessageLength,
+				const RecordFields&	Fields);
+			void Report(
+				int		CategoryId,
+				LPCTSTR	Message);
+			void Report(
+				int		CategoryId,
+				LPCTSTR	Message,
+				size_t	MessageLength);
+			void Report(
+				int					CategoryId,
+				LPCTSTR				Message,
+				size_t				MessageLength,
+				const RecordFields&	Fields);
 			void Report(
 				const char* Message);
+			void Report(
+				const char* Message,
+				size_t		MessageLength);
 			bool ReportError(
 				LPCTSTR Module,
 				HRESULT ErrorCode);
+			bool ReportError(
+				LPCTSTR Module,
+				size_t	ModuleLength,
+				HRESULT ErrorCode);
+			bool ReportError(
+				const InternedString&	Module,
+				HRESULT					ErrorCode);
+			bool ReportError(
+				int		CategoryId,
+				HRESULT	ErrorCode);
 			void ReportException(
 				LPCTSTR Module,
 				LPCTSTR Message);
+			void ReportException(
+				LPCTSTR Module,
+				size_t	ModuleLength,
+				LPCTSTR Message,
+				size_t	MessageLength);
+			void ReportException(
+				const InternedString&	Module,
+				LPCTSTR					Message);
+			void ReportException(
+				int		CategoryId,
+				LPCTSTR	Message);
 			bool ReportGenericError(
 				LPCTSTR ErrorString,
 				long ErrorCode);
@@ -59,31 +164,179 @@ class DllExport Diagnostics
 			bool ReportString(
 				LPCTSTR	InfoString,
 				LPCTSTR String);
+			bool ReportString(
+				LPCTSTR	InfoString,
+				size_t	InfoStringLength,
+				LPCTSTR String,
+				size_t	StringLength);
 			bool ReportValue(
 				LPCTSTR InfoString,
 				ULONG_PTR Value);
+			bool SetCategoryLevel(
+				int	CategoryId,
+				int	Level);
+			bool SetCategoryLevel(
+				LPCTSTR	Name,
+				int		Level);
+			void SetConfigSource(
+				ConfigSource*	Source);
 			bool SetDiagnosticOutput(
 				int	nOption);
 			void SetRegistryOverride(
 				bool RegistryOverride);
+			void SetStackCapture(
+				bool	Enable);
+			void SetStructuredSink(
+				StructuredSink*	Sink);
+			bool StartStatisticsReports(
+				DWORD	IntervalMilliseconds);
+			void StopStatisticsReports(void);
+
+#ifdef DIAGNOSTICS_STRING_VIEW
+			// The views need not be NUL terminated, and are not copied.
+			void Report(
+				std::wstring_view Message)
+			{
+				Report(Message.data(), Message.size());
+			}
+			void Report(
+				std::string_view Message)
+			{
+				Report(Message.data(), Message.size());
+			}
+			bool ReportError(
+				std::wstring_view	Module,
+				HRESULT				ErrorCode)
+			{
+				return ReportError(Module.data(), Module.size(), ErrorCode);
+			}
+			void ReportException(
+				std::wstring_view Module,
+				std::wstring_view Message)
+			{
+				ReportException(Module.data(), Module.size(),
+					Message.data(), Message.size());
+			}
+			bool ReportString(
+				std::wstring_view InfoString,
+				std::wstring_view String)
+			{
+				return ReportString(InfoString.data(), InfoString.size(),
+					String.data(), String.size());
+			}
+#endif
 
 	private:
 		// Properties
-			UINT		m_OutputLevel;
-			TCHAR*		m_LogFilePath;
-			TCHAR*		m_Version;
+			UINT					m_OutputLevel;
+			ConfigSource* volatile	m_ConfigSource;
+			// held while the default registry source is in use
+			RegistryConfigSource*	m_RegistrySource;
+			bool					m_RegistryOverride;
+			// created by LoadConfigFile
+			FileConfigSource*		m_OwnedConfigSource;
+			// DIAGNOSTICS_CATEGORY_DEFAULT, or the level for the category
+			volatile LONG			m_CategoryLevels[DIAGNOSTICS_CATEGORIES];
+			// categories with a level of their own
+			volatile LONG			m_CategoryOverrides;
+			InternedString			m_LogFilePath;
+			InternedString			m_Version;
+			StructuredSink*			m_StructuredSink;
+			StackTracer*			m_StackTracer;
+			MetricsRegistry*		m_Telemetry;
+			MetricCounter*			m_RecordsAccepted;
+			MetricCounter*			m_RecordsSuppressed;
+			MetricCounter*			m_RecordsDropped;
+			MetricCounter*			m_BytesWritten;
+			MetricCounter*			m_WriteCalls;
+			MetricHistogram*		m_ReportTime;
+			LONGLONG				m_StartCount;
 
 		// Methods
+			void AddStackTrace(
+				RecordFields*	Fields);
 			TCHAR* ConcatStrings(
 				TCHAR*	FirstString,
 				TCHAR*	SecondString);
 			TCHAR* GetStringCopy(
 				LPCTSTR	SourceString);
-			DWORD GetOutputRegistryKey();
+			int FindModuleCategory(
+				LPCTSTR	Module,
+				size_t	ModuleLength) const;
+			void InitializeCategories(void);
+			void InitializeTelemetry(void);
+			// the level the source holds, if any, else the one set in code
+			UINT GetOutputLevel(void) const
+			{
+				UINT			Level	= m_OutputLevel;
+				ConfigSource*	Source	= m_ConfigSource;
+
+				if (NULL != Source)
+				{
+					LONG	Configured	= Source->GetLevel();
+
+					if (CONFIG_LEVEL_UNSET != Configured)
+					{
+						Level = (UINT)Configured;
+					}
+				}
+
+				return Level;
+			}
+			UINT GetOutputLevel(
+				int	CategoryId) const
+			{
+				LONG			Level	= DIAGNOSTICS_CATEGORY_DEFAULT;
+				ConfigSource*	Source	= m_ConfigSource;
+
+				if ((DIAGNOSTICS_CATEGORY_NONE < CategoryId) &&
+					(CategoryId < DIAGNOSTICS_CATEGORIES))
+				{
+					Level = m_CategoryLevels[CategoryId];
+				}
+
+				if ((DIAGNOSTICS_CATEGORY_DEFAULT == Level) &&
+					(NULL != Source))
+				{
+					Level = Source->GetCategoryLevel(CategoryId);
+				}
+
+				if ((DIAGNOSTICS_CATEGORY_DEFAULT == Level) ||
+					(CONFIG_LEVEL_UNSET == Level))
+				{
+					Level = (LONG)GetOutputLevel();
+				}
+
+				return (UINT)Level;
+			}
+			void ReleaseRegistrySource(void);
+			void Output(
+				UINT	OutputLevel,
+				LPCTSTR	Message,
+				size_t	MessageLength);
+			void ReportModuleException(
+				int		CategoryId,
+				LPCTSTR Module,
+				size_t	ModuleLength,
+				LPCTSTR Message,
+				size_t	MessageLength);
+			void ReportRecord(
+				UINT				OutputLevel,
+				LPCTSTR				Message,
+				size_t				MessageLength,
+				const RecordFields*	Fields);
+			bool ReportSystemError(
+				int					CategoryId,
+				HMODULE				ModuleHandle,
+				DWORD				ErrorCode,
+				const RecordFields*	Fields = NULL);
+			void SetLogFilePath(
+				TCHAR*	BaseFileName);
 			TCHAR* GetUserDataPath(
 				TCHAR*	FileName);
 			void Write(
-				LPCTSTR EventToReport);
+				LPCTSTR EventToReport,
+				size_t	EventLength);
 			int GetMultiByteStringFromUnicodeString(
 				LPCWSTR szUnicodeString,
 				//wchar_t * szUnicodeString,
@@ -0,0 +1,263 @@
+///////////////////////////////////////////////////////////////////////
+// MessageArena.cpp - Class Implementation
+//
+// Per-thread bump allocator for the temporary strings built while
+// reporting a diagnostic event.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "MessageArena.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+#define ARENA_ALIGNMENT	8
+
+// header in front of every block that had to come from the heap
+struct HeapBlock
+{
+	HeapBlock*	Next;
+	ULONGLONG	Alignment;
+};
+
+DWORD MessageArena::s_TlsIndex = TLS_OUT_OF_INDEXES;
+
+///////////////////////////////////////////////////////////////////////
+// MessageArena Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Ctors / Dtors
+///////////////////////////////////////////////////////////////////////
+MessageArena::MessageArena(
+	size_t	Capacity) :
+		m_Buffer(NULL),
+		m_Capacity(0),
+		m_Used(0)
+{
+	m_Buffer = new BYTE[Capacity];
+
+	if (NULL != m_Buffer)
+	{
+		m_Capacity = Capacity;
+	}
+}
+
+MessageArena::~MessageArena(void)
+{
+	if (NULL != m_Buffer)
+	{
+		delete[] m_Buffer;
+		m_Buffer = NULL;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Allocate
+//
+// Returns NULL when the arena is full.
+///////////////////////////////////////////////////////////////////////
+void*
+MessageArena::Allocate(
+	size_t	Size)
+{
+	void*	Block		= NULL;
+	size_t	Aligned		= (Size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+	if ((NULL != m_Buffer) && (Aligned <= m_Capacity - m_Used))
+	{
+		Block	= m_Buffer + m_Used;
+		m_Used	+= Aligned;
+	}
+
+	return Block;
+}
+
+size_t
+MessageArena::GetMark(void) const
+{
+	return m_Used;
+}
+
+void
+MessageArena::Rewind(
+	size_t	Mark)
+{
+	if (Mark <= m_Used)
+	{
+		m_Used = Mark;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetThreadArena
+//
+// Returns NULL if the TLS slot is not available, in which case callers
+// use the heap.
+///////////////////////////////////////////////////////////////////////
+MessageArena*
+MessageArena::GetThreadArena(void)
+{
+	MessageArena*	Arena	= NULL;
+
+	// TlsGetValue clears the last error, which ReportLastError still needs
+	DWORD	LastError	= GetLastError();
+
+	if (TLS_OUT_OF_INDEXES != s_TlsIndex)
+	{
+		Arena = (MessageArena*)TlsGetValue(s_TlsIndex);
+
+		if (NULL == Arena)
+		{
+			Arena = new MessageArena(MESSAGE_ARENA_SIZE);
+
+			if (NULL != Arena)
+			{
+				TlsSetValue(s_TlsIndex, Arena);
+			}
+		}
+	}
+
+	SetLastError(LastError);
+
+	return Arena;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Initialize
+//
+// Called from DllMain on DLL_PROCESS_ATTACH.
+///////////////////////////////////////////////////////////////////////
+bool
+MessageArena::Initialize(void)
+{
+	bool	ReturnCode	= true;
+
+	if (TLS_OUT_OF_INDEXES == s_TlsIndex)
+	{
+		s_TlsIndex = TlsAlloc();
+
+		if (TLS_OUT_OF_INDEXES == s_TlsIndex)
+		{
+			ReturnCode = false;
+		}
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// ReleaseThreadArena
+//
+// Called from DllMain on DLL_THREAD_DETACH.
+///////////////////////////////////////////////////////////////////////
+void
+MessageArena::ReleaseThreadArena(void)
+{
+	if (TLS_OUT_OF_INDEXES != s_TlsIndex)
+	{
+		MessageArena*	Arena	= (MessageArena*)TlsGetValue(s_TlsIndex);
+
+		if (NULL != Arena)
+		{
+			delete Arena;
+			TlsSetValue(s_TlsIndex, NULL);
+		}
+	}
+}
+
+void
+MessageArena::Uninitialize(void)
+{
+	if (TLS_OUT_OF_INDEXES != s_TlsIndex)
+	{
+		TlsFree(s_TlsIndex);
+		s_TlsIndex = TLS_OUT_OF_INDEXES;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// ArenaScope Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Ctors / Dtors
+///////////////////////////////////////////////////////////////////////
+ArenaScope::ArenaScope(void) :
+	m_Arena(NULL),
+	m_Mark(0),
+	m_HeapBlocks(NULL)
+{
+	m_Arena = MessageArena::GetThreadArena();
+
+	if (NULL != m_Arena)
+	{
+		m_Mark = m_Arena->GetMark();
+	}
+}
+
+ArenaScope::~ArenaScope(void)
+{
+	HeapBlock*	Block	= (HeapBlock*)m_HeapBlocks;
+
+	while (NULL != Block)
+	{
+		HeapBlock*	Next	= Block->Next;
+
+		delete[] (BYTE*)Block;
+		Block = Next;
+	}
+
+	if (NULL != m_Arena)
+	{
+		m_Arena->Rewind(m_Mark);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Allocate
+///////////////////////////////////////////////////////////////////////
+void*
+ArenaScope::Allocate(
+	size_t	Size)
+{
+	void*	Block	= NULL;
+
+	if (NULL != m_Arena)
+	{
+		Block = m_Arena->Allocate(Size);
+	}
+
+	if (NULL == Block)
+	{
+		// oversized message, or no arena on this thread
+		HeapBlock*	Header	= (HeapBlock*)new BYTE[sizeof(HeapBlock) + Size];
+
+		if (NULL != Header)
+		{
+			Header->Next	= (HeapBlock*)m_HeapBlocks;
+			m_HeapBlocks	= Header;
+			Block			= Header + 1;
+		}
+	}
+
+	return Block;
+}
+
+char*
+ArenaScope::AllocateStringA(
+	size_t	Characters)
+{
+	return (char*)Allocate(Characters * sizeof(char));
+}
+
+TCHAR*
+ArenaScope::AllocateString(
+	size_t	Characters)
+{
+	return (TCHAR*)Allocate(Characters * sizeof(TCHAR));
+}
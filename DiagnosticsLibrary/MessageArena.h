@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////
+// MessageArena.h
+//
+// Per-thread bump allocator for the temporary strings built while
+// reporting a diagnostic event.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "../Include/common.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+const size_t MESSAGE_ARENA_SIZE	= 16 * 1024;
+
+///////////////////////////////////////////////////////////////////////
+// Class: MessageArena
+//
+// One per thread, created on first use and freed on DLL_THREAD_DETACH.
+///////////////////////////////////////////////////////////////////////
+class MessageArena
+{
+	public:
+		// Methods
+			MessageArena(
+				size_t	Capacity);
+			~MessageArena(void);
+
+			void* Allocate(
+				size_t	Size);
+			size_t GetMark(void) const;
+			void Rewind(
+				size_t	Mark);
+
+			static MessageArena* GetThreadArena(void);
+			static bool Initialize(void);
+			static void ReleaseThreadArena(void);
+			static void Uninitialize(void);
+
+	private:
+		// Properties
+			BYTE*	m_Buffer;
+			size_t	m_Capacity;
+			size_t	m_Used;
+
+			static DWORD	s_TlsIndex;
+};
+
+///////////////////////////////////////////////////////////////////////
+// Class: ArenaScope
+//
+// Everything allocated through a scope is released when it goes out
+// of scope.  Scopes nest; the outermost one leaves the arena empty, so
+// the arena is reset after each record.  Requests that do not fit in
+// the arena fall back to the heap.
+///////////////////////////////////////////////////////////////////////
+class ArenaScope
+{
+	public:
+		// Methods
+			ArenaScope(void);
+			~ArenaScope(void);
+
+			void* Allocate(
+				size_t	Size);
+			char* AllocateStringA(
+				size_t	Characters);
+			TCHAR* AllocateString(
+				size_t	Characters);
+
+	private:
+		// Properties
+			MessageArena*	m_Arena;
+			size_t			m_Mark;
+			void*			m_HeapBlocks;
+
+		// Methods
+			ArenaScope(
+				const ArenaScope&);
+			ArenaScope& operator=(
+				const ArenaScope&);
+};
@@ -0,0 +1,773 @@
+///////////////////////////////////////////////////////////////////////
+// Metrics.cpp - Class Implementation
+//
+// Counters, gauges and latency histograms, with periodic snapshots.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include <malloc.h>
+#include <tchar.h>
+#include "Metrics.h"
+#include "Diagnostics.h"
+#include "RecordFields.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+#define HISTOGRAM_SUB_BUCKETS	(1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_VALUE_MAXIMUM	((1LL << HISTOGRAM_VALUE_BITS) - 1)
+
+enum MetricType
+{
+	MetricTypeCounter,
+	MetricTypeGauge,
+	MetricTypeHistogram
+};
+
+struct MetricsRegistry::MetricEntry
+{
+	int				Type;
+	InternedString	Name;
+	MetricEntry*	Next;
+	void*			Metric;
+};
+
+///////////////////////////////////////////////////////////////////////
+// AtomicAdd
+//
+// 64 bit interlocked add, built on compare exchange, which is also
+// available on 32 bit XP.  Returns the new value.
+///////////////////////////////////////////////////////////////////////
+static LONGLONG
+AtomicAdd(
+	volatile LONGLONG*	Target,
+	LONGLONG			Value)
+{
+	LONGLONG	Current	= *Target;
+	LONGLONG	Previous;
+
+	while (Current != (Previous = InterlockedCompareExchange64(Target, Current + Value, Current)))
+	{
+		Current = Previous;
+	}
+
+	return Current + Value;
+}
+
+///////////////////////////////////////////////////////////////////////
+// AtomicRead
+//
+// A plain 64 bit read may tear on 32 bit processors.
+///////////////////////////////////////////////////////////////////////
+static LONGLONG
+AtomicRead(
+	const volatile LONGLONG*	Target)
+{
+	return InterlockedCompareExchange64((volatile LONGLONG*)Target, 0, 0);
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetHighestBit
+///////////////////////////////////////////////////////////////////////
+static int
+GetHighestBit(
+	ULONGLONG	Value)
+{
+	int	Bit	= -1;
+
+	while (0 != Value)
+	{
+		Value >>= 1;
+		Bit++;
+	}
+
+	return Bit;
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetPerformanceCount
+///////////////////////////////////////////////////////////////////////
+LONGLONG
+GetPerformanceCount(void)
+{
+	LARGE_INTEGER	Count;
+
+	QueryPerformanceCounter(&Count);
+
+	return Count.QuadPart;
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetElapsedMicroseconds
+///////////////////////////////////////////////////////////////////////
+ULONGLONG
+GetElapsedMicroseconds(
+	LONGLONG	StartCount,
+	LONGLONG	EndCount)
+{
+	// counts per second, fixed at boot; racing threads store the same value
+	static LONGLONG	Frequency	= 0;
+
+	ULONGLONG		Elapsed		= 0;
+	LONGLONG		Counts		= EndCount - StartCount;
+
+	if (0 == Frequency)
+	{
+		LARGE_INTEGER	PerformanceFrequency;
+
+		if (FALSE != QueryPerformanceFrequency(&PerformanceFrequency))
+		{
+			Frequency = PerformanceFrequency.QuadPart;
+		}
+	}
+
+	if ((0 < Counts) && (0 < Frequency))
+	{
+		// split, so the multiply can't overflow on long intervals
+		Elapsed = (ULONGLONG)(Counts / Frequency) * 1000000 +
+			(ULONGLONG)(Counts % Frequency) * 1000000 / (ULONGLONG)Frequency;
+	}
+
+	return Elapsed;
+}
+
+///////////////////////////////////////////////////////////////////////
+// MetricCounter Class Definition
+///////////////////////////////////////////////////////////////////////
+MetricCounter::MetricCounter(
+	const InternedString&	Name) :
+		m_Name(Name)
+{
+	memset((void*)m_Shards, 0, sizeof(m_Shards));
+}
+
+LONGLONG
+MetricCounter::Add(
+	LONGLONG	Value /* = 1 */)
+{
+	// thread ids are multiples of four
+	size_t	Index	= (GetCurrentThreadId() >> 2) % METRICS_SHARDS;
+
+	return AtomicAdd(&m_Shards[Index].Value, Value);
+}
+
+const InternedString&
+MetricCounter::GetName(void) const
+{
+	return m_Name;
+}
+
+LONGLONG
+MetricCounter::GetValue(void) const
+{
+	LONGLONG	Value	= 0;
+
+	for (size_t Index = 0; Index < METRICS_SHARDS; Index++)
+	{
+		Value += AtomicRead(&m_Shards[Index].Value);
+	}
+
+	return Value;
+}
+
+///////////////////////////////////////////////////////////////////////
+// operator new
+//
+// Returns NULL rather than throwing, as the rest of the library
+// expects of new.
+///////////////////////////////////////////////////////////////////////
+void*
+MetricCounter::operator new(
+	size_t	Size) throw()
+{
+	return _aligned_malloc(Size, METRICS_CACHE_LINE);
+}
+
+void
+MetricCounter::operator delete(
+	void*	Memory)
+{
+	_aligned_free(Memory);
+}
+
+///////////////////////////////////////////////////////////////////////
+// MetricGauge Class Definition
+///////////////////////////////////////////////////////////////////////
+MetricGauge::MetricGauge(
+	const InternedString&	Name) :
+		m_Name(Name),
+		m_Value(0)
+{
+}
+
+void
+MetricGauge::Add(
+	LONGLONG	Value)
+{
+	AtomicAdd(&m_Value, Value);
+}
+
+const InternedString&
+MetricGauge::GetName(void) const
+{
+	return m_Name;
+}
+
+LONGLONG
+MetricGauge::GetValue(void) const
+{
+	return AtomicRead(&m_Value);
+}
+
+void
+MetricGauge::Set(
+	LONGLONG	Value)
+{
+	InterlockedExchange64(&m_Value, Value);
+}
+
+///////////////////////////////////////////////////////////////////////
+// MetricHistogram Class Definition
+///////////////////////////////////////////////////////////////////////
+MetricHistogram::MetricHistogram(
+	const InternedString&	Name) :
+		m_Name(Name)
+{
+	Reset();
+}
+
+LONGLONG
+MetricHistogram::GetCount(void) const
+{
+	LONGLONG	Count	= 0;
+
+	for (size_t Index = 0; Index < HISTOGRAM_BUCKETS; Index++)
+	{
+		Count += m_Buckets[Index];
+	}
+
+	return Count;
+}
+
+LONGLONG
+MetricHistogram::GetMaximum(void) const
+{
+	return AtomicRead(&m_Maximum);
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetMinimum
+//
+// 0 when nothing has been recorded.
+///////////////////////////////////////////////////////////////////////
+LONGLONG
+MetricHistogram::GetMinimum(void) const
+{
+	LONGLONG	Minimum	= AtomicRead(&m_Minimum);
+
+	if (HISTOGRAM_VALUE_MAXIMUM < Minimum)
+	{
+		Minimum = 0;
+	}
+
+	return Minimum;
+}
+
+const InternedString&
+MetricHistogram::GetName(void) const
+{
+	return m_Name;
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetPercentile
+//
+// Percentile is 0 to 100.  Values recorded while this runs may or may
+// not be counted.
+///////////////////////////////////////////////////////////////////////
+LONGLONG
+MetricHistogram::GetPercentile(
+	double	Percentile) const
+{
+	LONGLONG	Value	= 0;
+	LONG		Counts[HISTOGRAM_BUCKETS];
+	LONGLONG	Count	= 0;
+
+	// one pass over the live buckets, so the total matches the counts
+	for (size_t Index = 0; Index < HISTOGRAM_BUCKETS; Index++)
+	{
+		Counts[Index]	= m_Buckets[Index];
+		Count			+= Counts[Index];
+	}
+
+	if (0 < Count)
+	{
+		LONGLONG	Rank	= (LONGLONG)(Percentile / 100.0 * (double)Count + 0.5);
+		LONGLONG	Seen	= 0;
+
+		if (1 > Rank)
+		{
+			Rank = 1;
+		}
+
+		for (size_t Index = 0; Index < HISTOGRAM_BUCKETS; Index++)
+		{
+			Seen += Counts[Index];
+
+			if (Seen >= Rank)
+			{
+				Value = GetBucketMaximum(Index);
+				break;
+			}
+		}
+
+		// the bucket's top can be past anything actually recorded
+		LONGLONG	Maximum	= GetMaximum();
+
+		if (Value > Maximum)
+		{
+			Value = Maximum;
+		}
+	}
+
+	return Value;
+}
+
+LONGLONG
+MetricHistogram::GetSum(void) const
+{
+	return AtomicRead(&m_Sum);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Record
+//
+// Values are clamped to 0 .. 2^40 - 1.
+///////////////////////////////////////////////////////////////////////
+void
+MetricHistogram::Record(
+	LONGLONG	Value)
+{
+	if (0 > Value)
+	{
+		Value = 0;
+	}
+	else if (HISTOGRAM_VALUE_MAXIMUM < Value)
+	{
+		Value = HISTOGRAM_VALUE_MAXIMUM;
+	}
+
+	InterlockedIncrement(&m_Buckets[GetBucketIndex(Value)]);
+	AtomicAdd(&m_Sum, Value);
+
+	LONGLONG	Current	= AtomicRead(&m_Minimum);
+
+	while ((Value < Current) &&
+		(Current != InterlockedCompareExchange64(&m_Minimum, Value, Current)))
+	{
+		Current = AtomicRead(&m_Minimum);
+	}
+
+	Current = AtomicRead(&m_Maximum);
+
+	while ((Value > Current) &&
+		(Current != InterlockedCompareExchange64(&m_Maximum, Value, Current)))
+	{
+		Current = AtomicRead(&m_Maximum);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Reset
+//
+// Not atomic with respect to concurrent recording.
+///////////////////////////////////////////////////////////////////////
+void
+MetricHistogram::Reset(void)
+{
+	for (size_t Index = 0; Index < HISTOGRAM_BUCKETS; Index++)
+	{
+		InterlockedExchange(&m_Buckets[Index], 0);
+	}
+
+	InterlockedExchange64(&m_Sum, 0);
+	InterlockedExchange64(&m_Minimum, HISTOGRAM_VALUE_MAXIMUM + 1);
+	InterlockedExchange64(&m_Maximum, 0);
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetBucketIndex
+//
+// Values below 2 * 2^bits have a bucket each.  Above that, each power
+// of two is split into 2^bits buckets, so the top bits of the value,
+// shifted down to fit, give the bucket within its power of two.
+///////////////////////////////////////////////////////////////////////
+size_t
+MetricHistogram::GetBucketIndex(
+	LONGLONG	Value)
+{
+	int	Shift	= GetHighestBit((ULONGLONG)Value) - HISTOGRAM_SUB_BUCKET_BITS;
+
+	if (0 > Shift)
+	{
+		Shift = 0;
+	}
+
+	return ((size_t)Shift << HISTOGRAM_SUB_BUCKET_BITS) + (size_t)(Value >> Shift);
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetBucketMaximum
+//
+// The highest value that falls in the bucket.
+///////////////////////////////////////////////////////////////////////
+LONGLONG
+MetricHistogram::GetBucketMaximum(
+	size_t	Index)
+{
+	LONGLONG	Value	= (LONGLONG)Index;
+
+	if (2 * HISTOGRAM_SUB_BUCKETS <= Index)
+	{
+		int			Shift	= (int)(Index >> HISTOGRAM_SUB_BUCKET_BITS) - 1;
+		LONGLONG	Top		= (LONGLONG)Index - ((LONGLONG)Shift << HISTOGRAM_SUB_BUCKET_BITS);
+
+		Value = ((Top + 1) << Shift) - 1;
+	}
+
+	return Value;
+}
+
+///////////////////////////////////////////////////////////////////////
+// MetricsRegistry Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Ctors / Dtors
+///////////////////////////////////////////////////////////////////////
+MetricsRegistry::MetricsRegistry(
+	Diagnostics&	Output) :
+		m_Output(&Output),
+		m_Metrics(NULL),
+		m_StopEvent(NULL),
+		m_Thread(NULL),
+		m_Interval(0)
+{
+	InitializeCriticalSection(&m_Lock);
+}
+
+MetricsRegistry::~MetricsRegistry(void)
+{
+	StopSnapshots();
+
+	while (NULL != m_Metrics)
+	{
+		MetricEntry*	Next	= m_Metrics->Next;
+
+		switch (m_Metrics->Type)
+		{
+			case MetricTypeCounter:
+			{
+				delete (MetricCounter*)m_Metrics->Metric;
+				break;
+			}
+			case MetricTypeGauge:
+			{
+				delete (MetricGauge*)m_Metrics->Metric;
+				break;
+			}
+			case MetricTypeHistogram:
+			{
+				delete (MetricHistogram*)m_Metrics->Metric;
+				break;
+			}
+			default:
+			{
+				break;
+			}
+		}
+
+		delete m_Metrics;
+		m_Metrics = Next;
+	}
+
+	DeleteCriticalSection(&m_Lock);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Get methods
+//
+// Return NULL only if memory runs out.  A name can be used by one
+// metric of each type.
+///////////////////////////////////////////////////////////////////////
+MetricCounter*
+MetricsRegistry::GetCounter(
+	LPCTSTR	Name)
+{
+	MetricCounter*	Counter	= NULL;
+	MetricEntry*	Entry	= Find(MetricTypeCounter, Name);
+
+	if (NULL != Entry)
+	{
+		Counter = (MetricCounter*)Entry->Metric;
+	}
+
+	return Counter;
+}
+
+MetricGauge*
+MetricsRegistry::GetGauge(
+	LPCTSTR	Name)
+{
+	MetricGauge*	Gauge	= NULL;
+	MetricEntry*	Entry	= Find(MetricTypeGauge, Name);
+
+	if (NULL != Entry)
+	{
+		Gauge = (MetricGauge*)Entry->Metric;
+	}
+
+	return Gauge;
+}
+
+MetricHistogram*
+MetricsRegistry::GetHistogram(
+	LPCTSTR	Name)
+{
+	MetricHistogram*	Histogram	= NULL;
+	MetricEntry*		Entry		= Find(MetricTypeHistogram, Name);
+
+	if (NULL != Entry)
+	{
+		Histogram = (MetricHistogram*)Entry->Metric;
+	}
+
+	return Histogram;
+}
+
+///////////////////////////////////////////////////////////////////////
+// StartSnapshots
+//
+// Writes a snapshot every interval, on a thread of its own, until
+// StopSnapshots.  Values are cumulative from when each metric was
+// created.
+///////////////////////////////////////////////////////////////////////
+bool
+MetricsRegistry::StartSnapshots(
+	DWORD	IntervalMilliseconds)
+{
+	bool	ReturnCode	= false;
+
+	if ((NULL == m_Thread) && (0 < IntervalMilliseconds))
+	{
+		m_Interval	= IntervalMilliseconds;
+		m_StopEvent	= CreateEvent(NULL, TRUE, FALSE, NULL);
+
+		if (NULL != m_StopEvent)
+		{
+			m_Thread = CreateThread(NULL, 0, Run, this, 0, NULL);
+
+			if (NULL != m_Thread)
+			{
+				ReturnCode = true;
+			}
+			else
+			{
+				CloseHandle(m_StopEvent);
+				m_StopEvent = NULL;
+			}
+		}
+	}
+
+	return ReturnCode;
+}
+
+void
+MetricsRegistry::StopSnapshots(void)
+{
+	if (NULL != m_Thread)
+	{
+		SetEvent(m_StopEvent);
+		WaitForSingleObject(m_Thread, INFINITE);
+
+		CloseHandle(m_Thread);
+		m_Thread = NULL;
+
+		CloseHandle(m_StopEvent);
+		m_StopEvent = NULL;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// WriteSnapshot
+//
+// The registry lock only keeps new metrics from being added meanwhile;
+// recording goes on.
+///////////////////////////////////////////////////////////////////////
+void
+MetricsRegistry::WriteSnapshot(void)
+{
+	EnterCriticalSection(&m_Lock);
+
+	for (MetricEntry* Entry = m_Metrics; NULL != Entry; Entry = Entry->Next)
+	{
+		RecordFields	Fields;
+		LPCTSTR			Name	= NULL;
+
+		switch (Entry->Type)
+		{
+			case MetricTypeCounter:
+			{
+				MetricCounter*	Counter	= (MetricCounter*)Entry->Metric;
+
+				Name = Counter->GetName().GetString();
+				Fields.AddString(_T("metric"), _T("counter"));
+				Fields.AddInteger(_T("value"), Counter->GetValue());
+				break;
+			}
+			case MetricTypeGauge:
+			{
+				MetricGauge*	Gauge	= (MetricGauge*)Entry->Metric;
+
+				Name = Gauge->GetName().GetString();
+				Fields.AddString(_T("metric"), _T("gauge"));
+				Fields.AddInteger(_T("value"), Gauge->GetValue());
+				break;
+			}
+			case MetricTypeHistogram:
+			{
+				MetricHistogram*	Histogram	= (MetricHistogram*)Entry->Metric;
+				LONGLONG			Count		= Histogram->GetCount();
+
+				Name = Histogram->GetName().GetString();
+				Fields.AddString(_T("metric"), _T("histogram"));
+				Fields.AddInteger(_T("count"), Count);
+
+				if (0 < Count)
+				{
+					Fields.AddInteger(_T("min"), Histogram->GetMinimum());
+					Fields.AddFloat(_T("mean"), (double)Histogram->GetSum() / (double)Count);
+					Fields.AddInteger(_T("p50"), Histogram->GetPercentile(50.0));
+					Fields.AddInteger(_T("p90"), Histogram->GetPercentile(90.0));
+					Fields.AddInteger(_T("p99"), Histogram->GetPercentile(99.0));
+					Fields.AddInteger(_T("p999"), Histogram->GetPercentile(99.9));
+					Fields.AddInteger(_T("max"), Histogram->GetMaximum());
+				}
+				break;
+			}
+			default:
+			{
+				break;
+			}
+		}
+
+		if (NULL != Name)
+		{
+			m_Output->Report(Name, Fields);
+		}
+	}
+
+	LeaveCriticalSection(&m_Lock);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Find
+//
+// Finds the metric, creating it if it is new.
+///////////////////////////////////////////////////////////////////////
+MetricsRegistry::MetricEntry*
+MetricsRegistry::Find(
+	int		Type,
+	LPCTSTR	Name)
+{
+	InternedString	MetricName(Name);
+	MetricEntry*	Entry	= NULL;
+	MetricEntry**	Link	= &m_Metrics;
+
+	EnterCriticalSection(&m_Lock);
+
+	// new metrics go at the end, so snapshots keep creation order
+	for (Entry = m_Metrics; NULL != Entry; Entry = Entry->Next)
+	{
+		if ((Type == Entry->Type) && (MetricName == Entry->Name))
+		{
+			break;
+		}
+
+		Link = &Entry->Next;
+	}
+
+	if (NULL == Entry)
+	{
+		Entry = new MetricEntry;
+
+		if (NULL != Entry)
+		{
+			Entry->Type		= Type;
+			Entry->Name		= MetricName;
+			Entry->Next		= NULL;
+			Entry->Metric	= NULL;
+
+			switch (Type)
+			{
+				case MetricTypeCounter:
+				{
+					Entry->Metric = new MetricCounter(MetricName);
+					break;
+				}
+				case MetricTypeGauge:
+				{
+					Entry->Metric = new MetricGauge(MetricName);
+					break;
+				}
+				case MetricTypeHistogram:
+				{
+					Entry->Metric = new MetricHistogram(MetricName);
+					break;
+				}
+				default:
+				{
+					break;
+				}
+			}
+
+			if (NULL != Entry->Metric)
+			{
+				*Link = Entry;
+			}
+			else
+			{
+				delete Entry;
+				Entry = NULL;
+			}
+		}
+	}
+
+	LeaveCriticalSection(&m_Lock);
+
+	return Entry;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Run
+//
+// The snapshot thread.
+///////////////////////////////////////////////////////////////////////
+DWORD WINAPI
+MetricsRegistry::Run(
+	LPVOID	Parameter)
+{
+	MetricsRegistry*	Registry	= (MetricsRegistry*)Parameter;
+
+	while (WAIT_TIMEOUT == WaitForSingleObject(Registry->m_StopEvent, Registry->m_Interval))
+	{
+		Registry->WriteSnapshot();
+	}
+
+	return 0;
+}
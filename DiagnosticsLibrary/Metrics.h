@@ -0,0 +1,224 @@
+///////////////////////////////////////////////////////////////////////
+// Metrics.h
+//
+// Counters, gauges and latency histograms, with periodic snapshots.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "../Include/common.h"
+#include "../Utils/InternedString.h"
+
+class Diagnostics;
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+// counter shards, each on its own cache line
+const size_t METRICS_SHARDS				= 16;
+const size_t METRICS_CACHE_LINE			= 64;
+
+// histograms keep 2^5 sub-buckets per power of two, about 3% precision,
+// for values up to 2^40 (12 days, in microseconds)
+const int	HISTOGRAM_SUB_BUCKET_BITS	= 5;
+const int	HISTOGRAM_VALUE_BITS		= 40;
+const size_t HISTOGRAM_BUCKETS			=
+	(HISTOGRAM_VALUE_BITS - HISTOGRAM_SUB_BUCKET_BITS + 1) << HISTOGRAM_SUB_BUCKET_BITS;
+
+///////////////////////////////////////////////////////////////////////
+// Timing
+//
+// Performance counter readings, and the microseconds between two of
+// them.
+///////////////////////////////////////////////////////////////////////
+DllExport LONGLONG
+GetPerformanceCount(void);
+
+DllExport ULONGLONG
+GetElapsedMicroseconds(
+	LONGLONG	StartCount,
+	LONGLONG	EndCount);
+
+///////////////////////////////////////////////////////////////////////
+// Class: MetricCounter
+//
+// A count that only goes up.  Each thread adds to one of several
+// shards, so threads counting the same thing rarely share a cache
+// line.  The shards are summed when the value is read.  Add returns
+// the new value of the thread's shard, which callers can use to act on
+// every Nth event without sharing anything more.
+//
+// The shards are cache line aligned, which new does not honor on its
+// own, so counters are allocated aligned by their own operator new.
+///////////////////////////////////////////////////////////////////////
+class DllExport MetricCounter
+{
+	public:
+		// Methods
+			MetricCounter(
+				const InternedString&	Name);
+
+			LONGLONG Add(
+				LONGLONG	Value = 1);
+			const InternedString& GetName(void) const;
+			LONGLONG GetValue(void) const;
+
+			static void* operator new(
+				size_t	Size) throw();
+			static void operator delete(
+				void*	Memory);
+
+	private:
+		// METRICS_CACHE_LINE; align takes only a literal
+		struct __declspec(align(64)) Shard
+		{
+			volatile LONGLONG	Value;
+		};
+
+		// Properties
+			InternedString	m_Name;
+			Shard			m_Shards[METRICS_SHARDS];
+
+		// Methods
+			MetricCounter(
+				const MetricCounter&);
+			MetricCounter& operator=(
+				const MetricCounter&);
+};
+
+///////////////////////////////////////////////////////////////////////
+// Class: MetricGauge
+//
+// A value that is set, or moved up and down.
+///////////////////////////////////////////////////////////////////////
+class DllExport MetricGauge
+{
+	public:
+		// Methods
+			MetricGauge(
+				const InternedString&	Name);
+
+			void Add(
+				LONGLONG	Value);
+			const InternedString& GetName(void) const;
+			LONGLONG GetValue(void) const;
+			void Set(
+				LONGLONG	Value);
+
+	private:
+		// Properties
+			InternedString		m_Name;
+			volatile LONGLONG	m_Value;
+
+		// Methods
+			MetricGauge(
+				const MetricGauge&);
+			MetricGauge& operator=(
+				const MetricGauge&);
+};
+
+///////////////////////////////////////////////////////////////////////
+// Class: MetricHistogram
+//
+// HDR style log-linear histogram.  Recording is one interlocked
+// increment of a bucket plus the running sum, min and max; no locks.
+// Percentiles are reported as the highest value of their bucket.
+///////////////////////////////////////////////////////////////////////
+class DllExport MetricHistogram
+{
+	public:
+		// Methods
+			MetricHistogram(
+				const InternedString&	Name);
+
+			LONGLONG GetCount(void) const;
+			LONGLONG GetMaximum(void) const;
+			LONGLONG GetMinimum(void) const;
+			const InternedString& GetName(void) const;
+			LONGLONG GetPercentile(
+				double	Percentile) const;
+			LONGLONG GetSum(void) const;
+			void Record(
+				LONGLONG	Value);
+			void Reset(void);
+
+			static size_t GetBucketIndex(
+				LONGLONG	Value);
+			static LONGLONG GetBucketMaximum(
+				size_t	Index);
+
+	private:
+		// Properties
+			InternedString		m_Name;
+			volatile LONG		m_Buckets[HISTOGRAM_BUCKETS];
+			volatile LONGLONG	m_Sum;
+			volatile LONGLONG	m_Minimum;
+			volatile LONGLONG	m_Maximum;
+
+		// Methods
+			MetricHistogram(
+				const MetricHistogram&);
+			MetricHistogram& operator=(
+				const MetricHistogram&);
+};
+
+///////////////////////////////////////////////////////////////////////
+// Class: MetricsRegistry
+//
+// Owns the metrics, which are created on first request by name and
+// stay valid, at the same address, for the life of the registry.
+// Callers look a metric up once and keep the pointer.
+//
+// Snapshots report every metric through the given Diagnostics object,
+// one record per metric, so they go to its log file; use a separate
+// Diagnostics object for a dedicated file.  Taking a snapshot only
+// reads the metrics, and never blocks the threads recording them.
+///////////////////////////////////////////////////////////////////////
+class DllExport MetricsRegistry
+{
+	public:
+		// Methods
+			MetricsRegistry(
+				Diagnostics&	Output);
+			~MetricsRegistry(void);
+
+			MetricCounter* GetCounter(
+				LPCTSTR	Name);
+			MetricGauge* GetGauge(
+				LPCTSTR	Name);
+			MetricHistogram* GetHistogram(
+				LPCTSTR	Name);
+			bool StartSnapshots(
+				DWORD	IntervalMilliseconds);
+			void StopSnapshots(void);
+			void WriteSnapshot(void);
+
+	private:
+		struct MetricEntry;
+
+		// Properties
+			Diagnostics*		m_Output;
+			CRITICAL_SECTION	m_Lock;
+			MetricEntry*		m_Metrics;
+			HANDLE				m_StopEvent;
+			HANDLE				m_Thread;
+			DWORD				m_Interval;
+
+		// Methods
+			MetricsRegistry(
+				const MetricsRegistry&);
+			MetricsRegistry& operator=(
+				const MetricsRegistry&);
+
+			MetricEntry* Find(
+				int				Type,
+				LPCTSTR			Name);
+
+			static DWORD WINAPI Run(
+				LPVOID	Parameter);
+};
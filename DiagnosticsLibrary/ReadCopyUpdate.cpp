@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////
+// ReadCopyUpdate.cpp - Class Implementation
+//
+// Lets readers use shared data without locking while a writer replaces
+// it.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include <malloc.h>
+#include "ReadCopyUpdate.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+// checks of a reader count before the writer starts to sleep
+#define RCU_SPIN_COUNT	64
+
+///////////////////////////////////////////////////////////////////////
+// ReadCopyUpdate Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Ctors / Dtors
+///////////////////////////////////////////////////////////////////////
+ReadCopyUpdate::ReadCopyUpdate(void) :
+	m_Phase(0)
+{
+	InitializeCriticalSection(&m_Lock);
+	memset(m_Readers, 0, sizeof(m_Readers));
+}
+
+ReadCopyUpdate::~ReadCopyUpdate(void)
+{
+	DeleteCriticalSection(&m_Lock);
+}
+
+///////////////////////////////////////////////////////////////////////
+// BeginRead
+//
+// Returns the token for EndRead.  Shared data is to be read after this
+// call, not before.
+///////////////////////////////////////////////////////////////////////
+int
+ReadCopyUpdate::BeginRead(void)
+{
+	// thread ids are multiples of four
+	int	Token	= (int)((GetCurrentThreadId() >> 2) % RCU_SHARDS);
+
+	Token += (int)((m_Phase & 1) * RCU_SHARDS);
+
+	InterlockedIncrement(&m_Readers[Token / RCU_SHARDS][Token % RCU_SHARDS].Count);
+
+	return Token;
+}
+
+void
+ReadCopyUpdate::EndRead(
+	int	Token)
+{
+	InterlockedDecrement(&m_Readers[Token / RCU_SHARDS][Token % RCU_SHARDS].Count);
+}
+
+///////////////////////////////////////////////////////////////////////
+// operator new
+//
+// Cache line aligned, for the shards.  Returns NULL rather than
+// throwing, as the rest of the library expects of new.
+///////////////////////////////////////////////////////////////////////
+void*
+ReadCopyUpdate::operator new(
+	size_t	Size) throw()
+{
+	return _aligned_malloc(Size, RCU_CACHE_LINE);
+}
+
+void
+ReadCopyUpdate::operator delete(
+	void*	Memory)
+{
+	_aligned_free(Memory);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Synchronize
+//
+// Called after the new data is published.  Blocks only the writer.
+///////////////////////////////////////////////////////////////////////
+void
+ReadCopyUpdate::Synchronize(void)
+{
+	EnterCriticalSection(&m_Lock);
+
+	for (int Flip = 0; Flip < 2; Flip++)
+	{
+		LONG	OldPhase	= m_Phase;
+
+		InterlockedExchange(&m_Phase, OldPhase ^ 1);
+		WaitForReaders(OldPhase);
+	}
+
+	LeaveCriticalSection(&m_Lock);
+}
+
+///////////////////////////////////////////////////////////////////////
+// WaitForReaders
+//
+// Each shard only needs to be seen empty once: a reader counting itself
+// in after that reads the shared data after it was replaced.
+///////////////////////////////////////////////////////////////////////
+void
+ReadCopyUpdate::WaitForReaders(
+	LONG	Phase)
+{
+	for (size_t Index = 0; Index < RCU_SHARDS; Index++)
+	{
+		int	Spins	= 0;
+
+		while (0 != m_Readers[Phase][Index].Count)
+		{
+			if (Spins < RCU_SPIN_COUNT)
+			{
+				Spins++;
+				SwitchToThread();
+			}
+			else
+			{
+				Sleep(1);
+			}
+		}
+	}
+}
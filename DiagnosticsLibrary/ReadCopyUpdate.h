@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////
+// ReadCopyUpdate.h
+//
+// Lets readers use shared data without locking while a writer replaces
+// it.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "../Include/common.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+// reader count shards per phase, each on its own cache line
+const size_t RCU_SHARDS		= 16;
+const size_t RCU_CACHE_LINE	= 64;
+
+///////////////////////////////////////////////////////////////////////
+// Class: ReadCopyUpdate
+//
+// A reader brackets its use of the shared data with BeginRead and
+// EndRead, which only count it in and out, on a counter shared with
+// few other threads.  A writer publishes new data with a pointer
+// store, then calls Synchronize before freeing the old data; it
+// returns once every read that could have seen the old data is over.
+//
+// Reads are counted in two phases.  Synchronize flips the phase twice,
+// each time waiting for the readers of the phase it left to finish, so
+// a reader that was late to count itself in is waited for by the next
+// writer at the latest, by which time it has only seen newer data.
+//
+// The shards are cache line aligned.  new does not honor that on this
+// compiler, so the class allocates itself aligned, and a class that
+// holds one must do the same, as ConfigSource does.
+///////////////////////////////////////////////////////////////////////
+class DllExport ReadCopyUpdate
+{
+	public:
+		// Methods
+			ReadCopyUpdate(void);
+			~ReadCopyUpdate(void);
+
+			int BeginRead(void);
+			void EndRead(
+				int	Token);
+			void Synchronize(void);
+
+			static void* operator new(
+				size_t	Size) throw();
+			static void operator delete(
+				void*	Memory);
+
+	private:
+		// RCU_CACHE_LINE; align takes only a literal
+		struct __declspec(align(64)) Shard
+		{
+			volatile LONG	Count;
+		};
+
+		// Properties
+			Shard				m_Readers[2][RCU_SHARDS];
+			volatile LONG		m_Phase;
+			// one writer at a time
+			CRITICAL_SECTION	m_Lock;
+
+		// Methods
+			ReadCopyUpdate(
+				const ReadCopyUpdate&);
+			ReadCopyUpdate& operator=(
+				const ReadCopyUpdate&);
+
+			void WaitForReaders(
+				LONG	Phase);
+};
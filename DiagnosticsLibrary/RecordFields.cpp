@@ -0,0 +1,623 @@
+///////////////////////////////////////////////////////////////////////
+// RecordFields.cpp - Class Implementation
+//
+// Typed key / value fields attached to a diagnostic record.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include <tchar.h>
+#include "RecordFields.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+// longest rendered number, " key=" not included
+#define NUMBER_TEXT_SIZE	32
+
+///////////////////////////////////////////////////////////////////////
+// ReadVarint
+///////////////////////////////////////////////////////////////////////
+static bool
+ReadVarint(
+	const BYTE*	Data,
+	size_t		Size,
+	size_t*		Position,
+	ULONGLONG*	Value)
+{
+	bool	ReturnCode	= false;
+	int		Shift		= 0;
+
+	*Value = 0;
+
+	while ((*Position < Size) && (Shift < 64))
+	{
+		BYTE	Byte	= Data[(*Position)++];
+
+		*Value |= (ULONGLONG)(Byte & 0x7F) << Shift;
+		Shift += 7;
+
+		if (0 == (Byte & 0x80))
+		{
+			ReturnCode = true;
+			break;
+		}
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// ReadText
+//
+// A varint length followed by that many TCHARs.
+///////////////////////////////////////////////////////////////////////
+static bool
+ReadText(
+	const BYTE*	Data,
+	size_t		Size,
+	size_t*		Position,
+	LPCTSTR*	Text,
+	size_t*		Length)
+{
+	bool		ReturnCode	= false;
+	ULONGLONG	Characters	= 0;
+
+	if ((true == ReadVarint(Data, Size, Position, &Characters)) &&
+		(Characters <= (Size - *Position) / sizeof(TCHAR)))
+	{
+		*Text		= (LPCTSTR)(Data + *Position);
+		*Length		= (size_t)Characters;
+		*Position	+= (size_t)Characters * sizeof(TCHAR);
+		ReturnCode	= true;
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// RenderText
+//
+// Appends Length characters if they fit, returning the new count or
+// (size_t)-1 if they don't.
+///////////////////////////////////////////////////////////////////////
+static size_t
+RenderText(
+	TCHAR*	Buffer,
+	size_t	BufferSize,
+	size_t	Written,
+	LPCTSTR	Text,
+	size_t	Length)
+{
+	if (((size_t)-1 != Written) && (Length <= BufferSize - Written))
+	{
+		memcpy(Buffer + Written, Text, Length * sizeof(TCHAR));
+		Written += Length;
+	}
+	else
+	{
+		Written = (size_t)-1;
+	}
+
+	return Written;
+}
+
+///////////////////////////////////////////////////////////////////////
+// RecordFields Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Ctors / Dtors
+///////////////////////////////////////////////////////////////////////
+RecordFields::RecordFields(void) :
+	m_Data(m_Inline),
+	m_Size(0),
+	m_Capacity(RECORD_FIELDS_INLINE_SIZE),
+	m_Count(0),
+	m_RenderBound(0)
+{
+}
+
+RecordFields::~RecordFields(void)
+{
+	if (m_Inline != m_Data)
+	{
+		delete[] m_Data;
+		m_Data = NULL;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Add methods
+//
+// Each returns false, leaving the fields as they were, if memory for
+// the field could not be allocated.
+///////////////////////////////////////////////////////////////////////
+bool
+RecordFields::AddErrorCode(
+	LPCTSTR	Key,
+	DWORD	ErrorCode)
+{
+	size_t	Mark		= m_Size;
+	size_t	CountMark	= m_Count;
+	size_t	RenderMark	= m_RenderBound;
+	bool	ReturnCode	= (true == AddKey(RecordFieldErrorCode, Key)) &&
+		(true == AddBytes(&ErrorCode, sizeof(ErrorCode)));
+
+	if (true == ReturnCode)
+	{
+		m_RenderBound += NUMBER_TEXT_SIZE;
+	}
+	else
+	{
+		m_Size			= Mark;
+		m_Count			= CountMark;
+		m_RenderBound	= RenderMark;
+	}
+
+	return ReturnCode;
+}
+
+bool
+RecordFields::AddFloat(
+	LPCTSTR	Key,
+	double	Value)
+{
+	size_t	Mark		= m_Size;
+	size_t	CountMark	= m_Count;
+	size_t	RenderMark	= m_RenderBound;
+	bool	ReturnCode	= (true == AddKey(RecordFieldFloat, Key)) &&
+		(true == AddBytes(&Value, sizeof(Value)));
+
+	if (true == ReturnCode)
+	{
+		m_RenderBound += NUMBER_TEXT_SIZE;
+	}
+	else
+	{
+		m_Size			= Mark;
+		m_Count			= CountMark;
+		m_RenderBound	= RenderMark;
+	}
+
+	return ReturnCode;
+}
+
+bool
+RecordFields::AddInteger(
+	LPCTSTR		Key,
+	LONGLONG	Value)
+{
+	size_t		Mark		= m_Size;
+	size_t		CountMark	= m_Count;
+	size_t		RenderMark	= m_RenderBound;
+	// zigzag, so small negative values stay short
+	ULONGLONG	Encoded		= ((ULONGLONG)Value << 1) ^ (ULONGLONG)(Value >> 63);
+	bool		ReturnCode	= (true == AddKey(RecordFieldInteger, Key)) &&
+		(true == AddVarint(Encoded));
+
+	if (true == ReturnCode)
+	{
+		m_RenderBound += NUMBER_TEXT_SIZE;
+	}
+	else
+	{
+		m_Size			= Mark;
+		m_Count			= CountMark;
+		m_RenderBound	= RenderMark;
+	}
+
+	return ReturnCode;
+}
+
+bool
+RecordFields::AddString(
+	LPCTSTR	Key,
+	LPCTSTR	Value)
+{
+	size_t	ValueLength	= 0;
+
+	if (NULL != Value)
+	{
+		ValueLength = _tcslen(Value);
+	}
+
+	return AddString(Key, Value, ValueLength);
+}
+
+bool
+RecordFields::AddString(
+	LPCTSTR	Key,
+	LPCTSTR	Value,
+	size_t	ValueLength)
+{
+	size_t	Mark		= m_Size;
+	size_t	CountMark	= m_Count;
+	size_t	RenderMark	= m_RenderBound;
+
+	if (NULL == Value)
+	{
+		ValueLength = 0;
+	}
+
+	bool	ReturnCode	= (true == AddKey(RecordFieldString, Key)) &&
+		(true == AddVarint(ValueLength)) &&
+		(true == AddBytes(Value, ValueLength * sizeof(TCHAR)));
+
+	if (true == ReturnCode)
+	{
+		// quotes, and every character may need escaping
+		m_RenderBound += ValueLength * 2 + 2;
+	}
+	else
+	{
+		m_Size			= Mark;
+		m_Count			= CountMark;
+		m_RenderBound	= RenderMark;
+	}
+
+	return ReturnCode;
+}
+
+bool
+RecordFields::AddUnsigned(
+	LPCTSTR		Key,
+	ULONGLONG	Value)
+{
+	size_t	Mark		= m_Size;
+	size_t	CountMark	= m_Count;
+	size_t	RenderMark	= m_RenderBound;
+	bool	ReturnCode	= (true == AddKey(RecordFieldUnsigned, Key)) &&
+		(true == AddVarint(Value));
+
+	if (true == ReturnCode)
+	{
+		m_RenderBound += NUMBER_TEXT_SIZE;
+	}
+	else
+	{
+		m_Size			= Mark;
+		m_Count			= CountMark;
+		m_RenderBound	= RenderMark;
+	}
+
+	return ReturnCode;
+}
+
+void
+RecordFields::Clear(void)
+{
+	m_Size			= 0;
+	m_Count			= 0;
+	m_RenderBound	= 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Accessors
+///////////////////////////////////////////////////////////////////////
+size_t
+RecordFields::GetCount(void) const
+{
+	return m_Count;
+}
+
+const BYTE*
+RecordFields::GetData(void) const
+{
+	return m_Data;
+}
+
+///////////////////////////////////////////////////////////////////////
+// GetRenderBound
+//
+// Characters always enough for Render.
+///////////////////////////////////////////////////////////////////////
+size_t
+RecordFields::GetRenderBound(void) const
+{
+	return m_RenderBound;
+}
+
+size_t
+RecordFields::GetSize(void) const
+{
+	return m_Size;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Render
+///////////////////////////////////////////////////////////////////////
+size_t
+RecordFields::Render(
+	TCHAR*	Buffer,
+	size_t	BufferSize) const
+{
+	return RenderFields(m_Data, m_Size, Buffer, BufferSize);
+}
+
+///////////////////////////////////////////////////////////////////////
+// DecodeField
+//
+// Reads the field at Position and advances past it.  Returns false at
+// the end of the data, or if the data is malformed.
+///////////////////////////////////////////////////////////////////////
+bool
+RecordFields::DecodeField(
+	const BYTE*		Data,
+	size_t			Size,
+	size_t*			Position,
+	RecordField*	Field)
+{
+	bool	ReturnCode	= false;
+
+	if ((NULL != Data) && (*Position < Size))
+	{
+		memset(Field, 0, sizeof(RecordField));
+
+		Field->Type = (RecordFieldType)Data[(*Position)++];
+
+		if (true == ReadText(Data, Size, Position, &Field->Key, &Field->KeyLength))
+		{
+			switch (Field->Type)
+			{
+				case RecordFieldInteger:
+				{
+					ULONGLONG	Encoded	= 0;
+
+					ReturnCode = ReadVarint(Data, Size, Position, &Encoded);
+					Field->Integer = (LONGLONG)(Encoded >> 1) ^ -(LONGLONG)(Encoded & 1);
+					break;
+				}
+				case RecordFieldUnsigned:
+				{
+					ReturnCode = ReadVarint(Data, Size, Position, &Field->Unsigned);
+					break;
+				}
+				case RecordFieldFloat:
+				{
+					if (sizeof(double) <= Size - *Position)
+					{
+						memcpy(&Field->Float, Data + *Position, sizeof(double));
+						*Position += sizeof(double);
+						ReturnCode = true;
+					}
+					break;
+				}
+				case RecordFieldString:
+				{
+					ReturnCode = ReadText(Data, Size, Position,
+						&Field->String, &Field->StringLength);
+					break;
+				}
+				case RecordFieldErrorCode:
+				{
+					if (sizeof(DWORD) <= Size - *Position)
+					{
+						memcpy(&Field->ErrorCode, Data + *Position, sizeof(DWORD));
+						*Position += sizeof(DWORD);
+						ReturnCode = true;
+					}
+					break;
+				}
+				default:
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// RenderFields
+//
+// The text form, " key=value" for each field, with strings quoted and
+// '"' and '\' escaped.  Returns the characters written, not terminated,
+// or 0 if the buffer is too small.
+///////////////////////////////////////////////////////////////////////
+size_t
+RecordFields::RenderFields(
+	const BYTE*	Data,
+	size_t		Size,
+	TCHAR*		Buffer,
+	size_t		BufferSize)
+{
+	size_t		Written		= 0;
+	size_t		Position	= 0;
+	RecordField	Field;
+
+	while ((true == DecodeField(Data, Size, &Position, &Field)) &&
+		((size_t)-1 != Written))
+	{
+		TCHAR	Number[NUMBER_TEXT_SIZE];
+		int		NumberLength	= 0;
+
+		Written = RenderText(Buffer, BufferSize, Written, _T(" "), 1);
+		Written = RenderText(Buffer, BufferSize, Written, Field.Key, Field.KeyLength);
+		Written = RenderText(Buffer, BufferSize, Written, _T("="), 1);
+
+		switch (Field.Type)
+		{
+			case RecordFieldInteger:
+			{
+				NumberLength = _stprintf_s(Number, NUMBER_TEXT_SIZE, _T("%I64d"), Field.Integer);
+				break;
+			}
+			case RecordFieldUnsigned:
+			{
+				NumberLength = _stprintf_s(Number, NUMBER_TEXT_SIZE, _T("%I64u"), Field.Unsigned);
+				break;
+			}
+			case RecordFieldFloat:
+			{
+				NumberLength = _stprintf_s(Number, NUMBER_TEXT_SIZE, _T("%.17g"), Field.Float);
+				break;
+			}
+			case RecordFieldErrorCode:
+			{
+				NumberLength = _stprintf_s(Number, NUMBER_TEXT_SIZE, _T("0x%08X"), Field.ErrorCode);
+				break;
+			}
+			case RecordFieldString:
+			{
+				Written = RenderText(Buffer, BufferSize, Written, _T("\""), 1);
+
+				for (size_t Index = 0; Index < Field.StringLength; Index++)
+				{
+					TCHAR	Character	= Field.String[Index];
+
+					if ((_T('"') == Character) || (_T('\\') == Character))
+					{
+						Written = RenderText(Buffer, BufferSize, Written, _T("\\"), 1);
+					}
+
+					Written = RenderText(Buffer, BufferSize, Written, &Character, 1);
+				}
+
+				Written = RenderText(Buffer, BufferSize, Written, _T("\""), 1);
+				break;
+			}
+			default:
+			{
+				break;
+			}
+		}
+
+		if (0 < NumberLength)
+		{
+			Written = RenderText(Buffer, BufferSize, Written, Number, NumberLength);
+		}
+	}
+
+	if ((size_t)-1 == Written)
+	{
+		Written = 0;
+	}
+
+	return Written;
+}
+
+///////////////////////////////////////////////////////////////////////
+// AddBytes
+///////////////////////////////////////////////////////////////////////
+bool
+RecordFields::AddBytes(
+	const void*	Bytes,
+	size_t		Size)
+{
+	bool	ReturnCode	= Reserve(Size);
+
+	if ((true == ReturnCode) && (0 < Size))
+	{
+		memcpy(m_Data + m_Size, Bytes, Size);
+		m_Size += Size;
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// AddKey
+//
+// Starts a field: the type, then the key.
+///////////////////////////////////////////////////////////////////////
+bool
+RecordFields::AddKey(
+	RecordFieldType	Type,
+	LPCTSTR			Key)
+{
+	bool	ReturnCode	= false;
+	size_t	KeyLength	= 0;
+	BYTE	TypeByte	= (BYTE)Type;
+
+	if (NULL != Key)
+	{
+		KeyLength = _tcslen(Key);
+	}
+
+	if ((true == AddBytes(&TypeByte, 1)) &&
+		(true == AddVarint(KeyLength)) &&
+		(true == AddBytes(Key, KeyLength * sizeof(TCHAR))))
+	{
+		m_Count++;
+		// " key="
+		m_RenderBound	+= KeyLength + 2;
+		ReturnCode		= true;
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// AddVarint
+///////////////////////////////////////////////////////////////////////
+bool
+RecordFields::AddVarint(
+	ULONGLONG	Value)
+{
+	BYTE	Bytes[10];
+	size_t	Length	= 0;
+
+	do
+	{
+		Bytes[Length] = (BYTE)(Value & 0x7F);
+		Value >>= 7;
+
+		if (0 != Value)
+		{
+			Bytes[Length] |= 0x80;
+		}
+
+		Length++;
+	}
+	while (0 != Value);
+
+	return AddBytes(Bytes, Length);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Reserve
+///////////////////////////////////////////////////////////////////////
+bool
+RecordFields::Reserve(
+	size_t	Size)
+{
+	bool	ReturnCode	= true;
+
+	if (Size > m_Capacity - m_Size)
+	{
+		size_t	Capacity	= m_Capacity * 2;
+
+		while (Capacity - m_Size < Size)
+		{
+			Capacity *= 2;
+		}
+
+		BYTE*	Data	= new BYTE[Capacity];
+
+		if (NULL != Data)
+		{
+			memcpy(Data, m_Data, m_Size);
+
+			if (m_Inline != m_Data)
+			{
+				delete[] m_Data;
+			}
+
+			m_Data		= Data;
+			m_Capacity	= Capacity;
+		}
+		else
+		{
+			ReturnCode = false;
+		}
+	}
+
+	return ReturnCode;
+}
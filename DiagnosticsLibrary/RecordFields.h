@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////
+// RecordFields.h
+//
+// Typed key / value fields attached to a diagnostic record.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "../Include/common.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+const size_t RECORD_FIELDS_INLINE_SIZE	= 128;
+
+///////////////////////////////////////////////////////////////////////
+// Types
+//
+// Encoding, one after another for each field:
+//	BYTE		type
+//	varint		key length (characters), then the key's TCHARs
+//	value		Integer		zigzag varint
+//				Unsigned	varint
+//				Float		8 byte IEEE double
+//				String		varint length (characters), then the TCHARs
+//				ErrorCode	4 byte DWORD
+// Varints are LEB128, multibyte values are little endian as stored.
+///////////////////////////////////////////////////////////////////////
+enum RecordFieldType
+{
+	RecordFieldInteger		= 1,
+	RecordFieldUnsigned		= 2,
+	RecordFieldFloat		= 3,
+	RecordFieldString		= 4,
+	RecordFieldErrorCode	= 5
+};
+
+// one decoded field, pointing into the encoded data
+struct RecordField
+{
+	RecordFieldType	Type;
+	LPCTSTR			Key;
+	size_t			KeyLength;
+	LONGLONG		Integer;
+	ULONGLONG		Unsigned;
+	double			Float;
+	LPCTSTR			String;
+	size_t			StringLength;
+	DWORD			ErrorCode;
+};
+
+///////////////////////////////////////////////////////////////////////
+// Class: RecordFields
+//
+// Built on the stack by the caller and passed to Diagnostics::Report.
+// Small sets of fields need no allocation.
+///////////////////////////////////////////////////////////////////////
+class DllExport RecordFields
+{
+	public:
+		// Methods
+			RecordFields(void);
+			~RecordFields(void);
+
+			bool AddErrorCode(
+				LPCTSTR	Key,
+				DWORD	ErrorCode);
+			bool AddFloat(
+				LPCTSTR	Key,
+				double	Value);
+			bool AddInteger(
+				LPCTSTR		Key,
+				LONGLONG	Value);
+			bool AddString(
+				LPCTSTR	Key,
+				LPCTSTR	Value);
+			bool AddString(
+				LPCTSTR	Key,
+				LPCTSTR	Value,
+				size_t	ValueLength);
+			bool AddUnsigned(
+				LPCTSTR		Key,
+				ULONGLONG	Value);
+			void Clear(void);
+
+			size_t GetCount(void) const;
+			const BYTE* GetData(void) const;
+			size_t GetRenderBound(void) const;
+			size_t GetSize(void) const;
+			size_t Render(
+				TCHAR*	Buffer,
+				size_t	BufferSize) const;
+
+			static bool DecodeField(
+				const BYTE*		Data,
+				size_t			Size,
+				size_t*			Position,
+				RecordField*	Field);
+			static size_t RenderFields(
+				const BYTE*	Data,
+				size_t		Size,
+				TCHAR*		Buffer,
+				size_t		BufferSize);
+
+	private:
+		// Properties
+			BYTE	m_Inline[RECORD_FIELDS_INLINE_SIZE];
+			BYTE*	m_Data;
+			size_t	m_Size;
+			size_t	m_Capacity;
+			size_t	m_Count;
+			size_t	m_RenderBound;
+
+		// Methods
+			RecordFields(
+				const RecordFields&);
+			RecordFields& operator=(
+				const RecordFields&);
+
+			bool AddBytes(
+				const void*	Bytes,
+				size_t		Size);
+			bool AddKey(
+				RecordFieldType	Type,
+				LPCTSTR			Key);
+			bool AddVarint(
+				ULONGLONG	Value);
+			bool Reserve(
+				size_t	Size);
+};
+
+///////////////////////////////////////////////////////////////////////
+// Class: StructuredSink
+//
+// Receives every reported record with its fields still encoded, to
+// store or forward without parsing text.  Fields is NULL when a record
+// has none.  Called on the reporting thread.
+///////////////////////////////////////////////////////////////////////
+class DllExport StructuredSink
+{
+	public:
+		// Methods
+			virtual ~StructuredSink(void) {}
+
+			virtual void WriteRecord(
+				LPCTSTR		Message,
+				size_t		MessageLength,
+				const BYTE*	Fields,
+				size_t		FieldsSize) = 0;
+};
@@ -0,0 +1,587 @@
+///////////////////////////////////////////////////////////////////////
+// StackTrace.cpp - Class Implementation
+//
+// Stack capture on the reporting thread, symbolization on a background
+// thread.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include <tchar.h>
+#include <dbghelp.h>
+#include "StackTrace.h"
+#include "MessageArena.h"
+#include "Metrics.h"
+#include "../Utils/InternedString.h"
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+#define SYMBOL_CACHE_SIZE	4096
+#define SYMBOL_NAME_SIZE	256
+// longest line for one frame, "\r\n\t#nn " and the symbol
+#define FRAME_TEXT_SIZE		(SYMBOL_NAME_SIZE + MAX_PATH + 64)
+
+typedef DWORD (WINAPI* SymSetOptionsFunction)(DWORD);
+typedef BOOL (WINAPI* SymInitializeFunction)(HANDLE, PCSTR, BOOL);
+typedef BOOL (WINAPI* SymFromAddrFunction)(HANDLE, DWORD64, PDWORD64, PSYMBOL_INFO);
+typedef BOOL (WINAPI* SymGetLineFromAddr64Function)(HANDLE, DWORD64, PDWORD, PIMAGEHLP_LINE64);
+
+///////////////////////////////////////////////////////////////////////
+// SymbolCache Class Definition
+//
+// Shared by every tracer.  Entries are never evicted; once the cache is
+// full, further addresses are resolved each time.  DbgHelp is not
+// thread safe, so all lookups are serialized.
+///////////////////////////////////////////////////////////////////////
+class SymbolCache
+{
+	public:
+		// Methods
+			SymbolCache(void);
+			~SymbolCache(void);
+
+			InternedString Lookup(
+				void*	Address);
+
+	private:
+		// Properties
+			CRITICAL_SECTION	m_Lock;
+			void*				m_Addresses[SYMBOL_CACHE_SIZE];
+			InternedString		m_Symbols[SYMBOL_CACHE_SIZE];
+			size_t				m_Count;
+			bool							m_Loaded;
+			SymFromAddrFunction				m_SymFromAddr;
+			SymGetLineFromAddr64Function	m_SymGetLineFromAddr64;
+
+		// Methods
+			void Load(void);
+			InternedString Resolve(
+				void*	Address);
+};
+
+static SymbolCache g_SymbolCache;
+
+///////////////////////////////////////////////////////////////////////
+// GetAddressHash
+///////////////////////////////////////////////////////////////////////
+static ULONG
+GetAddressHash(
+	const void*	Address)
+{
+	ULONGLONG	Value	= (ULONGLONG)(ULONG_PTR)Address;
+
+	Value = (Value ^ (Value >> 29)) * 0x9E3779B97F4A7C15ULL;
+
+	return (ULONG)(Value >> 32);
+}
+
+///////////////////////////////////////////////////////////////////////
+// CaptureStackTrace
+///////////////////////////////////////////////////////////////////////
+bool
+CaptureStackTrace(
+	ULONG		SkipFrames,
+	StackTrace*	Trace)
+{
+	bool	ReturnCode	= false;
+	ULONG	Hash		= 2166136261UL;
+
+	// this function's own frame
+	SkipFrames++;
+
+	Trace->FrameCount = CaptureStackBackTrace(SkipFrames,
+		(DWORD)STACK_TRACE_FRAMES,
+		Trace->Frames,
+		NULL);
+
+	// FNV-1a over the addresses
+	for (size_t Index = 0; Index < Trace->FrameCount; Index++)
+	{
+		ULONGLONG	Value	= (ULONGLONG)(ULONG_PTR)Trace->Frames[Index];
+
+		for (int Byte = 0; Byte < (int)sizeof(void*); Byte++)
+		{
+			Hash ^= (ULONG)(Value & 0xFF);
+			Hash *= 16777619UL;
+			Value >>= 8;
+		}
+	}
+
+	// 0 marks an empty slot in the seen table
+	if (0 == Hash)
+	{
+		Hash = 1;
+	}
+
+	Trace->Hash = Hash;
+
+	if (0 < Trace->FrameCount)
+	{
+		ReturnCode = true;
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// SymbolCache Constructors / Destructors
+///////////////////////////////////////////////////////////////////////
+SymbolCache::SymbolCache(void) :
+	m_Count(0),
+	m_Loaded(false),
+	m_SymFromAddr(NULL),
+	m_SymGetLineFromAddr64(NULL)
+{
+	InitializeCriticalSection(&m_Lock);
+	memset(m_Addresses, 0, sizeof(m_Addresses));
+}
+
+SymbolCache::~SymbolCache(void)
+{
+	// DbgHelp is left loaded, FreeLibrary is not safe during detach
+	DeleteCriticalSection(&m_Lock);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Lookup
+//
+// Returns the text for one return address, such as
+// "module!function+0x1c (file.cpp:42)".
+///////////////////////////////////////////////////////////////////////
+InternedString
+SymbolCache::Lookup(
+	void*	Address)
+{
+	InternedString	Symbol;
+	bool			Found	= false;
+	size_t			Slot	= GetAddressHash(Address) % SYMBOL_CACHE_SIZE;
+
+	EnterCriticalSection(&m_Lock);
+
+	for (size_t Probe = 0; Probe < SYMBOL_CACHE_SIZE; Probe++)
+	{
+		if (Address == m_Addresses[Slot])
+		{
+			Symbol	= m_Symbols[Slot];
+			Found	= true;
+			break;
+		}
+
+		if (NULL == m_Addresses[Slot])
+		{
+			break;
+		}
+
+		Slot = (Slot + 1) % SYMBOL_CACHE_SIZE;
+	}
+
+	if (false == Found)
+	{
+		Symbol = Resolve(Address);
+
+		// open addressing, so keep some slots free
+		if ((NULL == m_Addresses[Slot]) &&
+			(m_Count < SYMBOL_CACHE_SIZE / 4 * 3))
+		{
+			m_Addresses[Slot]	= Address;
+			m_Symbols[Slot]		= Symbol;
+			m_Count++;
+		}
+	}
+
+	LeaveCriticalSection(&m_Lock);
+
+	return Symbol;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Load
+//
+// DbgHelp is loaded on first use, by the symbolizer thread, so
+// processes that never trace a stack don't pay for it.
+///////////////////////////////////////////////////////////////////////
+void
+SymbolCache::Load(void)
+{
+	if (false == m_Loaded)
+	{
+		HMODULE	DbgHelp	= LoadLibrary(_T("dbghelp.dll"));
+
+		m_Loaded = true;
+
+		if (NULL != DbgHelp)
+		{
+			SymSetOptionsFunction	SymSetOptionsEntry		=
+				(SymSetOptionsFunction)GetProcAddress(DbgHelp, "SymSetOptions");
+			SymInitializeFunction	SymInitializeEntry		=
+				(SymInitializeFunction)GetProcAddress(DbgHelp, "SymInitialize");
+
+			if ((NULL != SymSetOptionsEntry) && (NULL != SymInitializeEntry))
+			{
+				SymSetOptionsEntry(SYMOPT_DEFERRED_LOADS | SYMOPT_UNDNAME |
+					SYMOPT_LOAD_LINES | SYMOPT_FAIL_CRITICAL_ERRORS);
+
+				if (FALSE != SymInitializeEntry(GetCurrentProcess(), NULL, TRUE))
+				{
+					m_SymFromAddr = (SymFromAddrFunction)
+						GetProcAddress(DbgHelp, "SymFromAddr");
+					m_SymGetLineFromAddr64 = (SymGetLineFromAddr64Function)
+						GetProcAddress(DbgHelp, "SymGetLineFromAddr64");
+				}
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Resolve
+//
+// Falls back to module+offset, then to the bare address, when there
+// are no symbols.
+///////////////////////////////////////////////////////////////////////
+InternedString
+SymbolCache::Resolve(
+	void*	Address)
+{
+	TCHAR	Text[SYMBOL_NAME_SIZE + MAX_PATH + 32];
+
+	// long names are truncated rather than dropped
+	Text[0] = _T('\0');
+
+	HMODULE	Module		= NULL;
+	TCHAR	ModulePath[MAX_PATH];
+	LPCTSTR	ModuleName	= NULL;
+
+	Load();
+
+	if ((FALSE != GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+			GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+			(LPCTSTR)Address,
+			&Module)) &&
+		(0 < GetModuleFileName(Module, ModulePath, MAX_PATH)))
+	{
+		ModulePath[MAX_PATH - 1] = _T('\0');
+		ModuleName = _tcsrchr(ModulePath, _T('\\'));
+
+		if (NULL == ModuleName)
+		{
+			ModuleName = ModulePath;
+		}
+		else
+		{
+			ModuleName++;
+		}
+	}
+
+	BYTE			SymbolBuffer[sizeof(SYMBOL_INFO) + SYMBOL_NAME_SIZE];
+	PSYMBOL_INFO	Symbol			= (PSYMBOL_INFO)SymbolBuffer;
+	DWORD64			Displacement	= 0;
+
+	memset(SymbolBuffer, 0, sizeof(SymbolBuffer));
+	Symbol->SizeOfStruct	= sizeof(SYMBOL_INFO);
+	Symbol->MaxNameLen		= SYMBOL_NAME_SIZE;
+
+	if ((NULL != ModuleName) && (NULL != m_SymFromAddr) &&
+		(FALSE != m_SymFromAddr(GetCurrentProcess(),
+			(DWORD64)(ULONG_PTR)Address, &Displacement, Symbol)))
+	{
+		IMAGEHLP_LINE64	Line;
+		DWORD			LineDisplacement	= 0;
+
+		memset(&Line, 0, sizeof(Line));
+		Line.SizeOfStruct = sizeof(Line);
+
+		if ((NULL != m_SymGetLineFromAddr64) &&
+			(FALSE != m_SymGetLineFromAddr64(GetCurrentProcess(),
+				(DWORD64)(ULONG_PTR)Address, &LineDisplacement, &Line)))
+		{
+			_sntprintf_s(Text, _countof(Text), _TRUNCATE, _T("%s!%hs+0x%I64x (%hs:%lu)"),
+				ModuleName, Symbol->Name, Displacement, Line.FileName, Line.LineNumber);
+		}
+		else
+		{
+			_sntprintf_s(Text, _countof(Text), _TRUNCATE, _T("%s!%hs+0x%I64x"),
+				ModuleName, Symbol->Name, Displacement);
+		}
+	}
+	else if (NULL != ModuleName)
+	{
+		_sntprintf_s(Text, _countof(Text), _TRUNCATE, _T("%s+0x%Ix"),
+			ModuleName, (ULONG_PTR)Address - (ULONG_PTR)Module);
+	}
+
+	if (_T('\0') == Text[0])
+	{
+		_sntprintf_s(Text, _countof(Text), _TRUNCATE, _T("0x%p"), Address);
+	}
+
+	return InternedString(Text);
+}
+
+///////////////////////////////////////////////////////////////////////
+// StackTracer Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Ctors / Dtors
+///////////////////////////////////////////////////////////////////////
+StackTracer::StackTracer(
+	StackTraceWriter	Writer,
+	void*				Context,
+	MetricsRegistry*	Telemetry /* = NULL */) :
+		m_Writer(Writer),
+		m_Context(Context),
+		m_Event(NULL),
+		m_Thread(NULL),
+		m_Stopping(0),
+		m_SeenCount(0),
+		m_QueueHead(0),
+		m_QueueCount(0),
+		m_QueueHighWater(0),
+		m_QueueHighWaterGauge(NULL),
+		m_Dropped(NULL),
+		m_BusyTime(NULL)
+{
+	InitializeCriticalSection(&m_Lock);
+	memset(m_Seen, 0, sizeof(m_Seen));
+	memset(m_Queue, 0, sizeof(m_Queue));
+
+	if (NULL != Telemetry)
+	{
+		m_QueueHighWaterGauge	= Telemetry->GetGauge(_T("diagnostics.stack_queue_high_water"));
+		m_Dropped				= Telemetry->GetCounter(_T("diagnostics.records_dropped"));
+		m_BusyTime				= Telemetry->GetCounter(_T("diagnostics.symbolizer_busy_us"));
+
+		if (NULL != m_QueueHighWaterGauge)
+		{
+			// carried over from an earlier tracer
+			m_QueueHighWater = (size_t)m_QueueHighWaterGauge->GetValue();
+		}
+	}
+
+	m_Event = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+	if (NULL != m_Event)
+	{
+		m_Thread = CreateThread(NULL, 0, Run, this, 0, NULL);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Stacks already queued are written before the thread stops.
+///////////////////////////////////////////////////////////////////////
+StackTracer::~StackTracer(void)
+{
+	if (NULL != m_Thread)
+	{
+		InterlockedExchange(&m_Stopping, 1);
+		SetEvent(m_Event);
+
+		WaitForSingleObject(m_Thread, INFINITE);
+		CloseHandle(m_Thread);
+		m_Thread = NULL;
+	}
+
+	for (size_t Index = 0; Index < m_QueueCount; Index++)
+	{
+		delete m_Queue[(m_QueueHead + Index) % STACK_TRACE_QUEUE_SIZE];
+	}
+
+	if (NULL != m_Event)
+	{
+		CloseHandle(m_Event);
+		m_Event = NULL;
+	}
+
+	DeleteCriticalSection(&m_Lock);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Submit
+//
+// Returns true if the stack was new and has been queued.  A stack that
+// could not be queued, because the queue was full, is not remembered,
+// so a later report of it gets another chance.
+///////////////////////////////////////////////////////////////////////
+bool
+StackTracer::Submit(
+	const StackTrace&	Trace)
+{
+	bool		ReturnCode	= false;
+	StackTrace*	Copy		= NULL;
+
+	if (NULL != m_Thread)
+	{
+		EnterCriticalSection(&m_Lock);
+
+		if (m_QueueCount == STACK_TRACE_QUEUE_SIZE)
+		{
+			if ((NULL != m_Dropped) && (true == MarkSeen(Trace.Hash, false)))
+			{
+				m_Dropped->Add();
+			}
+		}
+		else if (true == MarkSeen(Trace.Hash, true))
+		{
+			Copy = new StackTrace(Trace);
+
+			if (NULL != Copy)
+			{
+				m_Queue[(m_QueueHead + m_QueueCount) % STACK_TRACE_QUEUE_SIZE] = Copy;
+				m_QueueCount++;
+				ReturnCode = true;
+
+				if ((m_QueueCount > m_QueueHighWater) && (NULL != m_QueueHighWaterGauge))
+				{
+					m_QueueHighWater = m_QueueCount;
+					m_QueueHighWaterGauge->Set((LONGLONG)m_QueueHighWater);
+				}
+			}
+		}
+
+		LeaveCriticalSection(&m_Lock);
+
+		if (true == ReturnCode)
+		{
+			SetEvent(m_Event);
+		}
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// MarkSeen
+//
+// Called with the lock held.  Returns true if the hash was not seen
+// before and there is room to remember it; Remember then records it.
+///////////////////////////////////////////////////////////////////////
+bool
+StackTracer::MarkSeen(
+	ULONG	Hash,
+	bool	Remember)
+{
+	bool	ReturnCode	= false;
+	size_t	Slot		= Hash % STACK_TRACE_SEEN_SIZE;
+
+	if (m_SeenCount < STACK_TRACE_SEEN_SIZE / 4 * 3)
+	{
+		while ((0 != m_Seen[Slot]) && (Hash != m_Seen[Slot]))
+		{
+			Slot = (Slot + 1) % STACK_TRACE_SEEN_SIZE;
+		}
+
+		if (0 == m_Seen[Slot])
+		{
+			if (true == Remember)
+			{
+				m_Seen[Slot] = Hash;
+				m_SeenCount++;
+			}
+
+			ReturnCode = true;
+		}
+	}
+
+	return ReturnCode;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Symbolize
+//
+// Writes the stack as one record, headed by "stack=<hash>" to match the
+// field on the reports that refer to it.
+///////////////////////////////////////////////////////////////////////
+void
+StackTracer::Symbolize(
+	const StackTrace*	Trace)
+{
+	ArenaScope	Scope;
+	size_t		TextSize	= 32 + Trace->FrameCount * FRAME_TEXT_SIZE;
+	TCHAR*		Text		= Scope.AllocateString(TextSize);
+
+	if (NULL != Text)
+	{
+		int	Length	= _stprintf_s(Text, TextSize, _T("stack=%lu"), Trace->Hash);
+
+		for (size_t Index = 0; (0 < Length) && (Index < Trace->FrameCount); Index++)
+		{
+			InternedString	Symbol		= g_SymbolCache.Lookup(Trace->Frames[Index]);
+			int				FrameLength	= _stprintf_s(Text + Length,
+											TextSize - Length,
+											_T("\r\n\t#%02u %s"),
+											(UINT)Index,
+											Symbol.GetString());
+
+			if (0 < FrameLength)
+			{
+				Length += FrameLength;
+			}
+		}
+
+		if (0 < Length)
+		{
+			m_Writer(m_Context, Text, Length);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Run
+//
+// The symbolizer thread.  Drains the queue each time it is woken.
+///////////////////////////////////////////////////////////////////////
+DWORD WINAPI
+StackTracer::Run(
+	LPVOID	Parameter)
+{
+	StackTracer*	Tracer		= (StackTracer*)Parameter;
+	bool			Stopping	= false;
+
+	while (false == Stopping)
+	{
+		WaitForSingleObject(Tracer->m_Event, INFINITE);
+
+		Stopping = (0 != Tracer->m_Stopping);
+
+		StackTrace*	Trace	= NULL;
+
+		do
+		{
+			Trace = NULL;
+
+			EnterCriticalSection(&Tracer->m_Lock);
+
+			if (0 < Tracer->m_QueueCount)
+			{
+				Trace = Tracer->m_Queue[Tracer->m_QueueHead];
+				Tracer->m_QueueHead = (Tracer->m_QueueHead + 1) % STACK_TRACE_QUEUE_SIZE;
+				Tracer->m_QueueCount--;
+			}
+
+			LeaveCriticalSection(&Tracer->m_Lock);
+
+			if (NULL != Trace)
+			{
+				LONGLONG	StartCount	= GetPerformanceCount();
+
+				Tracer->Symbolize(Trace);
+				delete Trace;
+
+				if (NULL != Tracer->m_BusyTime)
+				{
+					Tracer->m_BusyTime->Add((LONGLONG)GetElapsedMicroseconds(StartCount,
+						GetPerformanceCount()));
+				}
+			}
+		}
+		while (NULL != Trace);
+	}
+
+	return 0;
+}
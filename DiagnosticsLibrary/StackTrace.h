@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////
+// StackTrace.h
+//
+// Stack capture on the reporting thread, symbolization on a background
+// thread.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "../Include/common.h"
+
+class MetricCounter;
+class MetricGauge;
+class MetricsRegistry;
+
+///////////////////////////////////////////////////////////////////////
+// defines
+///////////////////////////////////////////////////////////////////////
+const size_t STACK_TRACE_FRAMES			= 32;
+const size_t STACK_TRACE_QUEUE_SIZE		= 64;
+// unique stacks remembered, after which new ones are no longer written
+const size_t STACK_TRACE_SEEN_SIZE		= 1024;
+
+///////////////////////////////////////////////////////////////////////
+// Types
+///////////////////////////////////////////////////////////////////////
+struct StackTrace
+{
+	ULONG	Hash;
+	size_t	FrameCount;
+	void*	Frames[STACK_TRACE_FRAMES];
+};
+
+// receives the text of each symbolized stack, on the symbolizer thread
+typedef void (*StackTraceWriter)(
+	void*	Context,
+	LPCTSTR	Text,
+	size_t	Length);
+
+///////////////////////////////////////////////////////////////////////
+// CaptureStackTrace
+//
+// Only the raw return addresses are recorded, so this is cheap enough
+// to call on every error.  SkipFrames leaves out the callers' own
+// reporting frames.
+///////////////////////////////////////////////////////////////////////
+bool
+CaptureStackTrace(
+	ULONG		SkipFrames,
+	StackTrace*	Trace);
+
+///////////////////////////////////////////////////////////////////////
+// Class: StackTracer
+//
+// Stacks are identified by the hash of their return addresses.  The
+// first time a stack is submitted it is queued for the background
+// thread, which resolves the addresses (through a shared symbol cache)
+// and writes the stack once, headed by its hash.  Later submissions of
+// the same stack only need the hash in their report.
+//
+// Given a registry, the tracer keeps its queue high-water mark, the
+// stacks it had to drop and the thread's busy time there.
+///////////////////////////////////////////////////////////////////////
+class StackTracer
+{
+	public:
+		// Methods
+			StackTracer(
+				StackTraceWriter	Writer,
+				void*				Context,
+				MetricsRegistry*	Telemetry = NULL);
+			~StackTracer(void);
+
+			bool Submit(
+				const StackTrace&	Trace);
+
+	private:
+		// Properties
+			StackTraceWriter	m_Writer;
+			void*				m_Context;
+			CRITICAL_SECTION	m_Lock;
+			HANDLE				m_Event;
+			HANDLE				m_Thread;
+			volatile LONG		m_Stopping;
+			ULONG				m_Seen[STACK_TRACE_SEEN_SIZE];
+			size_t				m_SeenCount;
+			StackTrace*			m_Queue[STACK_TRACE_QUEUE_SIZE];
+			size_t				m_QueueHead;
+			size_t				m_QueueCount;
+			size_t				m_QueueHighWater;
+			MetricGauge*		m_QueueHighWaterGauge;
+			MetricCounter*		m_Dropped;
+			MetricCounter*		m_BusyTime;
+
+		// Methods
+			StackTracer(
+				const StackTracer&);
+			StackTracer& operator=(
+				const StackTracer&);
+
+			bool MarkSeen(
+				ULONG	Hash,
+				bool	Remember);
+			void Symbolize(
+				const StackTrace*	Trace);
+
+			static DWORD WINAPI Run(
+				LPVOID	Parameter);
+};
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////
+// TimingSpan.cpp - Class Implementation
+//
+// Scoped timing of an operation, reported when it ends.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include <tchar.h>
+#include "TimingSpan.h"
+#include "Metrics.h"
+#include "RecordFields.h"
+
+// ids are unique within the process, 0 means no span
+static volatile LONG g_LastSpanId = 0;
+
+///////////////////////////////////////////////////////////////////////
+// TimingSpan Class Definition
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// Start
+///////////////////////////////////////////////////////////////////////
+void
+TimingSpan::Start(
+	Diagnostics&	Owner)
+{
+	m_Id = (ULONG)InterlockedIncrement(&g_LastSpanId);
+
+	if (0 == m_Id)
+	{
+		// wrapped
+		m_Id = (ULONG)InterlockedIncrement(&g_LastSpanId);
+	}
+
+	m_Diagnostics = &Owner;
+
+	// last, so the time spent above is not counted
+	m_Start = GetPerformanceCount();
+}
+
+///////////////////////////////////////////////////////////////////////
+// End
+///////////////////////////////////////////////////////////////////////
+void
+TimingSpan::End(void)
+{
+	ULONGLONG		Duration	= GetElapsedMicroseconds(m_Start, GetPerformanceCount());
+	size_t			NameLength	= 0;
+	RecordFields	Fields;
+
+	if (NULL != m_Name)
+	{
+		NameLength = _tcslen(m_Name);
+	}
+
+	Fields.AddUnsigned(_T("span"), m_Id);
+
+	if (0 != m_ParentId)
+	{
+		Fields.AddUnsigned(_T("parent"), m_ParentId);
+	}
+
+	Fields.AddUnsigned(_T("duration_us"), Duration);
+
+	m_Diagnostics->Report(m_CategoryId, m_Name, NameLength, Fields);
+	m_Diagnostics = NULL;
+}
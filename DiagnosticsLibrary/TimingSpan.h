@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////
+// TimingSpan.h
+//
+// Scoped timing of an operation, reported when it ends.
+//
+// Copyright (c) 2006-2015 by James John McGuire
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+///////////////////////////////////////////////////////////////////////
+// Includes
+///////////////////////////////////////////////////////////////////////
+#include "../Include/common.h"
+#include "Diagnostics.h"
+
+///////////////////////////////////////////////////////////////////////
+// Class: TimingSpan
+//
+// Times its own lifetime with the performance counter and reports one
+// record when it goes out of scope: the name as the message, with
+// "span", "parent" (when given) and "duration_us" fields.  Pass the id
+// of an enclosing span as ParentId to nest spans.
+//
+// Whether the span is on is decided when it is created, from the output
+// level of its category, or the object's level when it has none.  When
+// that level has no outputs, construction and destruction are only the
+// inline checks below, so spans can be left in hot code.
+//
+// The name is not copied, and must outlive the span.
+///////////////////////////////////////////////////////////////////////
+class DllExport TimingSpan
+{
+	public:
+		// Methods
+			TimingSpan(
+				Diagnostics&	Owner,
+				LPCTSTR			Name,
+				ULONG			ParentId = 0) :
+					m_Diagnostics(NULL),
+					m_Name(Name),
+					m_CategoryId(DIAGNOSTICS_CATEGORY_NONE),
+					m_Id(0),
+					m_ParentId(ParentId),
+					m_Start(0)
+			{
+				if (true == Owner.IsEnabled(m_CategoryId))
+				{
+					Start(Owner);
+				}
+			}
+			TimingSpan(
+				Diagnostics&	Owner,
+				int				CategoryId,
+				LPCTSTR			Name,
+				ULONG			ParentId = 0) :
+					m_Diagnostics(NULL),
+					m_Name(Name),
+					m_CategoryId(CategoryId),
+					m_Id(0),
+					m_ParentId(ParentId),
+					m_Start(0)
+			{
+				if (true == Owner.IsEnabled(m_CategoryId))
+				{
+					Start(Owner);
+				}
+			}
+
+			~TimingSpan(void)
+			{
+				if (NULL != m_Diagnostics)
+				{
+					End();
+				}
+			}
+
+			// 0 when the span is off
+			ULONG GetId(void) const
+			{
+				return m_Id;
+			}
+
+	private:
+		// Properties
+			Diagnostics*	m_Diagnostics;
+			LPCTSTR			m_Name;
+			int				m_CategoryId;
+			ULONG			m_Id;
+			ULONG			m_ParentId;
+			LONGLONG		m_Start;
+
+		// Methods
+			TimingSpan(
+				const TimingSpan&);
+			TimingSpan& operator=(
+				const TimingSpan&);
+
+			void End(void);
+			void Start(
+				Diagnostics&	Owner);
+};
@@ -0,0 +1,90 @@
+/////////////////////////////////////////////////////////////////////////////
+// ErrorMessageTableTest.cpp
+//
+// Runs lookups read from standard input against an ErrorMessageTable with
+// the strerror formatter, for ErrorMessageTableTest.py to check.
+//
+// Usage: ErrorMessageTableTest < Commands
+//
+// Each input line is a command:
+//
+//	lookup Module ErrorCode LanguageId	prints the message, a tab, whether
+//										it was cached, as 1 or 0, a tab, and
+//										how many times the formatter has run
+//	count								prints the number of entries
+//	clear								empties the table, printing nothing
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../Utils/ErrorMessageTable.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+#define LINE_MAXIMUM	256
+
+static unsigned int g_FormatCount = 0;
+
+/////////////////////////////////////////////////////////////////////////////
+// CountFormat
+/////////////////////////////////////////////////////////////////////////////
+static void*
+	CountFormat(
+	const void*		Module,
+	unsigned int	ErrorCode,
+	unsigned short	LanguageId)
+{
+	g_FormatCount++;
+
+	return FormatErrnoMessage(Module, ErrorCode, LanguageId);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int
+	main(void)
+{
+	ErrorMessageTable	Table(CountFormat, FreeErrnoMessage);
+	char				Line[LINE_MAXIMUM];
+
+	while (NULL != fgets(Line, sizeof(Line), stdin))
+	{
+		unsigned long	Module		= 0;
+		unsigned int	ErrorCode	= 0;
+		unsigned int	LanguageId	= 0;
+
+		if (3 == sscanf(Line, "lookup %lx %u %x", &Module, &ErrorCode, &LanguageId))
+		{
+			bool	Cached	= false;
+			char*	Message	= (char*)Table.Lookup((const void*)Module, ErrorCode,
+				(unsigned short)LanguageId, &Cached);
+
+			printf("%s\t%d\t%u\n", (NULL != Message) ? Message : "",
+				(int)Cached, g_FormatCount);
+
+			if (false == Cached)
+			{
+				FreeErrnoMessage(Message);
+			}
+		}
+		else if (0 == strncmp(Line, "count", 5))
+		{
+			printf("%u\n", Table.GetCount());
+		}
+		else if (0 == strncmp(Line, "clear", 5))
+		{
+			Table.Clear();
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+#############################################################################
+# ErrorMessageTableTest.py
+#
+# Checks that ErrorMessageTable formats a message once per (module, code,
+# language), keeps keys that differ in any part apart, and stops caching,
+# but still answers, once it is full:
+#
+#	python ErrorMessageTableTest.py
+#
+# ErrorMessageTableTest.cpp is compiled with the compiler in CXX, c++ if
+# not set, as ErrorMessageTable needs only the C library and threads.
+#
+# Copyright (c) 2008 - 2015 by James John McGuire
+# All rights reserved.
+#############################################################################
+import errno
+import os
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+
+TESTS = os.path.dirname(os.path.abspath(__file__))
+UTILS = os.path.join(TESTS, '..', 'Utils')
+
+# must match ErrorMessageTable.h
+TABLE_LIMIT = 512 * 3 // 4
+
+ENGLISH = 0x0409
+GERMAN = 0x0407
+
+
+def lookup(module, code, language_id):
+	return 'lookup %x %d %x' % (module, code, language_id)
+
+
+def run(program, commands):
+	result = subprocess.run([program], input=''.join(command + '\n' for command in commands),
+		stdout=subprocess.PIPE, universal_newlines=True)
+
+	return result.returncode, result.stdout.splitlines()
+
+
+def check(name, program, commands, expected):
+	code, lines = run(program, commands)
+	passed = (0 == code) and (expected == lines)
+
+	print('%s: %s' % ('ok' if passed else 'FAILED', name))
+
+	return passed
+
+
+def found(code, cached, formats):
+	return '%s\t%d\t%d' % (os.strerror(code), 1 if cached else 0, formats)
+
+
+def main():
+	work = tempfile.mkdtemp()
+	passed = True
+
+	try:
+		program = os.path.join(work, 'ErrorMessageTableTest')
+
+		subprocess.check_call(shlex.split(os.environ.get('CXX', 'c++')) + ['-pthread', '-o',
+			program, os.path.join(TESTS, 'ErrorMessageTableTest.cpp'),
+			os.path.join(UTILS, 'ErrorMessageTable.cpp')])
+
+		passed &= check('miss then hit', program,
+			[lookup(0, errno.ENOENT, ENGLISH), lookup(0, errno.ENOENT, ENGLISH), 'count'],
+			[found(errno.ENOENT, True, 1), found(errno.ENOENT, True, 1), '1'])
+
+		# modules 4 bytes apart hash alike, so these also probe past each other
+		keys = [(0, errno.ENOENT, ENGLISH), (0, errno.EACCES, ENGLISH),
+			(0, errno.ENOENT, GERMAN), (0x10000000, errno.ENOENT, ENGLISH),
+			(0x10000004, errno.ENOENT, ENGLISH), (0x10000004, errno.ENOENT, GERMAN)]
+
+		passed &= check('keys kept apart', program,
+			[lookup(*key) for key in keys] + [lookup(*key) for key in keys] + ['count'],
+			[found(key[1], True, index + 1) for index, key in enumerate(keys)] +
+			[found(key[1], True, len(keys)) for key in keys] + [str(len(keys))])
+
+		# codes strerror does not know still get a message, and fill the table
+		filling = [lookup(0, 1000 + index, ENGLISH) for index in range(TABLE_LIMIT)]
+
+		passed &= check('full table', program,
+			filling + ['count',
+				lookup(0, errno.ENOENT, ENGLISH), lookup(0, errno.ENOENT, ENGLISH),
+				lookup(0, 1000, ENGLISH), 'count'],
+			[found(1000 + index, True, index + 1) for index in range(TABLE_LIMIT)] +
+				[str(TABLE_LIMIT),
+				found(errno.ENOENT, False, TABLE_LIMIT + 1),
+				found(errno.ENOENT, False, TABLE_LIMIT + 2),
+				found(1000, True, TABLE_LIMIT + 2), str(TABLE_LIMIT)])
+
+		passed &= check('clear', program,
+			filling + ['clear', 'count', lookup(0, errno.ENOENT, ENGLISH),
+				lookup(0, 1000, ENGLISH), 'count'],
+			[found(1000 + index, True, index + 1) for index in range(TABLE_LIMIT)] +
+				['0', found(errno.ENOENT, True, TABLE_LIMIT + 1),
+				found(1000, True, TABLE_LIMIT + 2), '2'])
+	finally:
+		shutil.rmtree(work)
+
+	return 0 if passed else 1
+
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -0,0 +1,143 @@
+/////////////////////////////////////////////////////////////////////////////
+// NormalizationTest.cpp
+//
+// Normalizes strings read from standard input, for NormalizationTest.py to
+// compare with Python's unicodedata.
+//
+// Usage: NormalizationTest < Strings
+//
+// Each input line is a string, as hex code points separated by spaces.
+// Each output line has, separated by tabs: the NFC and NFD forms, as hex
+// code points, surrogate pairs joined; the NFC and NFD quick check
+// results, as Y, N or M; and whether the string is NFC and NFD, as 1 or 0.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include "../Utils/Normalization.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+#define LINE_MAXIMUM	4096
+#define STRING_MAXIMUM	256
+
+/////////////////////////////////////////////////////////////////////////////
+// PrintString
+/////////////////////////////////////////////////////////////////////////////
+static void
+	PrintString(
+	const wchar_t*	Text,
+	size_t			Length)
+{
+	const char*	Separator	= "";
+
+	for (size_t Index = 0; Index < Length; Index++)
+	{
+		unsigned long	Character	= (unsigned long)Text[Index];
+
+		if ((0xD800 <= Character) && (Character < 0xDC00) &&
+			(Index + 1 < Length) && (0xDC00 <= (unsigned long)Text[Index + 1]) &&
+			((unsigned long)Text[Index + 1] <= 0xDFFF))
+		{
+			Character = 0x10000 + ((Character - 0xD800) << 10) +
+				((unsigned long)Text[Index + 1] - 0xDC00);
+			Index++;
+		}
+
+		printf("%s%lX", Separator, Character);
+		Separator = " ";
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// PrintNormalized
+/////////////////////////////////////////////////////////////////////////////
+static void
+	PrintNormalized(
+	UnicodeForm		Form,
+	const wchar_t*	String,
+	size_t			Length)
+{
+	size_t		BufferSize	= GetNormalizedBound(Length);
+	wchar_t*	Buffer		= new wchar_t[BufferSize + 1];
+
+	PrintString(Buffer, NormalizeString(Form, String, Length, Buffer, BufferSize));
+
+	delete[] Buffer;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetQuickCheckName
+/////////////////////////////////////////////////////////////////////////////
+static char
+	GetQuickCheckName(
+	QuickCheckResult	Result)
+{
+	char	Name	= 'M';
+
+	if (QuickCheckYes == Result)
+	{
+		Name = 'Y';
+	}
+	else if (QuickCheckNo == Result)
+	{
+		Name = 'N';
+	}
+
+	return Name;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int
+	main(void)
+{
+	char	Line[LINE_MAXIMUM];
+
+	while (NULL != fgets(Line, sizeof(Line), stdin))
+	{
+		wchar_t			String[STRING_MAXIMUM * 2];
+		size_t			Length		= 0;
+		char*			Position	= Line;
+		char*			End			= NULL;
+		unsigned long	Character	= strtoul(Position, &End, 16);
+
+		while ((End != Position) && (Length < STRING_MAXIMUM * 2 - 1))
+		{
+			if ((2 == sizeof(wchar_t)) && (0xFFFF < Character))
+			{
+				Character -= 0x10000;
+
+				String[Length++] = (wchar_t)(0xD800 + (Character >> 10));
+				String[Length++] = (wchar_t)(0xDC00 + (Character & 0x3FF));
+			}
+			else
+			{
+				String[Length++] = (wchar_t)Character;
+			}
+
+			Position	= End;
+			Character	= strtoul(Position, &End, 16);
+		}
+
+		PrintNormalized(UnicodeFormC, String, Length);
+		printf("\t");
+		PrintNormalized(UnicodeFormD, String, Length);
+
+		printf("\t%c\t%c\t%d\t%d\n",
+			GetQuickCheckName(QuickCheckNormalization(UnicodeFormC, String, Length)),
+			GetQuickCheckName(QuickCheckNormalization(UnicodeFormD, String, Length)),
+			(int)IsNormalizedString(UnicodeFormC, String, Length),
+			(int)IsNormalizedString(UnicodeFormD, String, Length));
+	}
+
+	return 0;
+}
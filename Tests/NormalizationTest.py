@@ -0,0 +1,153 @@
+#############################################################################
+# NormalizationTest.py
+#
+# Checks NormalizeString, QuickCheckNormalization and IsNormalizedString
+# against Python's unicodedata, which must be the Unicode version
+# NormalizationData.h was generated from:
+#
+#	python NormalizationTest.py
+#
+# Every code point is normalized on its own, then runs of plain text ahead
+# of characters that need normalizing, to exercise the quick check's
+# skipping, then random mixes of letters, marks and Hangul.  A quick check
+# of yes or no must agree with unicodedata; maybe may go either way.
+#
+# NormalizationTest.cpp is compiled with the compiler in CXX, c++ if not
+# set, as Normalization needs only the C library.
+#
+# Copyright (c) 2008 - 2015 by James John McGuire
+# All rights reserved.
+#############################################################################
+import os
+import random
+import re
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+import unicodedata
+
+TESTS = os.path.dirname(os.path.abspath(__file__))
+UTILS = os.path.join(TESTS, '..', 'Utils')
+
+# code points at or above this have no normalization properties
+PROPERTY_LIMIT = 0x30000
+
+# characters to build random strings from: plain text below both quick
+# check limits, Latin-1 letters that decompose, combining marks of several
+# classes, Hangul jamo and syllables, composition exclusions, and a
+# character outside the BMP that decomposes
+POOL = [
+	'a', 'e', 'o', 'A', ' ', '\u00A8', '\u00BF',
+	'\u00C0', '\u00C5', '\u00E9', '\u00F1', '\u0100',
+	'\u0300', '\u0301', '\u0308', '\u0316', '\u0327', '\u0345', '\u05B0', '\u0E38',
+	'\u1100', '\u1161', '\u11A8', '\uAC00', '\uAC01',
+	'\u0958', '\u2126', '\u212B', '\U0001D15E', '\U0001D165', '\U00010000',
+]
+RANDOM_STRINGS = 20000
+
+
+def get_version():
+	with open(os.path.join(UTILS, 'NormalizationData.h')) as data:
+		return re.search(r'Unicode ([0-9]+(?:\.[0-9]+)*)', data.read()).group(1)
+
+
+def encode(text):
+	return ' '.join('%X' % ord(character) for character in text)
+
+
+def run(program, strings):
+	result = subprocess.run([program], input=''.join(encode(text) + '\n' for text in strings),
+		stdout=subprocess.PIPE, universal_newlines=True)
+
+	return result.returncode, result.stdout.split('\n')[:len(strings)]
+
+
+def compare(text, line):
+	fields = line.split('\t')
+
+	if 6 != len(fields):
+		return False
+
+	nfc_text, nfd_text, nfc_check, nfd_check, nfc_normalized, nfd_normalized = fields
+
+	for form, output, check, normalized in (('NFC', nfc_text, nfc_check, nfc_normalized),
+		('NFD', nfd_text, nfd_check, nfd_normalized)):
+		expected = unicodedata.is_normalized(form, text)
+
+		if (output != encode(unicodedata.normalize(form, text))) or \
+			(normalized != ('1' if expected else '0')) or \
+			((check == 'Y') and not expected) or ((check == 'N') and expected):
+			return False
+
+	return True
+
+
+def check_strings(name, program, strings):
+	code, lines = run(program, strings)
+	failures = [text for text, line in zip(strings, lines) if not compare(text, line)]
+	passed = (0 == code) and (len(lines) == len(strings)) and not failures
+
+	print('%s: %s' % ('ok' if passed else 'FAILED', name))
+
+	for text in failures[:5]:
+		print('\t%s' % encode(text))
+
+	return passed
+
+
+def check_quick(name, program, text, nfc_check, nfd_check):
+	code, lines = run(program, [text])
+	passed = (0 == code) and (1 == len(lines)) and \
+		(lines[0].split('\t')[2:4] == [nfc_check, nfd_check])
+
+	print('%s: %s' % ('ok' if passed else 'FAILED', name))
+
+	return passed
+
+
+def main():
+	if unicodedata.unidata_version != get_version():
+		print('FAILED: unicodedata is %s, NormalizationData.h %s' %
+			(unicodedata.unidata_version, get_version()))
+
+		return 1
+
+	work = tempfile.mkdtemp()
+	passed = True
+
+	try:
+		program = os.path.join(work, 'NormalizationTest')
+
+		subprocess.check_call(shlex.split(os.environ.get('CXX', 'c++')) + ['-o', program,
+			os.path.join(TESTS, 'NormalizationTest.cpp'), os.path.join(UTILS, 'Normalization.cpp')])
+
+		passed &= check_strings('every code point', program,
+			[chr(code_point) for code_point in range(1, PROPERTY_LIMIT)
+				if not (0xD800 <= code_point <= 0xDFFF)])
+
+		# the quick check skips 8 characters at a time below its limit
+		passed &= check_strings('after plain text', program,
+			['a' * length + character + 'b' * (length % 3)
+				for length in range(0, 20) for character in POOL])
+
+		generator = random.Random(0)
+
+		passed &= check_strings('random strings', program,
+			[''.join(generator.choice(POOL) for _ in range(generator.randint(1, 12)))
+				for _ in range(RANDOM_STRINGS)])
+
+		passed &= check_quick('plain text', program, 'plain text', 'Y', 'Y')
+		passed &= check_quick('Latin-1 letter', program, 'plain text \u00C0', 'Y', 'N')
+		passed &= check_quick('combining mark', program, 'plain text e\u0301', 'M', 'Y')
+		passed &= check_quick('marks out of order', program, 'a\u0301\u0316', 'N', 'N')
+		passed &= check_quick('composition exclusion', program, '\u0958', 'N', 'N')
+	finally:
+		shutil.rmtree(work)
+
+	return 0 if passed else 1
+
+
+if __name__ == '__main__':
+	sys.exit(main())
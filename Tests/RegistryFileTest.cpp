@@ -0,0 +1,327 @@
+/////////////////////////////////////////////////////////////////////////////
+// RegistryFileTest.cpp
+//
+// Applies registry writes to a .reg file with RegistryFile, and dumps the
+// file as RegistrySnapshot::LoadFile reads it back, for
+// RegistryFileTest.py to compare with its own model of the registry.
+//
+// Usage: RegistryFileTest < Commands
+//
+// Reads a command per line, its fields separated by tabs:
+//
+//	set		KeyPath	Name	Type	Data
+//	delete	KeyPath	Name
+//	deletekey	KeyPath
+//	apply	File
+//	dump	File
+//
+// Paths, names and string data are given as hex code points separated by
+// spaces, other data as hex bytes, and the type in hex.  apply prints
+// "applied" or "failed"; dump prints the file as RegistrySnapshotTest
+// does, or "unreadable".
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "../Utils/RegistryFile.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+#define LINE_SIZE		65536
+
+#define FIELD_COUNT		5
+
+/////////////////////////////////////////////////////////////////////////////
+// IsStringType
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	IsStringType(
+	unsigned int	Type)
+{
+	return ((REG_SZ == Type) || (REG_EXPAND_SZ == Type) ||
+		(REG_MULTI_SZ == Type));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// PrintString
+/////////////////////////////////////////////////////////////////////////////
+static void
+	PrintString(
+	const wchar_t*	Text,
+	size_t			Length)
+{
+	const char*	Separator	= "";
+
+	for (size_t Index = 0; Index < Length; Index++)
+	{
+		unsigned long	Character	= (unsigned long)Text[Index];
+
+		if ((2 == sizeof(wchar_t)) && (0xD800 <= Character) &&
+			(Character < 0xDC00) && (Index + 1 < Length) &&
+			(0xDC00 <= (unsigned long)Text[Index + 1]) &&
+			((unsigned long)Text[Index + 1] <= 0xDFFF))
+		{
+			Character = 0x10000 + ((Character - 0xD800) << 10) +
+				((unsigned long)Text[Index + 1] - 0xDC00);
+			Index++;
+		}
+
+		printf("%s%lX", Separator, Character);
+		Separator = " ";
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Dump
+/////////////////////////////////////////////////////////////////////////////
+static void
+	Dump(
+	const wchar_t*	FilePath)
+{
+	RegistrySnapshot	Snapshot;
+
+	if (true == Snapshot.LoadFile(FilePath, NULL))
+	{
+		for (size_t Index = 0; Index < Snapshot.GetKeyCount(); Index++)
+		{
+			const wchar_t*	Path	= Snapshot.GetKeyPath(Index);
+
+			printf("key\t");
+			PrintString(Path, wcslen(Path));
+			printf("\n");
+		}
+
+		for (size_t Index = 0; Index < Snapshot.GetValueCount(); Index++)
+		{
+			const RegistryValue*	Value	= Snapshot.GetValue(Index);
+
+			printf("value\t");
+			PrintString(Value->KeyPath, wcslen(Value->KeyPath));
+			printf("\t");
+			PrintString(Value->Name, wcslen(Value->Name));
+			printf("\t%X\t", Value->Type);
+
+			if (true == IsStringType(Value->Type))
+			{
+				PrintString((const wchar_t*)Value->Data,
+					Value->DataSize / sizeof(wchar_t));
+			}
+			else
+			{
+				for (unsigned int Byte = 0; Byte < Value->DataSize; Byte++)
+				{
+					printf("%02X", Value->Data[Byte]);
+				}
+			}
+
+			printf("\n");
+		}
+	}
+	else
+	{
+		printf("unreadable\n");
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ParseString
+//
+// Decodes hex code points, as surrogate pairs where wchar_t is 16 bits.
+// Returns the characters, for the caller to delete, and their count.
+/////////////////////////////////////////////////////////////////////////////
+static wchar_t*
+	ParseString(
+	const char*	Field,
+	size_t*		Length)
+{
+	// a pair needs a code point of five digits, so this is enough
+	wchar_t*	Text	= new wchar_t[strlen(Field) + 1];
+	char*		End		= NULL;
+
+	*Length = 0;
+
+	while ('\0' != *Field)
+	{
+		unsigned long	Character	= strtoul(Field, &End, 16);
+
+		if ((2 == sizeof(wchar_t)) && (0x10000 <= Character))
+		{
+			Text[*Length] = (wchar_t)(0xD800 + ((Character - 0x10000) >> 10));
+			(*Length)++;
+			Character = 0xDC00 + ((Character - 0x10000) & 0x3FF);
+		}
+
+		Text[*Length] = (wchar_t)Character;
+		(*Length)++;
+
+		Field = End;
+
+		if (' ' == *Field)
+		{
+			Field++;
+		}
+	}
+
+	Text[*Length] = L'\0';
+
+	return Text;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ParseBytes
+/////////////////////////////////////////////////////////////////////////////
+static unsigned char*
+	ParseBytes(
+	const char*	Field,
+	size_t*		Size)
+{
+	unsigned char*	Bytes	= new unsigned char[strlen(Field) / 2 + 1];
+
+	for (*Size = 0; ('\0' != Field[0]) && ('\0' != Field[1]); (*Size)++)
+	{
+		char	Pair[3]	= { Field[0], Field[1], '\0' };
+
+		Bytes[*Size] = (unsigned char)strtoul(Pair, NULL, 16);
+		Field += 2;
+	}
+
+	return Bytes;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Widen
+//
+// File paths are ASCII, so need no locale.
+/////////////////////////////////////////////////////////////////////////////
+static wchar_t*
+	Widen(
+	const char*	Text)
+{
+	size_t		Length	= strlen(Text);
+	wchar_t*	Wide	= new wchar_t[Length + 1];
+
+	for (size_t Index = 0; Index <= Length; Index++)
+	{
+		Wide[Index] = (wchar_t)(unsigned char)Text[Index];
+	}
+
+	return Wide;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int
+	main(void)
+{
+	int				ReturnCode	= 0;
+	RegistryFile	File;
+	char*			Line		= new char[LINE_SIZE];
+
+	while ((0 == ReturnCode) && (NULL != fgets(Line, LINE_SIZE, stdin)))
+	{
+		char*		Fields[FIELD_COUNT]	= { NULL };
+		size_t		FieldCount			= 0;
+		char*		Next				= Line;
+		size_t		Length				= 0;
+		wchar_t*	KeyPath				= NULL;
+		wchar_t*	Name				= NULL;
+
+		Line[strcspn(Line, "\r\n")] = '\0';
+
+		while ((NULL != Next) && (FieldCount < FIELD_COUNT))
+		{
+			Fields[FieldCount] = Next;
+			FieldCount++;
+
+			Next = strchr(Next, '\t');
+
+			if (NULL != Next)
+			{
+				*Next = '\0';
+				Next++;
+			}
+		}
+
+		if ((0 == strcmp(Fields[0], "set")) && (5 == FieldCount))
+		{
+			unsigned int	Type	= (unsigned int)strtoul(Fields[3], NULL,
+				16);
+			unsigned char*	Data	= NULL;
+			size_t			Size	= 0;
+
+			KeyPath	= ParseString(Fields[1], &Length);
+			Name	= ParseString(Fields[2], &Length);
+
+			if (true == IsStringType(Type))
+			{
+				Data = (unsigned char*)ParseString(Fields[4], &Size);
+				Size *= sizeof(wchar_t);
+			}
+			else
+			{
+				Data = ParseBytes(Fields[4], &Size);
+			}
+
+			File.SetValue(KeyPath, Name, Type, Data, (unsigned int)Size);
+
+			if (true == IsStringType(Type))
+			{
+				delete[] (wchar_t*)Data;
+			}
+			else
+			{
+				delete[] Data;
+			}
+		}
+		else if ((0 == strcmp(Fields[0], "delete")) && (3 == FieldCount))
+		{
+			KeyPath	= ParseString(Fields[1], &Length);
+			Name	= ParseString(Fields[2], &Length);
+
+			File.Delete(KeyPath, Name);
+		}
+		else if ((0 == strcmp(Fields[0], "deletekey")) && (2 == FieldCount))
+		{
+			KeyPath = ParseString(Fields[1], &Length);
+
+			File.DeleteKey(KeyPath);
+		}
+		else if ((0 == strcmp(Fields[0], "apply")) && (2 == FieldCount))
+		{
+			KeyPath = Widen(Fields[1]);
+
+			printf("%s\n", (true == File.Apply(KeyPath)) ?
+				"applied" : "failed");
+		}
+		else if ((0 == strcmp(Fields[0], "dump")) && (2 == FieldCount))
+		{
+			KeyPath = Widen(Fields[1]);
+
+			Dump(KeyPath);
+		}
+		else
+		{
+			fprintf(stderr, "bad command: %s\n", Fields[0]);
+			ReturnCode = 1;
+		}
+
+		delete[] KeyPath;
+		delete[] Name;
+
+		fflush(stdout);
+	}
+
+	delete[] Line;
+
+	return ReturnCode;
+}
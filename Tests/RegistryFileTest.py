@@ -0,0 +1,313 @@
+#############################################################################
+# RegistryFileTest.py
+#
+# Applies random value writes, value deletions and key deletions to a .reg
+# file with RegistryFile, and checks that RegistrySnapshot reads back what
+# the same edits leave in a model of the registry:
+#
+#	python RegistryFileTest.py
+#
+# The file is first created, then replaced by one written as regedit
+# does, then edited over several rounds, each applied at once.  Values
+# are strings that need escaping or UTF-16 surrogate pairs, dword: values,
+# and hex: and hex(n): values long enough to be continued; names are set
+# again in another case.  An edit that can not be applied is kept to be
+# applied again.
+#
+# RegistryFileTest.cpp is compiled with the compiler in CXX, c++ if not
+# set, as .reg files are written with nothing but the C library.
+#
+# Copyright (c) 2008 - 2015 by James John McGuire
+# All rights reserved.
+#############################################################################
+import os
+import random
+import shlex
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+TESTS = os.path.dirname(os.path.abspath(__file__))
+UTILS = os.path.join(TESTS, '..', 'Utils')
+
+REG_NONE = 0
+REG_SZ = 1
+REG_EXPAND_SZ = 2
+REG_BINARY = 3
+REG_DWORD = 4
+REG_MULTI_SZ = 7
+REG_QWORD = 11
+
+STRING_TYPES = (REG_SZ, REG_EXPAND_SZ, REG_MULTI_SZ)
+
+HEADER = 'Windows Registry Editor Version 5.00\r\n'
+
+ROOT = 'HKEY_CURRENT_USER\\Software\\Zenware'
+TEST = ROOT + '\\Test'
+
+# bytes of hex: data per line, as regedit writes them
+HEX_LINE = 25
+
+ROUNDS = 40
+
+# the keys edited; TestOther shares the start of Test's path, but not a
+# whole component, so is not deleted with it
+KEY_PATHS = [ROOT, TEST, TEST + '\\Sub', TEST + '\\Sub\\Deeper',
+	TEST + '\\Caf\u00e9', TEST + 'Other']
+
+NAMES = ['', 'Name', 'NAME', 'name', 'Quoted "name" = \\', 'Caf\u00e9',
+	'\U0001F600']
+
+PIECES = ['a', 'Z', ' ', '"', '\\', '=', '%Path%', '\u00e9', '\u4e2d',
+	'\U0001F600']
+
+# the file as regedit writes it, before any edits
+EXISTING = [
+	(TEST, [
+		('', REG_SZ, 'the default value\0'),
+		('Name', REG_DWORD, struct.pack('<I', 0x0001F00D)),
+		('Binary', REG_BINARY, bytes(range(0, 256, 3))),
+		('Expand', REG_EXPAND_SZ, '%SystemRoot%\\\U0001F600\0'),
+	]),
+	(TEST + '\\Sub', [
+		('Caf\u00e9', REG_MULTI_SZ, 'one\0two\0\0'),
+	]),
+	(TEST + '\\Empty', []),
+	(TEST + 'Other', [
+		('Quad', REG_QWORD, struct.pack('<Q', 0x0123456789ABCDEF)),
+	]),
+]
+
+
+class Model(object):
+	# the keys and values, by path and name folded to lower case, as the
+	# registry would hold them
+
+	def __init__(self):
+		self.keys = {}
+		self.values = {}
+
+	def set(self, key_path, name, value_type, data):
+		self.keys[fold(key_path)] = key_path
+		self.values[(fold(key_path), fold(name))] = (key_path, name, value_type, data)
+
+	def delete(self, key_path, name):
+		self.values.pop((fold(key_path), fold(name)), None)
+
+	def delete_key(self, key_path):
+		def is_under(path):
+			return (fold(path) == fold(key_path)) or \
+				fold(path).startswith(fold(key_path) + '\\')
+
+		self.keys = dict((folded, path) for folded, path in self.keys.items()
+			if not is_under(path))
+		self.values = dict((folded, value) for folded, value in self.values.items()
+			if not is_under(value[0]))
+
+	def get_lines(self):
+		key_lines = [(fold(path), 'key\t' + encode(path)) for path in self.keys.values()]
+		value_lines = [((fold(key_path), fold(name)), '\t'.join(['value',
+			encode(key_path), encode(name), '%X' % value_type,
+			encode(data) if value_type in STRING_TYPES else format_bytes(data)]))
+			for key_path, name, value_type, data in self.values.values()]
+
+		return [line for _, line in sorted(key_lines)] + \
+			[line for _, line in sorted(value_lines)]
+
+
+def fold(text):
+	# as the C locale folds case
+	return ''.join(character.lower() if 'A' <= character <= 'Z' else character
+		for character in text)
+
+
+def encode(text):
+	return ' '.join('%X' % ord(character) for character in text)
+
+
+def format_bytes(data):
+	return ''.join('%02X' % byte for byte in data)
+
+
+def escape(text):
+	return text.replace('\\', '\\\\').replace('"', '\\"')
+
+
+def format_hex(prefix, data):
+	# continued as regedit does, each line ending with a comma and backslash
+	lines = []
+	pairs = ['%02x' % byte for byte in data]
+
+	for start in range(0, len(pairs), HEX_LINE):
+		lines.append(','.join(pairs[start:start + HEX_LINE]))
+
+	return prefix + ',\\\r\n  '.join(lines)
+
+
+def format_value(name, value_type, data):
+	line = '@=' if ('' == name) else '"%s"=' % escape(name)
+
+	if REG_SZ == value_type:
+		line += '"%s"' % escape(data[:-1])
+	elif REG_DWORD == value_type:
+		line += 'dword:%08x' % struct.unpack('<I', data)
+	elif REG_BINARY == value_type:
+		line = format_hex(line + 'hex:', data)
+	else:
+		if value_type in STRING_TYPES:
+			data = data.encode('utf-16-le')
+
+		line = format_hex(line + 'hex(%x):' % value_type, data)
+
+	return line
+
+
+def format_existing():
+	lines = [HEADER[:-2], '']
+
+	for key_path, values in EXISTING:
+		lines.append('[%s]' % key_path)
+		lines += [format_value(name, value_type, data) for name, value_type, data in values]
+		lines.append('')
+
+	return b'\xff\xfe' + '\r\n'.join(lines).encode('utf-16-le')
+
+
+def random_text(generator):
+	return ''.join(generator.choice(PIECES) for _ in range(generator.randint(0, 12)))
+
+
+def random_value(generator):
+	value_type = generator.choice([REG_SZ, REG_SZ, REG_EXPAND_SZ, REG_MULTI_SZ,
+		REG_DWORD, REG_BINARY, REG_QWORD, REG_NONE])
+
+	if REG_SZ == value_type:
+		data = random_text(generator) + '\0'
+	elif REG_EXPAND_SZ == value_type:
+		data = '%SystemRoot%' + random_text(generator) + '\0'
+	elif REG_MULTI_SZ == value_type:
+		data = ''.join(random_text(generator) + '\0'
+			for _ in range(generator.randint(1, 3))) + '\0'
+	elif REG_DWORD == value_type:
+		data = struct.pack('<I', generator.getrandbits(32))
+	elif REG_QWORD == value_type:
+		data = struct.pack('<Q', generator.getrandbits(64))
+	elif REG_BINARY == value_type:
+		data = bytes(generator.getrandbits(8) for _ in range(generator.randint(0, 80)))
+	else:
+		data = b''
+
+	return value_type, data
+
+
+def format_set(key_path, name, value_type, data):
+	return '\t'.join(['set', encode(key_path), encode(name), '%X' % value_type,
+		encode(data) if value_type in STRING_TYPES else format_bytes(data)])
+
+
+def random_edits(generator, model):
+	commands = []
+
+	for _ in range(generator.randint(1, 30)):
+		key_path = generator.choice(KEY_PATHS)
+		name = generator.choice(NAMES)
+		choice = generator.random()
+
+		if choice < 0.6:
+			value_type, data = random_value(generator)
+			model.set(key_path, name, value_type, data)
+			commands.append(format_set(key_path, name, value_type, data))
+		elif choice < 0.9:
+			model.delete(key_path, name)
+			commands.append('\t'.join(['delete', encode(key_path), encode(name)]))
+		# the root's deletion empties the file, so is rare
+		elif (ROOT != key_path) or (choice > 0.99):
+			model.delete_key(key_path)
+			commands.append('\t'.join(['deletekey', encode(key_path)]))
+
+	return commands
+
+
+def run(program, commands):
+	result = subprocess.run([program], input='\n'.join(commands) + '\n',
+		stdout=subprocess.PIPE, universal_newlines=True)
+
+	return result.returncode, result.stdout.splitlines()
+
+
+def check(name, passed, lines=(), expected=()):
+	print('%s: %s' % ('ok' if passed else 'FAILED', name))
+
+	if not passed:
+		for line in [line for line in lines if line not in expected][:5]:
+			print('\tunexpected %s' % line)
+
+		for line in [line for line in expected if line not in lines][:5]:
+			print('\tmissing %s' % line)
+
+	return passed
+
+
+def main():
+	work = tempfile.mkdtemp()
+	passed = True
+
+	try:
+		program = os.path.join(work, 'RegistryFileTest')
+		path = os.path.join(work, 'Test.reg')
+		generator = random.Random(2015)
+		model = Model()
+
+		subprocess.check_call(shlex.split(os.environ.get('CXX', 'c++')) + ['-o', program,
+			os.path.join(TESTS, 'RegistryFileTest.cpp'),
+			os.path.join(UTILS, 'RegistryFile.cpp'),
+			os.path.join(UTILS, 'RegistrySnapshot.cpp')])
+
+		# a file that does not exist is created
+		commands = random_edits(generator, model)
+		code, lines = run(program, commands + ['apply\t' + path, 'dump\t' + path])
+		passed &= check('new file', (0 == code) and (['applied'] + model.get_lines() == lines),
+			lines, ['applied'] + model.get_lines())
+
+		# the edits are kept until a file can be written
+		commands = random_edits(generator, model)
+		code, lines = run(program, commands + ['apply\t' + os.path.join(work, 'Missing', 'Test.reg'),
+			'apply\t' + path, 'dump\t' + path])
+		passed &= check('edits kept after a failure',
+			(0 == code) and (['failed', 'applied'] + model.get_lines() == lines),
+			lines, ['failed', 'applied'] + model.get_lines())
+
+		with open(path, 'wb') as output:
+			output.write(format_existing())
+
+		model = Model()
+
+		for key_path, values in EXISTING:
+			model.keys[fold(key_path)] = key_path
+
+			for name, value_type, data in values:
+				model.set(key_path, name, value_type, data)
+
+		for number in range(ROUNDS):
+			commands = random_edits(generator, model)
+			expected = ['applied'] + model.get_lines()
+			code, lines = run(program, commands + ['apply\t' + path, 'dump\t' + path])
+			passed &= check('round %d, %d edits' % (number + 1, len(commands)),
+				(0 == code) and (expected == lines), lines, expected)
+
+		with open(path, 'rb') as input:
+			contents = input.read()
+
+		passed &= check('written as regedit writes',
+			contents.startswith(b'\xff\xfe' + HEADER.encode('utf-16-le')) and
+			(sorted(os.listdir(work)) == ['RegistryFileTest', 'Test.reg']))
+	finally:
+		shutil.rmtree(work)
+
+	return 0 if passed else 1
+
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -0,0 +1,162 @@
+/////////////////////////////////////////////////////////////////////////////
+// RegistrySnapshotTest.cpp
+//
+// Dumps a .reg file, as RegistrySnapshot::LoadFile reads it, for
+// RegistrySnapshotTest.py to compare with the values it was written from.
+//
+// Usage: RegistrySnapshotTest File [KeyPath]
+//
+// Prints a line per key, "key", a tab and its path, then a line per
+// value, "value", the key path, the name, the type in hex and the data,
+// separated by tabs.  Paths, names and string data are printed as hex
+// code points, surrogate pairs joined where wchar_t is 16 bits, and
+// other data as hex bytes.  A value that Find does not return is printed
+// again with "lost" in place of "value".  Exits with 1 if the file cannot be loaded.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "../Utils/RegistrySnapshot.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// PrintString
+/////////////////////////////////////////////////////////////////////////////
+static void
+	PrintString(
+	const wchar_t*	Text,
+	size_t			Length)
+{
+	const char*	Separator	= "";
+
+	for (size_t Index = 0; Index < Length; Index++)
+	{
+		unsigned long	Character	= (unsigned long)Text[Index];
+
+		if ((2 == sizeof(wchar_t)) && (0xD800 <= Character) &&
+			(Character < 0xDC00) && (Index + 1 < Length) &&
+			(0xDC00 <= (unsigned long)Text[Index + 1]) &&
+			((unsigned long)Text[Index + 1] <= 0xDFFF))
+		{
+			Character = 0x10000 + ((Character - 0xD800) << 10) +
+				((unsigned long)Text[Index + 1] - 0xDC00);
+			Index++;
+		}
+
+		printf("%s%lX", Separator, Character);
+		Separator = " ";
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// PrintValue
+/////////////////////////////////////////////////////////////////////////////
+static void
+	PrintValue(
+	const char*				Label,
+	const RegistryValue*	Value)
+{
+	printf("%s\t", Label);
+	PrintString(Value->KeyPath, wcslen(Value->KeyPath));
+	printf("\t");
+	PrintString(Value->Name, wcslen(Value->Name));
+	printf("\t%X\t", Value->Type);
+
+	if ((REG_SZ == Value->Type) || (REG_EXPAND_SZ == Value->Type) ||
+		(REG_MULTI_SZ == Value->Type))
+	{
+		PrintString((const wchar_t*)Value->Data,
+			Value->DataSize / sizeof(wchar_t));
+	}
+	else
+	{
+		for (unsigned int Index = 0; Index < Value->DataSize; Index++)
+		{
+			printf("%02X", Value->Data[Index]);
+		}
+	}
+
+	printf("\n");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Widen
+//
+// The arguments are ASCII, so need no locale.
+/////////////////////////////////////////////////////////////////////////////
+static wchar_t*
+	Widen(
+	const char*	Text)
+{
+	size_t		Length	= strlen(Text);
+	wchar_t*	Wide	= new wchar_t[Length + 1];
+
+	for (size_t Index = 0; Index <= Length; Index++)
+	{
+		Wide[Index] = (wchar_t)(unsigned char)Text[Index];
+	}
+
+	return Wide;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int
+	main(
+	int		ArgumentCount,
+	char*	Arguments[])
+{
+	int					ReturnCode	= 1;
+	RegistrySnapshot	Snapshot;
+	wchar_t*			FilePath	= NULL;
+	wchar_t*			KeyPath		= NULL;
+
+	if (2 <= ArgumentCount)
+	{
+		FilePath = Widen(Arguments[1]);
+	}
+
+	if (3 <= ArgumentCount)
+	{
+		KeyPath = Widen(Arguments[2]);
+	}
+
+	if ((NULL != FilePath) && (true == Snapshot.LoadFile(FilePath, KeyPath)))
+	{
+		for (size_t Index = 0; Index < Snapshot.GetKeyCount(); Index++)
+		{
+			const wchar_t*	Path	= Snapshot.GetKeyPath(Index);
+
+			printf("key\t");
+			PrintString(Path, wcslen(Path));
+			printf("\n");
+		}
+
+		for (size_t Index = 0; Index < Snapshot.GetValueCount(); Index++)
+		{
+			const RegistryValue*	Value	= Snapshot.GetValue(Index);
+
+			PrintValue("value", Value);
+
+			if (Value != Snapshot.Find(Value->KeyPath, Value->Name))
+			{
+				PrintValue("lost", Value);
+			}
+		}
+
+		ReturnCode = 0;
+	}
+
+	delete[] FilePath;
+	delete[] KeyPath;
+
+	return ReturnCode;
+}
@@ -0,0 +1,259 @@
+#############################################################################
+# RegistrySnapshotTest.py
+#
+# Writes .reg files, as regedit does, and checks that RegistrySnapshot
+# reads back the keys and values they were written from:
+#
+#	python RegistrySnapshotTest.py
+#
+# Each file is written in UTF-16, in UTF-8 and as REGEDIT4, with quoted
+# strings that need escaping, dword: values, hex: and hex(n): values
+# continued over several lines, and the things a reader must skip: keys
+# and values being deleted, and lines it cannot read.  Each is read
+# whole, then under a key, which must match whole path components,
+# ignoring case.
+#
+# RegistrySnapshotTest.cpp is compiled with the compiler in CXX, c++ if
+# not set, as .reg files are read with nothing but the C library.
+#
+# Copyright (c) 2008 - 2015 by James John McGuire
+# All rights reserved.
+#############################################################################
+import os
+import shlex
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+TESTS = os.path.dirname(os.path.abspath(__file__))
+UTILS = os.path.join(TESTS, '..', 'Utils')
+
+REG_NONE = 0
+REG_SZ = 1
+REG_EXPAND_SZ = 2
+REG_BINARY = 3
+REG_DWORD = 4
+REG_MULTI_SZ = 7
+REG_QWORD = 11
+
+STRING_TYPES = (REG_SZ, REG_EXPAND_SZ, REG_MULTI_SZ)
+
+ROOT = 'HKEY_CURRENT_USER\\Software\\Zenware'
+TEST = ROOT + '\\Test'
+
+# bytes of hex: data per line, as regedit writes them
+HEX_LINE = 25
+
+# the keys and values written, in order, as (key path, [(name, type,
+# data)]); string data is text, terminators included, other data bytes
+KEYS = [
+	(TEST, [
+		('', REG_SZ, 'the default value\0'),
+		('Quoted', REG_SZ, 'say "hi" to C:\\Temp\\ \\"\0'),
+		('Name "with" = and \\', REG_SZ, '\0'),
+		('Number', REG_DWORD, struct.pack('<I', 0x0001F00D)),
+		('Binary', REG_BINARY, bytes(range(0, 256, 3))),
+		('Quad', REG_QWORD, struct.pack('<Q', 0x0123456789ABCDEF)),
+		('None', REG_NONE, b''),
+		('Expand', REG_EXPAND_SZ, '%SystemRoot%\\\u00e9\U0001F600\0'),
+		('Multi', REG_MULTI_SZ, 'one\0two \u00fc\0\0'),
+	]),
+	(TEST + '\\Empty', []),
+	(TEST + '\\Sub', [
+		('Latin-1 \u00e9', REG_SZ, 'caf\u00e9\0'),
+	]),
+	(TEST + '\\Sub\\Deeper', [
+		('Number', REG_DWORD, struct.pack('<I', 0xFFFFFFFF)),
+	]),
+	# shares the start of Test's path, but not a whole component
+	(TEST + 'Other', [
+		('Outside', REG_SZ, 'not under Test\0'),
+	]),
+	(ROOT, [
+		('Parent', REG_DWORD, struct.pack('<I', 7)),
+	]),
+]
+
+
+def escape(text):
+	return text.replace('\\', '\\\\').replace('"', '\\"')
+
+
+def format_hex(prefix, data):
+	# continued as regedit does, each line ending with a comma and backslash
+	lines = []
+	pairs = ['%02x' % byte for byte in data]
+
+	for start in range(0, len(pairs), HEX_LINE):
+		lines.append(','.join(pairs[start:start + HEX_LINE]))
+
+	return prefix + ',\\\r\n  '.join(lines)
+
+
+def format_value(name, value_type, data):
+	line = '@=' if ('' == name) else '"%s"=' % escape(name)
+
+	if (REG_SZ == value_type) and ('\0' not in data[:-1]):
+		line += '"%s"' % escape(data[:-1])
+	elif REG_DWORD == value_type:
+		line += 'dword:%08x' % struct.unpack('<I', data)
+	elif REG_BINARY == value_type:
+		line = format_hex(line + 'hex:', data)
+	else:
+		if value_type in STRING_TYPES:
+			data = data.encode('utf-16-le')
+
+		line = format_hex(line + 'hex(%x):' % value_type, data)
+
+	return line
+
+
+def is_written(value_type, regedit4):
+	# REGEDIT4 has hex(n): strings in the ANSI code page, not UTF-16
+	return not (regedit4 and (value_type in (REG_EXPAND_SZ, REG_MULTI_SZ)))
+
+
+def format_file(regedit4):
+	lines = ['REGEDIT4' if regedit4 else 'Windows Registry Editor Version 5.00', '']
+
+	# a key and its values deleted, the values then skipped with it
+	lines += ['[-%s\\Gone]' % TEST, '"Stale"="skipped"', '']
+
+	for key_path, values in KEYS:
+		lines.append('[%s]' % key_path)
+
+		for name, value_type, data in values:
+			if is_written(value_type, regedit4):
+				lines.append(format_value(name, value_type, data))
+
+		lines.append('')
+
+	# values set again, in another case, deleted, or unreadable; the last
+	# copy of a value is kept
+	lines += ['[%s]' % TEST, '"NUMBER"=dword:0001f00d', '"Removed"=-',
+		'"Unreadable"=dword:xyz', '  "Indented" = "padded"  ', '']
+
+	return '\r\n'.join(lines)
+
+
+def get_expected(prefix, regedit4):
+	values = {}
+	keys = {}
+
+	for key_path, key_values in KEYS:
+		keys[key_path.lower()] = key_path
+
+		for name, value_type, data in key_values:
+			if is_written(value_type, regedit4):
+				values[(key_path.lower(), name.lower())] = (key_path, name, value_type, data)
+
+	values[(TEST.lower(), 'number')] = (TEST, 'NUMBER', REG_DWORD,
+		struct.pack('<I', 0x0001F00D))
+	values[(TEST.lower(), 'indented')] = (TEST, 'Indented', REG_SZ, 'padded\0')
+
+	def relative(path):
+		if prefix is None:
+			return path
+		elif path.lower() == prefix.lower():
+			return ''
+		elif path.lower().startswith(prefix.lower() + '\\'):
+			return path[len(prefix) + 1:]
+
+		return None
+
+	key_lines = [(relative(path), 'key\t' + encode(relative(path)))
+		for path in keys.values() if relative(path) is not None]
+	value_lines = []
+
+	for key_path, name, value_type, data in values.values():
+		if relative(key_path) is not None:
+			if value_type in STRING_TYPES:
+				text = encode(data)
+			else:
+				text = ''.join('%02X' % byte for byte in data)
+
+			value_lines.append(((relative(key_path), name), '\t'.join(['value',
+				encode(relative(key_path)), encode(name), '%X' % value_type, text])))
+
+	return [line for _, line in sorted(key_lines, key=lambda item: fold(item[0]))] + \
+		[line for _, line in sorted(value_lines,
+			key=lambda item: (fold(item[0][0]), fold(item[0][1])))]
+
+
+def fold(text):
+	# as the C locale folds case
+	return ''.join(character.lower() if 'A' <= character <= 'Z' else character
+		for character in text)
+
+
+def encode(text):
+	return ' '.join('%X' % ord(character) for character in text)
+
+
+def run(program, path, prefix):
+	arguments = [program, path] + ([] if prefix is None else [prefix])
+	result = subprocess.run(arguments, stdout=subprocess.PIPE, universal_newlines=True)
+
+	return result.returncode, result.stdout.splitlines()
+
+
+def check(name, program, path, prefix, expected):
+	code, lines = run(program, path, prefix)
+	passed = (0 == code) and (expected == lines)
+
+	print('%s: %s' % ('ok' if passed else 'FAILED', name))
+
+	if not passed:
+		for line in [line for line in lines if line not in expected][:5]:
+			print('\tunexpected %s' % line)
+
+		for line in [line for line in expected if line not in lines][:5]:
+			print('\tmissing %s' % line)
+
+	return passed
+
+
+def main():
+	work = tempfile.mkdtemp()
+	passed = True
+
+	try:
+		program = os.path.join(work, 'RegistrySnapshotTest')
+
+		subprocess.check_call(shlex.split(os.environ.get('CXX', 'c++')) + ['-o', program,
+			os.path.join(TESTS, 'RegistrySnapshotTest.cpp'),
+			os.path.join(UTILS, 'RegistrySnapshot.cpp')])
+
+		text = format_file(False)
+		path = os.path.join(work, 'Test.reg')
+		files = [('UTF-16', b'\xff\xfe' + text.encode('utf-16-le'), False),
+			('UTF-8', b'\xef\xbb\xbf' + text.encode('utf-8'), False),
+			('UTF-8 without a mark', text.encode('utf-8'), False),
+			# the ANSI code page is taken as Latin-1 off Windows
+			('REGEDIT4', format_file(True).encode('latin-1'), True)]
+
+		for name, contents, regedit4 in files:
+			with open(path, 'wb') as output:
+				output.write(contents)
+
+			passed &= check('%s, every key' % name, program, path, None,
+				get_expected(None, regedit4))
+			passed &= check('%s, under a key' % name, program, path, TEST,
+				get_expected(TEST, regedit4))
+			passed &= check('%s, under a key in another case' % name, program, path,
+				TEST.upper(), get_expected(TEST.upper(), regedit4))
+
+		code, lines = run(program, os.path.join(work, 'Missing.reg'), None)
+		passed &= (1 == code) and not lines
+
+		print('%s: missing file' % ('ok' if (1 == code) and not lines else 'FAILED'))
+	finally:
+		shutil.rmtree(work)
+
+	return 0 if passed else 1
+
+
+if __name__ == '__main__':
+	sys.exit(main())
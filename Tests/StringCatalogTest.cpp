@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////////////////////
+// StringCatalogTest.cpp
+//
+// Dumps one language of a string catalog, as StringCatalog decodes it,
+// for StringCatalogTest.py to compare with the strings it was built from.
+//
+// Usage: StringCatalogTest Catalog LanguageId
+//
+// Prints the language found, then a line per string: the id, a tab, and
+// the string's characters as hex code points, surrogate pairs joined.
+// Exits with 1 if the catalog cannot be loaded.
+//
+// Copyright (c) 2010 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include "../Utils/StringCatalog.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// PrintString
+/////////////////////////////////////////////////////////////////////////////
+static void
+	PrintString(
+	const wchar_t*	Text,
+	size_t			Length)
+{
+	for (size_t Index = 0; Index < Length; Index++)
+	{
+		unsigned long	Character	= (unsigned long)Text[Index];
+
+		if ((0xD800 <= Character) && (Character < 0xDC00) &&
+			(Index + 1 < Length) && (0xDC00 <= (unsigned long)Text[Index + 1]) &&
+			((unsigned long)Text[Index + 1] <= 0xDFFF))
+		{
+			Character = 0x10000 + ((Character - 0xD800) << 10) +
+				((unsigned long)Text[Index + 1] - 0xDC00);
+			Index++;
+		}
+
+		printf(" %lX", Character);
+	}
+
+	printf("\n");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int
+	main(
+	int		ArgumentCount,
+	char*	Arguments[])
+{
+	int				ReturnCode	= 1;
+	StringCatalog	Catalog;
+
+	if ((3 == ArgumentCount) && (true == Catalog.Load(Arguments[1],
+		(unsigned int)strtoul(Arguments[2], NULL, 0))))
+	{
+		unsigned int*	Offsets	= new unsigned int[Catalog.GetIdCount() + 1];
+		wchar_t*		Text	= new wchar_t[Catalog.GetTextLength() + 1];
+
+		Catalog.Decode(Offsets, Text);
+
+		printf("language 0x%04X\n", Catalog.GetLanguageId());
+
+		for (unsigned int Index = 0; Index < Catalog.GetIdCount(); Index++)
+		{
+			if (Offsets[Index + 1] > Offsets[Index])
+			{
+				printf("%u\t", Catalog.GetFirstId() + Index);
+
+				// without the terminator
+				PrintString(Text + Offsets[Index],
+					Offsets[Index + 1] - Offsets[Index] - 1);
+			}
+		}
+
+		delete[] Offsets;
+		delete[] Text;
+
+		ReturnCode = 0;
+	}
+
+	return ReturnCode;
+}
@@ -0,0 +1,127 @@
+#############################################################################
+# StringCatalogTest.py
+#
+# Builds string catalogs with MakeStringCatalog.py, in both character
+# sizes, and checks that StringCatalog reads back every string, that
+# languages fall back to their primary language, and that damaged
+# catalogs are rejected:
+#
+#	python StringCatalogTest.py
+#
+# StringCatalogTest.cpp is compiled with the compiler in CXX, c++ if not
+# set, as StringCatalog needs only the C library.
+#
+# Copyright (c) 2010 - 2015 by James John McGuire
+# All rights reserved.
+#############################################################################
+import os
+import shlex
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+TESTS = os.path.dirname(os.path.abspath(__file__))
+UTILS = os.path.join(TESTS, '..', 'Utils')
+
+# language, id, source text and the string it unescapes to
+STRINGS = [
+	(0x0409, 101, 'File not found.', 'File not found.'),
+	(0x0409, 102, 'Tab\\there', 'Tab\there'),
+	(0x0409, 105, 'Two\\nlines \\\\ done', 'Two\nlines \\ done'),
+	(0x0411, 101, 'ファイル', 'ファイル'),
+	(0x0411, 102, 'Smile \U0001F600 and \U00020BB7', 'Smile \U0001F600 and \U00020BB7'),
+	(0x0407, 200, 'Datei über', 'Datei über'),
+]
+
+
+def expected(language_id):
+	lines = ['language 0x%04X' % language_id]
+
+	for string_language, string_id, source, text in STRINGS:
+		if string_language == language_id:
+			lines.append('%d\t%s' % (string_id, ''.join(' %X' % ord(c) for c in text)))
+
+	return lines
+
+
+def run(program, catalog, language_id):
+	result = subprocess.run([program, catalog, '0x%04X' % language_id],
+		stdout=subprocess.PIPE, universal_newlines=True)
+
+	return result.returncode, result.stdout.splitlines()
+
+
+def check(name, condition):
+	print('%s: %s' % ('ok' if condition else 'FAILED', name))
+
+	return condition
+
+
+def main():
+	work = tempfile.mkdtemp()
+	passed = True
+
+	try:
+		program = os.path.join(work, 'StringCatalogTest')
+		source = os.path.join(work, 'Strings.txt')
+
+		subprocess.check_call(shlex.split(os.environ.get('CXX', 'c++')) + ['-o', program,
+			os.path.join(TESTS, 'StringCatalogTest.cpp'), os.path.join(UTILS, 'StringCatalog.cpp')])
+
+		with open(source, 'w', encoding='utf-8') as strings:
+			strings.write('# test strings\n')
+
+			for language_id, string_id, text, unescaped in STRINGS:
+				strings.write('0x%04X\t%d\t%s\n' % (language_id, string_id, text))
+
+		for char_size in (2, 4):
+			catalog = os.path.join(work, 'Strings%d.cat' % char_size)
+
+			subprocess.check_call([sys.executable, os.path.join(UTILS, 'MakeStringCatalog.py'),
+				source, catalog, str(char_size)])
+
+			for language_id in (0x0409, 0x0411, 0x0407):
+				code, lines = run(program, catalog, language_id)
+				passed &= check('char size %d, language 0x%04X' % (char_size, language_id),
+					(0 == code) and (expected(language_id) == lines))
+
+			# Swiss German has no strings of its own
+			code, lines = run(program, catalog, 0x0807)
+			passed &= check('char size %d, primary language' % char_size,
+				(0 == code) and (expected(0x0407) == lines))
+
+			code, lines = run(program, catalog, 0x040C)
+			passed &= check('char size %d, missing language' % char_size, 0 != code)
+
+			with open(catalog, 'rb') as original:
+				contents = original.read()
+
+			damaged = os.path.join(work, 'Damaged.cat')
+
+			with open(damaged, 'wb') as output:
+				output.write(contents[:-3])
+
+			code, lines = run(program, damaged, 0x0411)
+			passed &= check('char size %d, truncated' % char_size, 0 != code)
+
+			if 4 == char_size:
+				# the first language, 0x0407, has one string; make its first
+				# character one past the last code point
+				text_offset = struct.unpack_from('<I', contents, 16 + 16)[0]
+
+				with open(damaged, 'wb') as output:
+					output.write(contents[:text_offset] + struct.pack('<I', 0x110000) +
+						contents[text_offset + 4:])
+
+				code, lines = run(program, damaged, 0x0407)
+				passed &= check('char size 4, not Unicode', 0 != code)
+	finally:
+		shutil.rmtree(work)
+
+	return 0 if passed else 1
+
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -0,0 +1,554 @@
+/////////////////////////////////////////////////////////////////////////////
+// EncodingDetector.cpp - Class Implementation
+//
+// Determines the most likely code page of a multibyte buffer in one pass.
+//
+// A single scan feeds every byte to a UTF-8, a Shift-JIS and an EUC-JP
+// state machine at once, while counting byte order marks and ISO 2022
+// escape sequences.  Blocks of plain 7-bit text are skipped 16 bytes at a
+// time with SSE2.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "EncodingDetector.h"
+#include "Utils.h"
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+#define ESCAPE_CHARACTER	0x1B
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+EncodingDetector::EncodingDetector(void)
+{
+	Reset();
+}
+
+EncodingDetector::~EncodingDetector(void)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Detect
+//
+// Returns:		ULONG		code page to use for converting the buffer
+// Parameters:
+//	const BYTE*	Buffer				(IN)	Multibyte input
+//	size_t		BufferLength		(IN)	Input length (bytes)
+//	ULONG		PreferredCodePage	(IN)	Code page the caller expects
+//											-1 = Get local code page.
+//	bool		Utf16Bom			(IN)	Whether FF FE and FE FF mark
+//											UTF-16; false when the buffer
+//											can only be multibyte, as a
+//											NUL terminated one.
+//
+// Purpose:		The preferred code page is kept unless the input rules it
+//				out, or carries a byte order mark or ISO 2022 escapes.
+/////////////////////////////////////////////////////////////////////////////
+ULONG
+	EncodingDetector::Detect(
+	const BYTE*	Buffer,
+	size_t		BufferLength,
+	ULONG		PreferredCodePage,
+	bool		Utf16Bom)
+{
+	Reset();
+
+	// If no code page specified, take default for system
+	if ((ULONG)-1 == PreferredCodePage)
+	{
+		PreferredCodePage = GetACP();
+	}
+
+	if ((NULL == Buffer) || (0 == BufferLength))
+	{
+		return PreferredCodePage;
+	}
+
+	CheckBom(Buffer, BufferLength, Utf16Bom);
+
+	if (0 != m_BomCodePage)
+	{
+		return m_BomCodePage;
+	}
+
+	size_t	Index	= 0;
+
+#ifdef USE_SSE2
+	const __m128i	Escape	= _mm_set1_epi8(ESCAPE_CHARACTER);
+#endif
+
+	while (Index < BufferLength)
+	{
+#ifdef USE_SSE2
+		if ((BufferLength - Index >= 16) && (true == IsIdle()))
+		{
+			__m128i	Block		= _mm_loadu_si128(
+				(const __m128i*)(Buffer + Index));
+			int		HighMask	= _mm_movemask_epi8(Block);
+			int		EscapeMask	=
+				_mm_movemask_epi8(_mm_cmpeq_epi8(Block, Escape));
+
+			if (0 == (HighMask | EscapeMask))
+			{
+				Index += 16;
+				continue;
+			}
+
+			size_t	BlockEnd	= Index + 16;
+
+			for (; Index < BlockEnd; Index++)
+			{
+				ScanByte(Buffer + Index, BufferLength - Index);
+			}
+
+			continue;
+		}
+#endif
+		ScanByte(Buffer + Index, BufferLength - Index);
+		Index++;
+	}
+
+	// a sequence cut off by the end of the buffer is not valid
+	if (0 != m_Utf8Pending)
+	{
+		m_Utf8Errors++;
+	}
+	if (true == m_ShiftJisPending)
+	{
+		m_ShiftJisErrors++;
+	}
+	if (0 != m_EucPending)
+	{
+		m_EucErrors++;
+	}
+
+	if (0 == m_HighBytes)
+	{
+		if (0 < m_EscapeSequences)
+		{
+			if (true == m_HalfWidthKatakanaEscape)
+			{
+				return CodePage50221;
+			}
+
+			return CodePageJis;
+		}
+
+		// 7-bit text is the same in every ASCII based code page
+		return PreferredCodePage;
+	}
+
+	if (false == IsModeled(PreferredCodePage))
+	{
+		// valid multi-byte UTF-8 is very unlikely to be anything else
+		if ((0 == m_Utf8Errors) && (0 < m_Utf8Sequences))
+		{
+			return CodePageUtf8;
+		}
+
+		return PreferredCodePage;
+	}
+
+	if (0 == GetErrors(PreferredCodePage))
+	{
+		return PreferredCodePage;
+	}
+
+	ULONG	EucCodePage	= CodePageEucUndocumented;
+
+	if (CodePageEucOfficial == PreferredCodePage)
+	{
+		EucCodePage = CodePageEucOfficial;
+	}
+
+	ULONG	Candidates[]	= {CodePageUtf8, CodePageShiftJis, EucCodePage};
+	LONGLONG Scores[]		=
+	{
+		(LONGLONG)m_Utf8Sequences * 3,
+		(LONGLONG)m_ShiftJisPairs * 2 - (LONGLONG)m_ShiftJisKatakana,
+		(LONGLONG)m_EucPairs * 2
+	};
+
+	ULONG		BestCodePage	= PreferredCodePage;
+	size_t		BestErrors		= GetErrors(PreferredCodePage);
+	LONGLONG	BestScore		= LLONG_MIN;
+
+	for (int Candidate = 0; Candidate < _countof(Candidates); Candidate++)
+	{
+		size_t	Errors	= GetErrors(Candidates[Candidate]);
+
+		if ((Errors < BestErrors) ||
+			((Errors == BestErrors) && (Scores[Candidate] > BestScore)))
+		{
+			BestCodePage	= Candidates[Candidate];
+			BestErrors		= Errors;
+			BestScore		= Scores[Candidate];
+		}
+	}
+
+	return BestCodePage;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetBomLength
+//
+// Number of leading bytes that are a byte order mark, and should be
+// skipped before conversion.
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	EncodingDetector::GetBomLength(void) const
+{
+	return m_BomLength;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsAscii
+/////////////////////////////////////////////////////////////////////////////
+bool
+	EncodingDetector::IsAscii(void) const
+{
+	bool	Ascii	= false;
+
+	if ((0 == m_BomLength) && (0 == m_HighBytes) && (0 == m_EscapeSequences))
+	{
+		Ascii = true;
+	}
+
+	return Ascii;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// CheckBom
+/////////////////////////////////////////////////////////////////////////////
+void
+	EncodingDetector::CheckBom(
+	const BYTE*	Buffer,
+	size_t		BufferLength,
+	bool		Utf16Bom)
+{
+	if ((3 <= BufferLength) && (true == IsUtf8BomMark(Buffer, BufferLength)))
+	{
+		m_BomLength		= 3;
+		m_BomCodePage	= CodePageUtf8;
+	}
+	else if ((true == Utf16Bom) && (2 <= BufferLength) &&
+		(0xFF == Buffer[0]) && (0xFE == Buffer[1]))
+	{
+		m_BomLength		= 2;
+		m_BomCodePage	= CodePageUtf16Le;
+	}
+	else if ((true == Utf16Bom) && (2 <= BufferLength) &&
+		(0xFE == Buffer[0]) && (0xFF == Buffer[1]))
+	{
+		m_BomLength		= 2;
+		m_BomCodePage	= CodePageUtf16Be;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// CheckEscape
+//
+// Returns the length of the ISO 2022 JP escape sequence at Buffer, or 0.
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	EncodingDetector::CheckEscape(
+	const BYTE*	Buffer,
+	size_t		Remaining)
+{
+	size_t	SequenceLength	= 0;
+
+	if (3 <= Remaining)
+	{
+		BYTE	First	= Buffer[1];
+		BYTE	Second	= Buffer[2];
+
+		if (('$' == First) && (('@' == Second) || ('B' == Second)))
+		{
+			// JIS X 0208-1978 / JIS X 0208-1983
+			SequenceLength = 3;
+		}
+		else if (('(' == First) && (('B' == Second) || ('J' == Second)))
+		{
+			// ASCII / JIS X 0201 Roman
+			SequenceLength = 3;
+		}
+		else if (('(' == First) && ('I' == Second))
+		{
+			// JIS X 0201 Katakana
+			m_HalfWidthKatakanaEscape	= true;
+			SequenceLength				= 3;
+		}
+		else if ((4 <= Remaining) && ('$' == First) && ('(' == Second) &&
+			('D' == Buffer[3]))
+		{
+			// JIS X 0212-1990
+			SequenceLength = 4;
+		}
+	}
+
+	return SequenceLength;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsIdle
+//
+// True when no state machine is part way through a multibyte sequence,
+// so a block of 7-bit bytes can be skipped without scoring it.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	EncodingDetector::IsIdle(void) const
+{
+	bool	Idle	= false;
+
+	if ((0 == m_Utf8Pending) && (false == m_ShiftJisPending) &&
+		(0 == m_EucPending))
+	{
+		Idle = true;
+	}
+
+	return Idle;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsModeled
+/////////////////////////////////////////////////////////////////////////////
+bool
+	EncodingDetector::IsModeled(
+	ULONG CodePage) const
+{
+	bool	Modeled	= false;
+
+	switch (CodePage)
+	{
+		case CodePageUtf8:
+		case CodePageShiftJis:
+		case CodePageEucOfficial:
+		case CodePageEucUndocumented:
+		{
+			Modeled = true;
+			break;
+		}
+		default:
+		{
+			Modeled = false;
+			break;
+		}
+	}
+
+	return Modeled;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetErrors
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	EncodingDetector::GetErrors(
+	ULONG CodePage) const
+{
+	size_t	Errors	= 0;
+
+	switch (CodePage)
+	{
+		case CodePageUtf8:
+		{
+			Errors = m_Utf8Errors;
+			break;
+		}
+		case CodePageShiftJis:
+		{
+			Errors = m_ShiftJisErrors;
+			break;
+		}
+		case CodePageEucOfficial:
+		case CodePageEucUndocumented:
+		{
+			Errors = m_EucErrors;
+			break;
+		}
+		default:
+		{
+			Errors = 0;
+			break;
+		}
+	}
+
+	return Errors;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Reset
+/////////////////////////////////////////////////////////////////////////////
+void
+	EncodingDetector::Reset(void)
+{
+	m_BomLength					= 0;
+	m_BomCodePage				= 0;
+	m_HighBytes					= 0;
+	m_EscapeSequences			= 0;
+	m_HalfWidthKatakanaEscape	= false;
+
+	m_Utf8Errors				= 0;
+	m_Utf8Sequences				= 0;
+	m_Utf8Pending				= 0;
+
+	m_ShiftJisErrors			= 0;
+	m_ShiftJisPairs				= 0;
+	m_ShiftJisKatakana			= 0;
+	m_ShiftJisPending			= false;
+
+	m_EucErrors					= 0;
+	m_EucPairs					= 0;
+	m_EucPending				= 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ScanByte
+/////////////////////////////////////////////////////////////////////////////
+void
+	EncodingDetector::ScanByte(
+	const BYTE*	Position,
+	size_t		Remaining)
+{
+	BYTE	Byte	= *Position;
+
+	if (0x80 <= Byte)
+	{
+		m_HighBytes++;
+	}
+	else if (ESCAPE_CHARACTER == Byte)
+	{
+		if (0 < CheckEscape(Position, Remaining))
+		{
+			m_EscapeSequences++;
+		}
+	}
+
+	ScoreByte(Byte);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ScoreByte
+//
+// Advances the UTF-8, Shift-JIS and EUC-JP state machines by one byte.
+/////////////////////////////////////////////////////////////////////////////
+void
+	EncodingDetector::ScoreByte(
+	BYTE	Byte)
+{
+	// UTF-8
+	bool	Continued	= false;
+
+	if (0 < m_Utf8Pending)
+	{
+		if (0x80 == (Byte & 0xC0))
+		{
+			Continued = true;
+			m_Utf8Pending--;
+
+			if (0 == m_Utf8Pending)
+			{
+				m_Utf8Sequences++;
+			}
+		}
+		else
+		{
+			// sequence cut short, treat this byte as a new lead byte
+			m_Utf8Errors++;
+			m_Utf8Pending = 0;
+		}
+	}
+
+	if ((false == Continued) && (0x80 <= Byte))
+	{
+		if ((0xC2 <= Byte) && (Byte <= 0xDF))
+		{
+			m_Utf8Pending = 1;
+		}
+		else if ((0xE0 <= Byte) && (Byte <= 0xEF))
+		{
+			m_Utf8Pending = 2;
+		}
+		else if ((0xF0 <= Byte) && (Byte <= 0xF4))
+		{
+			m_Utf8Pending = 3;
+		}
+		else
+		{
+			m_Utf8Errors++;
+		}
+	}
+
+	// Shift-JIS
+	if (true == m_ShiftJisPending)
+	{
+		if (((0x40 <= Byte) && (Byte <= 0x7E)) ||
+			((0x80 <= Byte) && (Byte <= 0xFC)))
+		{
+			m_ShiftJisPairs++;
+		}
+		else
+		{
+			m_ShiftJisErrors++;
+		}
+
+		m_ShiftJisPending = false;
+	}
+	else if (((0x81 <= Byte) && (Byte <= 0x9F)) ||
+		((0xE0 <= Byte) && (Byte <= 0xFC)))
+	{
+		m_ShiftJisPending = true;
+	}
+	else if ((0xA1 <= Byte) && (Byte <= 0xDF))
+	{
+		// half-width katakana
+		m_ShiftJisKatakana++;
+	}
+	else if (0x80 <= Byte)
+	{
+		m_ShiftJisErrors++;
+	}
+
+	// EUC-JP
+	if (0 < m_EucPending)
+	{
+		if ((0xA1 <= Byte) && (Byte <= 0xFE))
+		{
+			m_EucPending--;
+
+			if (0 == m_EucPending)
+			{
+				m_EucPairs++;
+			}
+		}
+		else
+		{
+			m_EucErrors++;
+			m_EucPending = 0;
+		}
+	}
+	else if (((0xA1 <= Byte) && (Byte <= 0xFE)) || (0x8E == Byte))
+	{
+		// JIS X 0208, or SS2 half-width katakana
+		m_EucPending = 1;
+	}
+	else if (0x8F == Byte)
+	{
+		// SS3 JIS X 0212
+		m_EucPending = 2;
+	}
+	else if (0x80 <= Byte)
+	{
+		m_EucErrors++;
+	}
+}
@@ -0,0 +1,81 @@
+/////////////////////////////////////////////////////////////////////////////
+// EncodingDetector.h - Class Declaration
+//
+// Determines the most likely code page of a multibyte buffer in one pass.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// EncodingDetector Class Definition
+//
+// Usage:
+//	EncodingDetector Detector;
+//	ULONG CodePage = Detector.Detect(Buffer, Length, CodePageShiftJis);
+//	// skip Detector.GetBomLength() bytes before converting
+/////////////////////////////////////////////////////////////////////////////
+class DllExport EncodingDetector
+{
+	public:
+		// Properties
+
+		// Methods
+			EncodingDetector(void);
+			~EncodingDetector(void);
+
+			ULONG Detect(
+				const BYTE*	Buffer,
+				size_t		BufferLength,
+				ULONG		PreferredCodePage,
+				bool		Utf16Bom = true);
+			size_t GetBomLength(void) const;
+			bool IsAscii(void) const;
+
+	private:
+		// Properties
+			size_t	m_BomLength;
+			ULONG	m_BomCodePage;
+			size_t	m_HighBytes;
+			size_t	m_EscapeSequences;
+			bool	m_HalfWidthKatakanaEscape;
+
+			size_t	m_Utf8Errors;
+			size_t	m_Utf8Sequences;
+			int		m_Utf8Pending;
+
+			size_t	m_ShiftJisErrors;
+			size_t	m_ShiftJisPairs;
+			size_t	m_ShiftJisKatakana;
+			bool	m_ShiftJisPending;
+
+			size_t	m_EucErrors;
+			size_t	m_EucPairs;
+			int		m_EucPending;
+
+		// Methods
+			void CheckBom(
+				const BYTE*	Buffer,
+				size_t		BufferLength,
+				bool		Utf16Bom);
+			size_t CheckEscape(
+				const BYTE*	Buffer,
+				size_t		Remaining);
+			bool IsIdle(void) const;
+			bool IsModeled(
+				ULONG CodePage) const;
+			size_t GetErrors(
+				ULONG CodePage) const;
+			void Reset(void);
+			void ScanByte(
+				const BYTE*	Position,
+				size_t		Remaining);
+			void ScoreByte(
+				BYTE	Byte);
+};
@@ -0,0 +1,114 @@
+/////////////////////////////////////////////////////////////////////////////
+// ErrorCatalog.cpp
+//
+// Built in messages for common system error codes.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "ErrorCatalog.h"
+#include "ErrorMessageCache.h"
+
+#ifndef NO_ERROR_CATALOG
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+struct ErrorCatalogEntry
+{
+	DWORD	ErrorCode;
+	LPCTSTR	Message;
+	size_t	Length;
+};
+
+#include "ErrorCatalogData.h"
+
+// -1 until the user's language has been checked
+static volatile LONG g_CatalogLanguageMatches = -1;
+
+/////////////////////////////////////////////////////////////////////////////
+// HashErrorCode
+//
+// Must match hash_code in MakeErrorCatalog.py.
+/////////////////////////////////////////////////////////////////////////////
+static ULONG
+	HashErrorCode(
+	ULONG	ErrorCode,
+	ULONG	Seed)
+{
+	ULONG	Hash	= (ErrorCode ^ Seed) * 0x9E3779B1UL;
+
+	return Hash ^ (Hash >> 16);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsCatalogLanguage
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	IsCatalogLanguage(
+	WORD	LanguageId)
+{
+	bool	Matches	= true;
+
+	if (ERROR_MESSAGE_LANGUAGE_DEFAULT == LanguageId)
+	{
+		// the system formats these in the user's language
+		if (-1 == g_CatalogLanguageMatches)
+		{
+			LONG	English	= 0;
+
+			if (LANG_ENGLISH == PRIMARYLANGID(GetUserDefaultUILanguage()))
+			{
+				English = 1;
+			}
+
+			InterlockedExchange(&g_CatalogLanguageMatches, English);
+		}
+
+		Matches = (1 == g_CatalogLanguageMatches);
+	}
+	else
+	{
+		Matches = (LANG_ENGLISH == PRIMARYLANGID(LanguageId));
+	}
+
+	return Matches;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// LookupErrorCatalog
+/////////////////////////////////////////////////////////////////////////////
+bool
+	LookupErrorCatalog(
+	DWORD		ErrorCode,
+	WORD		LanguageId,
+	LPCTSTR*	Message,
+	size_t*		Length)
+{
+	bool	Found	= false;
+
+#ifndef NO_ERROR_CATALOG
+	if (true == IsCatalogLanguage(LanguageId))
+	{
+		ULONG	Bucket	= HashErrorCode(ErrorCode, 0) % ERROR_CATALOG_BUCKETS;
+		ULONG	Slot	= HashErrorCode(ErrorCode, g_ErrorCatalogSeeds[Bucket]) %
+			ERROR_CATALOG_SLOTS;
+
+		const ErrorCatalogEntry&	Entry	= g_ErrorCatalog[Slot];
+
+		if ((NULL != Entry.Message) && (ErrorCode == Entry.ErrorCode))
+		{
+			*Message	= Entry.Message;
+			*Length		= Entry.Length;
+			Found		= true;
+		}
+	}
+#endif
+
+	return Found;
+}
@@ -0,0 +1,31 @@
+/////////////////////////////////////////////////////////////////////////////
+// ErrorCatalog.h
+//
+// Built in messages for common system error codes.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// LookupErrorCatalog
+//
+// Finds the system message for ErrorCode in a read only table compiled
+// into the library, without calling the OS or allocating, for common
+// Win32 and HRESULT codes.  The messages are in English, so other
+// languages return false, as does every code when built with
+// NO_ERROR_CATALOG; callers then fall back to GetErrorMessage.  Regenerate the table with MakeErrorCatalog.py after
+// editing ErrorCatalog.txt.
+/////////////////////////////////////////////////////////////////////////////
+DllExport bool
+LookupErrorCatalog(
+	DWORD		ErrorCode,
+	WORD		LanguageId,
+	LPCTSTR*	Message,
+	size_t*		Length);
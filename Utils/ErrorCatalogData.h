@@ -0,0 +1,279 @@
+/////////////////////////////////////////////////////////////////////////////
+// ErrorCatalogData.h
+//
+// Generated by MakeErrorCatalog.py from ErrorCatalog.txt.  Do not edit.
+//
+// Included by ErrorCatalog.cpp only.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#define ERROR_CATALOG_SLOTS	256
+#define ERROR_CATALOG_BUCKETS	64
+
+static const USHORT g_ErrorCatalogSeeds[64] =
+{
+	1, 1, 1, 1, 1, 3, 2, 2, 0, 1, 1, 1, 2, 1, 1, 1,
+	0, 1, 5, 1, 1, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0, 1,
+	3, 1, 0, 0, 0, 1, 1, 1, 0, 0, 2, 0, 1, 0, 1, 0,
+	0, 1, 0, 1, 4, 1, 1, 1, 0, 1, 1, 0, 1, 1, 0, 1,
+};
+
+static const ErrorCatalogEntry g_ErrorCatalog[256] =
+{
+	{ 0x00000002, _T("The system cannot find the file specified.\r\n"), 44 },	// ERROR_FILE_NOT_FOUND
+	{ 0x80004002, _T("No such interface supported\r\n"), 29 },	// E_NOINTERFACE
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x000003F0, _T("An attempt was made to reference a token that does not exist.\r\n"), 63 },	// ERROR_NO_TOKEN
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000003, _T("The system cannot find the path specified.\r\n"), 44 },	// ERROR_PATH_NOT_FOUND
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x80070057, _T("The parameter is incorrect.\r\n"), 29 },	// E_INVALIDARG
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x80004005, _T("Unspecified error\r\n"), 19 },	// E_FAIL
+	{ 0x00000490, _T("Element not found.\r\n"), 20 },	// ERROR_NOT_FOUND
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x000003F1, _T("The configuration registry database is corrupt.\r\n"), 49 },	// ERROR_BADDB
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000006, _T("The handle is invalid.\r\n"), 24 },	// ERROR_INVALID_HANDLE
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x0000000E, _T("Not enough storage is available to complete this operation.\r\n"), 61 },	// ERROR_OUTOFMEMORY
+	{ 0x00000459, _T("No mapping for the Unicode character exists in the target multi-byte code page.\r\n"), 81 },	// ERROR_NO_UNICODE_TRANSLATION
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x000003E3, _T("The I/O operation has been aborted because of either a thread exit or an application request.\r\n"), 95 },	// ERROR_OPERATION_ABORTED
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x80070003, _T("The system cannot find the path specified.\r\n"), 44 },	// HRESULT_PATH_NOT_FOUND
+	{ 0x000004C7, _T("The operation was canceled by the user.\r\n"), 41 },	// ERROR_CANCELLED
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x0000000C, _T("The access code is invalid.\r\n"), 29 },	// ERROR_INVALID_ACCESS
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000578, _T("Invalid window handle.\r\n"), 24 },	// ERROR_INVALID_WINDOW_HANDLE
+	{ 0, NULL, 0 },
+	{ 0x00000102, _T("The wait operation timed out.\r\n"), 31 },	// WAIT_TIMEOUT
+	{ 0, NULL, 0 },
+	{ 0x0000007B, _T("The filename, directory name, or volume label syntax is incorrect.\r\n"), 68 },	// ERROR_INVALID_NAME
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000012, _T("There are no more files.\r\n"), 26 },	// ERROR_NO_MORE_FILES
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x8007000E, _T("Not enough storage is available to complete this operation.\r\n"), 61 },	// E_OUTOFMEMORY
+	{ 0, NULL, 0 },
+	{ 0x0000007E, _T("The specified module could not be found.\r\n"), 42 },	// ERROR_MOD_NOT_FOUND
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x0000010B, _T("The directory name is invalid.\r\n"), 32 },	// ERROR_DIRECTORY
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x0000007F, _T("The specified procedure could not be found.\r\n"), 45 },	// ERROR_PROC_NOT_FOUND
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000032, _T("The request is not supported.\r\n"), 31 },	// ERROR_NOT_SUPPORTED
+	{ 0x000001E7, _T("Attempt to access invalid address.\r\n"), 36 },	// ERROR_INVALID_ADDRESS
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x000003FA, _T("Illegal operation attempted on a registry key that has been marked for deletion.\r\n"), 82 },	// ERROR_KEY_DELETED
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000070, _T("There is not enough space on the disk.\r\n"), 40 },	// ERROR_DISK_FULL
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000004, _T("The system cannot open the file.\r\n"), 34 },	// ERROR_TOO_MANY_OPEN_FILES
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000005, _T("Access is denied.\r\n"), 19 },	// ERROR_ACCESS_DENIED
+	{ 0, NULL, 0 },
+	{ 0x80040154, _T("Class not registered\r\n"), 22 },	// REGDB_E_CLASSNOTREG
+	{ 0, NULL, 0 },
+	{ 0x80070002, _T("The system cannot find the file specified.\r\n"), 44 },	// HRESULT_FILE_NOT_FOUND
+	{ 0, NULL, 0 },
+	{ 0x80070005, _T("Access is denied.\r\n"), 19 },	// E_ACCESSDENIED
+	{ 0x000003E5, _T("Overlapped I/O operation is in progress.\r\n"), 42 },	// ERROR_IO_PENDING
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x000000B7, _T("Cannot create a file when that file already exists.\r\n"), 53 },	// ERROR_ALREADY_EXISTS
+	{ 0x00000050, _T("The file exists.\r\n"), 18 },	// ERROR_FILE_EXISTS
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000091, _T("The directory is not empty.\r\n"), 29 },	// ERROR_DIR_NOT_EMPTY
+	{ 0x00000027, _T("The disk is full.\r\n"), 19 },	// ERROR_HANDLE_DISK_FULL
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000715, _T("The specified resource type cannot be found in the image file.\r\n"), 64 },	// ERROR_RESOURCE_TYPE_NOT_FOUND
+	{ 0x00000424, _T("The specified service does not exist as an installed service.\r\n"), 63 },	// ERROR_SERVICE_DOES_NOT_EXIST
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000015, _T("The device is not ready.\r\n"), 26 },	// ERROR_NOT_READY
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000026, _T("Reached the end of the file.\r\n"), 30 },	// ERROR_HANDLE_EOF
+	{ 0, NULL, 0 },
+	{ 0x00000000, _T("The operation completed successfully.\r\n"), 39 },	// ERROR_SUCCESS
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000103, _T("No more data is available.\r\n"), 28 },	// ERROR_NO_MORE_ITEMS
+	{ 0, NULL, 0 },
+	{ 0x000003F3, _T("The configuration registry key could not be opened.\r\n"), 53 },	// ERROR_CANTOPEN
+	{ 0, NULL, 0 },
+	{ 0x80004001, _T("Not implemented\r\n"), 17 },	// E_NOTIMPL
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000078, _T("This function is not supported on this system.\r\n"), 48 },	// ERROR_CALL_NOT_IMPLEMENTED
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000013, _T("The media is write protected.\r\n"), 31 },	// ERROR_WRITE_PROTECT
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x000000EA, _T("More data is available.\r\n"), 25 },	// ERROR_MORE_DATA
+	{ 0, NULL, 0 },
+	{ 0x80070006, _T("The handle is invalid.\r\n"), 24 },	// E_HANDLE
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x000003F2, _T("The configuration registry key is invalid.\r\n"), 44 },	// ERROR_BADKEY
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x0000000F, _T("The system cannot find the drive specified.\r\n"), 45 },	// ERROR_INVALID_DRIVE
+	{ 0, NULL, 0 },
+	{ 0x00000716, _T("The specified resource name cannot be found in the image file.\r\n"), 64 },	// ERROR_RESOURCE_NAME_NOT_FOUND
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x0000007A, _T("The data area passed to a system call is too small.\r\n"), 53 },	// ERROR_INSUFFICIENT_BUFFER
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000035, _T("The network path was not found.\r\n"), 33 },	// ERROR_BAD_NETPATH
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000001, _T("Incorrect function.\r\n"), 21 },	// ERROR_INVALID_FUNCTION
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x80004003, _T("Invalid pointer\r\n"), 17 },	// E_POINTER
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x000005B4, _T("This operation returned because the timeout period expired.\r\n"), 61 },	// ERROR_TIMEOUT
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x000000CE, _T("The filename or extension is too long.\r\n"), 40 },	// ERROR_FILENAME_EXCED_RANGE
+	{ 0x00000522, _T("A required privilege is not held by the client.\r\n"), 49 },	// ERROR_PRIVILEGE_NOT_HELD
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000008, _T("Not enough storage is available to process this command.\r\n"), 58 },	// ERROR_NOT_ENOUGH_MEMORY
+	{ 0x0000006D, _T("The pipe has been ended.\r\n"), 26 },	// ERROR_BROKEN_PIPE
+	{ 0x000003E6, _T("Invalid access to memory location.\r\n"), 36 },	// ERROR_NOACCESS
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000021, _T("The process cannot access the file because another process has locked a portion of the file.\r\n"), 94 },	// ERROR_LOCK_VIOLATION
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000057, _T("The parameter is incorrect.\r\n"), 29 },	// ERROR_INVALID_PARAMETER
+	{ 0x0000000D, _T("The data is invalid.\r\n"), 22 },	// ERROR_INVALID_DATA
+	{ 0x800401F0, _T("CoInitialize has not been called.\r\n"), 35 },	// CO_E_NOTINITIALIZED
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x8000FFFF, _T("Catastrophic failure\r\n"), 22 },	// E_UNEXPECTED
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x000003F4, _T("The configuration registry key could not be read.\r\n"), 51 },	// ERROR_CANTREAD
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x80004004, _T("Operation aborted\r\n"), 19 },	// E_ABORT
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0x00000020, _T("The process cannot access the file because it is being used by another process.\r\n"), 81 },	// ERROR_SHARING_VIOLATION
+	{ 0, NULL, 0 },
+	{ 0x000003F5, _T("The configuration registry key could not be written.\r\n"), 54 },	// ERROR_CANTWRITE
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+	{ 0, NULL, 0 },
+};
@@ -0,0 +1,132 @@
+/////////////////////////////////////////////////////////////////////////////
+// ErrorMessageCache.cpp
+//
+// Process wide cache of formatted system error messages.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "ErrorMessageCache.h"
+#include "ErrorMessageTable.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+#define ERROR_FORMAT_SIZE	512
+
+/////////////////////////////////////////////////////////////////////////////
+// FormatErrorMessage
+//
+// The table's formatter: an InternedString, empty if the system has no
+// message, so that is cached too.
+/////////////////////////////////////////////////////////////////////////////
+static void*
+	FormatErrorMessage(
+	const void*		Module,
+	unsigned int	ErrorCode,
+	unsigned short	LanguageId)
+{
+	// freed by the table, or by GetErrorMessage if the table is full
+	InternedString*	Message			= new InternedString;
+	HMODULE			ModuleHandle	= (HMODULE)Module;
+
+	TCHAR	Buffer[ERROR_FORMAT_SIZE];
+	DWORD	FormatFlags	= FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS;
+
+	if (NULL != ModuleHandle)
+	{
+		FormatFlags |= FORMAT_MESSAGE_FROM_HMODULE;
+	}
+
+	DWORD	Length	= 0;
+
+	if (NULL != Message)
+	{
+		Length = FormatMessage(FormatFlags,
+			ModuleHandle,
+			ErrorCode,
+			LanguageId,
+			Buffer,
+			ERROR_FORMAT_SIZE,
+			NULL);
+
+		if (0 < Length)
+		{
+			*Message = InternedString(Buffer, Length);
+		}
+		else if (ERROR_INSUFFICIENT_BUFFER == GetLastError())
+		{
+			TCHAR*	AllocatedBuffer	= NULL;
+
+			Length = FormatMessage(FormatFlags | FORMAT_MESSAGE_ALLOCATE_BUFFER,
+				ModuleHandle,
+				ErrorCode,
+				LanguageId,
+				(TCHAR*)&AllocatedBuffer,
+				0,
+				NULL);
+
+			if (NULL != AllocatedBuffer)
+			{
+				*Message = InternedString(AllocatedBuffer, Length);
+				LocalFree(AllocatedBuffer);
+			}
+		}
+	}
+
+	return Message;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// FreeErrorMessage
+/////////////////////////////////////////////////////////////////////////////
+static void
+	FreeErrorMessage(
+	void*	Message)
+{
+	delete (InternedString*)Message;
+}
+
+static ErrorMessageTable g_ErrorMessageTable(FormatErrorMessage, FreeErrorMessage);
+
+/////////////////////////////////////////////////////////////////////////////
+// GetErrorMessage
+/////////////////////////////////////////////////////////////////////////////
+InternedString
+	GetErrorMessage(
+	HMODULE	ModuleHandle,
+	DWORD	ErrorCode,
+	WORD	LanguageId)
+{
+	InternedString	Message;
+	bool			Cached		= true;
+	InternedString*	Found		= (InternedString*)g_ErrorMessageTable.Lookup(
+		ModuleHandle, ErrorCode, LanguageId, &Cached);
+
+	if (NULL != Found)
+	{
+		Message = *Found;
+
+		// the table was too full to keep it
+		if (false == Cached)
+		{
+			FreeErrorMessage(Found);
+		}
+	}
+
+	return Message;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ClearErrorMessageCache
+/////////////////////////////////////////////////////////////////////////////
+void
+	ClearErrorMessageCache(void)
+{
+	g_ErrorMessageTable.Clear();
+}
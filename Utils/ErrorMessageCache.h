@@ -0,0 +1,44 @@
+/////////////////////////////////////////////////////////////////////////////
+// ErrorMessageCache.h
+//
+// Process wide cache of formatted system error messages.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+#include "InternedString.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+#define ERROR_MESSAGE_LANGUAGE_DEFAULT	MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT)
+
+/////////////////////////////////////////////////////////////////////////////
+// GetErrorMessage
+//
+// Returns the message for ErrorCode, from ModuleHandle's message table if
+// given, otherwise from the system, or an empty string if there is none.
+// The first lookup of a (module, code, language) formats the message;
+// later ones find it in an ErrorMessageTable without locking or
+// allocating.  Windows only, as the messages come from FormatMessage.
+/////////////////////////////////////////////////////////////////////////////
+DllExport InternedString
+GetErrorMessage(
+	HMODULE	ModuleHandle,
+	DWORD	ErrorCode,
+	WORD	LanguageId = ERROR_MESSAGE_LANGUAGE_DEFAULT);
+
+/////////////////////////////////////////////////////////////////////////////
+// ClearErrorMessageCache
+//
+// Forgets every cached message.  Only call when no other thread can be
+// looking one up, for example before unloading a message module.
+/////////////////////////////////////////////////////////////////////////////
+DllExport void
+ClearErrorMessageCache(void);
@@ -0,0 +1,285 @@
+/////////////////////////////////////////////////////////////////////////////
+// ErrorMessageTable.cpp - Class Implementation
+//
+// Lock free lookup table of formatted error messages, with the formatting
+// left to the caller, so it builds and is tested off Windows.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+// built without the precompiled header, so as not to need Windows
+#include <string.h>
+#include "ErrorMessageTable.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// GetSlot
+/////////////////////////////////////////////////////////////////////////////
+static unsigned int
+	GetSlot(
+	const void*		Module,
+	unsigned int	ErrorCode,
+	unsigned short	LanguageId)
+{
+	unsigned int	Hash	= ErrorCode * 2654435761U;
+
+	Hash ^= (unsigned int)((size_t)Module >> 12) * 40503U;
+	Hash ^= LanguageId;
+
+	return (Hash ^ (Hash >> 16)) & (ERROR_MESSAGE_TABLE_SLOTS - 1);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ReadSlot / PublishSlot
+//
+// The entry is written before the slot is published, and read after it
+// is; a volatile read is an acquire with Visual C++.
+/////////////////////////////////////////////////////////////////////////////
+static const ErrorMessageEntry*
+	ReadSlot(
+	ErrorMessageEntry* const volatile*	Slot)
+{
+#if defined(_WIN32)
+	return *Slot;
+#else
+	return __atomic_load_n(Slot, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void
+	PublishSlot(
+	ErrorMessageEntry* volatile*	Slot,
+	ErrorMessageEntry*				Entry)
+{
+#if defined(_WIN32)
+	InterlockedExchangePointer((PVOID volatile*)Slot, Entry);
+#else
+	__atomic_store_n(Slot, Entry, __ATOMIC_RELEASE);
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// FormatErrnoMessage
+/////////////////////////////////////////////////////////////////////////////
+void*
+	FormatErrnoMessage(
+	const void*		/* Module */,
+	unsigned int	ErrorCode,
+	unsigned short	/* LanguageId */)
+{
+	const char*	Text	= strerror((int)ErrorCode);
+	size_t		Length	= strlen(Text);
+	char*		Message	= new char[Length + 1];
+
+	if (NULL != Message)
+	{
+		memcpy(Message, Text, Length + 1);
+	}
+
+	return Message;
+}
+
+void
+	FreeErrnoMessage(
+	void*	Message)
+{
+	delete[] (char*)Message;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+ErrorMessageTable::ErrorMessageTable(
+	ErrorMessageFormat	Format,
+	ErrorMessageFree	Free) :
+	m_Format(Format),
+	m_Free(Free),
+	m_Count(0)
+{
+#if defined(_WIN32)
+	InitializeCriticalSection(&m_Lock);
+#else
+	pthread_mutex_init(&m_Lock, NULL);
+#endif
+	memset((void*)m_Slots, 0, sizeof(m_Slots));
+}
+
+ErrorMessageTable::~ErrorMessageTable(void)
+{
+	Clear();
+
+#if defined(_WIN32)
+	DeleteCriticalSection(&m_Lock);
+#else
+	pthread_mutex_destroy(&m_Lock);
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Clear
+//
+// Frees every entry.  Only call when no other thread can be looking one
+// up, as messages returned from the table are freed with it.
+/////////////////////////////////////////////////////////////////////////////
+void
+	ErrorMessageTable::Clear(void)
+{
+	Lock();
+
+	for (unsigned int Slot = 0; Slot < ERROR_MESSAGE_TABLE_SLOTS; Slot++)
+	{
+		if (NULL != m_Slots[Slot])
+		{
+			m_Free(m_Slots[Slot]->Message);
+
+			delete m_Slots[Slot];
+			m_Slots[Slot] = NULL;
+		}
+	}
+
+	m_Count = 0;
+
+	Unlock();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetCount
+/////////////////////////////////////////////////////////////////////////////
+unsigned int
+	ErrorMessageTable::GetCount(void) const
+{
+	return m_Count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Lookup
+//
+// Returns the message, formatting it on the first lookup of its key.
+// Cached is set false if the table was too full to keep it, in which case
+// the caller frees it; a cached message stays valid until Clear.
+/////////////////////////////////////////////////////////////////////////////
+void*
+	ErrorMessageTable::Lookup(
+	const void*		Module,
+	unsigned int	ErrorCode,
+	unsigned short	LanguageId,
+	bool*			Cached)
+{
+	void*						Message		= NULL;
+	unsigned int				FreeSlot	= ERROR_MESSAGE_TABLE_SLOTS;
+	const ErrorMessageEntry*	Entry		= Find(Module, ErrorCode, LanguageId, &FreeSlot);
+
+	*Cached = true;
+
+	if (NULL != Entry)
+	{
+		Message = Entry->Message;
+	}
+	else
+	{
+		Lock();
+
+		// another thread may have added it since
+		Entry = Find(Module, ErrorCode, LanguageId, &FreeSlot);
+
+		if (NULL != Entry)
+		{
+			Message = Entry->Message;
+		}
+		else
+		{
+			ErrorMessageEntry*	NewEntry	= NULL;
+
+			Message = m_Format(Module, ErrorCode, LanguageId);
+
+			if ((NULL != Message) && (ERROR_MESSAGE_TABLE_SLOTS > FreeSlot) &&
+				(m_Count < ERROR_MESSAGE_TABLE_LIMIT))
+			{
+				NewEntry = new ErrorMessageEntry;
+			}
+
+			if (NULL != NewEntry)
+			{
+				NewEntry->Module		= Module;
+				NewEntry->ErrorCode		= ErrorCode;
+				NewEntry->LanguageId	= LanguageId;
+				NewEntry->Message		= Message;
+
+				PublishSlot(&m_Slots[FreeSlot], NewEntry);
+				m_Count++;
+			}
+			else
+			{
+				*Cached = false;
+			}
+		}
+
+		Unlock();
+	}
+
+	return Message;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Find
+//
+// Returns the entry, or NULL with FreeSlot set to where it would go.
+/////////////////////////////////////////////////////////////////////////////
+const ErrorMessageEntry*
+	ErrorMessageTable::Find(
+	const void*		Module,
+	unsigned int	ErrorCode,
+	unsigned short	LanguageId,
+	unsigned int*	FreeSlot) const
+{
+	const ErrorMessageEntry*	Found	= NULL;
+	unsigned int				Slot	= GetSlot(Module, ErrorCode, LanguageId);
+
+	for (unsigned int Probe = 0; Probe < ERROR_MESSAGE_TABLE_SLOTS; Probe++)
+	{
+		const ErrorMessageEntry*	Entry	= ReadSlot(&m_Slots[Slot]);
+
+		if (NULL == Entry)
+		{
+			*FreeSlot = Slot;
+			break;
+		}
+
+		if ((ErrorCode == Entry->ErrorCode) && (Module == Entry->Module) &&
+			(LanguageId == Entry->LanguageId))
+		{
+			Found = Entry;
+			break;
+		}
+
+		Slot = (Slot + 1) & (ERROR_MESSAGE_TABLE_SLOTS - 1);
+	}
+
+	return Found;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Lock / Unlock
+/////////////////////////////////////////////////////////////////////////////
+void
+	ErrorMessageTable::Lock(void)
+{
+#if defined(_WIN32)
+	EnterCriticalSection(&m_Lock);
+#else
+	pthread_mutex_lock(&m_Lock);
+#endif
+}
+
+void
+	ErrorMessageTable::Unlock(void)
+{
+#if defined(_WIN32)
+	LeaveCriticalSection(&m_Lock);
+#else
+	pthread_mutex_unlock(&m_Lock);
+#endif
+}
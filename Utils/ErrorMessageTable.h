@@ -0,0 +1,120 @@
+/////////////////////////////////////////////////////////////////////////////
+// ErrorMessageTable.h - Class Declaration
+//
+// Lock free lookup table of formatted error messages, with the formatting
+// left to the caller, so it builds and is tested off Windows.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+
+#if defined(_WIN32)
+#include "../Include/Common.h"
+#else
+#include <pthread.h>
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+// a power of 2; lookups stop caching new codes once it is 3/4 full
+const unsigned int ERROR_MESSAGE_TABLE_SLOTS	= 512;
+const unsigned int ERROR_MESSAGE_TABLE_LIMIT	= ERROR_MESSAGE_TABLE_SLOTS * 3 / 4;
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+// Returns the message for the key, allocated, for the table to keep; NULL
+// only if it could not be allocated.  A code without a message should get
+// an empty one, so it is cached too.
+typedef void* (*ErrorMessageFormat)(
+	const void*		Module,
+	unsigned int	ErrorCode,
+	unsigned short	LanguageId);
+typedef void (*ErrorMessageFree)(
+	void*	Message);
+
+// never changed once it is published in a slot
+struct ErrorMessageEntry
+{
+	const void*		Module;
+	unsigned int	ErrorCode;
+	unsigned short	LanguageId;
+	void*			Message;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// FormatErrnoMessage / FreeErrnoMessage
+//
+// The formatter off Windows: a copy of strerror's text, as char.  The
+// module and language are ignored.
+/////////////////////////////////////////////////////////////////////////////
+void*
+FormatErrnoMessage(
+	const void*		Module,
+	unsigned int	ErrorCode,
+	unsigned short	LanguageId);
+void
+FreeErrnoMessage(
+	void*	Message);
+
+/////////////////////////////////////////////////////////////////////////////
+// ErrorMessageTable Class Definition
+//
+// Open addressing, keyed by (module, code, language), read without
+// locking.  Entries are only added, under the lock, and published with an
+// atomic store, so a reader either sees a finished entry or an empty slot.
+// Once ERROR_MESSAGE_TABLE_LIMIT entries are in, new keys are formatted on
+// every lookup instead, which keeps probes short.
+/////////////////////////////////////////////////////////////////////////////
+class ErrorMessageTable
+{
+	public:
+		// Properties
+
+		// Methods
+			ErrorMessageTable(
+				ErrorMessageFormat	Format,
+				ErrorMessageFree	Free);
+			~ErrorMessageTable(void);
+
+			void Clear(void);
+			unsigned int GetCount(void) const;
+			void* Lookup(
+				const void*		Module,
+				unsigned int	ErrorCode,
+				unsigned short	LanguageId,
+				bool*			Cached);
+
+	private:
+		// Properties
+			ErrorMessageFormat				m_Format;
+			ErrorMessageFree				m_Free;
+#if defined(_WIN32)
+			CRITICAL_SECTION				m_Lock;
+#else
+			pthread_mutex_t					m_Lock;
+#endif
+			unsigned int					m_Count;
+			ErrorMessageEntry* volatile		m_Slots[ERROR_MESSAGE_TABLE_SLOTS];
+
+		// Methods
+			ErrorMessageTable(
+				const ErrorMessageTable&);
+			ErrorMessageTable& operator=(
+				const ErrorMessageTable&);
+
+			const ErrorMessageEntry* Find(
+				const void*		Module,
+				unsigned int	ErrorCode,
+				unsigned short	LanguageId,
+				unsigned int*	FreeSlot) const;
+			void Lock(void);
+			void Unlock(void);
+};
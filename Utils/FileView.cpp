@@ -0,0 +1,222 @@
+/////////////////////////////////////////////////////////////////////////////
+// FileView.cpp - Class Implementation
+//
+// A read-only view of a whole file, mapped rather than read.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include <tchar.h>
+#include "FileView.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+// WIN32_MEMORY_RANGE_ENTRY, which the XP SDK lacks
+struct PrefetchRange
+{
+	PVOID	VirtualAddress;
+	SIZE_T	NumberOfBytes;
+};
+
+typedef BOOL (WINAPI* PrefetchVirtualMemoryFunction)(HANDLE, ULONG_PTR,
+	PrefetchRange*, ULONG);
+
+/////////////////////////////////////////////////////////////////////////////
+// PrefetchView
+//
+// Asks the system to read the view in, in large reads, rather than page
+// by page as it is touched.  Windows 8 on; elsewhere does nothing.
+/////////////////////////////////////////////////////////////////////////////
+static void
+	PrefetchView(
+	const BYTE*	Data,
+	SIZE_T		Size)
+{
+	PrefetchVirtualMemoryFunction	Prefetch	=
+		(PrefetchVirtualMemoryFunction)GetProcAddress(
+			GetModuleHandle(_T("kernel32.dll")), "PrefetchVirtualMemory");
+
+	if (NULL != Prefetch)
+	{
+		PrefetchRange	Range;
+
+		Range.VirtualAddress	= (PVOID)Data;
+		Range.NumberOfBytes		= Size;
+
+		Prefetch(GetCurrentProcess(), 1, &Range, 0);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+FileView::FileView(void) :
+	m_Data(NULL),
+	m_Size(0),
+	m_Open(false)
+{
+}
+
+FileView::~FileView(void)
+{
+	Close();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Close
+/////////////////////////////////////////////////////////////////////////////
+void
+	FileView::Close(void)
+{
+	if (NULL != m_Data)
+	{
+		UnmapViewOfFile(m_Data);
+		m_Data = NULL;
+	}
+
+	m_Size = 0;
+	m_Open = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetData
+//
+// NULL if the file is empty.
+/////////////////////////////////////////////////////////////////////////////
+const BYTE*
+	FileView::GetData(void) const
+{
+	return m_Data;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetSize
+/////////////////////////////////////////////////////////////////////////////
+ULONGLONG
+	FileView::GetSize(void) const
+{
+	return m_Size;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsOpen
+/////////////////////////////////////////////////////////////////////////////
+bool
+	FileView::IsOpen(void) const
+{
+	return m_Open;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Open
+//
+// Maps the whole file, which must fit in the address space; so, in 32 bit
+// builds, files of more than a GB or so may fail.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	FileView::Open(
+	LPCTSTR			FilePath,
+	FileAccessHint	Hint)
+{
+	DWORD			Flags		= FILE_ATTRIBUTE_NORMAL;
+	HANDLE			Mapping		= NULL;
+	HANDLE			File		= INVALID_HANDLE_VALUE;
+	LARGE_INTEGER	FileSize;
+
+	Close();
+
+	if (FileAccessSequential == Hint)
+	{
+		Flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+	}
+	else if (FileAccessRandom == Hint)
+	{
+		Flags |= FILE_FLAG_RANDOM_ACCESS;
+	}
+
+	if (NULL != FilePath)
+	{
+		// not sharing writes, so a file still being written is not mapped
+		File = CreateFile(FilePath, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, Flags, NULL);
+	}
+
+	if (INVALID_HANDLE_VALUE != File)
+	{
+		if (FALSE != GetFileSizeEx(File, &FileSize))
+		{
+			// an empty file cannot be mapped, nor needs to be
+			if (0 == FileSize.QuadPart)
+			{
+				m_Open = true;
+			}
+			else if ((ULONGLONG)FileSize.QuadPart <= (SIZE_T)-1)
+			{
+				Mapping = CreateFileMapping(File, NULL, PAGE_READONLY, 0, 0,
+					NULL);
+			}
+		}
+
+		if (NULL != Mapping)
+		{
+			// the view keeps the mapping open
+			m_Data = (const BYTE*)MapViewOfFile(Mapping, FILE_MAP_READ, 0,
+				0, 0);
+
+			CloseHandle(Mapping);
+		}
+
+		CloseHandle(File);
+	}
+
+	if (NULL != m_Data)
+	{
+		m_Size = (ULONGLONG)FileSize.QuadPart;
+		m_Open = true;
+
+		if (FileAccessSequential == Hint)
+		{
+			PrefetchView(m_Data, (SIZE_T)m_Size);
+		}
+	}
+
+	return m_Open;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Read
+//
+// Calls the reader with the view, returning false, rather than crashing,
+// if a page of the file cannot be read while it runs.  Only reads on this
+// thread are caught, and the reader is stopped where it was, without
+// unwinding, so it should keep anything it allocates in the context for
+// the caller to free.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	FileView::Read(
+	FileViewReader	Reader,
+	void*			Context) const
+{
+	bool	ReturnCode	= false;
+
+	if ((NULL != Reader) && (true == m_Open))
+	{
+		__try
+		{
+			ReturnCode = Reader(m_Data, m_Size, Context);
+		}
+		__except (EXCEPTION_IN_PAGE_ERROR == GetExceptionCode() ?
+			EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+		{
+			ReturnCode = false;
+		}
+	}
+
+	return ReturnCode;
+}
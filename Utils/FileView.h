@@ -0,0 +1,81 @@
+/////////////////////////////////////////////////////////////////////////////
+// FileView.h - Class Declaration
+//
+// A read-only view of a whole file, mapped rather than read.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+// how the view will be read; only advice, for the system's read ahead
+enum FileAccessHint
+{
+	FileAccessNormal,
+	// front to back, once; the view is also prefetched where the system
+	// can
+	FileAccessSequential,
+	// here and there
+	FileAccessRandom
+};
+
+// given the view by FileView::Read; returns false on failure
+typedef bool (*FileViewReader)(
+	const BYTE*	Data,
+	ULONGLONG	Size,
+	void*		Context);
+
+/////////////////////////////////////////////////////////////////////////////
+// FileView Class Definition
+//
+// Maps the file read-only, so its contents are neither copied nor
+// zeroed; pages are read from the file cache as they are first touched.
+// The view lasts until the object is closed or destroyed.  A file open
+// for writing elsewhere is not opened, but once open, the file is not
+// locked: it cannot be truncated while mapped, but writes to it by
+// others show through.  The view is not terminated.
+//
+// If a page cannot be read, as when a network share drops, touching it
+// raises EXCEPTION_IN_PAGE_ERROR rather than returning an error, so read
+// the view through Read, which catches it.
+/////////////////////////////////////////////////////////////////////////////
+class DllExport FileView
+{
+	public:
+		// Properties
+
+		// Methods
+			FileView(void);
+			~FileView(void);
+
+			void Close(void);
+			const BYTE* GetData(void) const;
+			ULONGLONG GetSize(void) const;
+			bool IsOpen(void) const;
+			bool Open(
+				LPCTSTR			FilePath,
+				FileAccessHint	Hint = FileAccessNormal);
+			bool Read(
+				FileViewReader	Reader,
+				void*			Context) const;
+
+	private:
+		// Properties
+			const BYTE*	m_Data;
+			ULONGLONG	m_Size;
+			bool		m_Open;
+
+		// Methods
+			FileView(
+				const FileView&);
+			FileView& operator=(
+				const FileView&);
+};
@@ -16,12 +16,142 @@
 #include <stdlib.h>
 #include <crtdbg.h>
 
+#include "EncodingDetector.h"
+#include "ParallelConvert.h"
 #include "utils.h"
 
 #if defined _DEBUG
 #define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
 #endif
 
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+// ReadUnicode's state for converting from a view
+struct ViewConversion
+{
+	ULONG		CodePage;
+	wchar_t*	Contents;
+	size_t		Length;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// ConvertText
+//
+// Converts the raw contents of a file, skipping any byte order mark.
+// Contents is set as soon as it is allocated, so a caller whose reads
+// can be cut short still has it to delete.  Only a ThreadCount of 1
+// keeps the reads on this thread.
+/////////////////////////////////////////////////////////////////////////////
+static void
+	ConvertText(
+	const char*	RawContents,
+	size_t		ContentsLength,
+	ULONG		CodePage,
+	DWORD		ThreadCount,
+	wchar_t**	Contents,
+	size_t*		UnicodeLength)
+{
+	EncodingDetector	Detector;
+	ULONG				PreferredCodePage	= CodePage;
+
+	if ((ULONG)-1 == PreferredCodePage)
+	{
+		PreferredCodePage = GetACP();
+	}
+
+	ULONG	DetectedCodePage	= Detector.Detect((const BYTE*)RawContents,
+		ContentsLength, PreferredCodePage);
+	size_t	BomLength			= 0;
+
+	if ((ULONG)-1 == CodePage)
+	{
+		CodePage = DetectedCodePage;
+	}
+
+	if (DetectedCodePage == CodePage)
+	{
+		BomLength = Detector.GetBomLength();
+	}
+
+	const char*	Text		= RawContents + BomLength;
+	size_t		TextLength	= ContentsLength - BomLength;
+
+	if ((CodePageUtf16Le == CodePage) || (CodePageUtf16Be == CodePage))
+	{
+		size_t		Length	= TextLength / sizeof(wchar_t);
+		wchar_t*	Buffer	= new wchar_t[Length + 1];
+
+		*Contents = Buffer;
+
+		if (NULL != Buffer)
+		{
+			memcpy(Buffer, Text, Length * sizeof(wchar_t));
+			Buffer[Length] = L'\0';
+
+			if (CodePageUtf16Be == CodePage)
+			{
+				for (size_t Index = 0; Index < Length; Index++)
+				{
+					Buffer[Index] = (wchar_t)((Buffer[Index] << 8) |
+						(Buffer[Index] >> 8));
+				}
+			}
+
+			*UnicodeLength = Length;
+		}
+	}
+	else if (1 != ThreadCount)
+	{
+		*Contents = ConvertMultiByteToUnicodeParallel(CodePage, Text,
+			TextLength, UnicodeLength, ThreadCount);
+	}
+	else
+	{
+		size_t		BufferSize	= GetUnicodeBound(CodePage, TextLength);
+		wchar_t*	Buffer		= new wchar_t[BufferSize + 1];
+
+		*Contents = Buffer;
+
+		if (NULL != Buffer)
+		{
+			size_t	Length	= ConvertMultiByteToUnicode(CodePage, Text,
+				TextLength, Buffer, BufferSize, NULL);
+
+			Buffer[Length] = L'\0';
+
+			*UnicodeLength = Length;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ConvertView
+//
+// FileView reader for ReadUnicode.
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	ConvertView(
+	const BYTE*	Data,
+	ULONGLONG	Size,
+	void*		Context)
+{
+	ViewConversion*	Conversion	= (ViewConversion*)Context;
+
+	// an empty file has no view, but converts to an empty string
+	const char*		RawContents	= "";
+
+	if (NULL != Data)
+	{
+		RawContents = (const char*)Data;
+	}
+
+	ConvertText(RawContents, (size_t)Size, Conversion->CodePage, 1,
+		&Conversion->Contents, &Conversion->Length);
+
+	return (NULL != Conversion->Contents);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // Constructors / Destructors
 /////////////////////////////////////////////////////////////////////////////
@@ -124,6 +254,28 @@ bool
 	return ReturnCode;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// Map
+//
+// Maps the whole file into the view, read-only, instead of reading it
+// into a new buffer as Read does; sizes are 64 bit.  The view owns the
+// mapping.  Read the view through FileView::Read.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	FileWrapper::Map(
+	FileView*		View,
+	FileAccessHint	Hint)
+{
+	bool	ReturnCode	= false;
+
+	if ((NULL != m_FileName) && (NULL != View))
+	{
+		ReturnCode = View->Open(m_FileName, Hint);
+	}
+
+	return ReturnCode;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // Read
 /////////////////////////////////////////////////////////////////////////////
@@ -173,11 +325,85 @@ BYTE*
 	return InputContents;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// ReadUnicode
+//
+// Returns:		wchar_t*	new terminated contents, delete after use.
+// Parameters:
+//	ULONG		CodePage	(IN)	Code page of the file
+//									-1 = detect, preferring the local code page.
+//	DWORD		ThreadCount	(IN)	Threads to convert large files with
+//									0 = one per processor.
+//	size_t*		Length		(OUT)	Characters returned, may be NULL
+//	bool		Mapped		(IN)	Convert from a view of the file rather
+//									than from a copy read into memory.
+//
+// Purpose:		Reads the file and converts it, skipping any byte order
+//				mark.  Large files are converted in parallel chunks.
+//				A mapped file is converted on this thread only, so that
+//				FileView::Read can catch the file failing to page in, and
+//				returns NULL then.
+/////////////////////////////////////////////////////////////////////////////
+wchar_t*
+	FileWrapper::ReadUnicode(
+	ULONG	CodePage,
+	DWORD	ThreadCount,
+	size_t*	Length,
+	bool	Mapped)
+{
+	wchar_t*	Contents		= NULL;
+	size_t		UnicodeLength	= 0;
+
+	if (true == Mapped)
+	{
+		FileView		View;
+		ViewConversion	Conversion;
+
+		Conversion.CodePage	= CodePage;
+		Conversion.Contents	= NULL;
+		Conversion.Length	= 0;
+
+		if ((true == Map(&View, FileAccessSequential)) &&
+			(true == View.Read(ConvertView, &Conversion)))
+		{
+			Contents		= Conversion.Contents;
+			UnicodeLength	= Conversion.Length;
+		}
+		else if (NULL != Conversion.Contents)
+		{
+			delete[] Conversion.Contents;
+		}
+	}
+	else
+	{
+		DWORD	ContentsLength	= 0;
+		char*	RawContents		= ReadText(&ContentsLength);
+
+		if (NULL != RawContents)
+		{
+			ConvertText(RawContents, ContentsLength, CodePage, ThreadCount,
+				&Contents, &UnicodeLength);
+
+			delete[] RawContents;
+		}
+	}
+
+	if (NULL != Length)
+	{
+		*Length = UnicodeLength;
+	}
+
+	return Contents;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // ReadText
+//
+// ContentsLength, if given, receives the number of bytes read.
 /////////////////////////////////////////////////////////////////////////////
 char*
-	FileWrapper::ReadText(void)
+	FileWrapper::ReadText(
+	DWORD*	ContentsLength)
 {
 	char*	InputContents = NULL;
 
@@ -211,9 +437,14 @@ char*
 					{
 					}
 
-					CloseHandle(FileHandle);
+					if (NULL != ContentsLength)
+					{
+						*ContentsLength = BytesRead;
+					}
 				}
 			}
+
+			CloseHandle(FileHandle);
 		}
 	}
 
@@ -12,6 +12,7 @@
 // Includes
 /////////////////////////////////////////////////////////////////////////////
 #include "../Include/Common.h"
+#include "FileView.h"
 
 /////////////////////////////////////////////////////////////////////////////
 // FileWrapper Class Definition
@@ -34,14 +35,23 @@ class DllExport FileWrapper
 			bool Create(
 				BYTE*	Contents,
 				DWORD	ContentsLength);
+			bool Map(
+				FileView*		View,
+				FileAccessHint	Hint = FileAccessNormal);
 			BYTE* Read(
 				DWORD*	ContentsLength);
+			wchar_t* ReadUnicode(
+				ULONG	CodePage = (ULONG)-1,
+				DWORD	ThreadCount = 1,
+				size_t*	Length = NULL,
+				bool	Mapped = false);
 
 private:
 		// Properties
 			LPCTSTR	m_FileName;
 
 		// Methods
-			char* ReadText(void);
+			char* ReadText(
+				DWORD*	ContentsLength = NULL);
 			TCHAR* ReadUnicodeText(void);
 };
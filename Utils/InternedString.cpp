@@ -0,0 +1,345 @@
+/////////////////////////////////////////////////////////////////////////////
+// InternedString.cpp - Class Implementation
+//
+// Reference counted, immutable, interned string.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "InternedString.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+#define INTERN_BUCKET_COUNT	1024
+
+/////////////////////////////////////////////////////////////////////////////
+// InternedEntry
+//
+// The pool holds one reference to every entry, so an entry can only be
+// freed after Purge has dropped it from the pool.
+/////////////////////////////////////////////////////////////////////////////
+struct InternedEntry
+{
+	volatile LONG	ReferenceCount;
+	ULONG			Hash;
+	size_t			Length;
+	InternedEntry*	Next;
+	TCHAR			Text[1];
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// InternPool Class Definition
+/////////////////////////////////////////////////////////////////////////////
+class InternPool
+{
+	public:
+		// Methods
+			InternPool(void);
+			~InternPool(void);
+
+			InternedEntry* Intern(
+				LPCTSTR	Text,
+				size_t	Length,
+				ULONG	Hash);
+			void Purge(void);
+
+	private:
+		// Properties
+			CRITICAL_SECTION	m_Lock;
+			InternedEntry*		m_Buckets[INTERN_BUCKET_COUNT];
+};
+
+static InternPool g_InternPool;
+
+/////////////////////////////////////////////////////////////////////////////
+// GetStringHash
+//
+// FNV-1a over the characters.
+/////////////////////////////////////////////////////////////////////////////
+static ULONG
+	GetStringHash(
+	LPCTSTR	Text,
+	size_t	Length)
+{
+	ULONG	Hash	= 2166136261UL;
+
+	for (size_t Index = 0; Index < Length; Index++)
+	{
+		Hash ^= (ULONG)Text[Index];
+		Hash *= 16777619UL;
+	}
+
+	return Hash;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// InternPool Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+InternPool::InternPool(void)
+{
+	InitializeCriticalSection(&m_Lock);
+	memset(m_Buckets, 0, sizeof(m_Buckets));
+}
+
+InternPool::~InternPool(void)
+{
+	// entries still in use by other static objects are left alone
+	Purge();
+	DeleteCriticalSection(&m_Lock);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Intern
+//
+// Returns the entry for the text, with a reference added for the caller.
+/////////////////////////////////////////////////////////////////////////////
+InternedEntry*
+	InternPool::Intern(
+	LPCTSTR	Text,
+	size_t	Length,
+	ULONG	Hash)
+{
+	InternedEntry*	Entry	= NULL;
+	ULONG			Bucket	= Hash % INTERN_BUCKET_COUNT;
+
+	EnterCriticalSection(&m_Lock);
+
+	for (Entry = m_Buckets[Bucket]; NULL != Entry; Entry = Entry->Next)
+	{
+		if ((Hash == Entry->Hash) && (Length == Entry->Length) &&
+			(0 == memcmp(Text, Entry->Text, Length * sizeof(TCHAR))))
+		{
+			InterlockedIncrement(&Entry->ReferenceCount);
+			break;
+		}
+	}
+
+	if (NULL == Entry)
+	{
+		size_t	EntrySize	= sizeof(InternedEntry) + Length * sizeof(TCHAR);
+
+		Entry = (InternedEntry*)new BYTE[EntrySize];
+
+		if (NULL != Entry)
+		{
+			// one for the pool, one for the caller
+			Entry->ReferenceCount	= 2;
+			Entry->Hash				= Hash;
+			Entry->Length			= Length;
+			Entry->Next				= m_Buckets[Bucket];
+
+			memcpy(Entry->Text, Text, Length * sizeof(TCHAR));
+			Entry->Text[Length] = _T('\0');
+
+			m_Buckets[Bucket] = Entry;
+		}
+	}
+
+	LeaveCriticalSection(&m_Lock);
+
+	return Entry;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Purge
+//
+// Frees every entry that only the pool refers to.
+/////////////////////////////////////////////////////////////////////////////
+void
+	InternPool::Purge(void)
+{
+	EnterCriticalSection(&m_Lock);
+
+	for (int Bucket = 0; Bucket < INTERN_BUCKET_COUNT; Bucket++)
+	{
+		InternedEntry**	Link	= &m_Buckets[Bucket];
+
+		while (NULL != *Link)
+		{
+			InternedEntry*	Entry	= *Link;
+
+			if (1 == InterlockedCompareExchange(&Entry->ReferenceCount, 0, 1))
+			{
+				*Link = Entry->Next;
+				delete[] (BYTE*)Entry;
+			}
+			else
+			{
+				Link = &Entry->Next;
+			}
+		}
+	}
+
+	LeaveCriticalSection(&m_Lock);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// InternedString Class Definition
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+// Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+InternedString::InternedString(void) :
+	m_Entry(NULL)
+{
+}
+
+InternedString::InternedString(
+	LPCTSTR	Text) :
+		m_Entry(NULL)
+{
+	if (NULL != Text)
+	{
+		size_t	Length	= _tcslen(Text);
+
+		if (0 < Length)
+		{
+			m_Entry = g_InternPool.Intern(Text, Length, GetStringHash(Text, Length));
+		}
+	}
+}
+
+InternedString::InternedString(
+	LPCTSTR	Text,
+	size_t	Length) :
+		m_Entry(NULL)
+{
+	if ((NULL != Text) && (0 < Length))
+	{
+		m_Entry = g_InternPool.Intern(Text, Length, GetStringHash(Text, Length));
+	}
+}
+
+InternedString::InternedString(
+	const InternedString&	Other) :
+		m_Entry(Other.m_Entry)
+{
+	if (NULL != m_Entry)
+	{
+		InterlockedIncrement(&m_Entry->ReferenceCount);
+	}
+}
+
+InternedString::~InternedString(void)
+{
+	Release();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Operators
+/////////////////////////////////////////////////////////////////////////////
+InternedString&
+	InternedString::operator=(
+	const InternedString&	Other)
+{
+	if (m_Entry != Other.m_Entry)
+	{
+		if (NULL != Other.m_Entry)
+		{
+			InterlockedIncrement(&Other.m_Entry->ReferenceCount);
+		}
+
+		Release();
+		m_Entry = Other.m_Entry;
+	}
+
+	return *this;
+}
+
+// interned, so equal strings always share an entry
+bool
+	InternedString::operator==(
+	const InternedString&	Other) const
+{
+	return m_Entry == Other.m_Entry;
+}
+
+bool
+	InternedString::operator!=(
+	const InternedString&	Other) const
+{
+	return m_Entry != Other.m_Entry;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Accessors
+/////////////////////////////////////////////////////////////////////////////
+ULONG
+	InternedString::GetHash(void) const
+{
+	ULONG	Hash	= 0;
+
+	if (NULL != m_Entry)
+	{
+		Hash = m_Entry->Hash;
+	}
+
+	return Hash;
+}
+
+size_t
+	InternedString::GetLength(void) const
+{
+	size_t	Length	= 0;
+
+	if (NULL != m_Entry)
+	{
+		Length = m_Entry->Length;
+	}
+
+	return Length;
+}
+
+LPCTSTR
+	InternedString::GetString(void) const
+{
+	LPCTSTR	Text	= _T("");
+
+	if (NULL != m_Entry)
+	{
+		Text = m_Entry->Text;
+	}
+
+	return Text;
+}
+
+bool
+	InternedString::IsEmpty(void) const
+{
+	return NULL == m_Entry;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Purge
+//
+// Frees pooled strings that are no longer referenced anywhere.  Values
+// that are interned again later are simply recreated.
+/////////////////////////////////////////////////////////////////////////////
+void
+	InternedString::Purge(void)
+{
+	g_InternPool.Purge();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Release
+/////////////////////////////////////////////////////////////////////////////
+void
+	InternedString::Release(void)
+{
+	if (NULL != m_Entry)
+	{
+		if (0 == InterlockedDecrement(&m_Entry->ReferenceCount))
+		{
+			delete[] (BYTE*)m_Entry;
+		}
+
+		m_Entry = NULL;
+	}
+}
@@ -0,0 +1,62 @@
+/////////////////////////////////////////////////////////////////////////////
+// InternedString.h - Class Declaration
+//
+// Reference counted, immutable, interned string.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+
+struct InternedEntry;
+
+/////////////////////////////////////////////////////////////////////////////
+// InternedString Class Definition
+//
+// Equal strings share one entry in a process wide pool, so copying,
+// comparing and getting the length or hash of a value never touches the
+// characters.  The text must not be modified, and stays valid for as long
+// as any InternedString refers to it.
+/////////////////////////////////////////////////////////////////////////////
+class DllExport InternedString
+{
+	public:
+		// Properties
+
+		// Methods
+			InternedString(void);
+			InternedString(
+				LPCTSTR	Text);
+			InternedString(
+				LPCTSTR	Text,
+				size_t	Length);
+			InternedString(
+				const InternedString&	Other);
+			~InternedString(void);
+
+			InternedString& operator=(
+				const InternedString&	Other);
+			bool operator==(
+				const InternedString&	Other) const;
+			bool operator!=(
+				const InternedString&	Other) const;
+
+			ULONG GetHash(void) const;
+			size_t GetLength(void) const;
+			LPCTSTR GetString(void) const;
+			bool IsEmpty(void) const;
+
+			static void Purge(void);
+
+	private:
+		// Properties
+			InternedEntry*	m_Entry;
+
+		// Methods
+			void Release(void);
+};
@@ -0,0 +1,119 @@
+#############################################################################
+# MakeErrorCatalog.py
+#
+# Generates ErrorCatalogData.h, perfect hash tables of error messages,
+# from ErrorCatalog.txt:
+#
+#	python MakeErrorCatalog.py ErrorCatalog.txt > ErrorCatalogData.h
+#
+# Copyright (c) 2008 - 2015 by James John McGuire
+# All rights reserved.
+#############################################################################
+import sys
+
+MASK = 0xFFFFFFFF
+SEED_LIMIT = 0x10000
+
+
+# must match HashErrorCode in ErrorCatalog.cpp
+def hash_code(code, seed):
+	value = ((code ^ seed) * 0x9E3779B1) & MASK
+	return value ^ (value >> 16)
+
+
+def build_table(entries):
+	slot_count = 1
+
+	while slot_count < len(entries) * 2:
+		slot_count *= 2
+
+	bucket_count = max(1, slot_count // 4)
+	buckets = [[] for _ in range(bucket_count)]
+
+	for entry in entries:
+		buckets[hash_code(entry[0], 0) % bucket_count].append(entry)
+
+	seeds = [0] * bucket_count
+	slots = [None] * slot_count
+
+	# place the biggest buckets first, while the table is emptiest
+	for bucket in sorted(range(bucket_count), key=lambda index: -len(buckets[index])):
+		if len(buckets[bucket]) == 0:
+			continue
+
+		for seed in range(1, SEED_LIMIT):
+			positions = [hash_code(entry[0], seed) % slot_count for entry in buckets[bucket]]
+
+			if (len(set(positions)) == len(positions)) and \
+				all(slots[position] is None for position in positions):
+				break
+		else:
+			raise Exception('no seed found, grow the table')
+
+		seeds[bucket] = seed
+
+		for entry, position in zip(buckets[bucket], positions):
+			slots[position] = entry
+
+	return seeds, slots
+
+
+def quote(text):
+	text = text.replace('\\', '\\\\').replace('"', '\\"')
+
+	return '_T("%s")' % text.replace('\r', '\\r').replace('\n', '\\n')
+
+
+def write_table(out, name, seeds, slots):
+	out.write('#define ERROR_CATALOG_SLOTS\t%d\n' % len(slots))
+	out.write('#define ERROR_CATALOG_BUCKETS\t%d\n\n' % len(seeds))
+	out.write('static const USHORT g_%sSeeds[%d] =\n{\n' % (name, len(seeds)))
+
+	for start in range(0, len(seeds), 16):
+		out.write('\t%s,\n' % ', '.join(str(seed) for seed in seeds[start:start + 16]))
+
+	out.write('};\n\n')
+	out.write('static const ErrorCatalogEntry g_%s[%d] =\n{\n' % (name, len(slots)))
+
+	for slot in slots:
+		if slot is None:
+			out.write('\t{ 0, NULL, 0 },\n')
+		else:
+			code, symbol, message = slot
+			out.write('\t{ 0x%08X, %s, %d },\t// %s\n' % (code, quote(message), len(message),
+				symbol))
+
+	out.write('};\n')
+
+
+def main():
+	system = []
+
+	with open(sys.argv[1]) as catalog:
+		for line in catalog:
+			line = line.strip()
+
+			if (line == '') or line.startswith('#'):
+				continue
+
+			fields = line.split(None, 3)
+
+			# FormatMessage ends system messages with a line break
+			system.append((int(fields[1], 0), fields[2], fields[3] + '\r\n'))
+
+	out = sys.stdout
+	out.write('/////////////////////////////////////////////////////////////////////////////\n')
+	out.write('// ErrorCatalogData.h\n')
+	out.write('//\n')
+	out.write('// Generated by MakeErrorCatalog.py from ErrorCatalog.txt.  Do not edit.\n')
+	out.write('//\n')
+	out.write('// Included by ErrorCatalog.cpp only.\n')
+	out.write('/////////////////////////////////////////////////////////////////////////////\n')
+	out.write('#pragma once\n\n')
+
+	seeds, slots = build_table(system)
+	write_table(out, 'ErrorCatalog', seeds, slots)
+
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,154 @@
+#############################################################################
+# MakeNormalizationData.py
+#
+# Generates NormalizationData.h from the Unicode character database that
+# ships with Python.  Run again after moving to a newer Python to pick up
+# a newer Unicode version:
+#
+#	python MakeNormalizationData.py > NormalizationData.h
+#
+# Copyright (c) 2008 - 2015 by James John McGuire
+# All rights reserved.
+#############################################################################
+import sys
+import unicodedata
+
+# code points at or above this have no normalization properties
+PROPERTY_LIMIT = 0x30000
+BLOCK_SIZE = 32
+
+QUICK_CHECK_NO = 1
+QUICK_CHECK_MAYBE = 2
+DECOMPOSES = 4
+
+HANGUL_FIRST = 0xAC00
+HANGUL_LAST = 0xD7A3
+
+
+def get_canonical_decomposition(code_point):
+	decomposition = unicodedata.decomposition(chr(code_point))
+
+	if (decomposition == '') or decomposition.startswith('<'):
+		return None
+
+	return [int(value, 16) for value in decomposition.split()]
+
+
+def main():
+	compositions = []
+	maybe = set(range(0x1161, 0x1176)) | set(range(0x11A8, 0x11C3))
+
+	for code_point in range(0x110000):
+		if HANGUL_FIRST <= code_point <= HANGUL_LAST:
+			continue
+
+		decomposition = get_canonical_decomposition(code_point)
+
+		if (decomposition is not None) and (len(decomposition) == 2):
+			# primary composites are the ones that normalize to themselves
+			if unicodedata.normalize('NFC', chr(code_point)) == chr(code_point):
+				compositions.append((decomposition[0], decomposition[1], code_point))
+				maybe.add(decomposition[1])
+
+	compositions.sort()
+
+	decompositions = []
+	decomposition_data = []
+
+	for code_point in range(0x110000):
+		if HANGUL_FIRST <= code_point <= HANGUL_LAST:
+			continue
+
+		if get_canonical_decomposition(code_point) is not None:
+			full = [ord(character) for character in unicodedata.normalize('NFD', chr(code_point))]
+			decompositions.append((code_point, len(decomposition_data), len(full)))
+			decomposition_data.extend(full)
+
+	properties = [(0, 0)]
+	property_index = {(0, 0): 0}
+	blocks = []
+	block_index = {}
+	index = []
+
+	for block_start in range(0, PROPERTY_LIMIT, BLOCK_SIZE):
+		block = []
+
+		for code_point in range(block_start, block_start + BLOCK_SIZE):
+			character = chr(code_point)
+			flags = 0
+
+			if unicodedata.normalize('NFC', character) != character:
+				flags |= QUICK_CHECK_NO
+			elif code_point in maybe:
+				flags |= QUICK_CHECK_MAYBE
+
+			if unicodedata.normalize('NFD', character) != character:
+				flags |= DECOMPOSES
+
+			value = (unicodedata.combining(character), flags)
+
+			if value not in property_index:
+				property_index[value] = len(properties)
+				properties.append(value)
+
+			block.append(property_index[value])
+
+		block = tuple(block)
+
+		if block not in block_index:
+			block_index[block] = len(blocks)
+			blocks.append(block)
+
+		index.append(block_index[block])
+
+	assert len(properties) <= 256
+	assert len(blocks) <= 256
+
+	out = sys.stdout
+	out.write('/////////////////////////////////////////////////////////////////////////////\n')
+	out.write('// NormalizationData.h\n')
+	out.write('//\n')
+	out.write('// Generated by MakeNormalizationData.py from Unicode %s.  Do not edit.\n'
+		% unicodedata.unidata_version)
+	out.write('//\n')
+	out.write('// Included by Normalization.cpp only.\n')
+	out.write('/////////////////////////////////////////////////////////////////////////////\n')
+	out.write('#pragma once\n\n')
+	out.write('#define NORMALIZATION_PROPERTY_LIMIT\t0x%X\n' % PROPERTY_LIMIT)
+	out.write('#define NORMALIZATION_BLOCK_SHIFT\t%d\n\n' % (BLOCK_SIZE.bit_length() - 1))
+
+	write_array(out, 'static const unsigned char', 'g_NormalizationIndex', index, 16)
+	write_array(out, 'static const unsigned char', 'g_NormalizationBlocks',
+		[value for block in blocks for value in block], 16)
+
+	out.write('static const NormalizationProperty g_NormalizationProperties[] =\n{\n')
+	for combining_class, flags in properties:
+		out.write('\t{ %d, %d },\n' % (combining_class, flags))
+	out.write('};\n\n')
+
+	out.write('static const DecompositionEntry g_Decompositions[] =\n{\n')
+	for code_point, offset, length in decompositions:
+		out.write('\t{ 0x%05X, %d, %d },\n' % (code_point, offset, length))
+	out.write('};\n\n')
+
+	write_array(out, 'static const unsigned int', 'g_DecompositionData',
+		['0x%05X' % value for value in decomposition_data], 8)
+
+	out.write('static const CompositionEntry g_Compositions[] =\n{\n')
+	for first, second, composite in compositions:
+		out.write('\t{ 0x%05X, 0x%05X, 0x%05X },\n' % (first, second, composite))
+	out.write('};\n')
+
+
+def write_array(out, type_name, name, values, per_line):
+	out.write('%s %s[%d] =\n{\n' % (type_name, name, len(values)))
+
+	for start in range(0, len(values), per_line):
+		line = ', '.join(str(value) for value in values[start:start + per_line])
+		out.write('\t%s,\n' % line)
+
+	out.write('};\n\n')
+
+
+if __name__ == '__main__':
+	main()
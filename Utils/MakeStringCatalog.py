@@ -0,0 +1,116 @@
+#############################################################################
+# MakeStringCatalog.py
+#
+# Compiles every language's localized strings into one string catalog
+# file, as read by StringCatalog and mapped by MessageCatalog:
+#
+#	python MakeStringCatalog.py Strings.txt Strings.cat [char size]
+#
+# Each line of the source is a language id, a string id and the string,
+# separated by white space, as in "0x0409	101	File not found.".  \n, \r,
+# \t and \\ are unescaped.  Lines starting with # are comments.  The
+# char size is 2, UTF-16, for Windows builds (the default), or 4, UTF-32,
+# for builds where wchar_t is 32 bits.
+#
+# Copyright (c) 2010 - 2015 by James John McGuire
+# All rights reserved.
+#############################################################################
+import struct
+import sys
+
+# must match StringCatalog.h
+MAGIC = 0x5441435A
+VERSION = 1
+HEADER_FORMAT = '<4I'
+LANGUAGE_FORMAT = '<6I'
+
+ESCAPES = {'n': '\n', 'r': '\r', 't': '\t', '\\': '\\'}
+
+
+def unescape(text):
+	result = []
+	index = 0
+
+	while index < len(text):
+		if (text[index] == '\\') and (index + 1 < len(text)) and (text[index + 1] in ESCAPES):
+			result.append(ESCAPES[text[index + 1]])
+			index += 2
+		else:
+			result.append(text[index])
+			index += 1
+
+	return ''.join(result)
+
+
+def align(data, boundary):
+	return data + b'\0' * (-len(data) % boundary)
+
+
+def build_language(strings, char_size, encoding):
+	first_id = min(strings)
+	id_count = max(strings) - first_id + 1
+	offsets = []
+	text = b''
+
+	for string_id in range(first_id, first_id + id_count + 1):
+		offsets.append(len(text) // char_size)
+
+		if (string_id in strings) and (strings[string_id] != ''):
+			text += (strings[string_id] + '\0').encode(encoding)
+
+	return first_id, id_count, struct.pack('<%dI' % len(offsets), *offsets), text
+
+
+def main():
+	char_size = 2
+
+	if len(sys.argv) > 3:
+		char_size = int(sys.argv[3])
+
+	encoding = {2: 'utf-16-le', 4: 'utf-32-le'}[char_size]
+	languages = {}
+
+	with open(sys.argv[1], encoding='utf-8-sig') as source:
+		for line_number, line in enumerate(source, 1):
+			line = line.rstrip('\r\n')
+
+			if (line.strip() == '') or line.lstrip().startswith('#'):
+				continue
+
+			fields = line.split(None, 2)
+
+			if len(fields) < 3:
+				raise Exception('line %d: expected language, id and string' % line_number)
+
+			strings = languages.setdefault(int(fields[0], 0), {})
+			string_id = int(fields[1], 0)
+
+			if string_id in strings:
+				raise Exception('line %d: string %d repeated' % (line_number, string_id))
+
+			strings[string_id] = unescape(fields[2])
+
+	entries = []
+	body = b''
+	start = struct.calcsize(HEADER_FORMAT) + struct.calcsize(LANGUAGE_FORMAT) * len(languages)
+
+	for language_id in sorted(languages):
+		first_id, id_count, offsets, text = build_language(languages[language_id], char_size,
+			encoding)
+		body = align(body, 4)
+		offsets_offset = start + len(body)
+		body += offsets
+		body = align(body, 4)
+		text_offset = start + len(body)
+		body += text
+		entries.append(struct.pack(LANGUAGE_FORMAT, language_id, first_id, id_count,
+			offsets_offset, text_offset, len(text) // char_size))
+
+	with open(sys.argv[2], 'wb') as catalog:
+		catalog.write(struct.pack(HEADER_FORMAT, MAGIC, VERSION, char_size, len(languages)))
+		catalog.write(b''.join(entries))
+		catalog.write(body)
+
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,349 @@
+/////////////////////////////////////////////////////////////////////////////
+// MessageCatalog.cpp - Class Implementation
+//
+// Every language's localized strings, mapped read-only from one catalog
+// file.
+//
+// Copyright (c) 2010 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "MessageCatalog.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+// one language of the catalog, pointing into the mapping
+struct MessageCatalogLanguage
+{
+	WORD			LanguageId;
+	UINT			FirstId;
+	UINT			IdCount;
+	const DWORD*	Offsets;
+	LPCTSTR			Text;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// CheckLanguage
+//
+// Checks that the language's offsets and text lie within the catalog,
+// aligned so as to be used in place, and that every string is in the
+// text and terminated.
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	CheckLanguage(
+	const BYTE*						View,
+	DWORD							Size,
+	const StringCatalogLanguage*	Language)
+{
+	bool	ReturnCode	= false;
+
+	if ((0 == Language->OffsetsOffset % sizeof(DWORD)) &&
+		(0 == Language->TextOffset % sizeof(TCHAR)) &&
+		((ULONGLONG)Language->OffsetsOffset +
+			((ULONGLONG)Language->IdCount + 1) * sizeof(DWORD) <= Size) &&
+		((ULONGLONG)Language->TextOffset +
+			(ULONGLONG)Language->TextLength * sizeof(TCHAR) <= Size))
+	{
+		ReturnCode = true;
+	}
+
+	if (true == ReturnCode)
+	{
+		const DWORD*	Offsets	=
+			(const DWORD*)(View + Language->OffsetsOffset);
+		LPCTSTR			Text	= (LPCTSTR)(View + Language->TextOffset);
+
+		for (DWORD Index = 0;
+			(true == ReturnCode) && (Index < Language->IdCount); Index++)
+		{
+			DWORD	Start	= Offsets[Index];
+			DWORD	End		= Offsets[Index + 1];
+
+			if ((End < Start) || (End > Language->TextLength) ||
+				((End > Start) && (_T('\0') != Text[End - 1])))
+			{
+				ReturnCode = false;
+			}
+		}
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+MessageCatalog::MessageCatalog(void) :
+	m_View(NULL),
+	m_Languages(NULL),
+	m_LanguageCount(0),
+	m_Active(NULL)
+{
+}
+
+MessageCatalog::~MessageCatalog(void)
+{
+	Close();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Close
+//
+// No other thread may be using the catalog, or strings from it.
+/////////////////////////////////////////////////////////////////////////////
+void
+	MessageCatalog::Close(void)
+{
+	m_Active = NULL;
+
+	if (NULL != m_Languages)
+	{
+		delete[] m_Languages;
+		m_Languages = NULL;
+	}
+
+	if (NULL != m_View)
+	{
+		UnmapViewOfFile(m_View);
+		m_View = NULL;
+	}
+
+	m_LanguageCount = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetLanguageId
+//
+// The language of the catalog in use, which may differ from the one
+// asked for in its sub language; 0 if none.
+/////////////////////////////////////////////////////////////////////////////
+WORD
+	MessageCatalog::GetLanguageId(void) const
+{
+	WORD							LanguageId	= 0;
+	const MessageCatalogLanguage*	Language	= m_Active;
+
+	if (NULL != Language)
+	{
+		LanguageId = Language->LanguageId;
+	}
+
+	return LanguageId;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetString
+//
+// Returns NULL if there is no such string in the current language.
+// Length, if not NULL, gets the length without the terminator.
+/////////////////////////////////////////////////////////////////////////////
+LPCTSTR
+	MessageCatalog::GetString(
+	UINT	StringId,
+	size_t*	Length) const
+{
+	LPCTSTR							String		= NULL;
+	const MessageCatalogLanguage*	Language	= m_Active;
+
+	if ((NULL != Language) && (StringId >= Language->FirstId) &&
+		(StringId - Language->FirstId < Language->IdCount))
+	{
+		UINT	Index	= StringId - Language->FirstId;
+		DWORD	Start	= Language->Offsets[Index];
+		DWORD	End		= Language->Offsets[Index + 1];
+
+		if (End > Start)
+		{
+			String = Language->Text + Start;
+
+			if (NULL != Length)
+			{
+				*Length = End - Start - 1;
+			}
+		}
+	}
+
+	return String;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsOpen
+/////////////////////////////////////////////////////////////////////////////
+bool
+	MessageCatalog::IsOpen(void) const
+{
+	return (NULL != m_View);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Open
+//
+// Maps the catalog and selects the language, as SetLanguage does.  The
+// catalog must have been written with this build's character size.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	MessageCatalog::Open(
+	LPCTSTR	CatalogPath,
+	WORD	LanguageId)
+{
+	bool	ReturnCode	= false;
+	DWORD	Size		= 0;
+	DWORD	SizeHigh	= 0;
+	HANDLE	Mapping		= NULL;
+	HANDLE	File		= NULL;
+
+	Close();
+
+	File = CreateFile(CatalogPath, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (INVALID_HANDLE_VALUE != File)
+	{
+		Size = GetFileSize(File, &SizeHigh);
+
+		// offsets in the catalog are 32 bits
+		if ((INVALID_FILE_SIZE != Size) && (0 == SizeHigh) &&
+			(sizeof(StringCatalogHeader) <= Size))
+		{
+			Mapping = CreateFileMapping(File, NULL, PAGE_READONLY, 0, 0,
+				NULL);
+		}
+
+		if (NULL != Mapping)
+		{
+			// the view keeps the mapping open
+			m_View = (const BYTE*)MapViewOfFile(Mapping, FILE_MAP_READ, 0,
+				0, 0);
+
+			CloseHandle(Mapping);
+		}
+
+		CloseHandle(File);
+	}
+
+	if (NULL != m_View)
+	{
+		ReturnCode = ReadLanguages(Size);
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = SetLanguage(LanguageId);
+	}
+
+	if (false == ReturnCode)
+	{
+		Close();
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SetLanguage
+//
+// Uses the language, or if the catalog does not have it, the first
+// language with the same primary language.  If there is neither, no
+// language is used, so every lookup fails and callers fall back to the
+// resource module, rather than going on in the old language.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	MessageCatalog::SetLanguage(
+	WORD	LanguageId)
+{
+	bool					ReturnCode	= false;
+	MessageCatalogLanguage*	Language	= FindLanguage(LanguageId);
+
+	InterlockedExchangePointer((PVOID volatile*)&m_Active, Language);
+
+	if (NULL != Language)
+	{
+		ReturnCode = true;
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// FindLanguage
+/////////////////////////////////////////////////////////////////////////////
+MessageCatalogLanguage*
+	MessageCatalog::FindLanguage(
+	WORD	LanguageId) const
+{
+	MessageCatalogLanguage*	Language	= NULL;
+
+	for (DWORD Index = 0; Index < m_LanguageCount; Index++)
+	{
+		if (LanguageId == m_Languages[Index].LanguageId)
+		{
+			Language = &m_Languages[Index];
+			break;
+		}
+
+		if ((NULL == Language) && (PRIMARYLANGID(LanguageId) ==
+			PRIMARYLANGID(m_Languages[Index].LanguageId)))
+		{
+			Language = &m_Languages[Index];
+		}
+	}
+
+	return Language;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ReadLanguages
+//
+// Checks the whole of the mapped catalog, and indexes its languages.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	MessageCatalog::ReadLanguages(
+	DWORD	Size)
+{
+	bool							ReturnCode	= false;
+	const StringCatalogHeader*		Header		=
+		(const StringCatalogHeader*)m_View;
+	const StringCatalogLanguage*	Entries		=
+		(const StringCatalogLanguage*)(Header + 1);
+
+	// strings are used in place, so must be in this build's characters
+	if ((STRING_CATALOG_MAGIC == Header->Magic) &&
+		(STRING_CATALOG_VERSION == Header->Version) &&
+		(sizeof(TCHAR) == Header->CharSize) &&
+		(0 < Header->LanguageCount) &&
+		(Header->LanguageCount <= (Size - sizeof(StringCatalogHeader)) /
+			sizeof(StringCatalogLanguage)))
+	{
+		m_Languages = new MessageCatalogLanguage[Header->LanguageCount];
+
+		ReturnCode = (NULL != m_Languages);
+	}
+
+	for (DWORD Index = 0;
+		(true == ReturnCode) && (Index < Header->LanguageCount); Index++)
+	{
+		const StringCatalogLanguage*	Entry	= &Entries[Index];
+
+		ReturnCode = CheckLanguage(m_View, Size, Entry);
+
+		if (true == ReturnCode)
+		{
+			m_Languages[Index].LanguageId	= (WORD)Entry->LanguageId;
+			m_Languages[Index].FirstId		= Entry->FirstId;
+			m_Languages[Index].IdCount		= Entry->IdCount;
+			m_Languages[Index].Offsets		=
+				(const DWORD*)(m_View + Entry->OffsetsOffset);
+			m_Languages[Index].Text			=
+				(LPCTSTR)(m_View + Entry->TextOffset);
+
+			m_LanguageCount = Index + 1;
+		}
+	}
+
+	return ReturnCode;
+}
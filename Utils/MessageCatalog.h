@@ -0,0 +1,72 @@
+/////////////////////////////////////////////////////////////////////////////
+// MessageCatalog.h - Class Declaration
+//
+// Every language's localized strings, mapped read-only from one catalog
+// file.
+//
+// Copyright (c) 2010 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+#include "StringTable.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+struct MessageCatalogLanguage;
+
+/////////////////////////////////////////////////////////////////////////////
+// MessageCatalog Class Definition
+//
+// Maps a string catalog, as written by MakeStringCatalog.py, and uses it
+// in place: nothing is copied, and processes mapping the same file share
+// its pages.  The whole catalog is checked once when opened, so looking
+// up a string is an array lookup, and changing the language only swaps
+// the pointer to the language's table, so is safe while other threads
+// look up strings.  Strings returned are views into the mapping, valid
+// until the catalog is closed.
+/////////////////////////////////////////////////////////////////////////////
+class DllExport MessageCatalog
+{
+	public:
+		// Properties
+
+		// Methods
+			MessageCatalog(void);
+			~MessageCatalog(void);
+
+			void Close(void);
+			WORD GetLanguageId(void) const;
+			LPCTSTR GetString(
+				UINT	StringId,
+				size_t*	Length) const;
+			bool IsOpen(void) const;
+			bool Open(
+				LPCTSTR	CatalogPath,
+				WORD	LanguageId);
+			bool SetLanguage(
+				WORD	LanguageId);
+
+	private:
+		// Properties
+			const BYTE*						m_View;
+			MessageCatalogLanguage*			m_Languages;
+			DWORD							m_LanguageCount;
+			MessageCatalogLanguage* volatile	m_Active;
+
+		// Methods
+			MessageCatalog(
+				const MessageCatalog&);
+			MessageCatalog& operator=(
+				const MessageCatalog&);
+
+			MessageCatalogLanguage* FindLanguage(
+				WORD	LanguageId) const;
+			bool ReadLanguages(
+				DWORD	Size);
+};
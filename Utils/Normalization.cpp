@@ -0,0 +1,634 @@
+/////////////////////////////////////////////////////////////////////////////
+// Normalization.cpp
+//
+// Unicode normalization (NFC / NFD) that does not depend on the OS, built
+// with nothing but the C library off Windows, so it can be tested there.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+// built without the precompiled header, so as not to need Windows
+#include <string.h>
+#include <wchar.h>
+#include "Normalization.h"
+
+#if defined(_WIN32)
+#include "TextScan.h"
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+struct NormalizationProperty
+{
+	unsigned char	CombiningClass;
+	unsigned char	Flags;
+};
+
+struct DecompositionEntry
+{
+	unsigned int	CodePoint;
+	unsigned short	Offset;
+	unsigned char	Length;
+};
+
+struct CompositionEntry
+{
+	unsigned int	First;
+	unsigned int	Second;
+	unsigned int	Composite;
+};
+
+#include "NormalizationData.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+// NormalizationProperty::Flags, must match MakeNormalizationData.py
+#define NFC_QUICK_CHECK_NO		1
+#define NFC_QUICK_CHECK_MAYBE	2
+#define NFD_DECOMPOSES			4
+
+// everything below these is NFC, or NFD, with combining class 0; the
+// first of the Latin-1 letters with accents, U+00C0, decomposes
+#define NFC_SAFE_LIMIT	0x0300
+#define NFD_SAFE_LIMIT	0x00C0
+
+#define LEAD_SURROGATE_FIRST	0xD800
+#define TRAIL_SURROGATE_FIRST	0xDC00
+#define TRAIL_SURROGATE_LAST	0xDFFF
+
+#define HANGUL_S_BASE	0xAC00
+#define HANGUL_L_BASE	0x1100
+#define HANGUL_V_BASE	0x1161
+#define HANGUL_T_BASE	0x11A7
+#define HANGUL_L_COUNT	19
+#define HANGUL_V_COUNT	21
+#define HANGUL_T_COUNT	28
+#define HANGUL_N_COUNT	(HANGUL_V_COUNT * HANGUL_T_COUNT)
+#define HANGUL_S_COUNT	(HANGUL_L_COUNT * HANGUL_N_COUNT)
+
+// no character fully decomposes to more than this many
+#define DECOMPOSITION_MAXIMUM	4
+
+#define SCRATCH_SIZE	256
+
+#if !defined(_WIN32)
+/////////////////////////////////////////////////////////////////////////////
+// GetUnicodeRunLength
+//
+// TextScan's SSE2 version, one unit at a time.
+/////////////////////////////////////////////////////////////////////////////
+static size_t
+	GetUnicodeRunLength(
+	const wchar_t*	String,
+	size_t			Length,
+	wchar_t			Limit)
+{
+	size_t	Index	= 0;
+
+	while ((Index < Length) && (String[Index] < Limit))
+	{
+		Index++;
+	}
+
+	return Index;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// GetProperty
+/////////////////////////////////////////////////////////////////////////////
+static const NormalizationProperty&
+	GetProperty(
+	unsigned int	CodePoint)
+{
+	unsigned char	Property	= 0;
+
+	if (CodePoint < NORMALIZATION_PROPERTY_LIMIT)
+	{
+		unsigned int	Block	= g_NormalizationIndex[CodePoint >> NORMALIZATION_BLOCK_SHIFT];
+
+		Property = g_NormalizationBlocks[(Block << NORMALIZATION_BLOCK_SHIFT) |
+			(CodePoint & ((1 << NORMALIZATION_BLOCK_SHIFT) - 1))];
+	}
+
+	return g_NormalizationProperties[Property];
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetCodePoint
+//
+// Reads one code point and advances Index.  Unpaired surrogates are
+// returned as they are; so are code points where wchar_t is 32 bits.
+/////////////////////////////////////////////////////////////////////////////
+static unsigned int
+	GetCodePoint(
+	const wchar_t*	String,
+	size_t			Length,
+	size_t*			Index)
+{
+	unsigned int	CodePoint	= String[*Index];
+
+	(*Index)++;
+
+	if ((LEAD_SURROGATE_FIRST <= CodePoint) && (CodePoint < TRAIL_SURROGATE_FIRST) &&
+		(*Index < Length) && (TRAIL_SURROGATE_FIRST <= (unsigned int)String[*Index]) &&
+		((unsigned int)String[*Index] <= TRAIL_SURROGATE_LAST))
+	{
+		CodePoint = 0x10000 + ((CodePoint - LEAD_SURROGATE_FIRST) << 10) +
+			((unsigned int)String[*Index] - TRAIL_SURROGATE_FIRST);
+		(*Index)++;
+	}
+
+	return CodePoint;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Compose
+//
+// Returns the primary composite of the pair, or 0 if there is none.
+/////////////////////////////////////////////////////////////////////////////
+static unsigned int
+	Compose(
+	unsigned int	First,
+	unsigned int	Second)
+{
+	unsigned int	Composite	= 0;
+
+	if ((HANGUL_L_BASE <= First) && (First < HANGUL_L_BASE + HANGUL_L_COUNT) &&
+		(HANGUL_V_BASE <= Second) && (Second < HANGUL_V_BASE + HANGUL_V_COUNT))
+	{
+		Composite = HANGUL_S_BASE + ((First - HANGUL_L_BASE) * HANGUL_V_COUNT +
+			(Second - HANGUL_V_BASE)) * HANGUL_T_COUNT;
+	}
+	else if ((HANGUL_S_BASE <= First) && (First < HANGUL_S_BASE + HANGUL_S_COUNT) &&
+		(0 == (First - HANGUL_S_BASE) % HANGUL_T_COUNT) &&
+		(HANGUL_T_BASE < Second) && (Second < HANGUL_T_BASE + HANGUL_T_COUNT))
+	{
+		Composite = First + (Second - HANGUL_T_BASE);
+	}
+	else
+	{
+		size_t	Low		= 0;
+		size_t	High	= sizeof(g_Compositions) / sizeof(g_Compositions[0]);
+
+		while (Low < High)
+		{
+			size_t					Middle	= (Low + High) / 2;
+			const CompositionEntry&	Entry	= g_Compositions[Middle];
+
+			if ((Entry.First < First) ||
+				((Entry.First == First) && (Entry.Second < Second)))
+			{
+				Low = Middle + 1;
+			}
+			else
+			{
+				High = Middle;
+			}
+		}
+
+		if ((Low < sizeof(g_Compositions) / sizeof(g_Compositions[0])) &&
+			(First == g_Compositions[Low].First) &&
+			(Second == g_Compositions[Low].Second))
+		{
+			Composite = g_Compositions[Low].Composite;
+		}
+	}
+
+	return Composite;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Decompose
+//
+// Appends the full canonical decomposition of CodePoint, keeping the
+// combining marks in canonical order.
+/////////////////////////////////////////////////////////////////////////////
+static void
+	Decompose(
+	unsigned int	CodePoint,
+	unsigned int*	Output,
+	size_t*			Count)
+{
+	unsigned int	Parts[DECOMPOSITION_MAXIMUM];
+	size_t			PartCount	= 0;
+
+	if ((HANGUL_S_BASE <= CodePoint) && (CodePoint < HANGUL_S_BASE + HANGUL_S_COUNT))
+	{
+		unsigned int	Index	= CodePoint - HANGUL_S_BASE;
+
+		Parts[PartCount++] = HANGUL_L_BASE + Index / HANGUL_N_COUNT;
+		Parts[PartCount++] = HANGUL_V_BASE + (Index % HANGUL_N_COUNT) / HANGUL_T_COUNT;
+
+		if (0 != Index % HANGUL_T_COUNT)
+		{
+			Parts[PartCount++] = HANGUL_T_BASE + Index % HANGUL_T_COUNT;
+		}
+	}
+	else if (0 != (GetProperty(CodePoint).Flags & NFD_DECOMPOSES))
+	{
+		size_t	Low		= 0;
+		size_t	High	= sizeof(g_Decompositions) / sizeof(g_Decompositions[0]);
+
+		while (Low < High)
+		{
+			size_t	Middle	= (Low + High) / 2;
+
+			if (g_Decompositions[Middle].CodePoint < CodePoint)
+			{
+				Low = Middle + 1;
+			}
+			else
+			{
+				High = Middle;
+			}
+		}
+
+		const DecompositionEntry&	Entry	= g_Decompositions[Low];
+
+		for (unsigned char Part = 0; Part < Entry.Length; Part++)
+		{
+			Parts[PartCount++] = g_DecompositionData[Entry.Offset + Part];
+		}
+	}
+	else
+	{
+		Parts[PartCount++] = CodePoint;
+	}
+
+	for (size_t Part = 0; Part < PartCount; Part++)
+	{
+		unsigned char	Class	= GetProperty(Parts[Part]).CombiningClass;
+		size_t			Index	= *Count;
+
+		if (0 != Class)
+		{
+			// insertion sort, stable for equal classes
+			while ((0 < Index) &&
+				(Class < GetProperty(Output[Index - 1]).CombiningClass))
+			{
+				Output[Index] = Output[Index - 1];
+				Index--;
+			}
+		}
+
+		Output[Index] = Parts[Part];
+		(*Count)++;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ComposeAll
+//
+// Canonical composition, in place, of a decomposed and ordered sequence.
+/////////////////////////////////////////////////////////////////////////////
+static size_t
+	ComposeAll(
+	unsigned int*	CodePoints,
+	size_t			Count)
+{
+	size_t			Starter		= (size_t)-1;
+	unsigned char	LastClass	= 0;
+	size_t			Written		= 0;
+
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		unsigned int	CodePoint	= CodePoints[Index];
+		unsigned char	Class		= GetProperty(CodePoint).CombiningClass;
+
+		if ((size_t)-1 != Starter)
+		{
+			bool	Blocked	= (Written > Starter + 1) &&
+				((0 == LastClass) || (LastClass >= Class));
+
+			if (false == Blocked)
+			{
+				unsigned int	Composite	= Compose(CodePoints[Starter], CodePoint);
+
+				if (0 != Composite)
+				{
+					CodePoints[Starter] = Composite;
+					continue;
+				}
+			}
+		}
+
+		if (0 == Class)
+		{
+			Starter = Written;
+		}
+
+		LastClass				= Class;
+		CodePoints[Written]		= CodePoint;
+		Written++;
+	}
+
+	return Written;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// QuickCheckNormalization
+/////////////////////////////////////////////////////////////////////////////
+QuickCheckResult
+	QuickCheckNormalization(
+	UnicodeForm		Form,
+	const wchar_t*	String,
+	size_t			Length)
+{
+	QuickCheckResult	Result		= QuickCheckYes;
+	unsigned char		LastClass	= 0;
+	size_t				Index		= 0;
+	wchar_t				SafeLimit	= NFC_SAFE_LIMIT;
+
+	if (UnicodeFormD == Form)
+	{
+		SafeLimit = NFD_SAFE_LIMIT;
+	}
+
+	while ((NULL != String) && (Index < Length) && (QuickCheckNo != Result))
+	{
+		if (String[Index] < SafeLimit)
+		{
+			Index		+= GetUnicodeRunLength(String + Index, Length - Index,
+				SafeLimit);
+			LastClass	= 0;
+		}
+		else
+		{
+			const NormalizationProperty&	Property	=
+				GetProperty(GetCodePoint(String, Length, &Index));
+
+			if ((0 != Property.CombiningClass) && (LastClass > Property.CombiningClass))
+			{
+				Result = QuickCheckNo;
+			}
+			else if (UnicodeFormD == Form)
+			{
+				if (0 != (Property.Flags & NFD_DECOMPOSES))
+				{
+					Result = QuickCheckNo;
+				}
+			}
+			else if (0 != (Property.Flags & NFC_QUICK_CHECK_NO))
+			{
+				Result = QuickCheckNo;
+			}
+			else if (0 != (Property.Flags & NFC_QUICK_CHECK_MAYBE))
+			{
+				Result = QuickCheckMaybe;
+			}
+
+			LastClass = Property.CombiningClass;
+		}
+	}
+
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsNormalizedString
+/////////////////////////////////////////////////////////////////////////////
+bool
+	IsNormalizedString(
+	UnicodeForm		Form,
+	const wchar_t*	String,
+	size_t			Length)
+{
+	bool				Normalized	= false;
+	QuickCheckResult	Result		= QuickCheckNormalization(Form, String, Length);
+
+	if (QuickCheckYes == Result)
+	{
+		Normalized = true;
+	}
+	else if (QuickCheckMaybe == Result)
+	{
+		size_t		BufferSize	= GetNormalizedBound(Length);
+		// delete after use
+		wchar_t*	Buffer		= new wchar_t[BufferSize];
+
+		if (NULL != Buffer)
+		{
+			size_t	Written	= NormalizeString(Form, String, Length, Buffer, BufferSize);
+
+			if ((Written == Length) &&
+				(0 == memcmp(Buffer, String, Length * sizeof(wchar_t))))
+			{
+				Normalized = true;
+			}
+
+			delete[] Buffer;
+		}
+	}
+
+	return Normalized;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetNfcSegment
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	GetNfcSegment(
+	const wchar_t*	String,
+	size_t			Length,
+	bool*			Normalized)
+{
+	size_t			Segment			= Length;
+	size_t			LastBoundary	= 0;
+	size_t			Problem			= Length;
+	unsigned char	LastClass		= 0;
+	size_t			Index			= 0;
+
+	*Normalized = true;
+
+	// find the first character that may need composing
+	while (Index < Length)
+	{
+		if (String[Index] < NFC_SAFE_LIMIT)
+		{
+			Index			+= GetUnicodeRunLength(String + Index, Length - Index,
+				NFC_SAFE_LIMIT);
+			LastBoundary	= Index - 1;
+			LastClass		= 0;
+		}
+		else
+		{
+			size_t							Start		= Index;
+			const NormalizationProperty&	Property	=
+				GetProperty(GetCodePoint(String, Length, &Index));
+
+			if ((0 != (Property.Flags & (NFC_QUICK_CHECK_NO | NFC_QUICK_CHECK_MAYBE))) ||
+				((0 != Property.CombiningClass) && (LastClass > Property.CombiningClass)))
+			{
+				Problem = Start;
+				break;
+			}
+
+			if (0 == Property.CombiningClass)
+			{
+				LastBoundary = Start;
+			}
+
+			LastClass = Property.CombiningClass;
+		}
+	}
+
+	if (Problem < Length)
+	{
+		if (0 < LastBoundary)
+		{
+			Segment = LastBoundary;
+		}
+		else
+		{
+			// the piece to compose ends before the next safe starter
+			*Normalized	= false;
+			Index		= Problem;
+
+			GetCodePoint(String, Length, &Index);
+			Segment = Length;
+
+			while (Index < Length)
+			{
+				size_t							Start		= Index;
+				const NormalizationProperty&	Property	=
+					GetProperty(GetCodePoint(String, Length, &Index));
+
+				if ((0 == Property.CombiningClass) &&
+					(0 == (Property.Flags & (NFC_QUICK_CHECK_NO | NFC_QUICK_CHECK_MAYBE))))
+				{
+					Segment = Start;
+					break;
+				}
+			}
+		}
+	}
+
+	return Segment;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetNormalizedBound
+//
+// A UTF-16 unit, or a UTF-32 one, never normalizes to more than four.
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	GetNormalizedBound(
+	size_t	Length)
+{
+	return Length * DECOMPOSITION_MAXIMUM;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NormalizeString
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	NormalizeString(
+	UnicodeForm		Form,
+	const wchar_t*	String,
+	size_t			Length,
+	wchar_t*		Buffer,
+	size_t			BufferSize)
+{
+	size_t	Written	= 0;
+
+	if ((NULL != String) && (NULL != Buffer))
+	{
+		unsigned int	Scratch[SCRATCH_SIZE];
+		unsigned int*	CodePoints	= Scratch;
+		size_t			Count		= 0;
+		bool			Fits		= true;
+
+		if (SCRATCH_SIZE < Length * DECOMPOSITION_MAXIMUM)
+		{
+			// delete after use
+			CodePoints = new unsigned int[Length * DECOMPOSITION_MAXIMUM];
+		}
+
+		if (NULL != CodePoints)
+		{
+			for (size_t Index = 0; Index < Length;)
+			{
+				Decompose(GetCodePoint(String, Length, &Index), CodePoints, &Count);
+			}
+
+			if (UnicodeFormC == Form)
+			{
+				Count = ComposeAll(CodePoints, Count);
+			}
+
+			for (size_t Index = 0; (Index < Count) && (true == Fits); Index++)
+			{
+				unsigned int	CodePoint	= CodePoints[Index];
+
+				if ((2 == sizeof(wchar_t)) && (0x10000 <= CodePoint))
+				{
+					if (Written + 2 <= BufferSize)
+					{
+						CodePoint -= 0x10000;
+						Buffer[Written++] = (wchar_t)(LEAD_SURROGATE_FIRST + (CodePoint >> 10));
+						Buffer[Written++] = (wchar_t)(TRAIL_SURROGATE_FIRST + (CodePoint & 0x3FF));
+					}
+					else
+					{
+						Fits = false;
+					}
+				}
+				else if (Written < BufferSize)
+				{
+					Buffer[Written++] = (wchar_t)CodePoint;
+				}
+				else
+				{
+					Fits = false;
+				}
+			}
+
+			if (false == Fits)
+			{
+				Written = 0;
+			}
+
+			if (Scratch != CodePoints)
+			{
+				delete[] CodePoints;
+			}
+		}
+	}
+
+	return Written;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetNormalizedString
+/////////////////////////////////////////////////////////////////////////////
+wchar_t*
+	GetNormalizedString(
+	UnicodeForm		Form,
+	const wchar_t*	String)
+{
+	wchar_t*	Normalized	= NULL;
+
+	if (NULL != String)
+	{
+		size_t	Length		= wcslen(String);
+		size_t	BufferSize	= GetNormalizedBound(Length);
+
+		Normalized = new wchar_t[BufferSize + 1];
+
+		if (NULL != Normalized)
+		{
+			size_t	Written	= NormalizeString(Form, String, Length, Normalized, BufferSize);
+
+			Normalized[Written] = L'\0';
+		}
+	}
+
+	return Normalized;
+}
@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////////////
+// Normalization.h
+//
+// Unicode normalization (NFC / NFD) that does not depend on the OS, built
+// with nothing but the C library off Windows, so it can be tested there.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+
+#if defined(_WIN32)
+#include "../Include/Common.h"
+#else
+#define DllExport
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+enum UnicodeForm
+{
+	UnicodeFormC,	// canonical composition
+	UnicodeFormD	// canonical decomposition
+};
+
+enum QuickCheckResult
+{
+	QuickCheckYes,
+	QuickCheckNo,
+	QuickCheckMaybe
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// QuickCheckNormalization
+//
+// The Unicode quick check.  Text below U+0300 for NFC, or U+00C0 for NFD,
+// is skipped 8 characters at a time; only QuickCheckMaybe needs a full
+// normalization to be sure.
+/////////////////////////////////////////////////////////////////////////////
+DllExport QuickCheckResult
+QuickCheckNormalization(
+	UnicodeForm		Form,
+	const wchar_t*	String,
+	size_t			Length);
+
+DllExport bool
+IsNormalizedString(
+	UnicodeForm		Form,
+	const wchar_t*	String,
+	size_t			Length);
+
+/////////////////////////////////////////////////////////////////////////////
+// GetNfcSegment
+//
+// Returns the length of the next piece of String that can be handled on
+// its own.  Normalized is set true if the piece is already NFC; otherwise
+// it runs between two safe boundaries and is all that needs composing.
+/////////////////////////////////////////////////////////////////////////////
+DllExport size_t
+GetNfcSegment(
+	const wchar_t*	String,
+	size_t			Length,
+	bool*			Normalized);
+
+/////////////////////////////////////////////////////////////////////////////
+// NormalizeString
+//
+// Returns:		size_t		chars written (no terminator), 0 if the buffer
+//							is too small.  GetNormalizedBound is always
+//							big enough.
+/////////////////////////////////////////////////////////////////////////////
+DllExport size_t
+GetNormalizedBound(
+	size_t	Length);
+DllExport size_t
+NormalizeString(
+	UnicodeForm		Form,
+	const wchar_t*	String,
+	size_t			Length,
+	wchar_t*		Buffer,
+	size_t			BufferSize);
+
+// delete after use
+DllExport wchar_t*
+GetNormalizedString(
+	UnicodeForm		Form,
+	const wchar_t*	String);
@@ -0,0 +1,150 @@
+/////////////////////////////////////////////////////////////////////////////
+// Parallel.cpp
+//
+// Splits a range of work items across the system thread pool.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "Parallel.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+struct ParallelJob
+{
+	ParallelCallback	Callback;
+	void*				Context;
+	// queued slices not yet done; the last to finish sets Done
+	volatile LONG		Pending;
+	HANDLE				Done;
+};
+
+struct ParallelSlice
+{
+	ParallelJob*	Job;
+	size_t			Begin;
+	size_t			End;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// RunSlice
+/////////////////////////////////////////////////////////////////////////////
+static DWORD WINAPI
+	RunSlice(
+	LPVOID	Parameter)
+{
+	ParallelSlice*	Slice	= (ParallelSlice*)Parameter;
+	ParallelJob*	Job		= Slice->Job;
+
+	Job->Callback(Job->Context, Slice->Begin, Slice->End);
+
+	if (0 == InterlockedDecrement(&Job->Pending))
+	{
+		SetEvent(Job->Done);
+	}
+
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetProcessorCount
+/////////////////////////////////////////////////////////////////////////////
+DWORD
+	GetProcessorCount(void)
+{
+	SYSTEM_INFO	SystemInfo;
+
+	GetSystemInfo(&SystemInfo);
+
+	DWORD	Count	= SystemInfo.dwNumberOfProcessors;
+
+	if (0 == Count)
+	{
+		Count = 1;
+	}
+
+	return Count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ParallelFor
+/////////////////////////////////////////////////////////////////////////////
+void
+	ParallelFor(
+	size_t				Count,
+	DWORD				ThreadCount,
+	ParallelCallback	Callback,
+	void*				Context)
+{
+	if ((NULL != Callback) && (0 < Count))
+	{
+		if (0 == ThreadCount)
+		{
+			ThreadCount = GetProcessorCount();
+		}
+
+		if (Count < ThreadCount)
+		{
+			ThreadCount = (DWORD)Count;
+		}
+
+		ParallelJob		Job;
+		ParallelSlice*	Slices	= NULL;
+
+		Job.Callback	= Callback;
+		Job.Context		= Context;
+		Job.Pending		= (LONG)ThreadCount - 1;
+		Job.Done		= NULL;
+
+		if (1 < ThreadCount)
+		{
+			// delete after use
+			Slices		= new ParallelSlice[ThreadCount];
+			Job.Done	= CreateEvent(NULL, TRUE, FALSE, NULL);
+		}
+
+		if ((NULL == Slices) || (NULL == Job.Done))
+		{
+			Callback(Context, 0, Count);
+		}
+		else
+		{
+			for (DWORD Index = 0; Index < ThreadCount; Index++)
+			{
+				Slices[Index].Job	= &Job;
+				Slices[Index].Begin	= (Count * Index) / ThreadCount;
+				Slices[Index].End	= (Count * (Index + 1)) / ThreadCount;
+			}
+
+			for (DWORD Index = 0; Index + 1 < ThreadCount; Index++)
+			{
+				if (FALSE == QueueUserWorkItem(RunSlice, &Slices[Index],
+					WT_EXECUTEDEFAULT))
+				{
+					RunSlice(&Slices[Index]);
+				}
+			}
+
+			Callback(Context, Slices[ThreadCount - 1].Begin,
+				Slices[ThreadCount - 1].End);
+
+			WaitForSingleObject(Job.Done, INFINITE);
+		}
+
+		if (NULL != Job.Done)
+		{
+			CloseHandle(Job.Done);
+		}
+
+		if (NULL != Slices)
+		{
+			delete[] Slices;
+		}
+	}
+}
@@ -0,0 +1,46 @@
+/////////////////////////////////////////////////////////////////////////////
+// Parallel.h
+//
+// Splits a range of work items across the system thread pool.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+// called once per slice with the items [Begin, End)
+typedef void (*ParallelCallback)(
+	void*	Context,
+	size_t	Begin,
+	size_t	End);
+
+/////////////////////////////////////////////////////////////////////////////
+// GetProcessorCount
+/////////////////////////////////////////////////////////////////////////////
+DllExport DWORD
+GetProcessorCount(void);
+
+/////////////////////////////////////////////////////////////////////////////
+// ParallelFor
+//
+// Runs Callback over Count items in ThreadCount slices of equal size.  The
+// other slices are queued to the system thread pool, whose threads persist
+// between calls, and the calling thread does the last slice itself.  If a
+// slice can not be queued, it is run on the calling thread, so every item
+// is always done once the call returns.  A ThreadCount of 0 means one per
+// processor.
+/////////////////////////////////////////////////////////////////////////////
+DllExport void
+ParallelFor(
+	size_t				Count,
+	DWORD				ThreadCount,
+	ParallelCallback	Callback,
+	void*				Context);
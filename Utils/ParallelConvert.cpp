@@ -0,0 +1,469 @@
+/////////////////////////////////////////////////////////////////////////////
+// ParallelConvert.cpp
+//
+// Converts large strings on several threads at once.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "ParallelConvert.h"
+#include "Normalization.h"
+#include "Parallel.h"
+#include "Utils.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+// keeps every count passed to the Win32 calls well inside an int
+#define PARALLEL_CONVERT_CHUNK_MAXIMUM	(64 * 1024 * 1024)
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+struct ConvertJob
+{
+	ULONG			CodePage;
+	DWORD			Flags;
+	bool			ToUnicode;
+	const void*		Input;
+	size_t*			Starts;
+	size_t*			Offsets;
+	void*			Output;
+	volatile LONG	Failed;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// GetMultiByteChunkSplit
+//
+// Returns a character boundary at or before Position, found by looking
+// backwards only, or (size_t)-1 if the code page has no way to do that.
+/////////////////////////////////////////////////////////////////////////////
+static size_t
+	GetMultiByteChunkSplit(
+	ULONG		CodePage,
+	const BYTE*	String,
+	size_t		Position)
+{
+	size_t	Split	= (size_t)-1;
+
+	if (CodePageUtf8 == CodePage)
+	{
+		Split = Position;
+
+		while ((0 < Split) && (0x80 == (String[Split] & 0xC0)))
+		{
+			Split--;
+		}
+	}
+	else if (54936 != CodePage)
+	{
+		CPINFO	CodePageInfo;
+
+		if (FALSE != GetCPInfo(CodePage, &CodePageInfo))
+		{
+			if (1 == CodePageInfo.MaxCharSize)
+			{
+				Split = Position;
+			}
+			else if (2 == CodePageInfo.MaxCharSize)
+			{
+				// the byte before a run of possible lead bytes always ends a
+				// character, so the run pairs up from its start
+				size_t	Run	= 0;
+
+				while ((Run < Position) &&
+					(FALSE != IsDBCSLeadByteEx(CodePage, String[Position - Run - 1])))
+				{
+					Run++;
+				}
+
+				Split = Position - (Run % 2);
+			}
+		}
+	}
+
+	return Split;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetUnicodeChunkSplit
+//
+// Backs up so surrogate pairs, and characters and their combining marks,
+// stay together.
+/////////////////////////////////////////////////////////////////////////////
+static size_t
+	GetUnicodeChunkSplit(
+	LPCWSTR	String,
+	size_t	Position)
+{
+	size_t	Split	= Position;
+
+	while ((0 < Split) &&
+		((IS_HIGH_SURROGATE(String[Split - 1])) ||
+		((0x0300 <= String[Split]) && (String[Split] <= 0x036F))))
+	{
+		Split--;
+	}
+
+	return Split;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// MeasureChunks
+/////////////////////////////////////////////////////////////////////////////
+static void
+	MeasureChunks(
+	void*	Context,
+	size_t	Begin,
+	size_t	End)
+{
+	ConvertJob*	Job	= (ConvertJob*)Context;
+
+	for (size_t Chunk = Begin; Chunk < End; Chunk++)
+	{
+		size_t	Start	= Job->Starts[Chunk];
+		int		Length	= (int)(Job->Starts[Chunk + 1] - Start);
+		int		Size	= 0;
+
+		if (0 < Length)
+		{
+			if (true == Job->ToUnicode)
+			{
+				Size = MultiByteToWideChar(Job->CodePage, Job->Flags,
+					(LPCSTR)Job->Input + Start, Length, NULL, 0);
+			}
+			else
+			{
+				Size = WideCharToMultiByte(Job->CodePage, Job->Flags,
+					(LPCWSTR)Job->Input + Start, Length, NULL, 0, NULL, NULL);
+			}
+
+			if (0 == Size)
+			{
+				InterlockedExchange(&Job->Failed, 1);
+			}
+		}
+
+		Job->Offsets[Chunk + 1] = Size;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ConvertChunks
+/////////////////////////////////////////////////////////////////////////////
+static void
+	ConvertChunks(
+	void*	Context,
+	size_t	Begin,
+	size_t	End)
+{
+	ConvertJob*	Job	= (ConvertJob*)Context;
+
+	for (size_t Chunk = Begin; Chunk < End; Chunk++)
+	{
+		size_t	Start	= Job->Starts[Chunk];
+		int		Length	= (int)(Job->Starts[Chunk + 1] - Start);
+		int		Size	= (int)(Job->Offsets[Chunk + 1] - Job->Offsets[Chunk]);
+		int		Written	= 0;
+
+		if (0 < Length)
+		{
+			if (true == Job->ToUnicode)
+			{
+				Written = MultiByteToWideChar(Job->CodePage, Job->Flags,
+					(LPCSTR)Job->Input + Start, Length,
+					(wchar_t*)Job->Output + Job->Offsets[Chunk], Size);
+			}
+			else
+			{
+				Written = WideCharToMultiByte(Job->CodePage, Job->Flags,
+					(LPCWSTR)Job->Input + Start, Length,
+					(char*)Job->Output + Job->Offsets[Chunk], Size, NULL, NULL);
+			}
+
+			if (Written != Size)
+			{
+				InterlockedExchange(&Job->Failed, 1);
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RunParallelConversion
+//
+// Returns the new output, or NULL if the input can't be split or a chunk
+// failed to convert, in which case the caller converts on one thread.
+/////////////////////////////////////////////////////////////////////////////
+static void*
+	RunParallelConversion(
+	ULONG		CodePage,
+	const void*	Input,
+	size_t		Length,
+	bool		ToUnicode,
+	size_t*		OutputLength,
+	DWORD		ThreadCount)
+{
+	void*	Output	= NULL;
+	size_t	Chunks	= ThreadCount;
+
+	if (Chunks < Length / PARALLEL_CONVERT_CHUNK_MAXIMUM + 1)
+	{
+		Chunks = Length / PARALLEL_CONVERT_CHUNK_MAXIMUM + 1;
+	}
+
+	// delete after use
+	size_t*	Starts	= new size_t[Chunks + 1];
+	size_t*	Offsets	= new size_t[Chunks + 1];
+
+	if ((NULL != Starts) && (NULL != Offsets))
+	{
+		bool	Splittable	= true;
+
+		Starts[0]		= 0;
+		Starts[Chunks]	= Length;
+
+		for (size_t Chunk = 1; Chunk < Chunks; Chunk++)
+		{
+			size_t	Position	= (Length / Chunks) * Chunk;
+			size_t	Split		= 0;
+
+			if (true == ToUnicode)
+			{
+				Split = GetMultiByteChunkSplit(CodePage, (const BYTE*)Input, Position);
+			}
+			else
+			{
+				Split = GetUnicodeChunkSplit((LPCWSTR)Input, Position);
+			}
+
+			if ((size_t)-1 == Split)
+			{
+				Splittable = false;
+				break;
+			}
+
+			if (Split < Starts[Chunk - 1])
+			{
+				Split = Starts[Chunk - 1];
+			}
+
+			Starts[Chunk] = Split;
+		}
+
+		if (true == Splittable)
+		{
+			ConvertJob	Job;
+
+			Job.CodePage	= CodePage;
+			Job.Flags		= MB_PRECOMPOSED;
+			Job.ToUnicode	= ToUnicode;
+			Job.Input		= Input;
+			Job.Starts		= Starts;
+			Job.Offsets		= Offsets;
+			Job.Output		= NULL;
+			Job.Failed		= 0;
+
+			// composing is done up front, see ConvertUnicodeToMultiByte
+			if ((false == ToUnicode) || (false == AllowConversionFlags(CodePage)))
+			{
+				Job.Flags = 0;
+			}
+
+			Offsets[0] = 0;
+
+			ParallelFor(Chunks, ThreadCount, MeasureChunks, &Job);
+
+			if (0 == Job.Failed)
+			{
+				for (size_t Chunk = 0; Chunk < Chunks; Chunk++)
+				{
+					Offsets[Chunk + 1] += Offsets[Chunk];
+				}
+
+				if (true == ToUnicode)
+				{
+					Output = new wchar_t[Offsets[Chunks] + 1];
+				}
+				else
+				{
+					Output = new char[Offsets[Chunks] + 1];
+				}
+			}
+
+			if (NULL != Output)
+			{
+				Job.Output = Output;
+
+				ParallelFor(Chunks, ThreadCount, ConvertChunks, &Job);
+
+				if (0 != Job.Failed)
+				{
+					if (true == ToUnicode)
+					{
+						delete[] (wchar_t*)Output;
+					}
+					else
+					{
+						delete[] (char*)Output;
+					}
+
+					Output = NULL;
+				}
+				else if (true == ToUnicode)
+				{
+					((wchar_t*)Output)[Offsets[Chunks]] = L'\0';
+				}
+				else
+				{
+					((char*)Output)[Offsets[Chunks]] = '\0';
+				}
+			}
+
+			if (NULL != Output)
+			{
+				*OutputLength = Offsets[Chunks];
+			}
+		}
+	}
+
+	if (NULL != Starts)
+	{
+		delete[] Starts;
+	}
+
+	if (NULL != Offsets)
+	{
+		delete[] Offsets;
+	}
+
+	return Output;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ConvertUnicodeToMultiByteParallel
+/////////////////////////////////////////////////////////////////////////////
+char*
+	ConvertUnicodeToMultiByteParallel(
+	ULONG	CodePage,
+	LPCWSTR	UnicodeString,
+	size_t	UnicodeLength,
+	size_t*	MultiByteLength,
+	DWORD	ThreadCount)
+{
+	char*	MultiByteString	= NULL;
+	size_t	Length			= 0;
+
+	if (NULL != UnicodeString)
+	{
+		// If no code page specified, take default for system
+		if ((ULONG)-1 == CodePage)
+		{
+			CodePage = GetACP();
+		}
+
+		if (0 == ThreadCount)
+		{
+			ThreadCount = GetProcessorCount();
+		}
+
+		// text that needs composing goes through the single threaded
+		// path, which composes it piece by piece
+		if ((1 < ThreadCount) &&
+			(PARALLEL_CONVERT_SIZE <= UnicodeLength * sizeof(wchar_t)) &&
+			(false == IsStatefulCodePage(CodePage)) &&
+			((false == AllowConversionFlags(CodePage)) ||
+			(QuickCheckYes == QuickCheckNormalization(UnicodeFormC,
+				UnicodeString, UnicodeLength))))
+		{
+			MultiByteString = (char*)RunParallelConversion(CodePage,
+				UnicodeString, UnicodeLength, false, &Length, ThreadCount);
+		}
+
+		if (NULL == MultiByteString)
+		{
+			size_t	BufferSize	= GetMultiByteBound(CodePage, UnicodeLength);
+
+			MultiByteString = new char[BufferSize + 1];
+
+			if (NULL != MultiByteString)
+			{
+				Length = ConvertUnicodeToMultiByte(CodePage, UnicodeString,
+					UnicodeLength, MultiByteString, BufferSize, NULL);
+
+				MultiByteString[Length] = '\0';
+			}
+		}
+	}
+
+	if (NULL != MultiByteLength)
+	{
+		*MultiByteLength = Length;
+	}
+
+	return MultiByteString;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ConvertMultiByteToUnicodeParallel
+/////////////////////////////////////////////////////////////////////////////
+wchar_t*
+	ConvertMultiByteToUnicodeParallel(
+	ULONG	CodePage,
+	LPCSTR	MultiByteString,
+	size_t	MultiByteLength,
+	size_t*	UnicodeLength,
+	DWORD	ThreadCount)
+{
+	wchar_t*	UnicodeString	= NULL;
+	size_t		Length			= 0;
+
+	if (NULL != MultiByteString)
+	{
+		// If no code page specified, take default for system
+		if ((ULONG)-1 == CodePage)
+		{
+			CodePage = GetACP();
+		}
+
+		if (0 == ThreadCount)
+		{
+			ThreadCount = GetProcessorCount();
+		}
+
+		if ((1 < ThreadCount) &&
+			(PARALLEL_CONVERT_SIZE <= MultiByteLength) &&
+			(false == IsStatefulCodePage(CodePage)))
+		{
+			UnicodeString = (wchar_t*)RunParallelConversion(CodePage,
+				MultiByteString, MultiByteLength, true, &Length, ThreadCount);
+		}
+
+		if (NULL == UnicodeString)
+		{
+			size_t	BufferSize	= GetUnicodeBound(CodePage, MultiByteLength);
+
+			UnicodeString = new wchar_t[BufferSize + 1];
+
+			if (NULL != UnicodeString)
+			{
+				Length = ConvertMultiByteToUnicode(CodePage, MultiByteString,
+					MultiByteLength, UnicodeString, BufferSize, NULL);
+
+				UnicodeString[Length] = L'\0';
+			}
+		}
+	}
+
+	if (NULL != UnicodeLength)
+	{
+		*UnicodeLength = Length;
+	}
+
+	return UnicodeString;
+}
@@ -0,0 +1,47 @@
+/////////////////////////////////////////////////////////////////////////////
+// ParallelConvert.h
+//
+// Converts large strings on several threads at once.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+// inputs smaller than this are converted on the calling thread
+const size_t PARALLEL_CONVERT_SIZE	= 4 * 1024 * 1024;
+
+/////////////////////////////////////////////////////////////////////////////
+// Parallel conversions
+//
+// The input is cut into one chunk per thread, each ending on a whole
+// character.  The chunks are measured in parallel, then converted in
+// parallel straight into their place in one exactly sized result, so the
+// outputs are never copied.  Stateful code pages, and those without a
+// known way to find character boundaries, are converted on one thread.
+//
+// Returns a new terminated string, delete after use, or NULL on failure.
+// A ThreadCount of 0 means one per processor.
+/////////////////////////////////////////////////////////////////////////////
+DllExport char*
+ConvertUnicodeToMultiByteParallel(
+	ULONG	CodePage,
+	LPCWSTR	UnicodeString,
+	size_t	UnicodeLength,
+	size_t*	MultiByteLength,
+	DWORD	ThreadCount);
+DllExport wchar_t*
+ConvertMultiByteToUnicodeParallel(
+	ULONG	CodePage,
+	LPCSTR	MultiByteString,
+	size_t	MultiByteLength,
+	size_t*	UnicodeLength,
+	DWORD	ThreadCount);
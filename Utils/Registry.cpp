@@ -345,4 +345,19 @@ LONG
 	}
 
 	return lRet;
-}
\ No newline at end of file
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Snapshot
+//
+// Reads the key and all of its subkeys at once, for callers that read
+// many values.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	Registry::Snapshot(
+	HKEY				KeyRoot,
+	LPCTSTR				KeyPath,
+	RegistrySnapshot*	Target)
+{
+	return Target->Load(KeyRoot, KeyPath);
+}
@@ -12,6 +12,7 @@
 // Includes
 /////////////////////////////////////////////////////////////////////////////
 #include "Common.h"
+#include "RegistrySnapshot.h"
 
 #define MAX_KEY_LENGTH 255
 
@@ -63,4 +64,8 @@ class DllExport Registry
 				LPCTSTR	RegKeyPath,
 				LPCTSTR	RegKeyVar,
 				DWORD	Value);
+			bool Snapshot(
+				HKEY				KeyRoot,
+				LPCTSTR				KeyPath,
+				RegistrySnapshot*	Target);
 };
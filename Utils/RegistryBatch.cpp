@@ -0,0 +1,809 @@
+/////////////////////////////////////////////////////////////////////////////
+// RegistryBatch.cpp - Class Implementation
+//
+// Registry writes collected and applied together.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include <tchar.h>
+#include "RegistryBatch.h"
+#include "RegistryFile.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+// first operation array size; doubles as needed
+#define BATCH_INDEX_SIZE		256
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+enum OperationKind
+{
+	OperationSetValue,
+	OperationDeleteValue,
+	OperationDeleteKey
+};
+
+// the key path, name and data share one allocation
+struct RegistryOperation
+{
+	int		Kind;
+	HKEY	KeyRoot;
+	TCHAR*	KeyPath;
+	TCHAR*	Name;
+	DWORD	Type;
+	BYTE*	Data;
+	DWORD	DataSize;
+};
+
+typedef HANDLE (WINAPI* CreateTransactionFunction)(LPSECURITY_ATTRIBUTES,
+	LPGUID, DWORD, DWORD, DWORD, DWORD, LPWSTR);
+typedef BOOL (WINAPI* EndTransactionFunction)(HANDLE);
+typedef LONG (WINAPI* RegCreateKeyTransactedFunction)(HKEY, LPCTSTR, DWORD,
+	LPTSTR, DWORD, REGSAM, LPSECURITY_ATTRIBUTES, PHKEY, LPDWORD, HANDLE,
+	PVOID);
+typedef LONG (WINAPI* RegOpenKeyTransactedFunction)(HKEY, LPCTSTR, DWORD,
+	REGSAM, PHKEY, HANDLE, PVOID);
+typedef LONG (WINAPI* RegDeleteKeyTransactedFunction)(HKEY, LPCTSTR, REGSAM,
+	DWORD, HANDLE, PVOID);
+typedef LONG (WINAPI* RegDeleteTreeFunction)(HKEY, LPCTSTR);
+
+#ifdef UNICODE
+#define REG_CREATE_KEY_TRANSACTED	"RegCreateKeyTransactedW"
+#define REG_OPEN_KEY_TRANSACTED		"RegOpenKeyTransactedW"
+#define REG_DELETE_KEY_TRANSACTED	"RegDeleteKeyTransactedW"
+#define REG_DELETE_TREE				"RegDeleteTreeW"
+#else
+#define REG_CREATE_KEY_TRANSACTED	"RegCreateKeyTransactedA"
+#define REG_OPEN_KEY_TRANSACTED		"RegOpenKeyTransactedA"
+#define REG_DELETE_KEY_TRANSACTED	"RegDeleteKeyTransactedA"
+#define REG_DELETE_TREE				"RegDeleteTreeA"
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// BatchWriter Class Definition
+//
+// The state of one Apply: the transaction, if there is one, and the keys
+// opened so far, each of which stays open until the end.
+/////////////////////////////////////////////////////////////////////////////
+class BatchWriter
+{
+	public:
+		// Methods
+			BatchWriter(
+				size_t	MaximumKeys);
+			~BatchWriter(void);
+
+			LONG Begin(void);
+			LONG DeleteKey(
+				HKEY	KeyRoot,
+				LPCTSTR	KeyPath);
+			LONG End(
+				LONG	Result);
+			LONG GetKey(
+				HKEY	KeyRoot,
+				LPCTSTR	KeyPath,
+				bool	Create,
+				HKEY*	Key);
+
+	private:
+		struct OpenKey
+		{
+			HKEY	KeyRoot;
+			LPCTSTR	KeyPath;
+			HKEY	Key;
+		};
+
+		// Properties
+			OpenKey*						m_Keys;
+			size_t							m_KeyCount;
+			size_t							m_KeyCapacity;
+			size_t							m_LastKey;
+			HMODULE							m_KtmLibrary;
+			HANDLE							m_Transaction;
+			CreateTransactionFunction		m_CreateTransaction;
+			EndTransactionFunction			m_CommitTransaction;
+			EndTransactionFunction			m_RollbackTransaction;
+			RegCreateKeyTransactedFunction	m_RegCreateKeyTransacted;
+			RegOpenKeyTransactedFunction	m_RegOpenKeyTransacted;
+			RegDeleteKeyTransactedFunction	m_RegDeleteKeyTransacted;
+			RegDeleteTreeFunction			m_RegDeleteTree;
+
+		// Methods
+			BatchWriter(
+				const BatchWriter&);
+			BatchWriter& operator=(
+				const BatchWriter&);
+
+			void CloseKeys(
+				HKEY	KeyRoot,
+				LPCTSTR	KeyPath);
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// IsSameOrSubKey
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	IsSameOrSubKey(
+	LPCTSTR	KeyPath,
+	LPCTSTR	ParentPath)
+{
+	size_t	ParentLength	= _tcslen(ParentPath);
+
+	return ((0 == _tcsnicmp(KeyPath, ParentPath, ParentLength)) &&
+		((_T('\0') == KeyPath[ParentLength]) ||
+		(_T('\\') == KeyPath[ParentLength]) || (0 == ParentLength)));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BatchWriter Class Implementation
+/////////////////////////////////////////////////////////////////////////////
+BatchWriter::BatchWriter(
+	size_t	MaximumKeys) :
+		m_Keys(NULL),
+		m_KeyCount(0),
+		m_KeyCapacity(MaximumKeys),
+		m_LastKey(0),
+		m_KtmLibrary(NULL),
+		m_Transaction(INVALID_HANDLE_VALUE),
+		m_CreateTransaction(NULL),
+		m_CommitTransaction(NULL),
+		m_RollbackTransaction(NULL),
+		m_RegCreateKeyTransacted(NULL),
+		m_RegOpenKeyTransacted(NULL),
+		m_RegDeleteKeyTransacted(NULL),
+		m_RegDeleteTree(NULL)
+{
+	m_Keys = new OpenKey[MaximumKeys + 1];
+}
+
+BatchWriter::~BatchWriter(void)
+{
+	CloseKeys(NULL, NULL);
+
+	if (NULL != m_Keys)
+	{
+		delete[] m_Keys;
+		m_Keys = NULL;
+	}
+
+	if (INVALID_HANDLE_VALUE != m_Transaction)
+	{
+		CloseHandle(m_Transaction);
+		m_Transaction = INVALID_HANDLE_VALUE;
+	}
+
+	if (NULL != m_KtmLibrary)
+	{
+		FreeLibrary(m_KtmLibrary);
+		m_KtmLibrary = NULL;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Begin
+//
+// Starts a transaction where the registry has them.  The transaction
+// functions are looked up, as they are missing before Vista.
+/////////////////////////////////////////////////////////////////////////////
+LONG
+	BatchWriter::Begin(void)
+{
+	LONG	Result		= ERROR_SUCCESS;
+	HMODULE	Advapi32	= GetModuleHandle(_T("advapi32.dll"));
+
+	if (NULL == m_Keys)
+	{
+		Result = ERROR_OUTOFMEMORY;
+	}
+
+	if ((ERROR_SUCCESS == Result) && (NULL != Advapi32))
+	{
+		m_KtmLibrary = LoadLibrary(_T("ktmw32.dll"));
+	}
+
+	if (NULL != m_KtmLibrary)
+	{
+		m_CreateTransaction = (CreateTransactionFunction)
+			GetProcAddress(m_KtmLibrary, "CreateTransaction");
+		m_CommitTransaction = (EndTransactionFunction)
+			GetProcAddress(m_KtmLibrary, "CommitTransaction");
+		m_RollbackTransaction = (EndTransactionFunction)
+			GetProcAddress(m_KtmLibrary, "RollbackTransaction");
+		m_RegCreateKeyTransacted = (RegCreateKeyTransactedFunction)
+			GetProcAddress(Advapi32, REG_CREATE_KEY_TRANSACTED);
+		m_RegOpenKeyTransacted = (RegOpenKeyTransactedFunction)
+			GetProcAddress(Advapi32, REG_OPEN_KEY_TRANSACTED);
+		m_RegDeleteKeyTransacted = (RegDeleteKeyTransactedFunction)
+			GetProcAddress(Advapi32, REG_DELETE_KEY_TRANSACTED);
+		m_RegDeleteTree = (RegDeleteTreeFunction)
+			GetProcAddress(Advapi32, REG_DELETE_TREE);
+
+		if ((NULL != m_CreateTransaction) && (NULL != m_CommitTransaction) &&
+			(NULL != m_RollbackTransaction) &&
+			(NULL != m_RegCreateKeyTransacted) &&
+			(NULL != m_RegOpenKeyTransacted) &&
+			(NULL != m_RegDeleteKeyTransacted) && (NULL != m_RegDeleteTree))
+		{
+			m_Transaction = m_CreateTransaction(NULL, NULL, 0, 0, 0, 0, NULL);
+
+			if (INVALID_HANDLE_VALUE == m_Transaction)
+			{
+				Result = (LONG)GetLastError();
+			}
+		}
+	}
+
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DeleteKey
+//
+// A key that is already gone is not an error.
+/////////////////////////////////////////////////////////////////////////////
+LONG
+	BatchWriter::DeleteKey(
+	HKEY	KeyRoot,
+	LPCTSTR	KeyPath)
+{
+	LONG	Result	= ERROR_SUCCESS;
+
+	CloseKeys(KeyRoot, KeyPath);
+
+	if (INVALID_HANDLE_VALUE != m_Transaction)
+	{
+		HKEY	Key	= NULL;
+
+		Result = m_RegOpenKeyTransacted(KeyRoot, KeyPath, 0, KEY_ALL_ACCESS,
+			&Key, m_Transaction, NULL);
+
+		if (ERROR_SUCCESS == Result)
+		{
+			// on a transacted handle, the deletion is transacted too
+			Result = m_RegDeleteTree(Key, NULL);
+
+			RegCloseKey(Key);
+		}
+
+		if (ERROR_SUCCESS == Result)
+		{
+			Result = m_RegDeleteKeyTransacted(KeyRoot, KeyPath, 0, 0,
+				m_Transaction, NULL);
+		}
+	}
+	else
+	{
+		Result = SHDeleteKey(KeyRoot, KeyPath);
+	}
+
+	if (ERROR_FILE_NOT_FOUND == Result)
+	{
+		Result = ERROR_SUCCESS;
+	}
+
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// End
+//
+// Commits the transaction if Result is success, and rolls it back if not.
+// Returns the first failure.
+/////////////////////////////////////////////////////////////////////////////
+LONG
+	BatchWriter::End(
+	LONG	Result)
+{
+	// keys are closed before the transaction ends
+	CloseKeys(NULL, NULL);
+
+	if (INVALID_HANDLE_VALUE != m_Transaction)
+	{
+		if (ERROR_SUCCESS == Result)
+		{
+			if (FALSE == m_CommitTransaction(m_Transaction))
+			{
+				Result = (LONG)GetLastError();
+			}
+		}
+		else
+		{
+			m_RollbackTransaction(m_Transaction);
+		}
+	}
+
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetKey
+//
+// Opens the key, or creates it if Create is set, unless it is already
+// open.  Keys are looked up from the last one used, as the writes to one
+// key are usually added together.
+/////////////////////////////////////////////////////////////////////////////
+LONG
+	BatchWriter::GetKey(
+	HKEY	KeyRoot,
+	LPCTSTR	KeyPath,
+	bool	Create,
+	HKEY*	Key)
+{
+	LONG	Result	= ERROR_FILE_NOT_FOUND;
+
+	for (size_t Count = 0; Count < m_KeyCount; Count++)
+	{
+		size_t	Index	= (m_LastKey + m_KeyCount - Count) % m_KeyCount;
+
+		if ((KeyRoot == m_Keys[Index].KeyRoot) &&
+			(0 == _tcsicmp(KeyPath, m_Keys[Index].KeyPath)))
+		{
+			*Key		= m_Keys[Index].Key;
+			m_LastKey	= Index;
+			Result		= ERROR_SUCCESS;
+			break;
+		}
+	}
+
+	if ((ERROR_SUCCESS != Result) && (m_KeyCount < m_KeyCapacity))
+	{
+		DWORD	Disposition	= 0;
+
+		if (INVALID_HANDLE_VALUE != m_Transaction)
+		{
+			if (true == Create)
+			{
+				Result = m_RegCreateKeyTransacted(KeyRoot, KeyPath, 0, NULL,
+					REG_OPTION_NON_VOLATILE, KEY_ALL_ACCESS, NULL, Key,
+					&Disposition, m_Transaction, NULL);
+			}
+			else
+			{
+				Result = m_RegOpenKeyTransacted(KeyRoot, KeyPath, 0,
+					KEY_ALL_ACCESS, Key, m_Transaction, NULL);
+			}
+		}
+		else if (true == Create)
+		{
+			Result = RegCreateKeyEx(KeyRoot, KeyPath, 0, NULL,
+				REG_OPTION_NON_VOLATILE, KEY_ALL_ACCESS, NULL, Key,
+				&Disposition);
+		}
+		else
+		{
+			Result = RegOpenKeyEx(KeyRoot, KeyPath, 0, KEY_ALL_ACCESS, Key);
+		}
+
+		if (ERROR_SUCCESS == Result)
+		{
+			m_Keys[m_KeyCount].KeyRoot	= KeyRoot;
+			m_Keys[m_KeyCount].KeyPath	= KeyPath;
+			m_Keys[m_KeyCount].Key		= *Key;
+			m_LastKey					= m_KeyCount;
+			m_KeyCount++;
+		}
+	}
+
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// CloseKeys
+//
+// Closes the open keys at or under the key, or all of them if KeyPath is
+// NULL.
+/////////////////////////////////////////////////////////////////////////////
+void
+	BatchWriter::CloseKeys(
+	HKEY	KeyRoot,
+	LPCTSTR	KeyPath)
+{
+	size_t	Count	= 0;
+
+	for (size_t Index = 0; Index < m_KeyCount; Index++)
+	{
+		if ((NULL == KeyPath) || ((KeyRoot == m_Keys[Index].KeyRoot) &&
+			(true == IsSameOrSubKey(m_Keys[Index].KeyPath, KeyPath))))
+		{
+			RegCloseKey(m_Keys[Index].Key);
+		}
+		else
+		{
+			m_Keys[Count] = m_Keys[Index];
+			Count++;
+		}
+	}
+
+	m_KeyCount	= Count;
+	m_LastKey	= 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetRootName
+/////////////////////////////////////////////////////////////////////////////
+static LPCTSTR
+	GetRootName(
+	HKEY	KeyRoot)
+{
+	LPCTSTR	Name	= NULL;
+
+	if (HKEY_CLASSES_ROOT == KeyRoot)
+	{
+		Name = _T("HKEY_CLASSES_ROOT");
+	}
+	else if (HKEY_CURRENT_USER == KeyRoot)
+	{
+		Name = _T("HKEY_CURRENT_USER");
+	}
+	else if (HKEY_LOCAL_MACHINE == KeyRoot)
+	{
+		Name = _T("HKEY_LOCAL_MACHINE");
+	}
+	else if (HKEY_USERS == KeyRoot)
+	{
+		Name = _T("HKEY_USERS");
+	}
+	else if (HKEY_CURRENT_CONFIG == KeyRoot)
+	{
+		Name = _T("HKEY_CURRENT_CONFIG");
+	}
+
+	return Name;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+RegistryBatch::RegistryBatch(void) :
+	m_Operations(NULL),
+	m_Count(0),
+	m_Capacity(0)
+{
+}
+
+RegistryBatch::~RegistryBatch(void)
+{
+	Clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Apply
+//
+// Returns the first failure, as a Win32 error code.  The batch is cleared
+// if all the operations were applied, and kept otherwise.
+/////////////////////////////////////////////////////////////////////////////
+LONG
+	RegistryBatch::Apply(void)
+{
+	BatchWriter	Writer(m_Count);
+	LONG		Result	= Writer.Begin();
+
+	for (size_t Index = 0;
+		(ERROR_SUCCESS == Result) && (Index < m_Count); Index++)
+	{
+		RegistryOperation*	Operation	= &m_Operations[Index];
+		HKEY				Key			= NULL;
+
+		if (OperationSetValue == Operation->Kind)
+		{
+			Result = Writer.GetKey(Operation->KeyRoot, Operation->KeyPath,
+				true, &Key);
+
+			if (ERROR_SUCCESS == Result)
+			{
+				Result = RegSetValueEx(Key, Operation->Name, 0,
+					Operation->Type, Operation->Data, Operation->DataSize);
+			}
+		}
+		else if (OperationDeleteValue == Operation->Kind)
+		{
+			Result = Writer.GetKey(Operation->KeyRoot, Operation->KeyPath,
+				false, &Key);
+
+			if (ERROR_SUCCESS == Result)
+			{
+				Result = RegDeleteValue(Key, Operation->Name);
+			}
+
+			// the value, or its key, is already gone
+			if (ERROR_FILE_NOT_FOUND == Result)
+			{
+				Result = ERROR_SUCCESS;
+			}
+		}
+		else
+		{
+			Result = Writer.DeleteKey(Operation->KeyRoot, Operation->KeyPath);
+		}
+	}
+
+	Result = Writer.End(Result);
+
+	if (ERROR_SUCCESS == Result)
+	{
+		Clear();
+	}
+
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ApplyFile
+//
+// Applies the batch to a .reg file, as if it were the registry; the file
+// is created if it does not exist.  Keys are written under their full
+// paths, as regedit does.  The batch is cleared if the file was written.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryBatch::ApplyFile(
+	LPCTSTR	FilePath)
+{
+	bool			ReturnCode	= true;
+	RegistryFile	File;
+
+	for (size_t Index = 0;
+		(true == ReturnCode) && (Index < m_Count); Index++)
+	{
+		RegistryOperation*	Operation	= &m_Operations[Index];
+		LPCTSTR				RootName	= GetRootName(Operation->KeyRoot);
+		size_t				Size		= 0;
+		TCHAR*				Path		= NULL;
+
+		if (NULL != RootName)
+		{
+			Size = _tcslen(RootName) + _tcslen(Operation->KeyPath) + 2;
+			Path = new TCHAR[Size];
+		}
+
+		if (NULL != Path)
+		{
+			_tcscpy_s(Path, Size, RootName);
+
+			if (0 < _tcslen(Operation->KeyPath))
+			{
+				_tcscat_s(Path, Size, _T("\\"));
+				_tcscat_s(Path, Size, Operation->KeyPath);
+			}
+
+			if (OperationSetValue == Operation->Kind)
+			{
+				ReturnCode = File.SetValue(Path, Operation->Name,
+					Operation->Type, Operation->Data, Operation->DataSize);
+			}
+			else if (OperationDeleteValue == Operation->Kind)
+			{
+				ReturnCode = File.Delete(Path, Operation->Name);
+			}
+			else
+			{
+				ReturnCode = File.DeleteKey(Path);
+			}
+
+			delete[] Path;
+		}
+		else
+		{
+			ReturnCode = false;
+		}
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = File.Apply(FilePath);
+	}
+
+	if (true == ReturnCode)
+	{
+		Clear();
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Clear
+/////////////////////////////////////////////////////////////////////////////
+void
+	RegistryBatch::Clear(void)
+{
+	if (NULL != m_Operations)
+	{
+		for (size_t Index = 0; Index < m_Count; Index++)
+		{
+			delete[] (BYTE*)m_Operations[Index].KeyPath;
+		}
+
+		delete[] m_Operations;
+		m_Operations = NULL;
+	}
+
+	m_Count		= 0;
+	m_Capacity	= 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete
+//
+// Deletes one value; a NULL name is the default value.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryBatch::Delete(
+	HKEY	KeyRoot,
+	LPCTSTR	KeyPath,
+	LPCTSTR	Name)
+{
+	return Add(OperationDeleteValue, KeyRoot, KeyPath, Name, REG_NONE, NULL,
+		0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DeleteKey
+//
+// Deletes the key and all of its subkeys.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryBatch::DeleteKey(
+	HKEY	KeyRoot,
+	LPCTSTR	KeyPath)
+{
+	return Add(OperationDeleteKey, KeyRoot, KeyPath, NULL, REG_NONE, NULL, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetCount
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	RegistryBatch::GetCount(void) const
+{
+	return m_Count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SetValue
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryBatch::SetValue(
+	HKEY	KeyRoot,
+	LPCTSTR	KeyPath,
+	LPCTSTR	Name,
+	LPCTSTR	Value)
+{
+	return Add(OperationSetValue, KeyRoot, KeyPath, Name, REG_SZ,
+		(const BYTE*)Value, (DWORD)((_tcslen(Value) + 1) * sizeof(TCHAR)));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SetValue
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryBatch::SetValue(
+	HKEY	KeyRoot,
+	LPCTSTR	KeyPath,
+	LPCTSTR	Name,
+	DWORD	Value)
+{
+	return Add(OperationSetValue, KeyRoot, KeyPath, Name, REG_DWORD,
+		(const BYTE*)&Value, sizeof(DWORD));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SetValue
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryBatch::SetValue(
+	HKEY		KeyRoot,
+	LPCTSTR		KeyPath,
+	LPCTSTR		Name,
+	DWORD		Type,
+	const BYTE*	Data,
+	DWORD		DataSize)
+{
+	return Add(OperationSetValue, KeyRoot, KeyPath, Name, Type, Data,
+		DataSize);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Add
+//
+// Copies the operation's strings and data, so the caller's need not
+// outlive the call.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryBatch::Add(
+	int			Kind,
+	HKEY		KeyRoot,
+	LPCTSTR		KeyPath,
+	LPCTSTR		Name,
+	DWORD		Type,
+	const BYTE*	Data,
+	DWORD		DataSize)
+{
+	bool	ReturnCode	= true;
+	size_t	PathLength	= 0;
+	size_t	NameLength	= 0;
+	BYTE*	Storage		= NULL;
+
+	if (NULL == KeyPath)
+	{
+		KeyPath = _T("");
+	}
+
+	if (NULL == Name)
+	{
+		Name = _T("");
+	}
+
+	PathLength = _tcslen(KeyPath) + 1;
+	NameLength = _tcslen(Name) + 1;
+
+	if (m_Count == m_Capacity)
+	{
+		size_t				Capacity	= BATCH_INDEX_SIZE;
+		RegistryOperation*	Operations	= NULL;
+
+		if (0 < m_Capacity)
+		{
+			Capacity = m_Capacity * 2;
+		}
+
+		Operations = new RegistryOperation[Capacity];
+
+		if (NULL != Operations)
+		{
+			if (NULL != m_Operations)
+			{
+				memcpy(Operations, m_Operations,
+					m_Count * sizeof(RegistryOperation));
+				delete[] m_Operations;
+			}
+
+			m_Operations	= Operations;
+			m_Capacity		= Capacity;
+		}
+		else
+		{
+			ReturnCode = false;
+		}
+	}
+
+	if (true == ReturnCode)
+	{
+		Storage = new BYTE[(PathLength + NameLength) * sizeof(TCHAR) +
+			DataSize];
+
+		ReturnCode = (NULL != Storage);
+	}
+
+	if (true == ReturnCode)
+	{
+		RegistryOperation*	Operation	= &m_Operations[m_Count];
+
+		Operation->Kind		= Kind;
+		Operation->KeyRoot	= KeyRoot;
+		Operation->KeyPath	= (TCHAR*)Storage;
+		Operation->Name		= Operation->KeyPath + PathLength;
+		Operation->Type		= Type;
+		Operation->Data		= (BYTE*)(Operation->Name + NameLength);
+		Operation->DataSize	= DataSize;
+
+		memcpy(Operation->KeyPath, KeyPath, PathLength * sizeof(TCHAR));
+		memcpy(Operation->Name, Name, NameLength * sizeof(TCHAR));
+
+		if (0 < DataSize)
+		{
+			memcpy(Operation->Data, Data, DataSize);
+		}
+
+		m_Count++;
+	}
+
+	return ReturnCode;
+}
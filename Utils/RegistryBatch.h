@@ -0,0 +1,94 @@
+/////////////////////////////////////////////////////////////////////////////
+// RegistryBatch.h - Class Declaration
+//
+// Registry writes collected and applied together.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+struct RegistryOperation;
+
+/////////////////////////////////////////////////////////////////////////////
+// RegistryBatch Class Definition
+//
+// Collects value writes and deletions, across any number of keys, and
+// applies them in the order they were added.  Each key is opened once
+// per Apply, however many values are written to it.
+//
+// Where the registry supports transactions (Vista and later), Apply is
+// all or nothing; elsewhere it stops at the first failure, leaving the
+// writes before it in place.  ApplyFile applies the batch to a .reg file
+// instead, through RegistryFile, which RegistrySnapshot::LoadFile reads
+// back, so that code writing settings can be exercised without a
+// registry; the file is replaced whole, so it too is all or nothing.
+/////////////////////////////////////////////////////////////////////////////
+class DllExport RegistryBatch
+{
+	public:
+		// Properties
+
+		// Methods
+			RegistryBatch(void);
+			~RegistryBatch(void);
+
+			LONG Apply(void);
+			bool ApplyFile(
+				LPCTSTR	FilePath);
+			void Clear(void);
+			bool Delete(
+				HKEY	KeyRoot,
+				LPCTSTR	KeyPath,
+				LPCTSTR	Name);
+			bool DeleteKey(
+				HKEY	KeyRoot,
+				LPCTSTR	KeyPath);
+			size_t GetCount(void) const;
+			bool SetValue(
+				HKEY	KeyRoot,
+				LPCTSTR	KeyPath,
+				LPCTSTR	Name,
+				LPCTSTR	Value);
+			bool SetValue(
+				HKEY	KeyRoot,
+				LPCTSTR	KeyPath,
+				LPCTSTR	Name,
+				DWORD	Value);
+			bool SetValue(
+				HKEY		KeyRoot,
+				LPCTSTR		KeyPath,
+				LPCTSTR		Name,
+				DWORD		Type,
+				const BYTE*	Data,
+				DWORD		DataSize);
+
+	private:
+		// Properties
+			RegistryOperation*	m_Operations;
+			size_t				m_Count;
+			size_t				m_Capacity;
+
+		// Methods
+			RegistryBatch(
+				const RegistryBatch&);
+			RegistryBatch& operator=(
+				const RegistryBatch&);
+
+			bool Add(
+				int			Kind,
+				HKEY		KeyRoot,
+				LPCTSTR		KeyPath,
+				LPCTSTR		Name,
+				DWORD		Type,
+				const BYTE*	Data,
+				DWORD		DataSize);
+};
@@ -0,0 +1,1036 @@
+/////////////////////////////////////////////////////////////////////////////
+// RegistryFile.cpp - Class Implementation
+//
+// Registry writes applied to a .reg file, with nothing but the C library
+// off Windows, so code writing settings is tested there too.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+// built without the precompiled header, so as not to need Windows
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <wctype.h>
+#include "RegistryFile.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+// first edit array size; doubles as needed
+#define FILE_INDEX_SIZE			256
+
+// bytes of hex: data per line of a written file
+#define FILE_HEX_LINE			25
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+enum EditKind
+{
+	EditSetValue,
+	EditDeleteValue,
+	EditDeleteKey
+};
+
+// the key path, name and data share one allocation
+struct RegistryFileEdit
+{
+	int				Kind;
+	wchar_t*		KeyPath;
+	wchar_t*		Name;
+	unsigned int	Type;
+	unsigned char*	Data;
+	unsigned int	DataSize;
+};
+
+// a key, value or deletion in a file, as of the edit with the sequence
+// number; what was already in the file is sequence 0
+struct FileRecord
+{
+	const wchar_t*			KeyPath;
+	// NULL for a key
+	const wchar_t*			Name;
+	int						Kind;
+	unsigned int			Type;
+	const unsigned char*	Data;
+	unsigned int			DataSize;
+	size_t					Sequence;
+};
+
+struct TextBuffer
+{
+	wchar_t*	Text;
+	size_t		Length;
+	size_t		Capacity;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// CompareNoCase
+//
+// Compares at most Maximum characters, folding case as RegistrySnapshot
+// does, so records group as the values read back do.
+/////////////////////////////////////////////////////////////////////////////
+static int
+	CompareNoCase(
+	const wchar_t*	First,
+	const wchar_t*	Second,
+	size_t			Maximum)
+{
+	int	Result	= 0;
+
+	for (size_t Index = 0; (0 == Result) && (Index < Maximum); Index++)
+	{
+		wint_t	FirstCharacter	= towlower((wint_t)First[Index]);
+		wint_t	SecondCharacter	= towlower((wint_t)Second[Index]);
+
+		if (FirstCharacter < SecondCharacter)
+		{
+			Result = -1;
+		}
+		else if (FirstCharacter > SecondCharacter)
+		{
+			Result = 1;
+		}
+		else if (L'\0' == FirstCharacter)
+		{
+			break;
+		}
+	}
+
+	return Result;
+}
+
+static int
+	CompareNoCase(
+	const wchar_t*	First,
+	const wchar_t*	Second)
+{
+	return CompareNoCase(First, Second, (size_t)-1);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// EncodeUtf16
+//
+// Writes the text as little endian UTF-16, splitting characters outside
+// the BMP where wchar_t is 32 bits.  Returns the bytes written, at most
+// 4 per character.
+/////////////////////////////////////////////////////////////////////////////
+static size_t
+	EncodeUtf16(
+	const wchar_t*	Text,
+	size_t			Length,
+	unsigned char*	Bytes)
+{
+	size_t	Size	= 0;
+
+	for (size_t Index = 0; Index < Length; Index++)
+	{
+		unsigned int	Character	= (unsigned int)Text[Index];
+
+		if ((0x10000 <= Character) && (0x10FFFF >= Character))
+		{
+			unsigned int	Lead	= 0xD800 + ((Character - 0x10000) >> 10);
+
+			Bytes[Size]		= (unsigned char)(Lead & 0xFF);
+			Bytes[Size + 1]	= (unsigned char)(Lead >> 8);
+			Size += 2;
+
+			Character = 0xDC00 + ((Character - 0x10000) & 0x3FF);
+		}
+
+		Bytes[Size]		= (unsigned char)(Character & 0xFF);
+		Bytes[Size + 1]	= (unsigned char)((Character >> 8) & 0xFF);
+		Size += 2;
+	}
+
+	return Size;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsSameOrSubKey
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	IsSameOrSubKey(
+	const wchar_t*	KeyPath,
+	const wchar_t*	ParentPath)
+{
+	size_t	ParentLength	= wcslen(ParentPath);
+
+	return ((0 == CompareNoCase(KeyPath, ParentPath, ParentLength)) &&
+		((L'\0' == KeyPath[ParentLength]) ||
+		(L'\\' == KeyPath[ParentLength]) || (0 == ParentLength)));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AppendText
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	AppendText(
+	TextBuffer*		Buffer,
+	const wchar_t*	Text,
+	size_t			Length)
+{
+	bool	ReturnCode	= true;
+
+	if (Buffer->Length + Length + 1 > Buffer->Capacity)
+	{
+		size_t		Capacity	= Buffer->Capacity * 2;
+		wchar_t*	Text		= NULL;
+
+		if (Capacity < Buffer->Length + Length + 1)
+		{
+			Capacity = Buffer->Length + Length + 1;
+		}
+
+		Text = new wchar_t[Capacity];
+
+		if (NULL != Text)
+		{
+			if (NULL != Buffer->Text)
+			{
+				memcpy(Text, Buffer->Text, Buffer->Length * sizeof(wchar_t));
+				delete[] Buffer->Text;
+			}
+
+			Buffer->Text		= Text;
+			Buffer->Capacity	= Capacity;
+		}
+		else
+		{
+			ReturnCode = false;
+		}
+	}
+
+	if (true == ReturnCode)
+	{
+		memcpy(Buffer->Text + Buffer->Length, Text, Length * sizeof(wchar_t));
+		Buffer->Length += Length;
+		Buffer->Text[Buffer->Length] = L'\0';
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AppendHex
+//
+// Writes the number in lower case hex, padded with zeros to Digits.
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	AppendHex(
+	TextBuffer*		Buffer,
+	unsigned int	Number,
+	size_t			Digits)
+{
+	static const wchar_t	HexDigits[]	= L"0123456789abcdef";
+	wchar_t					Text[8];
+	size_t					Length		= 0;
+
+	do
+	{
+		Text[7 - Length] = HexDigits[Number & 0xF];
+		Number >>= 4;
+		Length++;
+	}
+	while ((0 != Number) || (Length < Digits));
+
+	return AppendText(Buffer, Text + 8 - Length, Length);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AppendQuoted
+//
+// Quotes the string, escaping backslashes and quotes.
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	AppendQuoted(
+	TextBuffer*		Buffer,
+	const wchar_t*	Text,
+	size_t			Length)
+{
+	bool	ReturnCode	= AppendText(Buffer, L"\"", 1);
+	size_t	Start		= 0;
+
+	for (size_t Index = 0; (true == ReturnCode) && (Index < Length); Index++)
+	{
+		if ((L'\\' == Text[Index]) || (L'"' == Text[Index]))
+		{
+			ReturnCode = (AppendText(Buffer, Text + Start, Index - Start) &&
+				AppendText(Buffer, L"\\", 1));
+			Start = Index;
+		}
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = (AppendText(Buffer, Text + Start, Length - Start) &&
+			AppendText(Buffer, L"\"", 1));
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AppendValue
+//
+// Writes one value line as regedit does: REG_SZ quoted, REG_DWORD as
+// dword:, and anything else as hex bytes, with strings in UTF-16.
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	AppendValue(
+	TextBuffer*			Buffer,
+	const FileRecord*	Record)
+{
+	bool	ReturnCode	= true;
+	size_t	NameLength	= wcslen(Record->Name);
+
+	if (0 == NameLength)
+	{
+		ReturnCode = AppendText(Buffer, L"@=", 2);
+	}
+	else
+	{
+		ReturnCode = (AppendQuoted(Buffer, Record->Name, NameLength) &&
+			AppendText(Buffer, L"=", 1));
+	}
+
+	if (true == ReturnCode)
+	{
+		if (REG_SZ == Record->Type)
+		{
+			const wchar_t*	String	= (const wchar_t*)Record->Data;
+			size_t			Length	= 0;
+
+			while ((Length < Record->DataSize / sizeof(wchar_t)) &&
+				(L'\0' != String[Length]))
+			{
+				Length++;
+			}
+
+			ReturnCode = AppendQuoted(Buffer, String, Length);
+		}
+		else if ((REG_DWORD == Record->Type) &&
+			(sizeof(unsigned int) == Record->DataSize))
+		{
+			unsigned int	Number	= 0;
+
+			memcpy(&Number, Record->Data, sizeof(unsigned int));
+
+			ReturnCode = (AppendText(Buffer, L"dword:", 6) &&
+				AppendHex(Buffer, Number, 8));
+		}
+		else
+		{
+			const unsigned char*	Bytes	= Record->Data;
+			unsigned char*			Encoded	= NULL;
+			size_t					Size	= Record->DataSize;
+
+			if (REG_BINARY == Record->Type)
+			{
+				ReturnCode = AppendText(Buffer, L"hex:", 4);
+			}
+			else
+			{
+				ReturnCode = (AppendText(Buffer, L"hex(", 4) &&
+					AppendHex(Buffer, Record->Type, 1) &&
+					AppendText(Buffer, L"):", 2));
+			}
+
+			// the file holds UTF-16 strings
+			if ((true == ReturnCode) && (2 != sizeof(wchar_t)) &&
+				((REG_EXPAND_SZ == Record->Type) ||
+				(REG_MULTI_SZ == Record->Type)))
+			{
+				Encoded = new unsigned char[Record->DataSize + 1];
+
+				if (NULL != Encoded)
+				{
+					Bytes	= Encoded;
+					Size	= EncodeUtf16((const wchar_t*)Record->Data,
+						Record->DataSize / sizeof(wchar_t), Encoded);
+				}
+				else
+				{
+					ReturnCode = false;
+				}
+			}
+
+			for (size_t Index = 0;
+				(true == ReturnCode) && (Index < Size); Index++)
+			{
+				if ((0 < Index) && (0 == Index % FILE_HEX_LINE))
+				{
+					ReturnCode = AppendText(Buffer, L",\\\r\n  ", 6);
+				}
+				else if (0 < Index)
+				{
+					ReturnCode = AppendText(Buffer, L",", 1);
+				}
+
+				if (true == ReturnCode)
+				{
+					ReturnCode = AppendHex(Buffer, Bytes[Index], 2);
+				}
+			}
+
+			if (NULL != Encoded)
+			{
+				delete[] Encoded;
+			}
+		}
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = AppendText(Buffer, L"\r\n", 2);
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// CompareRecords
+//
+// By key path, with the key itself first, then by value name, and last
+// by sequence, so the last record of a run is the one that stands.
+/////////////////////////////////////////////////////////////////////////////
+static int
+	CompareRecords(
+	const void*	First,
+	const void*	Second)
+{
+	const FileRecord*	FirstRecord		= (const FileRecord*)First;
+	const FileRecord*	SecondRecord	= (const FileRecord*)Second;
+	int					Result			= CompareNoCase(FirstRecord->KeyPath,
+		SecondRecord->KeyPath);
+
+	if ((0 == Result) && (FirstRecord->Name != SecondRecord->Name))
+	{
+		if (NULL == FirstRecord->Name)
+		{
+			Result = -1;
+		}
+		else if (NULL == SecondRecord->Name)
+		{
+			Result = 1;
+		}
+		else
+		{
+			Result = CompareNoCase(FirstRecord->Name, SecondRecord->Name);
+		}
+	}
+
+	if (0 == Result)
+	{
+		if (FirstRecord->Sequence < SecondRecord->Sequence)
+		{
+			Result = -1;
+		}
+		else if (FirstRecord->Sequence > SecondRecord->Sequence)
+		{
+			Result = 1;
+		}
+	}
+
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsDeleted
+//
+// Whether a key deleted after the sequence number holds the key path.
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	IsDeleted(
+	const wchar_t*		KeyPath,
+	size_t				Sequence,
+	const FileRecord*	Deletions,
+	size_t				DeletionCount)
+{
+	bool	Deleted	= false;
+
+	for (size_t Index = 0; Index < DeletionCount; Index++)
+	{
+		if ((Deletions[Index].Sequence > Sequence) &&
+			(true == IsSameOrSubKey(KeyPath, Deletions[Index].KeyPath)))
+		{
+			Deleted = true;
+			break;
+		}
+	}
+
+	return Deleted;
+}
+
+#if !defined(_WIN32)
+/////////////////////////////////////////////////////////////////////////////
+// GetNarrowPath
+//
+// The path in the locale's multibyte encoding, for the caller to delete,
+// or NULL if it has none.
+/////////////////////////////////////////////////////////////////////////////
+static char*
+	GetNarrowPath(
+	const wchar_t*	FilePath)
+{
+	size_t	Size	= wcslen(FilePath) * MB_CUR_MAX + 1;
+	char*	Path	= new char[Size];
+
+	if ((NULL != Path) && ((size_t)-1 == wcstombs(Path, FilePath, Size)))
+	{
+		delete[] Path;
+		Path = NULL;
+	}
+
+	return Path;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// OpenPath / FlushFile / ReplacePath / RemovePath
+//
+// The file operations that differ by platform.  ReplacePath moves one
+// file over another in one step, so the other is never half written.
+/////////////////////////////////////////////////////////////////////////////
+static FILE*
+	OpenPath(
+	const wchar_t*	FilePath,
+	bool			Write)
+{
+	FILE*	File	= NULL;
+
+#if defined(_WIN32)
+	File = _wfopen(FilePath, (true == Write) ? L"wb" : L"rb");
+#else
+	char*	Path	= GetNarrowPath(FilePath);
+
+	if (NULL != Path)
+	{
+		File = fopen(Path, (true == Write) ? "wb" : "rb");
+
+		delete[] Path;
+	}
+#endif
+
+	return File;
+}
+
+static bool
+	FlushFile(
+	FILE*	File)
+{
+	bool	ReturnCode	= (0 == fflush(File));
+
+	if (true == ReturnCode)
+	{
+#if defined(_WIN32)
+		ReturnCode = (0 == _commit(_fileno(File)));
+#else
+		ReturnCode = (0 == fsync(fileno(File)));
+#endif
+	}
+
+	return ReturnCode;
+}
+
+static bool
+	ReplacePath(
+	const wchar_t*	SourcePath,
+	const wchar_t*	TargetPath)
+{
+	bool	ReturnCode	= false;
+
+#if defined(_WIN32)
+	ReturnCode = (FALSE != MoveFileExW(SourcePath, TargetPath,
+		MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH));
+#else
+	char*	Source	= GetNarrowPath(SourcePath);
+	char*	Target	= GetNarrowPath(TargetPath);
+
+	if ((NULL != Source) && (NULL != Target))
+	{
+		ReturnCode = (0 == rename(Source, Target));
+	}
+
+	if (NULL != Source)
+	{
+		delete[] Source;
+	}
+
+	if (NULL != Target)
+	{
+		delete[] Target;
+	}
+#endif
+
+	return ReturnCode;
+}
+
+static void
+	RemovePath(
+	const wchar_t*	FilePath)
+{
+#if defined(_WIN32)
+	_wremove(FilePath);
+#else
+	char*	Path	= GetNarrowPath(FilePath);
+
+	if (NULL != Path)
+	{
+		remove(Path);
+
+		delete[] Path;
+	}
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// WriteFileText
+//
+// Writes the text as UTF-16 next to the file, then moves it over the
+// file, so the file is never seen half written.
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	WriteFileText(
+	const wchar_t*	FilePath,
+	const wchar_t*	Text,
+	size_t			Length)
+{
+	bool			ReturnCode	= false;
+	size_t			PathLength	= wcslen(FilePath);
+	wchar_t*		TempPath	= new wchar_t[PathLength + 5];
+	// the byte order mark, then at most a surrogate pair per character
+	unsigned char*	Bytes		= new unsigned char[Length * 4 + 2];
+
+	if ((NULL != TempPath) && (NULL != Bytes))
+	{
+		size_t	Size	= 2;
+		FILE*	File	= NULL;
+
+		memcpy(TempPath, FilePath, PathLength * sizeof(wchar_t));
+		memcpy(TempPath + PathLength, L".new", 5 * sizeof(wchar_t));
+
+		Bytes[0] = 0xFF;
+		Bytes[1] = 0xFE;
+
+		Size += EncodeUtf16(Text, Length, Bytes + 2);
+
+		File = OpenPath(TempPath, true);
+
+		if (NULL != File)
+		{
+			ReturnCode = ((Size == fwrite(Bytes, 1, Size, File)) &&
+				(true == FlushFile(File)));
+
+			if (0 != fclose(File))
+			{
+				ReturnCode = false;
+			}
+
+			if (true == ReturnCode)
+			{
+				ReturnCode = ReplacePath(TempPath, FilePath);
+			}
+
+			if (false == ReturnCode)
+			{
+				RemovePath(TempPath);
+			}
+		}
+	}
+
+	if (NULL != TempPath)
+	{
+		delete[] TempPath;
+	}
+
+	if (NULL != Bytes)
+	{
+		delete[] Bytes;
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+RegistryFile::RegistryFile(void) :
+	m_Edits(NULL),
+	m_Count(0),
+	m_Capacity(0)
+{
+}
+
+RegistryFile::~RegistryFile(void)
+{
+	Clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Apply
+//
+// Applies the edits to the .reg file, as if it were the registry; the
+// file is created if it does not exist.  The edits are cleared if the
+// file was written.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryFile::Apply(
+	const wchar_t*	FilePath)
+{
+	bool				ReturnCode		= true;
+	RegistrySnapshot	Existing;
+	FILE*				File			= NULL;
+	FileRecord*			Records			= NULL;
+	FileRecord*			Deletions		= NULL;
+	size_t				RecordCount		= 0;
+	size_t				DeletionCount	= 0;
+	TextBuffer			Buffer			= { NULL, 0, 0 };
+
+	errno	= 0;
+	File	= OpenPath(FilePath, false);
+
+	if (NULL != File)
+	{
+		fclose(File);
+
+		// a file that can not be read is left alone
+		ReturnCode = Existing.LoadFile(FilePath, NULL);
+	}
+	else if (ENOENT != errno)
+	{
+		ReturnCode = false;
+	}
+
+	if (true == ReturnCode)
+	{
+		size_t	MaximumRecords	= Existing.GetKeyCount() +
+			Existing.GetValueCount() + m_Count * 2;
+
+		Records		= new FileRecord[MaximumRecords + 1];
+		Deletions	= new FileRecord[m_Count + 1];
+
+		ReturnCode = ((NULL != Records) && (NULL != Deletions));
+	}
+
+	if (true == ReturnCode)
+	{
+		for (size_t Index = 0; Index < Existing.GetKeyCount(); Index++)
+		{
+			FileRecord*	Record	= &Records[RecordCount];
+
+			memset(Record, 0, sizeof(FileRecord));
+			Record->KeyPath = Existing.GetKeyPath(Index);
+			RecordCount++;
+		}
+
+		for (size_t Index = 0; Index < Existing.GetValueCount(); Index++)
+		{
+			const RegistryValue*	Value	= Existing.GetValue(Index);
+			FileRecord*				Record	= &Records[RecordCount];
+
+			Record->KeyPath		= Value->KeyPath;
+			Record->Name		= Value->Name;
+			Record->Kind		= EditSetValue;
+			Record->Type		= Value->Type;
+			Record->Data		= Value->Data;
+			Record->DataSize	= Value->DataSize;
+			Record->Sequence	= 0;
+			RecordCount++;
+		}
+
+		for (size_t Index = 0; Index < m_Count; Index++)
+		{
+			RegistryFileEdit*	Edit	= &m_Edits[Index];
+			FileRecord*			Record	= &Records[RecordCount];
+
+			if (EditDeleteKey == Edit->Kind)
+			{
+				Record = &Deletions[DeletionCount];
+				DeletionCount++;
+			}
+			else
+			{
+				RecordCount++;
+			}
+
+			Record->KeyPath		= Edit->KeyPath;
+			Record->Name		= Edit->Name;
+			Record->Kind		= Edit->Kind;
+			Record->Type		= Edit->Type;
+			Record->Data		= Edit->Data;
+			Record->DataSize	= Edit->DataSize;
+			Record->Sequence	= Index + 1;
+
+			// setting a value creates its key
+			if (EditSetValue == Edit->Kind)
+			{
+				Records[RecordCount] = *Record;
+				Records[RecordCount].Name = NULL;
+				RecordCount++;
+			}
+		}
+
+		qsort(Records, RecordCount, sizeof(FileRecord), CompareRecords);
+
+		ReturnCode = AppendText(&Buffer,
+			L"Windows Registry Editor Version 5.00\r\n", 38);
+	}
+
+	for (size_t KeyStart = 0;
+		(true == ReturnCode) && (KeyStart < RecordCount);)
+	{
+		const wchar_t*	KeyPath		= Records[KeyStart].KeyPath;
+		size_t			KeyEnd		= KeyStart;
+		size_t			Index		= KeyStart;
+
+		while ((KeyEnd < RecordCount) &&
+			(0 == CompareNoCase(KeyPath, Records[KeyEnd].KeyPath)))
+		{
+			KeyEnd++;
+		}
+
+		// the key records come first; the last says when it was created
+		while ((Index < KeyEnd) && (NULL == Records[Index].Name))
+		{
+			Index++;
+		}
+
+		if ((KeyStart < Index) && (false == IsDeleted(KeyPath,
+			Records[Index - 1].Sequence, Deletions, DeletionCount)))
+		{
+			ReturnCode = (AppendText(&Buffer, L"\r\n[", 3) &&
+				AppendText(&Buffer, KeyPath, wcslen(KeyPath)) &&
+				AppendText(&Buffer, L"]\r\n", 3));
+
+			while ((true == ReturnCode) && (Index < KeyEnd))
+			{
+				size_t	Last	= Index;
+
+				while ((Last + 1 < KeyEnd) && (0 == CompareNoCase(
+					Records[Index].Name, Records[Last + 1].Name)))
+				{
+					Last++;
+				}
+
+				if ((EditSetValue == Records[Last].Kind) &&
+					(false == IsDeleted(KeyPath, Records[Last].Sequence,
+					Deletions, DeletionCount)))
+				{
+					ReturnCode = AppendValue(&Buffer, &Records[Last]);
+				}
+
+				Index = Last + 1;
+			}
+		}
+
+		KeyStart = KeyEnd;
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = WriteFileText(FilePath, Buffer.Text, Buffer.Length);
+	}
+
+	if (true == ReturnCode)
+	{
+		Clear();
+	}
+
+	if (NULL != Buffer.Text)
+	{
+		delete[] Buffer.Text;
+	}
+
+	if (NULL != Records)
+	{
+		delete[] Records;
+	}
+
+	if (NULL != Deletions)
+	{
+		delete[] Deletions;
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Clear
+/////////////////////////////////////////////////////////////////////////////
+void
+	RegistryFile::Clear(void)
+{
+	if (NULL != m_Edits)
+	{
+		for (size_t Index = 0; Index < m_Count; Index++)
+		{
+			delete[] (unsigned char*)m_Edits[Index].KeyPath;
+		}
+
+		delete[] m_Edits;
+		m_Edits = NULL;
+	}
+
+	m_Count		= 0;
+	m_Capacity	= 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Delete
+//
+// Deletes one value; a NULL name is the default value.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryFile::Delete(
+	const wchar_t*	KeyPath,
+	const wchar_t*	Name)
+{
+	return Add(EditDeleteValue, KeyPath, Name, REG_NONE, NULL, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DeleteKey
+//
+// Deletes the key and all of its subkeys.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryFile::DeleteKey(
+	const wchar_t*	KeyPath)
+{
+	return Add(EditDeleteKey, KeyPath, NULL, REG_NONE, NULL, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetCount
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	RegistryFile::GetCount(void) const
+{
+	return m_Count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SetValue
+//
+// String data is wchar_t, as RegistrySnapshot holds it; it is written to
+// the file in UTF-16.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryFile::SetValue(
+	const wchar_t*			KeyPath,
+	const wchar_t*			Name,
+	unsigned int			Type,
+	const unsigned char*	Data,
+	unsigned int			DataSize)
+{
+	return Add(EditSetValue, KeyPath, Name, Type, Data, DataSize);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Add
+//
+// Copies the edit's strings and data, so the caller's need not outlive
+// the call.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistryFile::Add(
+	int						Kind,
+	const wchar_t*			KeyPath,
+	const wchar_t*			Name,
+	unsigned int			Type,
+	const unsigned char*	Data,
+	unsigned int			DataSize)
+{
+	bool			ReturnCode	= true;
+	size_t			PathLength	= 0;
+	size_t			NameLength	= 0;
+	unsigned char*	Storage		= NULL;
+
+	if (NULL == KeyPath)
+	{
+		KeyPath = L"";
+	}
+
+	if (NULL == Name)
+	{
+		Name = L"";
+	}
+
+	PathLength = wcslen(KeyPath) + 1;
+	NameLength = wcslen(Name) + 1;
+
+	if (m_Count == m_Capacity)
+	{
+		size_t				Capacity	= FILE_INDEX_SIZE;
+		RegistryFileEdit*	Edits		= NULL;
+
+		if (0 < m_Capacity)
+		{
+			Capacity = m_Capacity * 2;
+		}
+
+		Edits = new RegistryFileEdit[Capacity];
+
+		if (NULL != Edits)
+		{
+			if (NULL != m_Edits)
+			{
+				memcpy(Edits, m_Edits, m_Count * sizeof(RegistryFileEdit));
+				delete[] m_Edits;
+			}
+
+			m_Edits		= Edits;
+			m_Capacity	= Capacity;
+		}
+		else
+		{
+			ReturnCode = false;
+		}
+	}
+
+	if (true == ReturnCode)
+	{
+		Storage = new unsigned char[(PathLength + NameLength) *
+			sizeof(wchar_t) + DataSize];
+
+		ReturnCode = (NULL != Storage);
+	}
+
+	if (true == ReturnCode)
+	{
+		RegistryFileEdit*	Edit	= &m_Edits[m_Count];
+
+		Edit->Kind		= Kind;
+		Edit->KeyPath	= (wchar_t*)Storage;
+		Edit->Name		= Edit->KeyPath + PathLength;
+		Edit->Type		= Type;
+		Edit->Data		= (unsigned char*)(Edit->Name + NameLength);
+		Edit->DataSize	= DataSize;
+
+		memcpy(Edit->KeyPath, KeyPath, PathLength * sizeof(wchar_t));
+		memcpy(Edit->Name, Name, NameLength * sizeof(wchar_t));
+
+		if (0 < DataSize)
+		{
+			memcpy(Edit->Data, Data, DataSize);
+		}
+
+		m_Count++;
+	}
+
+	return ReturnCode;
+}
@@ -0,0 +1,77 @@
+/////////////////////////////////////////////////////////////////////////////
+// RegistryFile.h - Class Declaration
+//
+// Registry writes applied to a .reg file, with nothing but the C library
+// off Windows, so code writing settings is tested there too.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include "RegistrySnapshot.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+struct RegistryFileEdit;
+
+/////////////////////////////////////////////////////////////////////////////
+// RegistryFile Class Definition
+//
+// Collects value writes and deletions, by full key path, as in
+// "HKEY_CURRENT_USER\Software\Zenware", and applies them in the order
+// they were added to what a .reg file already holds, as RegistryBatch
+// applies them to the registry.  The file is written as regedit writes
+// it, in UTF-16, next to the old one, then moved over it, so it is
+// replaced whole or not at all.
+/////////////////////////////////////////////////////////////////////////////
+class DllExport RegistryFile
+{
+	public:
+		// Properties
+
+		// Methods
+			RegistryFile(void);
+			~RegistryFile(void);
+
+			bool Apply(
+				const wchar_t*	FilePath);
+			void Clear(void);
+			bool Delete(
+				const wchar_t*	KeyPath,
+				const wchar_t*	Name);
+			bool DeleteKey(
+				const wchar_t*	KeyPath);
+			size_t GetCount(void) const;
+			bool SetValue(
+				const wchar_t*			KeyPath,
+				const wchar_t*			Name,
+				unsigned int			Type,
+				const unsigned char*	Data,
+				unsigned int			DataSize);
+
+	private:
+		// Properties
+			RegistryFileEdit*	m_Edits;
+			size_t				m_Count;
+			size_t				m_Capacity;
+
+		// Methods
+			RegistryFile(
+				const RegistryFile&);
+			RegistryFile& operator=(
+				const RegistryFile&);
+
+			bool Add(
+				int						Kind,
+				const wchar_t*			KeyPath,
+				const wchar_t*			Name,
+				unsigned int			Type,
+				const unsigned char*	Data,
+				unsigned int			DataSize);
+};
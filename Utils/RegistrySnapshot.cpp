@@ -0,0 +1,1534 @@
+/////////////////////////////////////////////////////////////////////////////
+// RegistrySnapshot.cpp - Class Implementation
+//
+// A registry key and everything under it, read at once into memory.  All
+// but Load needs nothing but the C library, so .reg files are read, and
+// tested, off Windows too.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+// built without the precompiled header, so as not to need Windows
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <wctype.h>
+#include "RegistrySnapshot.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+// first arena and index sizes; both double as needed
+#define SNAPSHOT_ARENA_SIZE		(64 * 1024)
+#define SNAPSHOT_INDEX_SIZE		256
+
+// values start on this boundary, so QWORD data can be read in place
+#define SNAPSHOT_ALIGNMENT		8
+
+/////////////////////////////////////////////////////////////////////////////
+// CompareNoCase
+//
+// Compares at most Maximum characters, folding case as _wcsnicmp does in
+// the C locale, so the order is the same everywhere.
+/////////////////////////////////////////////////////////////////////////////
+static int
+	CompareNoCase(
+	const wchar_t*	First,
+	const wchar_t*	Second,
+	size_t			Maximum)
+{
+	int	Result	= 0;
+
+	for (size_t Index = 0; (0 == Result) && (Index < Maximum); Index++)
+	{
+		wint_t	FirstCharacter	= towlower((wint_t)First[Index]);
+		wint_t	SecondCharacter	= towlower((wint_t)Second[Index]);
+
+		if (FirstCharacter < SecondCharacter)
+		{
+			Result = -1;
+		}
+		else if (FirstCharacter > SecondCharacter)
+		{
+			Result = 1;
+		}
+		else if (L'\0' == FirstCharacter)
+		{
+			break;
+		}
+	}
+
+	return Result;
+}
+
+static int
+	CompareNoCase(
+	const wchar_t*	First,
+	const wchar_t*	Second)
+{
+	return CompareNoCase(First, Second, (size_t)-1);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// CompareNames
+//
+// The order of the index: key path, then value name, ignoring case.
+/////////////////////////////////////////////////////////////////////////////
+static int
+	CompareNames(
+	const wchar_t*			KeyPath,
+	const wchar_t*			Name,
+	const RegistryValue*	Value)
+{
+	int	Result	= 0;
+
+	// the values of one key share its path
+	if (KeyPath != Value->KeyPath)
+	{
+		Result = CompareNoCase(KeyPath, Value->KeyPath);
+	}
+
+	if (0 == Result)
+	{
+		Result = CompareNoCase(Name, Value->Name);
+	}
+
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// CompareKeys
+/////////////////////////////////////////////////////////////////////////////
+static int
+	CompareKeys(
+	const void*	First,
+	const void*	Second)
+{
+	return CompareNoCase(*(const wchar_t* const*)First,
+		*(const wchar_t* const*)Second);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// CompareValues
+//
+// Values with the same names keep the order they were added in, as the
+// data of a later one is further into the arena.
+/////////////////////////////////////////////////////////////////////////////
+static int
+	CompareValues(
+	const void*	First,
+	const void*	Second)
+{
+	const RegistryValue*	FirstValue	= (const RegistryValue*)First;
+	const RegistryValue*	SecondValue	= (const RegistryValue*)Second;
+	int						Result		= CompareNames(FirstValue->KeyPath,
+		FirstValue->Name, SecondValue);
+
+	if (0 == Result)
+	{
+		if (FirstValue->Data < SecondValue->Data)
+		{
+			Result = -1;
+		}
+		else if (FirstValue->Data > SecondValue->Data)
+		{
+			Result = 1;
+		}
+	}
+
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DecodeAnsi
+//
+// Reads REGEDIT4 text, which is in the ANSI code page; off Windows, where
+// there is none, it is taken as Latin-1.
+/////////////////////////////////////////////////////////////////////////////
+static size_t
+	DecodeAnsi(
+	const unsigned char*	Bytes,
+	size_t					Size,
+	wchar_t*				Text)
+{
+	size_t	Length	= 0;
+
+#if defined(_WIN32)
+	if (0 < Size)
+	{
+		Length = (size_t)MultiByteToWideChar(CP_ACP, 0, (LPCSTR)Bytes,
+			(int)Size, Text, (int)Size);
+	}
+#else
+	for (Length = 0; Length < Size; Length++)
+	{
+		Text[Length] = (wchar_t)Bytes[Length];
+	}
+#endif
+
+	return Length;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DecodeUtf16
+//
+// Reads little endian UTF-16 units, joining surrogate pairs where wchar_t
+// is 32 bits.  Returns the characters written, never more than Units.
+/////////////////////////////////////////////////////////////////////////////
+static size_t
+	DecodeUtf16(
+	const unsigned char*	Bytes,
+	size_t					Units,
+	wchar_t*				Text)
+{
+	size_t	Length	= 0;
+
+	for (size_t Index = 0; Index < Units; Index++)
+	{
+		unsigned int	Character	= Bytes[Index * 2] |
+			(Bytes[Index * 2 + 1] << 8);
+
+		if ((4 == sizeof(wchar_t)) && (0xD800 <= Character) &&
+			(0xDC00 > Character) && (Index + 1 < Units))
+		{
+			unsigned int	Trail	= Bytes[Index * 2 + 2] |
+				(Bytes[Index * 2 + 3] << 8);
+
+			if ((0xDC00 <= Trail) && (0xE000 > Trail))
+			{
+				Character = 0x10000 + ((Character - 0xD800) << 10) +
+					(Trail - 0xDC00);
+				Index++;
+			}
+		}
+
+		Text[Length] = (wchar_t)Character;
+		Length++;
+	}
+
+	return Length;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DecodeUtf8
+//
+// Bytes that are not UTF-8 become U+FFFD, as with MultiByteToWideChar.
+// Characters outside the BMP become surrogate pairs where wchar_t is 16
+// bits.  Returns the characters written, never more than Size.
+/////////////////////////////////////////////////////////////////////////////
+static size_t
+	DecodeUtf8(
+	const unsigned char*	Bytes,
+	size_t					Size,
+	wchar_t*				Text)
+{
+	size_t	Length	= 0;
+	size_t	Index	= 0;
+
+	while (Index < Size)
+	{
+		unsigned int	Character	= Bytes[Index];
+		unsigned int	Minimum		= 0;
+		size_t			Trailing	= 0;
+
+		if ((0xC2 <= Character) && (0xE0 > Character))
+		{
+			Character	&= 0x1F;
+			Minimum		= 0x80;
+			Trailing	= 1;
+		}
+		else if ((0xE0 <= Character) && (0xF0 > Character))
+		{
+			Character	&= 0x0F;
+			Minimum		= 0x800;
+			Trailing	= 2;
+		}
+		else if ((0xF0 <= Character) && (0xF5 > Character))
+		{
+			Character	&= 0x07;
+			Minimum		= 0x10000;
+			Trailing	= 3;
+		}
+		else if (0x80 <= Character)
+		{
+			Character = 0xFFFD;
+		}
+
+		Index++;
+
+		for (; 0 < Trailing; Trailing--)
+		{
+			if ((Index < Size) && (0x80 == (Bytes[Index] & 0xC0)))
+			{
+				Character = (Character << 6) | (Bytes[Index] & 0x3F);
+				Index++;
+			}
+			else
+			{
+				// a sequence cut short; the byte that ended it is read next
+				Character	= 0xFFFD;
+				Minimum		= 0;
+				break;
+			}
+		}
+
+		if ((Character < Minimum) || (0x10FFFF < Character) ||
+			((0xD800 <= Character) && (0xE000 > Character)))
+		{
+			Character = 0xFFFD;
+		}
+
+		if ((2 == sizeof(wchar_t)) && (0x10000 <= Character))
+		{
+			Text[Length] = (wchar_t)(0xD800 + ((Character - 0x10000) >> 10));
+			Length++;
+			Character = 0xDC00 + ((Character - 0x10000) & 0x3FF);
+		}
+
+		Text[Length] = (wchar_t)Character;
+		Length++;
+	}
+
+	return Length;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetHexDigit
+//
+// Returns -1 for anything but a hex digit.
+/////////////////////////////////////////////////////////////////////////////
+static int
+	GetHexDigit(
+	wchar_t	Character)
+{
+	int	Digit	= -1;
+
+	if ((Character >= L'0') && (Character <= L'9'))
+	{
+		Digit = Character - L'0';
+	}
+	else if ((Character >= L'a') && (Character <= L'f'))
+	{
+		Digit = Character - L'a' + 10;
+	}
+	else if ((Character >= L'A') && (Character <= L'F'))
+	{
+		Digit = Character - L'A' + 10;
+	}
+
+	return Digit;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsStringType
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	IsStringType(
+	unsigned int	Type)
+{
+	return ((REG_SZ == Type) || (REG_EXPAND_SZ == Type) ||
+		(REG_MULTI_SZ == Type));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// OpenRegistryFile
+//
+// Off Windows, the path is converted to the locale's multibyte encoding.
+/////////////////////////////////////////////////////////////////////////////
+static FILE*
+	OpenRegistryFile(
+	const wchar_t*	FilePath)
+{
+	FILE*	File	= NULL;
+
+#if defined(_WIN32)
+	File = _wfopen(FilePath, L"rb");
+#else
+	size_t	Size	= wcslen(FilePath) * MB_CUR_MAX + 1;
+	char*	Path	= new char[Size];
+
+	if ((NULL != Path) && ((size_t)-1 != wcstombs(Path, FilePath, Size)))
+	{
+		File = fopen(Path, "rb");
+	}
+
+	if (NULL != Path)
+	{
+		delete[] Path;
+	}
+#endif
+
+	return File;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ReadHexBytes
+//
+// Reads the comma separated bytes of a hex: value, as in "01,ff,00".
+/////////////////////////////////////////////////////////////////////////////
+static bool
+	ReadHexBytes(
+	const wchar_t*	Text,
+	unsigned char*	Bytes,
+	unsigned int*	Size)
+{
+	bool			ReturnCode	= true;
+	unsigned int	Count		= 0;
+
+	while ((true == ReturnCode) && (L'\0' != *Text))
+	{
+		int	High	= GetHexDigit(Text[0]);
+		int	Low		= -1;
+
+		if (0 <= High)
+		{
+			Low = GetHexDigit(Text[1]);
+		}
+
+		if (0 <= Low)
+		{
+			Bytes[Count] = (unsigned char)((High << 4) | Low);
+			Count++;
+			Text += 2;
+
+			while ((L' ' == *Text) || (L'\t' == *Text))
+			{
+				Text++;
+			}
+
+			if (L',' == *Text)
+			{
+				Text++;
+
+				while ((L' ' == *Text) || (L'\t' == *Text))
+				{
+					Text++;
+				}
+			}
+			else if (L'\0' != *Text)
+			{
+				ReturnCode = false;
+			}
+		}
+		else
+		{
+			ReturnCode = false;
+		}
+	}
+
+	*Size = Count;
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ReadQuoted
+//
+// Unescapes the quoted string at Text, which starts at its opening
+// quote, in place to the start of Text.  Returns what follows the closing
+// quote, or NULL if there is none.
+/////////////////////////////////////////////////////////////////////////////
+static wchar_t*
+	ReadQuoted(
+	wchar_t*	Text,
+	size_t*		Length)
+{
+	wchar_t*	Input	= Text + 1;
+	wchar_t*	Output	= Text;
+	wchar_t*	Rest	= NULL;
+
+	while (L'\0' != *Input)
+	{
+		if (L'"' == *Input)
+		{
+			Rest = Input + 1;
+			break;
+		}
+
+		if ((L'\\' == *Input) && (L'\0' != Input[1]))
+		{
+			Input++;
+		}
+
+		*Output = *Input;
+		Output++;
+		Input++;
+	}
+
+	*Length = Output - Text;
+
+	return Rest;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+RegistrySnapshot::RegistrySnapshot(void) :
+	m_Arena(NULL),
+	m_ArenaSize(0),
+	m_ArenaUsed(0),
+	m_Values(NULL),
+	m_ValueCount(0),
+	m_ValueCapacity(0),
+	m_Keys(NULL),
+	m_KeyCount(0),
+	m_KeyCapacity(0)
+{
+}
+
+RegistrySnapshot::~RegistrySnapshot(void)
+{
+	Clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Clear
+/////////////////////////////////////////////////////////////////////////////
+void
+	RegistrySnapshot::Clear(void)
+{
+	if (NULL != m_Arena)
+	{
+		delete[] m_Arena;
+		m_Arena = NULL;
+	}
+
+	if (NULL != m_Values)
+	{
+		delete[] m_Values;
+		m_Values = NULL;
+	}
+
+	if (NULL != m_Keys)
+	{
+		delete[] m_Keys;
+		m_Keys = NULL;
+	}
+
+	m_ArenaSize		= 0;
+	m_ArenaUsed		= 0;
+	m_ValueCount	= 0;
+	m_ValueCapacity	= 0;
+	m_KeyCount		= 0;
+	m_KeyCapacity	= 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Find
+//
+// A NULL key path is the snapshot's own key, and a NULL name the default
+// value.  Returns NULL if there is no such value.
+/////////////////////////////////////////////////////////////////////////////
+const RegistryValue*
+	RegistrySnapshot::Find(
+	const wchar_t*	KeyPath,
+	const wchar_t*	Name) const
+{
+	const RegistryValue*	Value	= NULL;
+	size_t					Low		= 0;
+	size_t					High	= m_ValueCount;
+
+	if (NULL == KeyPath)
+	{
+		KeyPath = L"";
+	}
+
+	if (NULL == Name)
+	{
+		Name = L"";
+	}
+
+	while (Low < High)
+	{
+		size_t	Middle	= Low + (High - Low) / 2;
+		int		Result	= CompareNames(KeyPath, Name, &m_Values[Middle]);
+
+		if (0 == Result)
+		{
+			Value = &m_Values[Middle];
+			break;
+		}
+		else if (0 > Result)
+		{
+			High = Middle;
+		}
+		else
+		{
+			Low = Middle + 1;
+		}
+	}
+
+	return Value;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// FindKey
+//
+// Gets the index range of the key's values, which is empty for a key
+// without values.  Returns false if the key is not in the snapshot.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistrySnapshot::FindKey(
+	const wchar_t*	KeyPath,
+	size_t*			First,
+	size_t*			Count) const
+{
+	bool	ReturnCode	= false;
+	size_t	Low			= 0;
+	size_t	High		= m_ValueCount;
+
+	if (NULL == KeyPath)
+	{
+		KeyPath = L"";
+	}
+
+	*First	= 0;
+	*Count	= 0;
+
+	if (NULL != bsearch(&KeyPath, m_Keys, m_KeyCount, sizeof(const wchar_t*),
+		CompareKeys))
+	{
+		// the first value at or after the key
+		while (Low < High)
+		{
+			size_t	Middle	= Low + (High - Low) / 2;
+
+			if (0 < CompareNoCase(KeyPath, m_Values[Middle].KeyPath))
+			{
+				Low = Middle + 1;
+			}
+			else
+			{
+				High = Middle;
+			}
+		}
+
+		High = Low;
+
+		while ((High < m_ValueCount) &&
+			(0 == CompareNoCase(KeyPath, m_Values[High].KeyPath)))
+		{
+			High++;
+		}
+
+		*First		= Low;
+		*Count		= High - Low;
+		ReturnCode	= true;
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetDwordValue
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistrySnapshot::GetDwordValue(
+	const wchar_t*	KeyPath,
+	const wchar_t*	Name,
+	unsigned int*	Value) const
+{
+	bool					ReturnCode	= false;
+	const RegistryValue*	Entry		= Find(KeyPath, Name);
+
+	if ((NULL != Entry) && (REG_DWORD == Entry->Type) &&
+		(sizeof(unsigned int) == Entry->DataSize))
+	{
+		*Value		= *(const unsigned int*)Entry->Data;
+		ReturnCode	= true;
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetKeyPath
+/////////////////////////////////////////////////////////////////////////////
+const wchar_t*
+	RegistrySnapshot::GetKeyPath(
+	size_t	Index) const
+{
+	const wchar_t*	KeyPath	= NULL;
+
+	if (Index < m_KeyCount)
+	{
+		KeyPath = m_Keys[Index];
+	}
+
+	return KeyPath;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetKeyCount
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	RegistrySnapshot::GetKeyCount(void) const
+{
+	return m_KeyCount;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetStringValue
+//
+// Returns NULL unless the value is a REG_SZ or REG_EXPAND_SZ.
+/////////////////////////////////////////////////////////////////////////////
+const wchar_t*
+	RegistrySnapshot::GetStringValue(
+	const wchar_t*	KeyPath,
+	const wchar_t*	Name) const
+{
+	const wchar_t*			String	= NULL;
+	const RegistryValue*	Entry	= Find(KeyPath, Name);
+
+	if ((NULL != Entry) &&
+		((REG_SZ == Entry->Type) || (REG_EXPAND_SZ == Entry->Type)))
+	{
+		String = (const wchar_t*)Entry->Data;
+	}
+
+	return String;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetValue
+/////////////////////////////////////////////////////////////////////////////
+const RegistryValue*
+	RegistrySnapshot::GetValue(
+	size_t	Index) const
+{
+	const RegistryValue*	Value	= NULL;
+
+	if (Index < m_ValueCount)
+	{
+		Value = &m_Values[Index];
+	}
+
+	return Value;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetValueCount
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	RegistrySnapshot::GetValueCount(void) const
+{
+	return m_ValueCount;
+}
+
+#if defined(_WIN32)
+/////////////////////////////////////////////////////////////////////////////
+// Load
+//
+// Reads the key and all of its subkeys.  Subkeys that can not be opened
+// are left out.  Returns false if the key can not be opened.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistrySnapshot::Load(
+	HKEY			KeyRoot,
+	const wchar_t*	KeyPath)
+{
+	bool	ReturnCode	= false;
+	HKEY	Key			= NULL;
+
+	Clear();
+
+	if (ERROR_SUCCESS == RegOpenKeyEx(KeyRoot, KeyPath, 0, KEY_READ, &Key))
+	{
+		wchar_t*	Path	= new wchar_t[REGISTRY_PATH_MAXIMUM];
+
+		if (NULL != Path)
+		{
+			Path[0] = L'\0';
+
+			ReturnCode = LoadKey(Key, Path, 0);
+
+			delete[] Path;
+		}
+
+		RegCloseKey(Key);
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = Finish();
+	}
+
+	if (false == ReturnCode)
+	{
+		Clear();
+	}
+
+	return ReturnCode;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// LoadContents
+//
+// Reads the key and all of its subkeys from a .reg file already in
+// memory: the UTF-16 one regedit writes, the same in UTF-8, or the older
+// REGEDIT4 one.  KeyPath is the full path of the key in the file, as
+// in "HKEY_LOCAL_MACHINE\SOFTWARE\Zenware"; NULL or empty reads every
+// key, with its full path.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistrySnapshot::LoadContents(
+	const unsigned char*	Contents,
+	size_t					Size,
+	const wchar_t*			KeyPath)
+{
+	bool	ReturnCode	= false;
+	// no encoding has more characters than bytes; then the terminator
+	wchar_t*	Text	= new wchar_t[Size + 1];
+	size_t		Length	= 0;
+
+	Clear();
+
+	if (NULL != Text)
+	{
+		if ((2 <= Size) && (0xFF == Contents[0]) && (0xFE == Contents[1]))
+		{
+			Length = DecodeUtf16(Contents + 2, (Size - 2) / 2, Text);
+		}
+		else if ((8 <= Size) && (0 == memcmp(Contents, "REGEDIT4", 8)))
+		{
+			Length = DecodeAnsi(Contents, Size, Text);
+		}
+		else
+		{
+			size_t	Start	= 0;
+
+			if ((3 <= Size) && (0xEF == Contents[0]) &&
+				(0xBB == Contents[1]) && (0xBF == Contents[2]))
+			{
+				Start = 3;
+			}
+
+			Length = DecodeUtf8(Contents + Start, Size - Start, Text);
+		}
+
+		Text[Length] = L'\0';
+
+		ReturnCode = ParseFile(Text, Length, KeyPath);
+
+		delete[] Text;
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = Finish();
+	}
+
+	if (false == ReturnCode)
+	{
+		Clear();
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// LoadFile
+//
+// Reads the whole file, then loads it as LoadContents does.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistrySnapshot::LoadFile(
+	const wchar_t*	FilePath,
+	const wchar_t*	KeyPath)
+{
+	bool			ReturnCode	= false;
+	long			Size		= -1;
+	unsigned char*	Contents	= NULL;
+	FILE*			File		= NULL;
+
+	Clear();
+
+	if (NULL != FilePath)
+	{
+		File = OpenRegistryFile(FilePath);
+	}
+
+	if (NULL != File)
+	{
+		if (0 == fseek(File, 0, SEEK_END))
+		{
+			Size = ftell(File);
+		}
+
+		if ((0 <= Size) && (0 == fseek(File, 0, SEEK_SET)))
+		{
+			Contents = new unsigned char[Size + 1];
+		}
+
+		if ((NULL != Contents) &&
+			((size_t)Size == fread(Contents, 1, (size_t)Size, File)))
+		{
+			ReturnCode = true;
+		}
+
+		fclose(File);
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = LoadContents(Contents, (size_t)Size, KeyPath);
+	}
+
+	if (NULL != Contents)
+	{
+		delete[] Contents;
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AddKey
+//
+// Until Finish, the index holds arena offsets in place of pointers, as
+// the arena moves when it grows.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistrySnapshot::AddKey(
+	const wchar_t*	KeyPath,
+	size_t			KeyPathLength,
+	size_t*			KeyOffset)
+{
+	bool	ReturnCode	= true;
+
+	if (m_KeyCount == m_KeyCapacity)
+	{
+		size_t			Capacity	= SNAPSHOT_INDEX_SIZE;
+		const wchar_t**	Keys		= NULL;
+
+		if (0 < m_KeyCapacity)
+		{
+			Capacity = m_KeyCapacity * 2;
+		}
+
+		Keys = new const wchar_t*[Capacity];
+
+		if (NULL != Keys)
+		{
+			if (NULL != m_Keys)
+			{
+				memcpy(Keys, m_Keys, m_KeyCount * sizeof(const wchar_t*));
+				delete[] m_Keys;
+			}
+
+			m_Keys			= Keys;
+			m_KeyCapacity	= Capacity;
+		}
+		else
+		{
+			ReturnCode = false;
+		}
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = Append(KeyPath, KeyPathLength * sizeof(wchar_t),
+			sizeof(wchar_t), KeyOffset);
+	}
+
+	if (true == ReturnCode)
+	{
+		m_Keys[m_KeyCount] = (const wchar_t*)(size_t)*KeyOffset;
+		m_KeyCount++;
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AddValue
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistrySnapshot::AddValue(
+	size_t					KeyOffset,
+	const wchar_t*			Name,
+	size_t					NameLength,
+	unsigned int			Type,
+	const unsigned char*	Data,
+	unsigned int			DataSize)
+{
+	bool	ReturnCode	= true;
+	size_t	NameOffset	= 0;
+	size_t	DataOffset	= 0;
+	size_t	ZeroBytes	= 0;
+
+	if (m_ValueCount == m_ValueCapacity)
+	{
+		size_t			Capacity	= SNAPSHOT_INDEX_SIZE;
+		RegistryValue*	Values		= NULL;
+
+		if (0 < m_ValueCapacity)
+		{
+			Capacity = m_ValueCapacity * 2;
+		}
+
+		Values = new RegistryValue[Capacity];
+
+		if (NULL != Values)
+		{
+			if (NULL != m_Values)
+			{
+				memcpy(Values, m_Values, m_ValueCount * sizeof(RegistryValue));
+				delete[] m_Values;
+			}
+
+			m_Values		= Values;
+			m_ValueCapacity	= Capacity;
+		}
+		else
+		{
+			ReturnCode = false;
+		}
+	}
+
+	// a string may be stored without its terminator, and a multi string
+	// without its final one
+	if (true == IsStringType(Type))
+	{
+		ZeroBytes = 2 * sizeof(wchar_t);
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = Append(Name, NameLength * sizeof(wchar_t),
+			sizeof(wchar_t), &NameOffset);
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = Append(Data, DataSize, ZeroBytes, &DataOffset);
+	}
+
+	if (true == ReturnCode)
+	{
+		RegistryValue*	Value	= &m_Values[m_ValueCount];
+
+		Value->KeyPath	= (const wchar_t*)(size_t)KeyOffset;
+		Value->Name		= (const wchar_t*)(size_t)NameOffset;
+		Value->Type		= Type;
+		Value->Data		= (const unsigned char*)(size_t)DataOffset;
+		Value->DataSize	= DataSize;
+
+		m_ValueCount++;
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Append
+//
+// Copies Size bytes of Data to the arena, aligned, followed by ZeroBytes
+// zero bytes.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistrySnapshot::Append(
+	const void*	Data,
+	size_t		Size,
+	size_t		ZeroBytes,
+	size_t*		Offset)
+{
+	bool	ReturnCode	= true;
+	size_t	Start		= (m_ArenaUsed + SNAPSHOT_ALIGNMENT - 1) &
+		~((size_t)SNAPSHOT_ALIGNMENT - 1);
+	size_t	Needed		= Start + Size + ZeroBytes;
+
+	if (Needed > m_ArenaSize)
+	{
+		size_t			ArenaSize	= SNAPSHOT_ARENA_SIZE;
+		unsigned char*	Arena		= NULL;
+
+		if (0 < m_ArenaSize)
+		{
+			ArenaSize = m_ArenaSize * 2;
+		}
+
+		while (ArenaSize < Needed)
+		{
+			ArenaSize *= 2;
+		}
+
+		Arena = new unsigned char[ArenaSize];
+
+		if (NULL != Arena)
+		{
+			if (NULL != m_Arena)
+			{
+				memcpy(Arena, m_Arena, m_ArenaUsed);
+				delete[] m_Arena;
+			}
+
+			m_Arena		= Arena;
+			m_ArenaSize	= ArenaSize;
+		}
+		else
+		{
+			ReturnCode = false;
+		}
+	}
+
+	if (true == ReturnCode)
+	{
+		if (0 < Size)
+		{
+			memcpy(m_Arena + Start, Data, Size);
+		}
+
+		memset(m_Arena + Start + Size, 0, ZeroBytes);
+
+		*Offset		= Start;
+		m_ArenaUsed	= Needed;
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Finish
+//
+// Turns the offsets into pointers and sorts both indexes.  A key or value
+// read more than once, which a .reg file allows, keeps its last copy.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistrySnapshot::Finish(void)
+{
+	size_t	Count	= 0;
+
+	for (size_t Index = 0; Index < m_KeyCount; Index++)
+	{
+		m_Keys[Index] = (const wchar_t*)(m_Arena + (size_t)m_Keys[Index]);
+	}
+
+	for (size_t Index = 0; Index < m_ValueCount; Index++)
+	{
+		RegistryValue*	Value	= &m_Values[Index];
+
+		Value->KeyPath	= (const wchar_t*)(m_Arena + (size_t)Value->KeyPath);
+		Value->Name		= (const wchar_t*)(m_Arena + (size_t)Value->Name);
+		Value->Data		= m_Arena + (size_t)Value->Data;
+	}
+
+	if (0 < m_KeyCount)
+	{
+		qsort(m_Keys, m_KeyCount, sizeof(const wchar_t*), CompareKeys);
+
+		Count = 1;
+
+		for (size_t Index = 1; Index < m_KeyCount; Index++)
+		{
+			if (0 != CompareNoCase(m_Keys[Count - 1], m_Keys[Index]))
+			{
+				m_Keys[Count] = m_Keys[Index];
+				Count++;
+			}
+		}
+
+		m_KeyCount = Count;
+	}
+
+	if (0 < m_ValueCount)
+	{
+		qsort(m_Values, m_ValueCount, sizeof(RegistryValue), CompareValues);
+
+		Count = 0;
+
+		for (size_t Index = 0; Index < m_ValueCount; Index++)
+		{
+			if ((Index + 1 == m_ValueCount) ||
+				(0 != CompareNames(m_Values[Index].KeyPath,
+					m_Values[Index].Name, &m_Values[Index + 1])))
+			{
+				m_Values[Count] = m_Values[Index];
+				Count++;
+			}
+		}
+
+		m_ValueCount = Count;
+	}
+
+	return true;
+}
+
+#if defined(_WIN32)
+/////////////////////////////////////////////////////////////////////////////
+// LoadKey
+//
+// Reads one key's values, then its subkeys.  KeyPath is the key's path
+// relative to the snapshot's key, in a buffer of REGISTRY_PATH_MAXIMUM
+// characters, which the subkeys' names are appended to in turn.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistrySnapshot::LoadKey(
+	HKEY		Key,
+	wchar_t*	KeyPath,
+	size_t		KeyPathLength)
+{
+	bool	ReturnCode			= true;
+	DWORD	SubKeyCount			= 0;
+	DWORD	MaximumSubKeyLength	= 0;
+	DWORD	ValueCount			= 0;
+	DWORD	MaximumNameLength	= 0;
+	DWORD	MaximumDataSize		= 0;
+	size_t	KeyOffset			= 0;
+	LONG	Result				= RegQueryInfoKey(Key, NULL, NULL, NULL,
+		&SubKeyCount, &MaximumSubKeyLength, NULL, &ValueCount,
+		&MaximumNameLength, &MaximumDataSize, NULL, NULL);
+
+	if (ERROR_SUCCESS == Result)
+	{
+		ReturnCode = AddKey(KeyPath, KeyPathLength, &KeyOffset);
+	}
+	else
+	{
+		// a key that can not be read is left out
+		SubKeyCount	= 0;
+		ValueCount	= 0;
+	}
+
+	if ((true == ReturnCode) && (0 < ValueCount))
+	{
+		wchar_t*	Name	= new wchar_t[MaximumNameLength + 1];
+		BYTE*		Data	= new BYTE[MaximumDataSize + 1];
+
+		if ((NULL != Name) && (NULL != Data))
+		{
+			for (DWORD Index = 0;
+				(true == ReturnCode) && (Index < ValueCount); Index++)
+			{
+				DWORD	NameLength	= MaximumNameLength + 1;
+				DWORD	DataSize	= MaximumDataSize;
+				DWORD	Type		= REG_NONE;
+
+				Result = RegEnumValue(Key, Index, Name, &NameLength, NULL,
+					&Type, Data, &DataSize);
+
+				if (ERROR_SUCCESS == Result)
+				{
+					ReturnCode = AddValue(KeyOffset, Name, NameLength, Type,
+						Data, DataSize);
+				}
+				else if (ERROR_NO_MORE_ITEMS == Result)
+				{
+					// values were deleted while being read
+					break;
+				}
+			}
+		}
+		else
+		{
+			ReturnCode = false;
+		}
+
+		if (NULL != Name)
+		{
+			delete[] Name;
+		}
+
+		if (NULL != Data)
+		{
+			delete[] Data;
+		}
+	}
+
+	if (true == ReturnCode)
+	{
+		size_t	Start	= KeyPathLength;
+
+		if (0 < KeyPathLength)
+		{
+			Start++;
+		}
+
+		for (DWORD Index = 0;
+			(true == ReturnCode) && (Index < SubKeyCount); Index++)
+		{
+			DWORD	NameLength	= (DWORD)(REGISTRY_PATH_MAXIMUM - Start);
+			HKEY	SubKey		= NULL;
+
+			if (NameLength <= MaximumSubKeyLength)
+			{
+				// too deep to have a path
+				break;
+			}
+
+			Result = RegEnumKeyEx(Key, Index, KeyPath + Start, &NameLength,
+				NULL, NULL, NULL, NULL);
+
+			if (ERROR_SUCCESS == Result)
+			{
+				if (ERROR_SUCCESS == RegOpenKeyEx(Key, KeyPath + Start, 0,
+					KEY_READ, &SubKey))
+				{
+					if (0 < KeyPathLength)
+					{
+						KeyPath[KeyPathLength] = L'\\';
+					}
+
+					ReturnCode = LoadKey(SubKey, KeyPath, Start + NameLength);
+
+					RegCloseKey(SubKey);
+				}
+			}
+			else if (ERROR_NO_MORE_ITEMS == Result)
+			{
+				break;
+			}
+
+			KeyPath[KeyPathLength] = L'\0';
+		}
+	}
+
+	return ReturnCode;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// ParseFile
+//
+// Text is changed in place: lines continued with a backslash are joined,
+// and quoted strings unescaped.  Deletions, "[-key]" and "name"=-, are
+// skipped, as are lines that can not be read.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	RegistrySnapshot::ParseFile(
+	wchar_t*		Text,
+	size_t			Length,
+	const wchar_t*	KeyPath)
+{
+	bool			ReturnCode		= true;
+	size_t			PrefixLength	= 0;
+	size_t			Position		= 0;
+	bool			InKey			= false;
+	size_t			KeyOffset		= 0;
+	// the data of hex: and dword: values
+	unsigned char*	Bytes			= new unsigned char[Length +
+		sizeof(unsigned int)];
+	// hex: strings, decoded, where wchar_t is not 16 bits
+	wchar_t*		Strings			= NULL;
+
+	if (NULL != KeyPath)
+	{
+		PrefixLength = wcslen(KeyPath);
+	}
+
+	if (2 != sizeof(wchar_t))
+	{
+		Strings = new wchar_t[Length / 2 + 1];
+	}
+
+	if ((NULL == Bytes) || ((2 != sizeof(wchar_t)) && (NULL == Strings)))
+	{
+		ReturnCode = false;
+	}
+
+	while ((true == ReturnCode) && (Position < Length))
+	{
+		wchar_t*	Line		= Text + Position;
+		size_t		LineLength	= 0;
+		bool		More		= true;
+
+		while (true == More)
+		{
+			size_t	End		= Position;
+			size_t	Next	= 0;
+
+			while ((End < Length) && (L'\n' != Text[End]))
+			{
+				End++;
+			}
+
+			Next = End + 1;
+
+			while ((Position < End) && ((L' ' == Text[Position]) ||
+				(L'\t' == Text[Position])))
+			{
+				Position++;
+			}
+
+			while ((Position < End) && ((L'\r' == Text[End - 1]) ||
+				(L' ' == Text[End - 1]) || (L'\t' == Text[End - 1])))
+			{
+				End--;
+			}
+
+			memmove(Line + LineLength, Text + Position,
+				(End - Position) * sizeof(wchar_t));
+			LineLength += End - Position;
+			Position = Next;
+
+			// only hex values are continued
+			More = ((0 < LineLength) && (L'\\' == Line[LineLength - 1]) &&
+				((L'"' == Line[0]) || (L'@' == Line[0])) &&
+				(Position < Length));
+
+			if (true == More)
+			{
+				LineLength--;
+			}
+		}
+
+		Line[LineLength] = L'\0';
+
+		if (L'[' == Line[0])
+		{
+			wchar_t*	Close	= wcsrchr(Line, L']');
+			wchar_t*	Path	= Line + 1;
+
+			InKey = false;
+
+			if ((NULL != Close) && (L'-' != Line[1]))
+			{
+				*Close = L'\0';
+
+				if (0 == PrefixLength)
+				{
+					InKey = true;
+				}
+				else if ((0 == CompareNoCase(Path, KeyPath, PrefixLength)) &&
+					((L'\0' == Path[PrefixLength]) ||
+					(L'\\' == Path[PrefixLength])))
+				{
+					Path += PrefixLength;
+
+					if (L'\\' == *Path)
+					{
+						Path++;
+					}
+
+					InKey = true;
+				}
+			}
+
+			if (true == InKey)
+			{
+				ReturnCode = AddKey(Path, wcslen(Path), &KeyOffset);
+			}
+		}
+		else if ((true == InKey) &&
+			((L'"' == Line[0]) || (L'@' == Line[0])))
+		{
+			bool					Default		= (L'@' == Line[0]);
+			size_t					NameLength	= 0;
+			wchar_t*				Value		= Line + 1;
+			unsigned int			Type		= REG_NONE;
+			const unsigned char*	Data		= Bytes;
+			unsigned int			DataSize	= 0;
+			bool					Valid		= false;
+
+			if (false == Default)
+			{
+				Value = ReadQuoted(Line, &NameLength);
+			}
+
+			while ((NULL != Value) && ((L' ' == *Value) ||
+				(L'\t' == *Value)))
+			{
+				Value++;
+			}
+
+			if ((NULL != Value) && (L'=' == *Value))
+			{
+				Value++;
+
+				while ((L' ' == *Value) || (L'\t' == *Value))
+				{
+					Value++;
+				}
+
+				if (L'"' == *Value)
+				{
+					size_t	ValueLength	= 0;
+
+					if (NULL != ReadQuoted(Value, &ValueLength))
+					{
+						Value[ValueLength] = L'\0';
+
+						Type		= REG_SZ;
+						Data		= (const unsigned char*)Value;
+						DataSize	= (unsigned int)((ValueLength + 1) *
+							sizeof(wchar_t));
+						Valid		= true;
+					}
+				}
+				else if (0 == CompareNoCase(Value, L"dword:", 6))
+				{
+					wchar_t*		End		= NULL;
+					unsigned int	Number	= (unsigned int)wcstoul(Value + 6,
+						&End, 16);
+
+					if ((End != Value + 6) && (L'\0' == *End))
+					{
+						Type		= REG_DWORD;
+						DataSize	= sizeof(unsigned int);
+						memcpy(Bytes, &Number, sizeof(unsigned int));
+						Valid		= true;
+					}
+				}
+				else if (0 == CompareNoCase(Value, L"hex", 3))
+				{
+					wchar_t*	Hex	= Value + 3;
+
+					Type = REG_BINARY;
+
+					if (L'(' == *Hex)
+					{
+						Type = (unsigned int)wcstoul(Hex + 1, &Hex, 16);
+
+						if (L')' == *Hex)
+						{
+							Hex++;
+						}
+						else
+						{
+							Hex = Value;
+						}
+					}
+
+					if (L':' == *Hex)
+					{
+						Valid = ReadHexBytes(Hex + 1, Bytes, &DataSize);
+					}
+
+					// the file holds UTF-16 strings
+					if ((true == Valid) && (2 != sizeof(wchar_t)) &&
+						(true == IsStringType(Type)))
+					{
+						Data		= (const unsigned char*)Strings;
+						DataSize	= (unsigned int)(DecodeUtf16(Bytes,
+							DataSize / 2, Strings) * sizeof(wchar_t));
+					}
+				}
+			}
+
+			if (true == Valid)
+			{
+				// the name was unescaped to the start of the line
+				ReturnCode = AddValue(KeyOffset, Line, NameLength, Type, Data,
+					DataSize);
+			}
+		}
+	}
+
+	if (NULL != Bytes)
+	{
+		delete[] Bytes;
+	}
+
+	if (NULL != Strings)
+	{
+		delete[] Strings;
+	}
+
+	return ReturnCode;
+}
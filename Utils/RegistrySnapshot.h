@@ -0,0 +1,160 @@
+/////////////////////////////////////////////////////////////////////////////
+// RegistrySnapshot.h - Class Declaration
+//
+// A registry key and everything under it, read at once into memory.  All
+// but Load needs nothing but the C library, so .reg files are read, and
+// tested, off Windows too.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+
+#if defined(_WIN32)
+#include "../Include/Common.h"
+#else
+#define DllExport
+
+// the value types, as winnt.h has them
+#define REG_NONE		0
+#define REG_SZ			1
+#define REG_EXPAND_SZ	2
+#define REG_BINARY		3
+#define REG_DWORD		4
+#define REG_MULTI_SZ	7
+#define REG_QWORD		11
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+// longest key path read, in characters; deeper keys are skipped
+const size_t REGISTRY_PATH_MAXIMUM	= 4096;
+
+/////////////////////////////////////////////////////////////////////////////
+// RegistryValue
+//
+// One value in a snapshot.  KeyPath is relative to the key the snapshot
+// was taken of, and empty for that key itself; Name is empty for the
+// default value.  String data is always terminated, even if the value
+// was stored without its terminator; DataSize is the size as stored.
+/////////////////////////////////////////////////////////////////////////////
+struct RegistryValue
+{
+	const wchar_t*			KeyPath;
+	const wchar_t*			Name;
+	unsigned int			Type;
+	const unsigned char*	Data;
+	unsigned int			DataSize;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// RegistrySnapshot Class Definition
+//
+// Every key path, value name and value lives in one arena, and the
+// values are indexed by key path and then name, ignoring case, as the
+// registry does, so lookups are binary searches and the values of a key
+// are next to each other.  The key paths have a sorted index of their
+// own, which includes keys without values.
+//
+// A snapshot is taken from the registry with one open per key and one
+// call per value, or from a .reg file, as written by regedit, which
+// needs no registry.  Pointers returned are valid until the snapshot is
+// cleared, loaded again or destroyed.
+/////////////////////////////////////////////////////////////////////////////
+class DllExport RegistrySnapshot
+{
+	public:
+		// Properties
+
+		// Methods
+			RegistrySnapshot(void);
+			~RegistrySnapshot(void);
+
+			void Clear(void);
+
+			const RegistryValue* Find(
+				const wchar_t*	KeyPath,
+				const wchar_t*	Name) const;
+			bool FindKey(
+				const wchar_t*	KeyPath,
+				size_t*			First,
+				size_t*			Count) const;
+			bool GetDwordValue(
+				const wchar_t*	KeyPath,
+				const wchar_t*	Name,
+				unsigned int*	Value) const;
+			const wchar_t* GetKeyPath(
+				size_t	Index) const;
+			size_t GetKeyCount(void) const;
+			const wchar_t* GetStringValue(
+				const wchar_t*	KeyPath,
+				const wchar_t*	Name) const;
+			const RegistryValue* GetValue(
+				size_t	Index) const;
+			size_t GetValueCount(void) const;
+
+#if defined(_WIN32)
+			bool Load(
+				HKEY			KeyRoot,
+				const wchar_t*	KeyPath);
+#endif
+			bool LoadContents(
+				const unsigned char*	Contents,
+				size_t					Size,
+				const wchar_t*			KeyPath);
+			bool LoadFile(
+				const wchar_t*	FilePath,
+				const wchar_t*	KeyPath);
+
+	private:
+		// Properties
+			unsigned char*	m_Arena;
+			size_t			m_ArenaSize;
+			size_t			m_ArenaUsed;
+			RegistryValue*	m_Values;
+			size_t			m_ValueCount;
+			size_t			m_ValueCapacity;
+			const wchar_t**	m_Keys;
+			size_t			m_KeyCount;
+			size_t			m_KeyCapacity;
+
+		// Methods
+			RegistrySnapshot(
+				const RegistrySnapshot&);
+			RegistrySnapshot& operator=(
+				const RegistrySnapshot&);
+
+			bool AddKey(
+				const wchar_t*	KeyPath,
+				size_t			KeyPathLength,
+				size_t*			KeyOffset);
+			bool AddValue(
+				size_t					KeyOffset,
+				const wchar_t*			Name,
+				size_t					NameLength,
+				unsigned int			Type,
+				const unsigned char*	Data,
+				unsigned int			DataSize);
+			bool Append(
+				const void*	Data,
+				size_t		Size,
+				size_t		ZeroBytes,
+				size_t*		Offset);
+			bool Finish(void);
+#if defined(_WIN32)
+			bool LoadKey(
+				HKEY		Key,
+				wchar_t*	KeyPath,
+				size_t		KeyPathLength);
+#endif
+			bool ParseFile(
+				wchar_t*		Text,
+				size_t			Length,
+				const wchar_t*	KeyPath);
+};
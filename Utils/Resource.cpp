@@ -8,16 +8,24 @@
 /////////////////////////////////////////////////////////////////////////////
 #include "StdAfx.h"
 #include "Resource.h"
+#include "MessageCatalog.h"
 #include "Utils.h"
 
 Resource::Resource(
-	LPCTSTR ModulePath)
+	LPCTSTR ModulePath) :
+		m_CatalogPath(NULL),
+		m_ResourceModule(NULL)
 {
 	m_ModulePath = ModulePath;
 }
 
 Resource::~Resource(void)
 {
+	if (NULL != m_CatalogPath)
+	{
+		delete[] m_CatalogPath;
+		m_CatalogPath = NULL;
+	}
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -59,26 +67,126 @@ Resource::GetString(
 {
 	CString ResourceCstring;
 	TCHAR*	ResourceString = NULL;
+	LPCTSTR	View = NULL;
+	MessageCatalog* Catalog = GetMessageCatalog();
 
-	if (NULL == m_ResourceModule)
+	if (NULL != Catalog)
 	{
-		m_ResourceModule = GetResourceModule();
+		View = Catalog->GetString(ResourceId, NULL);
 	}
 
-	if (NULL != m_ResourceModule)
+	if ((NULL == View) && (true == m_Strings.IsLoaded()) &&
+		(GetLanguageId() == m_Strings.GetLanguageId()))
+	{
+		View = m_Strings.GetString(ResourceId, NULL);
+	}
+
+	if (NULL != View)
+	{
+		ResourceString = GetStringCopy(View);
+	}
+	else
 	{
-		//BOOL ResultCode = ResourceCstring.LoadString(Module, ResourceId, m_LanguageId);
-		BOOL ResultCode = ResourceCstring.LoadString(m_ResourceModule, ResourceId);
+		if (NULL == m_ResourceModule)
+		{
+			m_ResourceModule = GetResourceModule();
+		}
 
-		if (TRUE == ResultCode)
+		if (NULL != m_ResourceModule)
 		{
-			ResourceString	= GetStringCopy(ResourceCstring);
+			//BOOL ResultCode = ResourceCstring.LoadString(Module, ResourceId, m_LanguageId);
+			BOOL ResultCode = ResourceCstring.LoadString(m_ResourceModule, ResourceId);
+
+			if (TRUE == ResultCode)
+			{
+				ResourceString	= GetStringCopy(ResourceCstring);
+			}
 		}
 	}
 
 	return ResourceString;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// GetStringView
+//
+// Gets a localized string from the process's message catalog, if one is
+// open, or else from the preloaded string table, preloading it first if
+// needed, or again if the language has changed.
+//
+// do not delete; valid until the language changes.
+/////////////////////////////////////////////////////////////////////////////
+LPCTSTR
+Resource::GetStringView(
+	UINT	ResourceId)
+{
+	LPCTSTR			View	= NULL;
+	MessageCatalog*	Catalog	= GetMessageCatalog();
+
+	if (NULL != Catalog)
+	{
+		View = Catalog->GetString(ResourceId, NULL);
+	}
+
+	if (NULL == View)
+	{
+		if ((false == m_Strings.IsLoaded()) ||
+			(GetLanguageId() != m_Strings.GetLanguageId()))
+		{
+			Preload();
+		}
+
+		View = m_Strings.GetString(ResourceId, NULL);
+	}
+
+	return View;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// LoadCatalog
+//
+// Takes strings from a catalog file, written by MakeStringCatalog.py,
+// instead of the resource module.  Needs no resource module, so works
+// the same off Windows.
+/////////////////////////////////////////////////////////////////////////////
+bool
+Resource::LoadCatalog(
+	LPCTSTR	CatalogPath)
+{
+	if (NULL != m_CatalogPath)
+	{
+		delete[] m_CatalogPath;
+	}
+
+	m_CatalogPath = GetStringCopy(CatalogPath);
+
+	return Preload();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Preload
+//
+// Loads the whole string table for the current language at once, so
+// later lookups neither touch the module nor allocate.
+/////////////////////////////////////////////////////////////////////////////
+bool
+Resource::Preload(void)
+{
+	bool	ReturnCode	= false;
+	WORD	LanguageId	= GetLanguageId();
+
+	if (NULL != m_CatalogPath)
+	{
+		ReturnCode = m_Strings.LoadCatalog(m_CatalogPath, LanguageId);
+	}
+	else if (NULL != GetResourceModule())
+	{
+		ReturnCode = m_Strings.LoadModule(m_ResourceModule, LanguageId);
+	}
+
+	return ReturnCode;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // ShowMessage
 /////////////////////////////////////////////////////////////////////////////
@@ -87,11 +195,9 @@ Resource::ShowMessage(
 	int TitleId,
 	int	StringId)
 {
-	TCHAR*	Title	= GetString(TitleId);
-	TCHAR*	Message	= GetString(StringId);
+	LPCTSTR	Title	= GetStringView(TitleId);
+	LPCTSTR	Message	= GetStringView(StringId);
 	int ReturnCode	= MessageBox(GetActiveWindow(), Message, Title, MB_OK);
-	delete Title;
-	delete Message;
 
 	return ReturnCode;
 }
@@ -105,13 +211,11 @@ Resource::ShowMessageError(
 	LPCTSTR	Message,
 	int		StringId)
 {
-	TCHAR*	Title			= GetString(TitleId);
-	TCHAR*	ErrorMessage	= GetString(StringId);
+	LPCTSTR	Title			= GetStringView(TitleId);
+	LPCTSTR	ErrorMessage	= GetStringView(StringId);
 	CString CompleteMessage = Message;
 	int ReturnCode = MessageBox(GetActiveWindow(),
 		CompleteMessage + _T(": ") + ErrorMessage, Title, MB_OK);
-	delete Title;
-	delete ErrorMessage;
 
 	return ReturnCode;
 }
@@ -124,11 +228,9 @@ Resource::ShowMessageYesNo(
 	int TitleId,
 	int	StringId)
 {
-	TCHAR*	Title	= GetString(TitleId);
-	TCHAR*	Message	= GetString(StringId);
+	LPCTSTR	Title	= GetStringView(TitleId);
+	LPCTSTR	Message	= GetStringView(StringId);
 	int ReturnCode	= MessageBox(GetActiveWindow(), Message, Title, MB_YESNO);
-	delete Title;
-	delete Message;
 
 	return ReturnCode;
 }
@@ -12,6 +12,7 @@
 // Includes
 /////////////////////////////////////////////////////////////////////////////
 #include "../Include/Common.h"
+#include "StringTable.h"
 
 class DllExport Resource
 {
@@ -23,6 +24,11 @@ class DllExport Resource
 		HMODULE GetResourceModule();
 		TCHAR* GetString(
 			UINT	ResourceId);
+		LPCTSTR GetStringView(
+			UINT	ResourceId);
+		bool LoadCatalog(
+			LPCTSTR	CatalogPath);
+		bool Preload(void);
 		int ShowMessageString(
 			LPCTSTR Message,
 			UINT uType = MB_OK);
@@ -38,6 +44,13 @@ class DllExport Resource
 			int	StringId);
 
 	private:
-		LPCTSTR m_ModulePath;
-		HMODULE m_ResourceModule;
+		TCHAR*		m_CatalogPath;
+		LPCTSTR		m_ModulePath;
+		HMODULE		m_ResourceModule;
+		StringTable	m_Strings;
+
+		Resource(
+			const Resource&);
+		Resource& operator=(
+			const Resource&);
 };
@@ -0,0 +1,357 @@
+/////////////////////////////////////////////////////////////////////////////
+// StringBatch.cpp - Class Implementation
+//
+// Converts many strings at once into a single buffer.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "StringBatch.h"
+#include "Parallel.h"
+#include "TextScan.h"
+#include "Utils.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+// shared by every slice of one conversion
+struct BatchJob
+{
+	ULONG			CodePage;
+	bool			AsciiCompatible;
+	const void*		Strings;
+	BYTE*			Buffer;
+	const size_t*	InputLengths;
+	size_t*			Slots;
+	size_t*			Lengths;
+	bool			ToUnicode;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// ConvertSlice
+//
+// Converts strings [Begin, End) into their slots, recording the number of
+// characters written for each.
+/////////////////////////////////////////////////////////////////////////////
+static void
+	ConvertSlice(
+	void*	Context,
+	size_t	Begin,
+	size_t	End)
+{
+	BatchJob*	Job	= (BatchJob*)Context;
+
+	for (size_t Index = Begin; Index < End; Index++)
+	{
+		size_t	InputLength	= Job->InputLengths[Index];
+		size_t	SlotSize	= Job->Slots[Index + 1] - Job->Slots[Index] - 1;
+		size_t	Written		= 0;
+
+		if (true == Job->ToUnicode)
+		{
+			LPCSTR		Input	= ((const LPCSTR*)Job->Strings)[Index];
+			wchar_t*	Output	= (wchar_t*)Job->Buffer + Job->Slots[Index];
+
+			if ((true == Job->AsciiCompatible) &&
+				(InputLength == GetAsciiLength(Input, InputLength)))
+			{
+				WidenAscii(Input, InputLength, Output);
+				Written = InputLength;
+			}
+			else
+			{
+				Written = ConvertMultiByteToUnicode(Job->CodePage, Input,
+					InputLength, Output, SlotSize, NULL);
+			}
+
+			Output[Written] = L'\0';
+		}
+		else
+		{
+			LPCWSTR	Input	= ((const LPCWSTR*)Job->Strings)[Index];
+			char*	Output	= (char*)Job->Buffer + Job->Slots[Index];
+
+			if ((true == Job->AsciiCompatible) &&
+				(InputLength == GetUnicodeRunLength(Input, InputLength, 0x80)))
+			{
+				NarrowAscii(Input, InputLength, Output);
+				Written = InputLength;
+			}
+			else
+			{
+				Written = ConvertUnicodeToMultiByte(Job->CodePage, Input,
+					InputLength, Output, SlotSize, NULL);
+			}
+
+			Output[Written] = '\0';
+		}
+
+		Job->Lengths[Index] = Written;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+StringBatch::StringBatch(void) :
+	m_Buffer(NULL),
+	m_Count(0),
+	m_Offsets(NULL),
+	m_Unicode(false)
+{
+}
+
+StringBatch::~StringBatch(void)
+{
+	Clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Clear
+/////////////////////////////////////////////////////////////////////////////
+void
+	StringBatch::Clear(void)
+{
+	if (NULL != m_Buffer)
+	{
+		delete[] m_Buffer;
+		m_Buffer = NULL;
+	}
+
+	if (NULL != m_Offsets)
+	{
+		delete[] m_Offsets;
+		m_Offsets = NULL;
+	}
+
+	m_Count = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ConvertToMultiByte
+/////////////////////////////////////////////////////////////////////////////
+bool
+	StringBatch::ConvertToMultiByte(
+	ULONG			CodePage,
+	const LPCWSTR*	Strings,
+	size_t			Count,
+	DWORD			ThreadCount)
+{
+	return Convert(CodePage, Strings, Count, ThreadCount, false);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ConvertToUnicode
+/////////////////////////////////////////////////////////////////////////////
+bool
+	StringBatch::ConvertToUnicode(
+	ULONG			CodePage,
+	const LPCSTR*	Strings,
+	size_t			Count,
+	DWORD			ThreadCount)
+{
+	return Convert(CodePage, Strings, Count, ThreadCount, true);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Accessors
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	StringBatch::GetCount(void) const
+{
+	return m_Count;
+}
+
+size_t
+	StringBatch::GetLength(
+	size_t	Index) const
+{
+	size_t	Length	= 0;
+
+	if (Index < m_Count)
+	{
+		Length = m_Offsets[Index + 1] - m_Offsets[Index] - 1;
+	}
+
+	return Length;
+}
+
+LPCSTR
+	StringBatch::GetMultiByteString(
+	size_t	Index) const
+{
+	LPCSTR	String	= NULL;
+
+	if ((false == m_Unicode) && (Index < m_Count))
+	{
+		String = (LPCSTR)m_Buffer + m_Offsets[Index];
+	}
+
+	return String;
+}
+
+const size_t*
+	StringBatch::GetOffsets(void) const
+{
+	return m_Offsets;
+}
+
+LPCWSTR
+	StringBatch::GetUnicodeString(
+	size_t	Index) const
+{
+	LPCWSTR	String	= NULL;
+
+	if ((true == m_Unicode) && (Index < m_Count))
+	{
+		String = (LPCWSTR)m_Buffer + m_Offsets[Index];
+	}
+
+	return String;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Convert
+//
+// Every string gets a slot sized by the worst case for the code page, so
+// the slots can be filled independently, and then the results are packed
+// down in place.  NULL input strings are treated as empty.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	StringBatch::Convert(
+	ULONG			CodePage,
+	const void*		Strings,
+	size_t			Count,
+	DWORD			ThreadCount,
+	bool			ToUnicode)
+{
+	bool	ReturnCode	= false;
+
+	Clear();
+	m_Unicode = ToUnicode;
+
+	if ((NULL != Strings) || (0 == Count))
+	{
+		size_t	UnitSize	= sizeof(char);
+		size_t	InputSize	= 0;
+
+		if (true == ToUnicode)
+		{
+			UnitSize = sizeof(wchar_t);
+		}
+
+		// delete after use
+		size_t*	InputLengths	= new size_t[Count + 1];
+		size_t*	Lengths			= new size_t[Count + 1];
+
+		m_Offsets = new size_t[Count + 1];
+
+		if ((NULL != InputLengths) && (NULL != Lengths) && (NULL != m_Offsets))
+		{
+			size_t	Total	= 0;
+
+			for (size_t Index = 0; Index < Count; Index++)
+			{
+				size_t	Length	= 0;
+				size_t	Bound	= 0;
+
+				if (true == ToUnicode)
+				{
+					LPCSTR	String	= ((const LPCSTR*)Strings)[Index];
+
+					if (NULL != String)
+					{
+						Length = strlen(String);
+					}
+
+					Bound = GetUnicodeBound(CodePage, Length);
+				}
+				else
+				{
+					LPCWSTR	String	= ((const LPCWSTR*)Strings)[Index];
+
+					if (NULL != String)
+					{
+						Length = wcslen(String);
+					}
+
+					Bound = GetMultiByteBound(CodePage, Length);
+				}
+
+				InputLengths[Index]	= Length;
+				InputSize			+= Length;
+				m_Offsets[Index]	= Total;
+				Total				+= Bound + 1;
+			}
+
+			m_Offsets[Count] = Total;
+
+			m_Buffer = new BYTE[Total * UnitSize + UnitSize];
+
+			if (NULL != m_Buffer)
+			{
+				BatchJob	Job;
+
+				Job.CodePage		= CodePage;
+				Job.AsciiCompatible	= IsAsciiCompatible(CodePage);
+				Job.Strings			= Strings;
+				Job.Buffer			= m_Buffer;
+				Job.InputLengths	= InputLengths;
+				Job.Slots			= m_Offsets;
+				Job.Lengths			= Lengths;
+				Job.ToUnicode		= ToUnicode;
+
+				if (InputSize < STRING_BATCH_PARALLEL_SIZE)
+				{
+					ThreadCount = 1;
+				}
+
+				ParallelFor(Count, ThreadCount, ConvertSlice, &Job);
+
+				// pack each string down against the one before it
+				size_t	Offset	= 0;
+
+				for (size_t Index = 0; Index < Count; Index++)
+				{
+					size_t	Characters	= Lengths[Index] + 1;
+
+					if (Offset != m_Offsets[Index])
+					{
+						memmove(m_Buffer + Offset * UnitSize,
+							m_Buffer + m_Offsets[Index] * UnitSize,
+							Characters * UnitSize);
+					}
+
+					m_Offsets[Index]	= Offset;
+					Offset				+= Characters;
+				}
+
+				m_Offsets[Count]	= Offset;
+				m_Count				= Count;
+				ReturnCode			= true;
+			}
+		}
+
+		if (NULL != InputLengths)
+		{
+			delete[] InputLengths;
+		}
+
+		if (NULL != Lengths)
+		{
+			delete[] Lengths;
+		}
+
+		if (false == ReturnCode)
+		{
+			Clear();
+		}
+	}
+
+	return ReturnCode;
+}
@@ -0,0 +1,82 @@
+/////////////////////////////////////////////////////////////////////////////
+// StringBatch.h - Class Declaration
+//
+// Converts many strings at once into a single buffer.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+// batches with less input than this are always converted on one thread
+const size_t STRING_BATCH_PARALLEL_SIZE	= 1024 * 1024;
+
+/////////////////////////////////////////////////////////////////////////////
+// StringBatch Class Definition
+//
+// All of the converted strings are stored back to back, each with its
+// terminator, in one buffer owned by the batch.  String Index starts at
+// GetOffsets()[Index], in characters, and the table has one extra entry
+// marking the end of the buffer.  Pointers returned are valid until the
+// batch is cleared, converted again or destroyed.
+/////////////////////////////////////////////////////////////////////////////
+class DllExport StringBatch
+{
+	public:
+		// Properties
+
+		// Methods
+			StringBatch(void);
+			~StringBatch(void);
+
+			void Clear(void);
+
+			// ThreadCount of 0 means one per processor, 1 means no threads
+			bool ConvertToMultiByte(
+				ULONG			CodePage,
+				const LPCWSTR*	Strings,
+				size_t			Count,
+				DWORD			ThreadCount = 1);
+			bool ConvertToUnicode(
+				ULONG			CodePage,
+				const LPCSTR*	Strings,
+				size_t			Count,
+				DWORD			ThreadCount = 1);
+
+			size_t GetCount(void) const;
+			size_t GetLength(
+				size_t	Index) const;
+			LPCSTR GetMultiByteString(
+				size_t	Index) const;
+			const size_t* GetOffsets(void) const;
+			LPCWSTR GetUnicodeString(
+				size_t	Index) const;
+
+	private:
+		// Properties
+			BYTE*	m_Buffer;
+			size_t	m_Count;
+			size_t*	m_Offsets;
+			bool	m_Unicode;
+
+		// Methods
+			StringBatch(
+				const StringBatch&);
+			StringBatch& operator=(
+				const StringBatch&);
+
+			bool Convert(
+				ULONG			CodePage,
+				const void*		Strings,
+				size_t			Count,
+				DWORD			ThreadCount,
+				bool			ToUnicode);
+};
@@ -0,0 +1,432 @@
+/////////////////////////////////////////////////////////////////////////////
+// StringCatalog.cpp - Class Implementation
+//
+// Reads one language of a string catalog file into wchar_t text, with
+// nothing but the C library, so it builds and is tested off Windows.
+//
+// Copyright (c) 2010 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+// built without the precompiled header, so as not to need Windows
+#include <stdio.h>
+#include <string.h>
+#include "StringCatalog.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+// PRIMARYLANGID, without windows.h
+#define PRIMARY_LANGUAGE(LanguageId)	((LanguageId) & 0x3FF)
+
+#define LEAD_SURROGATE_FIRST	0xD800
+#define TRAIL_SURROGATE_FIRST	0xDC00
+#define TRAIL_SURROGATE_LAST	0xDFFF
+#define UNICODE_LAST			0x10FFFF
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+StringCatalog::StringCatalog(void) :
+	m_Contents(NULL),
+	m_Catalog(NULL),
+	m_CharSize(0),
+	m_TextLength(0),
+	m_Open(false)
+{
+	memset(&m_Language, 0, sizeof(m_Language));
+}
+
+StringCatalog::~StringCatalog(void)
+{
+	Close();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Close
+/////////////////////////////////////////////////////////////////////////////
+void
+	StringCatalog::Close(void)
+{
+	if (NULL != m_Contents)
+	{
+		delete[] m_Contents;
+		m_Contents = NULL;
+	}
+
+	m_Catalog		= NULL;
+	m_CharSize		= 0;
+	m_TextLength	= 0;
+	m_Open			= false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Decode
+//
+// Offsets takes GetIdCount() + 1 entries, and Text GetTextLength() + 1
+// characters, the last a terminator.  Does nothing unless open.
+/////////////////////////////////////////////////////////////////////////////
+void
+	StringCatalog::Decode(
+	unsigned int*	Offsets,
+	wchar_t*		Text) const
+{
+	if (true == m_Open)
+	{
+		Offsets[0] = 0;
+
+		for (unsigned int Index = 0; Index < m_Language.IdCount; Index++)
+		{
+			Offsets[Index + 1] = Offsets[Index] + (unsigned int)DecodeString(
+				GetOffset(Index), GetOffset(Index + 1), Text + Offsets[Index]);
+		}
+
+		Text[m_TextLength] = L'\0';
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetFirstId
+/////////////////////////////////////////////////////////////////////////////
+unsigned int
+	StringCatalog::GetFirstId(void) const
+{
+	unsigned int	FirstId	= 0;
+
+	if (true == m_Open)
+	{
+		FirstId = m_Language.FirstId;
+	}
+
+	return FirstId;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetIdCount
+/////////////////////////////////////////////////////////////////////////////
+unsigned int
+	StringCatalog::GetIdCount(void) const
+{
+	unsigned int	IdCount	= 0;
+
+	if (true == m_Open)
+	{
+		IdCount = m_Language.IdCount;
+	}
+
+	return IdCount;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetLanguageId
+//
+// The language found, which may differ from the one asked for in its sub
+// language; 0 if none.
+/////////////////////////////////////////////////////////////////////////////
+unsigned int
+	StringCatalog::GetLanguageId(void) const
+{
+	unsigned int	LanguageId	= 0;
+
+	if (true == m_Open)
+	{
+		LanguageId = m_Language.LanguageId;
+	}
+
+	return LanguageId;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetTextLength
+//
+// In wchar_t, without the terminator Decode adds.
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	StringCatalog::GetTextLength(void) const
+{
+	return m_TextLength;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Load
+//
+// Reads the whole catalog file, then opens it as Open does.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	StringCatalog::Load(
+	const char*		CatalogPath,
+	unsigned int	LanguageId)
+{
+	bool	ReturnCode	= false;
+	long	Size		= -1;
+	FILE*	File		= NULL;
+
+	Close();
+
+	if (NULL != CatalogPath)
+	{
+		File = fopen(CatalogPath, "rb");
+	}
+
+	if (NULL != File)
+	{
+		if (0 == fseek(File, 0, SEEK_END))
+		{
+			Size = ftell(File);
+		}
+
+		if ((0 <= Size) && (0 == fseek(File, 0, SEEK_SET)))
+		{
+			m_Contents = new unsigned char[Size + 1];
+		}
+
+		if ((NULL != m_Contents) &&
+			((size_t)Size == fread(m_Contents, 1, (size_t)Size, File)))
+		{
+			ReturnCode = true;
+		}
+
+		fclose(File);
+	}
+
+	if (true == ReturnCode)
+	{
+		ReturnCode = Open(m_Contents, (size_t)Size, LanguageId);
+	}
+
+	if (false == ReturnCode)
+	{
+		Close();
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Open
+//
+// Checks the catalog and picks the language, or if the catalog does not
+// have it, the first language with the same primary language.  The
+// catalog is read in place, so must outlast the object, or its next
+// Open or Close; it need only be byte aligned.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	StringCatalog::Open(
+	const unsigned char*	Catalog,
+	size_t					Size,
+	unsigned int			LanguageId)
+{
+	bool					ReturnCode	= false;
+	bool					Found		= false;
+	StringCatalogHeader		Header;
+
+	if (Catalog != m_Contents)
+	{
+		Close();
+	}
+
+	memset(&Header, 0, sizeof(Header));
+
+	m_Catalog		= Catalog;
+	m_CharSize		= 0;
+	m_TextLength	= 0;
+	m_Open			= false;
+
+	if ((NULL != Catalog) && (sizeof(StringCatalogHeader) <= Size))
+	{
+		memcpy(&Header, Catalog, sizeof(StringCatalogHeader));
+
+		if ((STRING_CATALOG_MAGIC == Header.Magic) &&
+			(STRING_CATALOG_VERSION == Header.Version) &&
+			((2 == Header.CharSize) || (4 == Header.CharSize)) &&
+			(Header.LanguageCount <= (Size - sizeof(StringCatalogHeader)) /
+				sizeof(StringCatalogLanguage)))
+		{
+			m_CharSize = Header.CharSize;
+			ReturnCode = true;
+		}
+	}
+
+	for (unsigned int Index = 0;
+		(true == ReturnCode) && (Index < Header.LanguageCount); Index++)
+	{
+		StringCatalogLanguage	Entry;
+
+		memcpy(&Entry, Catalog + sizeof(StringCatalogHeader) +
+			(size_t)Index * sizeof(StringCatalogLanguage), sizeof(Entry));
+
+		if (LanguageId == Entry.LanguageId)
+		{
+			m_Language	= Entry;
+			Found		= true;
+			break;
+		}
+
+		if ((false == Found) && (PRIMARY_LANGUAGE(LanguageId) ==
+			PRIMARY_LANGUAGE(Entry.LanguageId)))
+		{
+			m_Language	= Entry;
+			Found		= true;
+		}
+	}
+
+	ReturnCode = ((true == Found) &&
+		((unsigned long long)m_Language.OffsetsOffset +
+			((unsigned long long)m_Language.IdCount + 1) * 4 <= Size) &&
+		((unsigned long long)m_Language.TextOffset +
+			(unsigned long long)m_Language.TextLength * m_CharSize <= Size));
+
+	// every string must be in the text, terminated, and decodable
+	for (unsigned int Index = 0;
+		(true == ReturnCode) && (Index < m_Language.IdCount); Index++)
+	{
+		unsigned int	Start	= GetOffset(Index);
+		unsigned int	End		= GetOffset(Index + 1);
+		size_t			Length	= (size_t)-1;
+
+		if ((Start <= End) && (End <= m_Language.TextLength) &&
+			((Start == End) || (0 == GetUnit(End - 1))))
+		{
+			Length = DecodeString(Start, End, NULL);
+		}
+
+		if ((size_t)-1 == Length)
+		{
+			ReturnCode = false;
+		}
+		else
+		{
+			m_TextLength += Length;
+		}
+	}
+
+	// offsets into the decoded text are 32 bits too
+	if ((true == ReturnCode) && (0xFFFFFFFF <= m_TextLength))
+	{
+		ReturnCode = false;
+	}
+
+	if (true == ReturnCode)
+	{
+		m_Open = true;
+	}
+	else
+	{
+		m_TextLength = 0;
+	}
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DecodeString
+//
+// Decodes the characters from Start to End into Text, if not NULL.
+// Returns the number of wchar_t, or (size_t)-1 for a character that is
+// not Unicode.  Pairs are only joined within the string.
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	StringCatalog::DecodeString(
+	unsigned int	Start,
+	unsigned int	End,
+	wchar_t*		Text) const
+{
+	size_t	Length	= 0;
+
+	for (unsigned int Index = Start; Index < End; Index++)
+	{
+		unsigned int	Character	= GetUnit(Index);
+
+		if ((4 == m_CharSize) && ((UNICODE_LAST < Character) ||
+			((LEAD_SURROGATE_FIRST <= Character) &&
+				(Character <= TRAIL_SURROGATE_LAST))))
+		{
+			Length = (size_t)-1;
+			break;
+		}
+
+		if ((2 == m_CharSize) && (4 == sizeof(wchar_t)) &&
+			(LEAD_SURROGATE_FIRST <= Character) &&
+			(Character < TRAIL_SURROGATE_FIRST) && (Index + 1 < End))
+		{
+			unsigned int	Trail	= GetUnit(Index + 1);
+
+			if ((TRAIL_SURROGATE_FIRST <= Trail) &&
+				(Trail <= TRAIL_SURROGATE_LAST))
+			{
+				Character = 0x10000 +
+					((Character - LEAD_SURROGATE_FIRST) << 10) +
+					(Trail - TRAIL_SURROGATE_FIRST);
+				Index++;
+			}
+		}
+
+		if ((2 == sizeof(wchar_t)) && (0xFFFF < Character))
+		{
+			if (NULL != Text)
+			{
+				Character -= 0x10000;
+
+				Text[Length]		= (wchar_t)(LEAD_SURROGATE_FIRST +
+					(Character >> 10));
+				Text[Length + 1]	= (wchar_t)(TRAIL_SURROGATE_FIRST +
+					(Character & 0x3FF));
+			}
+
+			Length += 2;
+		}
+		else
+		{
+			if (NULL != Text)
+			{
+				Text[Length] = (wchar_t)Character;
+			}
+
+			Length++;
+		}
+	}
+
+	return Length;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetOffset
+//
+// The language's offset for the id index, in the catalog's characters.
+/////////////////////////////////////////////////////////////////////////////
+unsigned int
+	StringCatalog::GetOffset(
+	unsigned int	Index) const
+{
+	const unsigned char*	Offset	=
+		m_Catalog + m_Language.OffsetsOffset + (size_t)Index * 4;
+
+	return (unsigned int)Offset[0] | ((unsigned int)Offset[1] << 8) |
+		((unsigned int)Offset[2] << 16) | ((unsigned int)Offset[3] << 24);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetUnit
+//
+// The language's text character at the index, as stored; so one half of
+// a surrogate pair in a UTF-16 catalog.
+/////////////////////////////////////////////////////////////////////////////
+unsigned int
+	StringCatalog::GetUnit(
+	unsigned int	Index) const
+{
+	const unsigned char*	Unit	=
+		m_Catalog + m_Language.TextOffset + (size_t)Index * m_CharSize;
+	unsigned int			Value	=
+		(unsigned int)Unit[0] | ((unsigned int)Unit[1] << 8);
+
+	if (4 == m_CharSize)
+	{
+		Value |= ((unsigned int)Unit[2] << 16) | ((unsigned int)Unit[3] << 24);
+	}
+
+	return Value;
+}
@@ -0,0 +1,119 @@
+/////////////////////////////////////////////////////////////////////////////
+// StringCatalog.h - Class Declaration
+//
+// Reads one language of a string catalog file into wchar_t text, with
+// nothing but the C library, so it builds and is tested off Windows.
+//
+// Copyright (c) 2010 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+const unsigned int STRING_CATALOG_MAGIC		= 0x5441435A;	// "ZCAT"
+const unsigned int STRING_CATALOG_VERSION	= 1;
+
+/////////////////////////////////////////////////////////////////////////////
+// Types
+//
+// A string catalog file, as written by MakeStringCatalog.py, is laid out
+// as follows, all little endian, in 32 bit fields:
+//
+//	StringCatalogHeader
+//	StringCatalogLanguage[LanguageCount]
+//	for each language, at the offsets its entry gives:
+//		Offsets[IdCount + 1]
+//		Text, in CharSize byte characters
+//
+// String Id - FirstId starts at Offsets[Id - FirstId] in the text and
+// ends, terminator included, before the next offset; equal offsets mean
+// no string.  Offsets and text start on 4 byte boundaries, so a mapped
+// catalog can be used in place, as MessageCatalog does.
+/////////////////////////////////////////////////////////////////////////////
+struct StringCatalogHeader
+{
+	unsigned int	Magic;
+	unsigned int	Version;
+	// 2 for UTF-16, or 4 for UTF-32, as wchar_t is off Windows
+	unsigned int	CharSize;
+	unsigned int	LanguageCount;
+};
+
+struct StringCatalogLanguage
+{
+	unsigned int	LanguageId;
+	unsigned int	FirstId;
+	unsigned int	IdCount;
+	// in bytes, from the start of the file
+	unsigned int	OffsetsOffset;
+	unsigned int	TextOffset;
+	// in characters
+	unsigned int	TextLength;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// StringCatalog Class Definition
+//
+// Open checks the catalog and picks the language, and Decode writes it
+// out as wchar_t text with offsets into it, in the layout StringTable
+// uses.  A catalog written with a character size other than wchar_t's
+// is converted: UTF-32 characters outside the BMP become surrogate pairs
+// where wchar_t is 16 bits, and pairs are joined where it is 32; a
+// catalog with characters that are not Unicode is rejected.
+/////////////////////////////////////////////////////////////////////////////
+class StringCatalog
+{
+	public:
+		// Properties
+
+		// Methods
+			StringCatalog(void);
+			~StringCatalog(void);
+
+			void Close(void);
+			void Decode(
+				unsigned int*	Offsets,
+				wchar_t*		Text) const;
+			unsigned int GetFirstId(void) const;
+			unsigned int GetIdCount(void) const;
+			unsigned int GetLanguageId(void) const;
+			size_t GetTextLength(void) const;
+			bool Load(
+				const char*		CatalogPath,
+				unsigned int	LanguageId);
+			bool Open(
+				const unsigned char*	Catalog,
+				size_t					Size,
+				unsigned int			LanguageId);
+
+	private:
+		// Properties
+			unsigned char*			m_Contents;
+			const unsigned char*	m_Catalog;
+			StringCatalogLanguage	m_Language;
+			unsigned int			m_CharSize;
+			size_t					m_TextLength;
+			bool					m_Open;
+
+		// Methods
+			StringCatalog(
+				const StringCatalog&);
+			StringCatalog& operator=(
+				const StringCatalog&);
+
+			size_t DecodeString(
+				unsigned int	Start,
+				unsigned int	End,
+				wchar_t*		Text) const;
+			unsigned int GetOffset(
+				unsigned int	Index) const;
+			unsigned int GetUnit(
+				unsigned int	Index) const;
+};
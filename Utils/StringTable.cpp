@@ -0,0 +1,400 @@
+/////////////////////////////////////////////////////////////////////////////
+// StringTable.cpp - Class Implementation
+//
+// One language's localized strings, held in memory and found by id.
+//
+// Copyright (c) 2010 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "StringTable.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Defines
+/////////////////////////////////////////////////////////////////////////////
+// strings per RT_STRING resource; block n holds ids (n - 1) * 16 on
+#define STRING_BLOCK_SIZE	16
+
+#if defined(_WIN32)
+/////////////////////////////////////////////////////////////////////////////
+// Types
+/////////////////////////////////////////////////////////////////////////////
+struct StringBlockRange
+{
+	UINT	First;
+	UINT	Last;
+	bool	Found;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// EnumStringBlock
+//
+// Widens the range to take in each RT_STRING block of the module.
+/////////////////////////////////////////////////////////////////////////////
+static BOOL CALLBACK
+	EnumStringBlock(
+	HMODULE		Module,
+	LPCTSTR		Type,
+	LPTSTR		Name,
+	LONG_PTR	Parameter)
+{
+	StringBlockRange*	Range	= (StringBlockRange*)Parameter;
+
+	if (IS_INTRESOURCE(Name))
+	{
+		UINT	Block	= (UINT)(ULONG_PTR)Name;
+
+		if ((false == Range->Found) || (Block < Range->First))
+		{
+			Range->First = Block;
+		}
+
+		if ((false == Range->Found) || (Block > Range->Last))
+		{
+			Range->Last = Block;
+		}
+
+		Range->Found = true;
+	}
+
+	return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// FindStringBlock
+//
+// Falls back to the module's default language when the block is missing
+// in the one asked for, as LoadString does.
+/////////////////////////////////////////////////////////////////////////////
+static const WCHAR*
+	FindStringBlock(
+	HMODULE	Module,
+	UINT	Block,
+	WORD	LanguageId)
+{
+	const WCHAR*	Strings	= NULL;
+	HRSRC			Found	= FindResourceEx(Module, RT_STRING,
+		MAKEINTRESOURCE(Block), LanguageId);
+
+	if (NULL == Found)
+	{
+		Found = FindResource(Module, MAKEINTRESOURCE(Block), RT_STRING);
+	}
+
+	if (NULL != Found)
+	{
+		HGLOBAL	Loaded	= LoadResource(Module, Found);
+
+		if (NULL != Loaded)
+		{
+			Strings = (const WCHAR*)LockResource(Loaded);
+		}
+	}
+
+	return Strings;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// ReadCatalogFile
+//
+// delete returned buffer after use.
+/////////////////////////////////////////////////////////////////////////////
+static BYTE*
+	ReadCatalogFile(
+	LPCTSTR	CatalogPath,
+	DWORD*	Size)
+{
+	BYTE*	Contents	= NULL;
+	HANDLE	File		= CreateFile(CatalogPath, GENERIC_READ,
+		FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (INVALID_HANDLE_VALUE != File)
+	{
+		DWORD	FileSize	= GetFileSize(File, NULL);
+
+		if (INVALID_FILE_SIZE != FileSize)
+		{
+			Contents = new BYTE[FileSize + 1];
+		}
+
+		if ((NULL != Contents) &&
+			((FALSE == ReadFile(File, Contents, FileSize, Size, NULL)) ||
+			(FileSize != *Size)))
+		{
+			delete[] Contents;
+			Contents = NULL;
+		}
+
+		CloseHandle(File);
+	}
+
+	return Contents;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructors / Destructors
+/////////////////////////////////////////////////////////////////////////////
+StringTable::StringTable(void) :
+	m_Text(NULL),
+	m_Offsets(NULL),
+	m_FirstId(0),
+	m_IdCount(0),
+	m_LanguageId(0),
+	m_Loaded(false)
+{
+}
+
+StringTable::~StringTable(void)
+{
+	Clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Clear
+/////////////////////////////////////////////////////////////////////////////
+void
+	StringTable::Clear(void)
+{
+	if (NULL != m_Text)
+	{
+		delete[] m_Text;
+		m_Text = NULL;
+	}
+
+	if (NULL != m_Offsets)
+	{
+		delete[] m_Offsets;
+		m_Offsets = NULL;
+	}
+
+	m_FirstId		= 0;
+	m_IdCount		= 0;
+	m_LanguageId	= 0;
+	m_Loaded		= false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetLanguageId
+//
+// The language asked for when the table was loaded.
+/////////////////////////////////////////////////////////////////////////////
+WORD
+	StringTable::GetLanguageId(void) const
+{
+	return m_LanguageId;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetString
+//
+// Returns NULL if there is no such string.  Length, if not NULL, gets the
+// length without the terminator.
+/////////////////////////////////////////////////////////////////////////////
+LPCTSTR
+	StringTable::GetString(
+	UINT	StringId,
+	size_t*	Length) const
+{
+	LPCTSTR	String	= NULL;
+	UINT	Index	= StringId - m_FirstId;
+
+	if ((true == m_Loaded) && (StringId >= m_FirstId) && (Index < m_IdCount))
+	{
+		DWORD	Start	= m_Offsets[Index];
+		DWORD	End		= m_Offsets[Index + 1];
+
+		if (End > Start)
+		{
+			String = m_Text + Start;
+
+			if (NULL != Length)
+			{
+				*Length = End - Start - 1;
+			}
+		}
+	}
+
+	return String;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsLoaded
+/////////////////////////////////////////////////////////////////////////////
+bool
+	StringTable::IsLoaded(void) const
+{
+	return m_Loaded;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// LoadCatalog
+//
+// Loads the language from a catalog file, or if the catalog does not
+// have it, the first language with the same primary language.  The
+// catalog is read by StringCatalog, as it is off Windows.  Unicode
+// builds only, as the strings are kept as wchar_t.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	StringTable::LoadCatalog(
+	LPCTSTR	CatalogPath,
+	WORD	LanguageId)
+{
+	bool			ReturnCode	= false;
+	DWORD			Size		= 0;
+	BYTE*			Contents	= NULL;
+	StringCatalog	Catalog;
+
+	Clear();
+
+#ifdef UNICODE
+	Contents = ReadCatalogFile(CatalogPath, &Size);
+
+	if ((NULL != Contents) &&
+		(true == Catalog.Open(Contents, Size, LanguageId)))
+	{
+		ReturnCode = Allocate(Catalog.GetIdCount(), Catalog.GetTextLength());
+	}
+
+	if (true == ReturnCode)
+	{
+		Catalog.Decode(m_Offsets, m_Text);
+
+		m_FirstId		= Catalog.GetFirstId();
+		m_IdCount		= Catalog.GetIdCount();
+		m_LanguageId	= LanguageId;
+		m_Loaded		= true;
+	}
+	else
+	{
+		Clear();
+	}
+
+	if (NULL != Contents)
+	{
+		delete[] Contents;
+	}
+#endif
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// LoadModule
+//
+// Loads every RT_STRING block of the module in the language, in two
+// passes: one to size the table, one to fill it.  Windows only.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	StringTable::LoadModule(
+	HMODULE	Module,
+	WORD	LanguageId)
+{
+	bool	ReturnCode	= false;
+
+	Clear();
+
+#if defined(_WIN32)
+	StringBlockRange	Range	= { 0, 0, false };
+
+	EnumResourceNames(Module, RT_STRING, EnumStringBlock, (LONG_PTR)&Range);
+
+	if (true == Range.Found)
+	{
+		UINT			BlockCount	= Range.Last - Range.First + 1;
+		const WCHAR**	Blocks		= new const WCHAR*[BlockCount];
+		size_t			TextLength	= 0;
+
+		if (NULL != Blocks)
+		{
+			for (UINT Block = 0; Block < BlockCount; Block++)
+			{
+				const WCHAR*	Strings	= FindStringBlock(Module,
+					Range.First + Block, LanguageId);
+
+				Blocks[Block] = Strings;
+
+				for (UINT Index = 0;
+					(NULL != Strings) && (Index < STRING_BLOCK_SIZE); Index++)
+				{
+					if (0 < *Strings)
+					{
+						TextLength += *Strings + 1;
+					}
+
+					Strings += *Strings + 1;
+				}
+			}
+
+			ReturnCode = Allocate(BlockCount * STRING_BLOCK_SIZE, TextLength);
+		}
+
+		if (true == ReturnCode)
+		{
+			DWORD	Offset	= 0;
+
+			for (UINT Block = 0; Block < BlockCount; Block++)
+			{
+				const WCHAR*	Strings	= Blocks[Block];
+
+				for (UINT Index = 0; Index < STRING_BLOCK_SIZE; Index++)
+				{
+					m_Offsets[Block * STRING_BLOCK_SIZE + Index] = Offset;
+
+					if (NULL != Strings)
+					{
+						WORD	Length	= *Strings;
+
+						if (0 < Length)
+						{
+							for (WORD Character = 0; Character < Length;
+								Character++)
+							{
+								m_Text[Offset + Character] =
+									(TCHAR)Strings[Character + 1];
+							}
+
+							m_Text[Offset + Length] = _T('\0');
+							Offset += Length + 1;
+						}
+
+						Strings += Length + 1;
+					}
+				}
+			}
+
+			m_Offsets[BlockCount * STRING_BLOCK_SIZE] = Offset;
+
+			m_FirstId		= (Range.First - 1) * STRING_BLOCK_SIZE;
+			m_IdCount		= BlockCount * STRING_BLOCK_SIZE;
+			m_LanguageId	= LanguageId;
+			m_Loaded		= true;
+		}
+
+		if (NULL != Blocks)
+		{
+			delete[] Blocks;
+		}
+	}
+#endif
+
+	return ReturnCode;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Allocate
+/////////////////////////////////////////////////////////////////////////////
+bool
+	StringTable::Allocate(
+	UINT	IdCount,
+	size_t	TextLength)
+{
+	m_Offsets	= new UINT[IdCount + 1];
+	m_Text		= new TCHAR[TextLength + 1];
+
+	return ((NULL != m_Offsets) && (NULL != m_Text));
+}
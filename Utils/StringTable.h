@@ -0,0 +1,65 @@
+/////////////////////////////////////////////////////////////////////////////
+// StringTable.h - Class Declaration
+//
+// One language's localized strings, held in memory and found by id.
+//
+// Copyright (c) 2010 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+#include "StringCatalog.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// StringTable Class Definition
+//
+// Every string of the language is in one block of text, indexed by id
+// less the lowest id, so finding a string is an array lookup.  Strings
+// returned are views into the table, valid until it is cleared or
+// loaded again.
+/////////////////////////////////////////////////////////////////////////////
+class DllExport StringTable
+{
+	public:
+		// Properties
+
+		// Methods
+			StringTable(void);
+			~StringTable(void);
+
+			void Clear(void);
+			WORD GetLanguageId(void) const;
+			LPCTSTR GetString(
+				UINT	StringId,
+				size_t*	Length) const;
+			bool IsLoaded(void) const;
+			bool LoadCatalog(
+				LPCTSTR	CatalogPath,
+				WORD	LanguageId);
+			bool LoadModule(
+				HMODULE	Module,
+				WORD	LanguageId);
+
+	private:
+		// Properties
+			TCHAR*	m_Text;
+			UINT*	m_Offsets;
+			UINT	m_FirstId;
+			UINT	m_IdCount;
+			WORD	m_LanguageId;
+			bool	m_Loaded;
+
+		// Methods
+			StringTable(
+				const StringTable&);
+			StringTable& operator=(
+				const StringTable&);
+
+			bool Allocate(
+				UINT	IdCount,
+				size_t	TextLength);
+};
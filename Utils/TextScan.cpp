@@ -0,0 +1,195 @@
+/////////////////////////////////////////////////////////////////////////////
+// TextScan.cpp
+//
+// SSE2 helpers for finding and copying runs of plain text.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "StdAfx.h"
+#include "TextScan.h"
+#include "Utils.h"
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// GetAsciiLength
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	GetAsciiLength(
+	const char*	String,
+	size_t		Length)
+{
+	size_t	Index	= 0;
+
+	if (NULL != String)
+	{
+#ifdef USE_SSE2
+		for (; Index + 16 <= Length; Index += 16)
+		{
+			__m128i	Block	= _mm_loadu_si128((const __m128i*)(String + Index));
+
+			if (0 != _mm_movemask_epi8(Block))
+			{
+				break;
+			}
+		}
+#endif
+		while ((Index < Length) && (0 == (String[Index] & 0x80)))
+		{
+			Index++;
+		}
+	}
+
+	return Index;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetUnicodeRunLength
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	GetUnicodeRunLength(
+	const wchar_t*	String,
+	size_t			Length,
+	wchar_t			Limit)
+{
+	size_t	Index	= 0;
+
+	if ((NULL != String) && (0 < Limit))
+	{
+#ifdef USE_SSE2
+		// a < Limit exactly when a - (Limit - 1), saturated, is 0
+		const __m128i	Maximum	= _mm_set1_epi16((short)(Limit - 1));
+		const __m128i	Zero	= _mm_setzero_si128();
+
+		for (; Index + 8 <= Length; Index += 8)
+		{
+			__m128i	Block	= _mm_loadu_si128((const __m128i*)(String + Index));
+			__m128i	Over	= _mm_subs_epu16(Block, Maximum);
+
+			if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi16(Over, Zero)))
+			{
+				break;
+			}
+		}
+#endif
+		while ((Index < Length) && (String[Index] < Limit))
+		{
+			Index++;
+		}
+	}
+
+	return Index;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IsAsciiCompatible
+/////////////////////////////////////////////////////////////////////////////
+bool
+	IsAsciiCompatible(
+	ULONG	CodePage)
+{
+	bool	Compatible	= false;
+
+	// If no code page specified, take default for system
+	if ((ULONG)-1 == CodePage)
+	{
+		CodePage = GetACP();
+	}
+
+	if (((1250 <= CodePage) && (CodePage <= 1258)) ||
+		((28591 <= CodePage) && (CodePage <= 28605)))
+	{
+		Compatible = true;
+	}
+	else
+	{
+		switch (CodePage)
+		{
+			case 874:
+			case 932:
+			case 936:
+			case 949:
+			case 950:
+			case 20127:
+			case 20932:
+			case 51932:
+			case 51936:
+			case 51949:
+			case 54936:
+			case 65001:
+			{
+				Compatible = true;
+				break;
+			}
+			default:
+			{
+				Compatible = false;
+				break;
+			}
+		}
+	}
+
+	return Compatible;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NarrowAscii
+/////////////////////////////////////////////////////////////////////////////
+void
+	NarrowAscii(
+	const wchar_t*	Source,
+	size_t			Length,
+	char*			Destination)
+{
+	size_t	Index	= 0;
+
+#ifdef USE_SSE2
+	for (; Index + 16 <= Length; Index += 16)
+	{
+		__m128i	Low		= _mm_loadu_si128((const __m128i*)(Source + Index));
+		__m128i	High	= _mm_loadu_si128((const __m128i*)(Source + Index + 8));
+
+		_mm_storeu_si128((__m128i*)(Destination + Index), _mm_packus_epi16(Low, High));
+	}
+#endif
+	for (; Index < Length; Index++)
+	{
+		Destination[Index] = (char)Source[Index];
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// WidenAscii
+/////////////////////////////////////////////////////////////////////////////
+void
+	WidenAscii(
+	const char*	Source,
+	size_t		Length,
+	wchar_t*	Destination)
+{
+	size_t	Index	= 0;
+
+#ifdef USE_SSE2
+	const __m128i	Zero	= _mm_setzero_si128();
+
+	for (; Index + 16 <= Length; Index += 16)
+	{
+		__m128i	Block	= _mm_loadu_si128((const __m128i*)(Source + Index));
+
+		_mm_storeu_si128((__m128i*)(Destination + Index), _mm_unpacklo_epi8(Block, Zero));
+		_mm_storeu_si128((__m128i*)(Destination + Index + 8), _mm_unpackhi_epi8(Block, Zero));
+	}
+#endif
+	for (; Index < Length; Index++)
+	{
+		Destination[Index] = (wchar_t)(BYTE)Source[Index];
+	}
+}
@@ -0,0 +1,61 @@
+/////////////////////////////////////////////////////////////////////////////
+// TextScan.h
+//
+// SSE2 helpers for finding and copying runs of plain text.
+//
+// Copyright (c) 2008 - 2015 by James John McGuire
+// All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// Includes
+/////////////////////////////////////////////////////////////////////////////
+#include "../Include/Common.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// GetAsciiLength
+//
+// Length of the leading run of 7-bit bytes.
+/////////////////////////////////////////////////////////////////////////////
+DllExport size_t
+GetAsciiLength(
+	const char*	String,
+	size_t		Length);
+
+/////////////////////////////////////////////////////////////////////////////
+// GetUnicodeRunLength
+//
+// Length of the leading run of UTF-16 units below Limit.
+/////////////////////////////////////////////////////////////////////////////
+DllExport size_t
+GetUnicodeRunLength(
+	const wchar_t*	String,
+	size_t			Length,
+	wchar_t			Limit);
+
+/////////////////////////////////////////////////////////////////////////////
+// IsAsciiCompatible
+//
+// True if 7-bit bytes mean the same ASCII characters in the code page.
+/////////////////////////////////////////////////////////////////////////////
+DllExport bool
+IsAsciiCompatible(
+	ULONG	CodePage);
+
+/////////////////////////////////////////////////////////////////////////////
+// NarrowAscii / WidenAscii
+//
+// Copy 7-bit text between UTF-16 and single bytes.
+/////////////////////////////////////////////////////////////////////////////
+DllExport void
+NarrowAscii(
+	const wchar_t*	Source,
+	size_t			Length,
+	char*			Destination);
+
+DllExport void
+WidenAscii(
+	const char*	Source,
+	size_t		Length,
+	wchar_t*	Destination);
@@ -19,6 +19,11 @@
 #include <stdlib.h>
 #include <shlobj.h>
 #include "Utils.h"
+#include "EncodingDetector.h"
+#include "ErrorCatalog.h"
+#include "ErrorMessageCache.h"
+#include "MessageCatalog.h"
+#include "Normalization.h"
 #include "Registry.h"
 
 #if defined _DEBUG
@@ -42,9 +47,9 @@ static WORD g_LanguageId = LANG_ENGLISH;
 
 static HMODULE g_ResourceModule	= NULL;
 
-CWinApp theApp;
+static MessageCatalog g_MessageCatalog;
 
-static ULONG alternativeCodePages[] = {CodePageUtf8, CodePageUsAscii, 0};
+CWinApp theApp;
 
 BOOL CWinApp::InitInstance()
 {
@@ -208,6 +213,31 @@ void
 {
 	g_LanguageId = LangId;
 	g_ResourceModule = ResourceModule;
+
+	if (true == g_MessageCatalog.IsOpen())
+	{
+		g_MessageCatalog.SetLanguage(LangId);
+	}
+}
+
+MessageCatalog*
+	GetMessageCatalog(void)
+{
+	MessageCatalog*	Catalog	= NULL;
+
+	if (true == g_MessageCatalog.IsOpen())
+	{
+		Catalog = &g_MessageCatalog;
+	}
+
+	return Catalog;
+}
+
+bool
+	OpenMessageCatalog(
+	LPCTSTR	CatalogPath)
+{
+	return g_MessageCatalog.Open(CatalogPath, g_LanguageId);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -258,18 +288,499 @@ bool
 	return ReturnCode;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// IsStatefulCodePage
+//
+// Code pages that shift between character sets with escape sequences or
+// mode bytes.  Their multibyte input can't be split without the state.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	IsStatefulCodePage(
+	ULONG CodePage)
+{
+	bool Stateful = false;
+
+	switch(CodePage)
+	{
+	case 50220:
+	case 50221:
+	case 50222:
+	case 50225:
+	case 50227:
+	case 50229:
+	case 52936:
+	case 57002:
+	case 57003:
+	case 57004:
+	case 57005:
+	case 57006:
+	case 57007:
+	case 57008:
+	case 57009:
+	case 57010:
+	case 57011:
+	case 65000:
+		{
+			Stateful = true;
+			break;
+		}
+	default:
+		{
+			Stateful = false;
+			break;
+		}
+	}
+
+	return Stateful;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetMultiByteBound
+//
+// Cheap upper bound of the bytes needed for UnicodeLength UTF-16 units.
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	GetMultiByteBound(
+	ULONG	CodePage,
+	size_t	UnicodeLength)
+{
+	size_t	BytesPerCharacter	= 2;
+
+	// If no code page specified, take default for system
+	if ((ULONG)-1 == CodePage)
+	{
+		CodePage = GetACP();
+	}
+
+	if (CodePageUtf8 == CodePage)
+	{
+		BytesPerCharacter = 3;
+	}
+	else if (54936 == CodePage)
+	{
+		// GB18030
+		BytesPerCharacter = 4;
+	}
+	else if (true == IsStatefulCodePage(CodePage))
+	{
+		// worst case, every character switches mode and back
+		BytesPerCharacter = 8;
+	}
+
+	return UnicodeLength * BytesPerCharacter;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetUnicodeBound
+//
+// Upper bound of the UTF-16 units produced from MultiByteLength bytes.
+// No code page produces more than one unit per input byte.
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	GetUnicodeBound(
+	ULONG	CodePage,
+	size_t	MultiByteLength)
+{
+	return MultiByteLength;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GetMultiByteSplit
+//
+// Returns the largest count, no more than Length, that ends on a whole
+// character.  The byte at String[Length] must be readable.
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	GetMultiByteSplit(
+	ULONG	CodePage,
+	LPCSTR	MultiByteString,
+	size_t	Length)
+{
+	const BYTE*	String	= (const BYTE*)MultiByteString;
+	size_t		Split	= Length;
+
+	if ((ULONG)-1 == CodePage)
+	{
+		CodePage = GetACP();
+	}
+
+	if (CodePageUtf8 == CodePage)
+	{
+		// back up over continuation bytes to the start of a character
+		while ((0 < Split) && (0x80 == (String[Split] & 0xC0)))
+		{
+			Split--;
+		}
+	}
+	else if (54936 == CodePage)
+	{
+		size_t	Index	= 0;
+
+		while (Index < Length)
+		{
+			size_t	Step	= 1;
+
+			if ((0x81 <= String[Index]) && (String[Index] <= 0xFE))
+			{
+				Step = 2;
+
+				if ((0x30 <= String[Index + 1]) && (String[Index + 1] <= 0x39))
+				{
+					Step = 4;
+				}
+			}
+
+			if (Index + Step > Length)
+			{
+				break;
+			}
+
+			Index += Step;
+		}
+
+		Split = Index;
+	}
+	else
+	{
+		CPINFO	CodePageInfo;
+
+		if ((FALSE != GetCPInfo(CodePage, &CodePageInfo)) &&
+			(2 == CodePageInfo.MaxCharSize))
+		{
+			size_t	Index	= 0;
+
+			while (Index < Length)
+			{
+				size_t	Step	= 1;
+
+				if (FALSE != IsDBCSLeadByteEx(CodePage, String[Index]))
+				{
+					Step = 2;
+				}
+
+				if (Index + Step > Length)
+				{
+					break;
+				}
+
+				Index += Step;
+			}
+
+			Split = Index;
+		}
+	}
+
+	return Split;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ConvertUnicodeRun
+//
+// Converts text that needs no composing, as much as fits.
+/////////////////////////////////////////////////////////////////////////////
+static size_t
+	ConvertUnicodeRun(
+	ULONG	CodePage,
+	LPCWSTR	UnicodeString,
+	size_t	UnicodeLength,
+	char*	MultiByteBuffer,
+	size_t	MultiByteBufferSize,
+	size_t*	UnicodeUsed)
+{
+	size_t	BytesWritten		= 0;
+	size_t	Used				= 0;
+	size_t	BytesPerCharacter	= GetMultiByteBound(CodePage, 1);
+
+	while (Used < UnicodeLength)
+	{
+		size_t	Chunk	= UnicodeLength - Used;
+		size_t	Space	= MultiByteBufferSize - BytesWritten;
+
+		if (INT_MAX < Space)
+		{
+			Space = INT_MAX;
+		}
+
+		if (Chunk * BytesPerCharacter > Space)
+		{
+			Chunk = Space / BytesPerCharacter;
+
+			// don't split surrogate pairs, or a character from its
+			// combining marks
+			while ((0 < Chunk) &&
+				((IS_HIGH_SURROGATE(UnicodeString[Used + Chunk - 1])) ||
+				((0x0300 <= UnicodeString[Used + Chunk]) &&
+				(UnicodeString[Used + Chunk] <= 0x036F))))
+			{
+				Chunk--;
+			}
+
+			if (0 == Chunk)
+			{
+				break;
+			}
+		}
+
+		int	Written	= WideCharToMultiByte(CodePage,
+			0,
+			UnicodeString + Used,
+			(int)Chunk,
+			MultiByteBuffer + BytesWritten,
+			(int)Space,
+			NULL,
+			NULL);
+
+		if (0 == Written)
+		{
+			TCHAR	ErrorMessage[256];
+			_stprintf_s(ErrorMessage, _T("\r\nError in WideCharToMultiByte: %d\r\n"), GetLastError());
+			ATLTRACE(ErrorMessage);
+			break;
+		}
+
+		BytesWritten	+= Written;
+		Used			+= Chunk;
+	}
+
+	*UnicodeUsed = Used;
+
+	return BytesWritten;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ConvertUnicodeToMultiByte
+//
+// Returns:		size_t		number of bytes written (no terminator)
+// Parameters:
+//	ULONG		CodePage			(IN)	Code page used to perform conversion
+//											-1 = Get local code page.
+//	LPCWSTR		UnicodeString		(IN)	Unicode input, need not be terminated
+//	size_t		UnicodeLength		(IN)	Input length (chars)
+//	char*		MultiByteBuffer		(OUT)	Caller's output buffer
+//	size_t		MultiByteBufferSize	(IN)	Output buffer size (bytes)
+//	size_t*		UnicodeUsed			(OUT)	Input chars consumed, may be NULL
+//
+// Purpose:		Converts in one pass into the caller's buffer, without a
+//				sizing call.  If the buffer may be too small, as much as
+//				fits is converted, whole characters at a time, and
+//				UnicodeUsed tells the caller where to resume.
+//				Text is composed to NFC first, in place of the OS
+//				WC_COMPOSITECHECK handling, but only the pieces the
+//				quick check finds need it; everything else is passed
+//				straight through.
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	ConvertUnicodeToMultiByte(
+	ULONG	CodePage,
+	LPCWSTR	UnicodeString,
+	size_t	UnicodeLength,
+	char*	MultiByteBuffer,
+	size_t	MultiByteBufferSize,
+	size_t*	UnicodeUsed)
+{
+	size_t	BytesWritten	= 0;
+	size_t	Used			= 0;
+
+	if ((NULL != UnicodeString) && (NULL != MultiByteBuffer))
+	{
+		// If no code page specified, take default for system
+		if ((ULONG)-1 == CodePage)
+		{
+			CodePage = GetACP();
+		}
+
+		bool	Compose	= AllowConversionFlags(CodePage);
+
+		while (Used < UnicodeLength)
+		{
+			size_t	Segment		= UnicodeLength - Used;
+			size_t	SegmentUsed	= 0;
+			bool	Normalized	= true;
+
+			if (true == Compose)
+			{
+				Segment = GetNfcSegment(UnicodeString + Used, Segment, &Normalized);
+			}
+
+			if (true == Normalized)
+			{
+				BytesWritten += ConvertUnicodeRun(CodePage,
+					UnicodeString + Used,
+					Segment,
+					MultiByteBuffer + BytesWritten,
+					MultiByteBufferSize - BytesWritten,
+					&SegmentUsed);
+
+				Used += SegmentUsed;
+			}
+			else
+			{
+				wchar_t		Composed[64];
+				wchar_t*	ComposedString	= Composed;
+				size_t		ComposedSize	= GetNormalizedBound(Segment);
+
+				if (64 < ComposedSize)
+				{
+					// delete after use
+					ComposedString = new wchar_t[ComposedSize];
+				}
+
+				if (NULL != ComposedString)
+				{
+					size_t	ComposedLength	= NormalizeString(UnicodeFormC,
+						UnicodeString + Used,
+						Segment,
+						ComposedString,
+						ComposedSize);
+
+					size_t	Written		= ConvertUnicodeRun(CodePage,
+						ComposedString,
+						ComposedLength,
+						MultiByteBuffer + BytesWritten,
+						MultiByteBufferSize - BytesWritten,
+						&SegmentUsed);
+
+					// a composed piece goes in whole or not at all
+					if ((0 < ComposedLength) && (SegmentUsed == ComposedLength))
+					{
+						BytesWritten	+= Written;
+						Used			+= Segment;
+						SegmentUsed		= Segment;
+					}
+					else
+					{
+						SegmentUsed = 0;
+					}
+
+					if (Composed != ComposedString)
+					{
+						delete[] ComposedString;
+					}
+				}
+			}
+
+			if (SegmentUsed < Segment)
+			{
+				break;
+			}
+		}
+	}
+
+	if (NULL != UnicodeUsed)
+	{
+		*UnicodeUsed = Used;
+	}
+
+	return BytesWritten;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ConvertMultiByteToUnicode
+//
+// Returns:		size_t		number of chars written (no terminator)
+// Parameters:
+//	ULONG		CodePage			(IN)	Code page used to perform conversion
+//											-1 = Get local code page.
+//	LPCSTR		MultiByteString		(IN)	Multibyte input, need not be terminated
+//	size_t		MultiByteLength		(IN)	Input length (bytes)
+//	wchar_t*	UnicodeBuffer		(OUT)	Caller's output buffer
+//	size_t		UnicodeBufferSize	(IN)	Output buffer size (chars)
+//	size_t*		MultiByteUsed		(OUT)	Input bytes consumed, may be NULL
+//
+// Purpose:		As ConvertUnicodeToMultiByte.  Input in a stateful code
+//				page (ISO 2022, UTF-7...) is only converted whole, as its
+//				shift state can't be carried across calls.
+/////////////////////////////////////////////////////////////////////////////
+size_t
+	ConvertMultiByteToUnicode(
+	ULONG		CodePage,
+	LPCSTR		MultiByteString,
+	size_t		MultiByteLength,
+	wchar_t*	UnicodeBuffer,
+	size_t		UnicodeBufferSize,
+	size_t*		MultiByteUsed)
+{
+	size_t	CharactersWritten	= 0;
+	size_t	Used				= 0;
+
+	if ((NULL != MultiByteString) && (NULL != UnicodeBuffer))
+	{
+		// If no code page specified, take default for system
+		if ((ULONG)-1 == CodePage)
+		{
+			CodePage = GetACP();
+		}
+
+		DWORD	Flags	= MB_PRECOMPOSED;
+
+		if (false == AllowConversionFlags(CodePage))
+		{
+			Flags = 0;
+		}
+
+		while (Used < MultiByteLength)
+		{
+			size_t	Chunk	= MultiByteLength - Used;
+			size_t	Space	= UnicodeBufferSize - CharactersWritten;
+
+			if (INT_MAX < Space)
+			{
+				Space = INT_MAX;
+			}
+
+			if (GetUnicodeBound(CodePage, Chunk) > Space)
+			{
+				if (true == IsStatefulCodePage(CodePage))
+				{
+					break;
+				}
+
+				Chunk = GetMultiByteSplit(CodePage, MultiByteString + Used, Space);
+
+				if (0 == Chunk)
+				{
+					break;
+				}
+			}
+
+			int	Written	= MultiByteToWideChar(CodePage,
+				Flags,
+				MultiByteString + Used,
+				(int)Chunk,
+				UnicodeBuffer + CharactersWritten,
+				(int)Space);
+
+			if (0 == Written)
+			{
+				GetLastErrorInfo(NULL);
+				break;
+			}
+
+			CharactersWritten	+= Written;
+			Used				+= Chunk;
+		}
+	}
+
+	if (NULL != MultiByteUsed)
+	{
+		*MultiByteUsed = Used;
+	}
+
+	return CharactersWritten;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // GetMultiByteStringFromUnicodeString()
 //
-// Returns:		int			number of characters written. 0 means error
+// Returns:		char*		new multibyte string, delete after use.
 // Parameters:
 //	wchar_t *	szUnicodeString			(IN)	Unicode input string
-//	char*		szMultiByteString		(OUT)	Multibyte output string
-//	int			nMultiByteBufferSize	(IN)	Multibyte buffer size (chars)
 //	ULONG		nCodePage				(IN)	Code page used to perform conversion
 //												Default = -1 (Get local code page).
 //
 // Purpose:		Gets a MultiByte string from a Unicode string
+//				The buffer is sized from GetMultiByteBound, so the
+//				conversion runs once.
 // Exceptions:	None.
 /////////////////////////////////////////////////////////////////////////////
 DllExport char *
@@ -277,70 +788,24 @@ DllExport char *
 	LPCWSTR	UnicodeString,
 	ULONG	CodePage)
 {
-	BOOL	bUsedDefChar	= FALSE;
-	int		nCharsWritten = 0;
 	char*	MultiByteString = NULL;
 	try
 	{
 		if (UnicodeString)
 		{
-			// If no code page specified, take default for system
-			if (-1 == CodePage)
-			{
-				CodePage = GetACP();
-			}
-
-			int MultiByteBufferSize = WideCharToMultiByte( CodePage,
-				0,
-				UnicodeString,
-				-1,
-				NULL,
-				0,
-				NULL,
-				NULL);
+			size_t	UnicodeLength		= wcslen(UnicodeString);
+			size_t	MultiByteBufferSize	= GetMultiByteBound(CodePage, UnicodeLength) + 1;
 
 			MultiByteString = new char[MultiByteBufferSize];
 
-			// Zero out buffer first
-			memset((void*)MultiByteString, '\0', MultiByteBufferSize);
-
-			DWORD Flags	= WC_COMPOSITECHECK | WC_SEPCHARS;
-
-			bool UseFlags	= AllowConversionFlags(CodePage);
-
-			if (false == UseFlags)
-			{
-				Flags	= 0;
-			}
-
-			// If writing to UTF8, flags, default char and boolean flag must be NULL
-			nCharsWritten = WideCharToMultiByte(CodePage,
-				Flags,
+			size_t	BytesWritten	= ConvertUnicodeToMultiByte(CodePage,
 				UnicodeString,
-				-1,
+				UnicodeLength,
 				MultiByteString,
-				MultiByteBufferSize,
-				NULL,
+				MultiByteBufferSize - 1,
 				NULL);
 
-			// If no chars were written and the buffer is not 0, error!
-			if (nCharsWritten == 0 && MultiByteBufferSize > 0)
-			{
-				TCHAR	ErrorMessage[256];
-				_stprintf_s(ErrorMessage, _T("\r\nError in WideCharToMultiByte: %d\r\n"), GetLastError());
-				ATLTRACE(ErrorMessage);
-				MultiByteString[0]	= '\0';
-			}
-		}
-
-		// Now fix nCharsWritten
-		if (nCharsWritten > 0)
-		{
-			nCharsWritten--;
-		}
-		else
-		{
-			//MultiByteString[0]	= '\0';
+			MultiByteString[BytesWritten]	= '\0';
 		}
 	}
 	catch(...)
@@ -426,6 +891,9 @@ char*
 //												Default = -1 (Get local code page).
 //
 // Purpose:		Gets a Unicode string from a MultiByte string.
+//				The input is scanned once by EncodingDetector, which may
+//				override nCodePage when the contents rule it out, so the
+//				conversion itself only runs once.
 /////////////////////////////////////////////////////////////////////////////
 int
 	GetUnicodeStringFromMultiByteString(
@@ -439,11 +907,17 @@ int
 
 	if (szUnicodeString && szMultiByteString)
 	{
-		// If no code page specified, take default for system
-		if (nCodePage == -1)
-		{
-			nCodePage = GetACP();
-		}
+		EncodingDetector	Detector;
+		size_t				MultiByteLength	= strlen(szMultiByteString);
+
+		// NUL terminated, so not UTF-16; a leading "ÿþ" or "þÿ" is text
+		nCodePage = Detector.Detect((const BYTE*)szMultiByteString,
+			MultiByteLength,
+			nCodePage,
+			false);
+
+		// don't carry the byte order mark into the output
+		szMultiByteString += Detector.GetBomLength();
 
 		DWORD Flags	= MB_PRECOMPOSED;
 
@@ -461,20 +935,12 @@ int
 				nUnicodeBufferSize);
 
 			// When converting to UTF8, don't set any flags (see Q175392).
-			for (int codePageIndex = 0;;) {
-				nCharsWritten = MultiByteToWideChar(nCodePage,
-					Flags,
-					szMultiByteString,
-					-1,
-					szUnicodeString,
-					nUnicodeBufferSize+1);
-
-				if (nCharsWritten > 0 || alternativeCodePages[codePageIndex] == 0)
-					break;
-
-				//If there a problem converting to a wide char with the given code page.
-				nCodePage = alternativeCodePages[codePageIndex++];
-			}
+			nCharsWritten = MultiByteToWideChar(nCodePage,
+				Flags,
+				szMultiByteString,
+				-1,
+				szUnicodeString,
+				nUnicodeBufferSize+1);
 		}
 		catch(CException *ex)
 		{
@@ -653,6 +1119,27 @@ bool
 	return Utf8BomMark;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// IsUtf8BomMark
+//
+// Checks the full three byte mark (EF BB BF) at the start of the buffer.
+/////////////////////////////////////////////////////////////////////////////
+bool
+	IsUtf8BomMark(
+	const BYTE*	Buffer,
+	size_t		BufferLength)
+{
+	bool	Utf8BomMark	= false;
+
+	if ((NULL != Buffer) && (3 <= BufferLength) && (0xEF == Buffer[0]) &&
+		(0xBB == Buffer[1]) && (0xBF == Buffer[2]))
+	{
+		Utf8BomMark	= true;
+	}
+
+	return Utf8BomMark;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // GetBaseFileName
 //
@@ -856,33 +1343,25 @@ bool
 	HMODULE	ModuleHandle)
 {
 	bool	bRet		= false;
-
-	LPVOID	pMsgBuffer = NULL;
 	DWORD	dwErr		= GetLastError();
-	DWORD	dwRet;
-	DWORD	FormatFlags = FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM;
-//	LPTSTR buffer = reinterpret_cast<LPTSTR>(&pMsgBuffer);
-	LPTSTR buffer = NULL;
 
-	if (NULL != ModuleHandle)
+	LPCTSTR			buffer	= NULL;
+	size_t			Length	= 0;
+	InternedString	Message;
+
+	if ((NULL != ModuleHandle) || (false == LookupErrorCatalog(dwErr,
+		ERROR_MESSAGE_LANGUAGE_DEFAULT, &buffer, &Length)))
 	{
-		FormatFlags |= FORMAT_MESSAGE_FROM_HMODULE;
+		Message	= GetErrorMessage(ModuleHandle, dwErr);
+		buffer	= Message.GetString();
+		Length	= Message.GetLength();
 	}
 
-	dwRet	= FormatMessage(FormatFlags,
-		ModuleHandle,
-		dwErr,
-		MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-		(LPWSTR)&buffer,
-		0,
-		NULL);
-
-	if (NULL != buffer)
+	if (0 < Length)
 	{
 		OutputDebugString(buffer);
 		//TRACE(_T("Error: %s\r\n"), buffer);
 		_tprintf(_T("\tError: %s"), buffer);
-		LocalFree(pMsgBuffer);
 	}
 
 	return bRet;
@@ -25,6 +25,8 @@ const ULONG CodePageEucOfficial		= 51932;	// EUC - Japanese - doesn't work, at l
 const ULONG CodePageEucUndocumented	= 20932;	// EUC - Japanese - undocumented, works on, at least, XP
 const ULONG CodePageUsAscii			= 20127;	// US-ASCII (7-bit)
 const ULONG CodePageUtf8			= 65001;	// Unicode UTF-8
+const ULONG CodePageUtf16Le			= 1200;		// Unicode UTF-16, little endian
+const ULONG CodePageUtf16Be			= 1201;		// Unicode UTF-16, big endian
 
 /////////////////////////////////////////////////////////////////////////////
 // APIs
@@ -67,9 +69,29 @@ GetWindowsDllPath(
 /////////////////////////////////////////////////////////////////////////////
 // Language related utils
 /////////////////////////////////////////////////////////////////////////////
+class MessageCatalog;
+
 DllExport WORD
 GetLanguageId();
 
+/////////////////////////////////////////////////////////////////////////////
+// GetMessageCatalog
+//
+// The process's message catalog, or NULL if none has been opened.
+/////////////////////////////////////////////////////////////////////////////
+DllExport MessageCatalog*
+GetMessageCatalog(void);
+
+/////////////////////////////////////////////////////////////////////////////
+// OpenMessageCatalog
+//
+// Maps the catalog of every language's strings, in the current language.
+// Call once at startup; SetLanguageId then switches its language too.
+/////////////////////////////////////////////////////////////////////////////
+DllExport bool
+OpenMessageCatalog(
+	LPCTSTR	CatalogPath);
+
 DllExport void
 SetLanguageId(
 	WORD	LangId,
@@ -137,6 +159,54 @@ GetMultiByteStringFromUnicodeString(
 	LPCWSTR szUnicodeString,
 	ULONG nCodePage);
 
+// false for code pages that reject MB_PRECOMPOSED / WC_COMPOSITECHECK
+DllExport bool
+AllowConversionFlags(
+	ULONG	CodePage);
+
+// true for code pages whose multibyte text can't be split without state
+DllExport bool
+IsStatefulCodePage(
+	ULONG	CodePage);
+
+/////////////////////////////////////////////////////////////////////////////
+// Caller buffer conversions
+//
+// Convert into a buffer the caller owns, and return the exact count
+// written.  Size the buffer with GetMultiByteBound / GetUnicodeBound to
+// convert everything in one call, or reuse a smaller buffer and resume
+// from the returned input count.
+/////////////////////////////////////////////////////////////////////////////
+DllExport size_t
+GetMultiByteBound(
+	ULONG	CodePage,
+	size_t	UnicodeLength);
+DllExport size_t
+GetUnicodeBound(
+	ULONG	CodePage,
+	size_t	MultiByteLength);
+DllExport size_t
+GetMultiByteSplit(
+	ULONG	CodePage,
+	LPCSTR	MultiByteString,
+	size_t	Length);
+DllExport size_t
+ConvertUnicodeToMultiByte(
+	ULONG	CodePage,
+	LPCWSTR	UnicodeString,
+	size_t	UnicodeLength,
+	char*	MultiByteBuffer,
+	size_t	MultiByteBufferSize,
+	size_t*	UnicodeUsed);
+DllExport size_t
+ConvertMultiByteToUnicode(
+	ULONG		CodePage,
+	LPCSTR		MultiByteString,
+	size_t		MultiByteLength,
+	wchar_t*	UnicodeBuffer,
+	size_t		UnicodeBufferSize,
+	size_t*		MultiByteUsed);
+
 DllExport wchar_t*
 GetUnicodeString(
 	LPCSTR	MultiByteString);
@@ -188,6 +258,10 @@ StringSprintfInt(
 DllExport bool
 IsUtf8BomMark(
 	BYTE ByteInQuestion);
+DllExport bool
+IsUtf8BomMark(
+	const BYTE*	Buffer,
+	size_t		BufferLength);
 
 /////////////////////////////////////////////////////////////////////////////
 // Test related utils